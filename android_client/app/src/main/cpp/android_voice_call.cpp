@@ -1,9 +1,13 @@
 #include "voice_call.h"
+#include "ima_adpcm.h"
+#include "voice_packet.h"
 #include <android/log.h>
+#include <cstdlib>
 #include <cstring>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <map>
 #include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -31,6 +35,11 @@ public:
         , mic_volume_(1.0f)
         , speaker_volume_(1.0f)
         , running_(false)
+        , packets_sent_(0)
+        , bytes_sent_(0)
+        , packets_received_(0)
+        , bytes_received_(0)
+        , session_id_(kUnassignedSessionId)
         , engine_(nullptr)
         , engine_interface_(nullptr)
         , recorder_(nullptr)
@@ -186,28 +195,45 @@ public:
                     
                     // 处理服务器响应
                     if (strncmp(buffer, "JOIN_OK", 7) == 0) {
+                        // "JOIN_OK:房间:用户:会话ID"，会话ID由服务器分配，发送的每个包都要带上
+                        uint32_t session_id = kUnassignedSessionId;
+                        if (!ParseJoinOk(buffer, &session_id)) {
+                            LOGE("Ignoring malformed JOIN_OK: '%s'", buffer);
+                            continue;
+                        }
+                        session_id_ = session_id;
+                        // 新房间里的会话ID对应的是另一批发送端，丢掉切换前没收齐的分片
+                        fragment_assemblies_.clear();
+                        LOGI("Assigned session id: %u", session_id);
                         SetState(VOICE_CALL_STATE_CONNECTED);
-                        joined = true;
-                        LOGI("Successfully connected to server");
-                        // 等待少量时间再启动音频采集，减少延迟
-                        LOGI("Waiting 100ms before starting audio capture...");
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                        LOGI("Starting audio capture...");
-                        StartAudioCapture();
+                        if (!joined) {
+                            joined = true;
+                            LOGI("Successfully connected to server");
+                            // 等待少量时间再启动音频采集，减少延迟；切换房间时采集已在运行
+                            LOGI("Waiting 100ms before starting audio capture...");
+                            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                            LOGI("Starting audio capture...");
+                            StartAudioCapture();
+                        }
                     } else if (strncmp(buffer, "JOIN_FAIL", 9) == 0) {
                         SetState(VOICE_CALL_STATE_ERROR);
                         LOGE("Failed to join room");
                         break;
-                    } else if (received >= 654 && joined) {
-                        // 只有在成功加入房间后才处理音频数据包
+                    } else if (strncmp(buffer, "JOIN:", 5) == 0 || strncmp(buffer, "LEAVE:", 6) == 0) {
+                        // 其他用户加入/离开的广播，文本控制消息优先识别，避免较长的控制消息被当作音频包
+                        LOGI("Room notification: '%s'", buffer);
+                    } else if (received >= static_cast<ssize_t>(kAudioPacketHeaderSize) && joined) {
+                        // 只有在成功加入房间后才处理音频数据包 (ADPCM包和最后一个分片可能比PCM包小得多)
                         LOGI("Received audio packet, playing...");
                         // 添加调试信息
                         static auto last_packet_log = std::chrono::steady_clock::now();
                         auto now = std::chrono::steady_clock::now();
                         if (now - last_packet_log > std::chrono::seconds(5)) {
-                            LOGI("Audio packet debug: received=%zd bytes, expected=654 bytes", received);
+                            LOGI("Audio packet debug: received=%zd bytes", received);
                             last_packet_log = now;
                         }
+                        ++packets_received_;
+                        bytes_received_ += received;
                         PlayAudioData(buffer, received);
                     } else if (strlen(buffer) == 0) {
                         LOGI("Received empty response from server");
@@ -258,6 +284,36 @@ public:
         return state_;
     }
     
+    // 切换房间: 在同一个socket上离开当前房间并加入新房间，采集与播放保持运行；
+    // 收到新房间的 JOIN_OK 之前没有会话ID，不发送音频
+    voice_call_error_t SwitchRoom(const char* room_id) {
+        if (strlen(room_id) == 0 || strlen(room_id) >= sizeof(config_.room_id)) {
+            return VOICE_CALL_ERROR_INVALID_PARAM;
+        }
+        if (state_ == VOICE_CALL_STATE_IDLE || state_ == VOICE_CALL_STATE_DISCONNECTED) {
+            strcpy(config_.room_id, room_id);
+            return VOICE_CALL_SUCCESS;
+        }
+        if (state_ == VOICE_CALL_STATE_ERROR || socket_fd_ < 0) {
+            return VOICE_CALL_ERROR_NETWORK;
+        }
+        LOGI("Switching room: %s -> %s", config_.room_id, room_id);
+        std::string leave_msg = "LEAVE:" + std::string(config_.room_id) + ":" + std::string(config_.user_id);
+        sendto(socket_fd_, leave_msg.c_str(), leave_msg.length(), 0,
+               (struct sockaddr*)&server_addr_, sizeof(server_addr_));
+        session_id_ = kUnassignedSessionId;
+        SetState(VOICE_CALL_STATE_CONNECTING);
+        strcpy(config_.room_id, room_id);
+        std::string join_msg = "JOIN:" + std::string(config_.room_id) + ":" + std::string(config_.user_id);
+        if (sendto(socket_fd_, join_msg.c_str(), join_msg.length(), 0,
+                   (struct sockaddr*)&server_addr_, sizeof(server_addr_)) < 0) {
+            LOGE("Failed to send JOIN message: %s", strerror(errno));
+            SetState(VOICE_CALL_STATE_ERROR);
+            return VOICE_CALL_ERROR_NETWORK;
+        }
+        return VOICE_CALL_SUCCESS;
+    }
+    
     voice_call_error_t SetMuted(bool muted) {
         muted_ = muted;
         LOGI("Microphone %s", muted ? "muted" : "unmuted");
@@ -268,6 +324,16 @@ public:
         return muted_;
     }
     
+    // 简化实现只统计收发的包数和字节数，其余字段为0
+    voice_call_error_t GetStats(voice_call_stats_t* stats) const {
+        memset(stats, 0, sizeof(*stats));
+        stats->packets_sent = packets_sent_;
+        stats->bytes_sent = bytes_sent_;
+        stats->packets_received = packets_received_;
+        stats->bytes_received = bytes_received_;
+        return VOICE_CALL_SUCCESS;
+    }
+    
     voice_call_error_t SetMicrophoneVolume(float volume) {
         if (volume < 0.0f || volume > 1.0f) {
             return VOICE_CALL_ERROR_INVALID_PARAM;
@@ -287,6 +353,68 @@ public:
     }
 
 private:
+    // 从 "JOIN_OK:房间:用户:会话ID" 中取出会话ID，必须是完整的十进制数且不等于 kUnassignedSessionId
+    static bool ParseJoinOk(const char* message, uint32_t* session_id) {
+        int colons = 0;
+        for (const char* p = message; *p; ++p) {
+            colons += *p == ':';
+        }
+        const char* field = strrchr(message, ':');
+        if (colons < 3 || !field || field[1] < '0' || field[1] > '9') {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        unsigned long parsed = strtoul(field + 1, &end, 10);
+        if (*end != '\0' || errno == ERANGE || parsed >= kUnassignedSessionId) {
+            return false;
+        }
+        *session_id = static_cast<uint32_t>(parsed);
+        return true;
+    }
+    
+    // 收下一个分片，整帧的分片都到齐时拼接到 assembled_frame_ 并返回 true，frames 为分片头里的整帧帧数
+    // 每个发送端只保留正在接收的一帧: 新的一帧开始时丢弃没收齐的上一帧，比它更早的帧的迟到分片直接忽略
+    bool AssembleFragment(uint32_t session_id, uint32_t sequence, uint32_t timestamp, uint8_t payload_type,
+                          const uint8_t* data, size_t size, size_t* frames) {
+        FragmentHeader header;
+        if (size <= sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (header.count == 0 || header.count > kMaxFrameFragments || header.index >= header.count) {
+            return false;
+        }
+        FragmentAssembly& assembly = fragment_assemblies_[session_id];
+        uint32_t first_sequence = sequence - header.index;
+        bool same_frame = assembly.received_mask != 0 && assembly.timestamp == timestamp &&
+                          assembly.first_sequence == first_sequence && assembly.count == header.count &&
+                          assembly.frames == ntohs(header.frames) && assembly.payload_type == payload_type;
+        if (!same_frame) {
+            if (assembly.received_mask != 0 && static_cast<int32_t>(timestamp - assembly.timestamp) < 0) {
+                return false;
+            }
+            assembly.timestamp = timestamp;
+            assembly.first_sequence = first_sequence;
+            assembly.count = header.count;
+            assembly.frames = ntohs(header.frames);
+            assembly.payload_type = payload_type;
+            assembly.received_mask = 0;
+        }
+        assembly.parts[header.index].assign(data + sizeof(header), data + size);
+        assembly.received_mask |= 1u << header.index;
+        if (assembly.received_mask != (1u << assembly.count) - 1) {
+            return false;
+        }
+        assembled_frame_.clear();
+        for (size_t i = 0; i < assembly.count; ++i) {
+            assembled_frame_.insert(assembled_frame_.end(), assembly.parts[i].begin(), assembly.parts[i].end());
+        }
+        assembly.received_mask = 0;
+        *frames = assembly.frames;
+        return true;
+    }
+    
     void SetState(voice_call_state_t new_state) {
         if (state_ != new_state) {
             state_ = new_state;
@@ -541,8 +669,10 @@ private:
         struct AudioPacket {
             uint32_t sequence;
             uint32_t timestamp;
-            uint32_t user_id;
+            uint32_t session_id;
             uint16_t data_size;
+            uint8_t payload_type;   // 0=PCM16，5=ADPCM，2/6为带冗余的同种编码，其余类型 (舒适噪声、接收报告、重传请求) 本端不处理
+            uint8_t flags;
             uint8_t data[1024];
         } __attribute__((packed));
         
@@ -555,25 +685,84 @@ private:
         const AudioPacket* packet = reinterpret_cast<const AudioPacket*>(data);
         uint32_t sequence = ntohl(packet->sequence);
         uint32_t timestamp = ntohl(packet->timestamp);
-        uint32_t user_id = ntohl(packet->user_id);
+        uint32_t session_id = ntohl(packet->session_id);
         uint16_t data_size = ntohs(packet->data_size);
         
+        // 验证包大小 (解析负载之前，避免按 data_size 读到包外)
+        int expected_size = sizeof(AudioPacket) - sizeof(AudioPacket::data) + data_size;
+        if (length != expected_size) {
+            LOGE("Audio packet size mismatch: expected %d, got %zu", expected_size, length);
+            return;
+        }
+        
+        // 本端不请求重传，也不按序列号重排，重传包 (flags 位0) 一律忽略以免重复播放
+        if (packet->flags & 0x01) {
+            return;
+        }
+        // 本端没有房间密钥 (不支持 media_key)，加密的负载无法解密，当作PCM播放只会是噪声
+        if (packet->flags & kPacketFlagEncrypted) {
+            ++encrypted_packets_dropped_;
+            static auto last_encrypted_log = std::chrono::steady_clock::now();
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_encrypted_log > std::chrono::seconds(5)) {
+                LOGE("Dropping encrypted audio packets (no media key): %llu so far",
+                     static_cast<unsigned long long>(encrypted_packets_dropped_));
+                last_encrypted_log = now;
+            }
+            return;
+        }
+        
+        // 只播放音频负载: 冗余包 (类型2/6) 只取主负载，舒适噪声描述符、接收报告与重传请求直接忽略
+        const uint8_t* pcm_data = packet->data;
+        size_t pcm_size = data_size;
+        size_t fragment_frames = 0;
+        if (packet->flags & kPacketFlagFragment) {
+            // 大帧拆成的分片 (只有类型0/5) 收齐后拼接成整帧再解码，没收齐之前不播放
+            if ((packet->payload_type != 0 && packet->payload_type != 5) ||
+                !AssembleFragment(session_id, sequence, timestamp, packet->payload_type,
+                                  packet->data, data_size, &fragment_frames)) {
+                return;
+            }
+            pcm_data = assembled_frame_.data();
+            pcm_size = assembled_frame_.size();
+        } else if (packet->payload_type == 2 || packet->payload_type == 6) {
+            // 布局: block_count(1) + block_count * (距离1 + 时间戳差2 + 长度2) + 主负载 + 冗余数据
+            size_t header_bytes = 1 + static_cast<size_t>(packet->data[0]) * 5;
+            size_t redundant_bytes = 0;
+            for (size_t i = 0; i < packet->data[0] && header_bytes <= data_size; ++i) {
+                const uint8_t* block = packet->data + 1 + i * 5;
+                redundant_bytes += (block[3] << 8) | block[4];
+            }
+            if (header_bytes + redundant_bytes > data_size) {
+                return;
+            }
+            pcm_data = packet->data + header_bytes;
+            pcm_size = data_size - header_bytes - redundant_bytes;
+        } else if (packet->payload_type != 0 && packet->payload_type != 5) {
+            return;
+        }
+        // ADPCM主负载 (码率控制在带宽不足时使用) 先解码为PCM16，分片的帧数取分片头里的整帧帧数
+        std::vector<int16_t> decoded_audio;
+        if (packet->payload_type == 5 || packet->payload_type == 6) {
+            int channels = config_.audio_config.channels;
+            size_t frames = fragment_frames > 0 ? fragment_frames : ima_adpcm::DecodedFrames(channels, pcm_size);
+            decoded_audio.resize(frames * channels);
+            if (frames == 0 || !ima_adpcm::Decode(pcm_data, pcm_size, channels, frames, decoded_audio.data())) {
+                return;
+            }
+            pcm_data = reinterpret_cast<const uint8_t*>(decoded_audio.data());
+            pcm_size = decoded_audio.size() * sizeof(int16_t);
+        }
+        
         // 添加调试信息
         static auto last_debug_log = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
         if (now - last_debug_log > std::chrono::seconds(1)) {
-            LOGI("Audio packet debug: sequence=%u, timestamp=%u, user_id=0x%x, data_size=%u bytes", 
-                 sequence, timestamp, user_id, data_size);
+            LOGI("Audio packet debug: sequence=%u, timestamp=%u, session_id=%u, data_size=%u bytes", 
+                 sequence, timestamp, session_id, data_size);
             last_debug_log = now;
         }
         
-        // 验证包大小
-        int expected_size = sizeof(AudioPacket) - sizeof(AudioPacket::data) + data_size;
-        if (length != expected_size) {
-            LOGE("Audio packet size mismatch: expected %d, got %zu", expected_size, length);
-            return;
-        }
-        
         // 添加更详细的调试信息
         static auto last_detail_log = std::chrono::steady_clock::now();
         auto now_detail = std::chrono::steady_clock::now();
@@ -583,11 +772,11 @@ private:
             last_detail_log = now_detail;
         }
         
-        // 获取音频数据
-        const int16_t* audio_data = reinterpret_cast<const int16_t*>(packet->data);
+        // 获取音频数据 (分片拼接的整帧解码后可能超过一个包的大小)
+        const int16_t* audio_data = reinterpret_cast<const int16_t*>(pcm_data);
         
         // 直接复制音频数据并应用音量（音频数据已经是小端序格式）
-        std::vector<int16_t> converted_audio(data_size / sizeof(int16_t));
+        std::vector<int16_t> converted_audio(pcm_size / sizeof(int16_t));
         
         // 检查音频数据是否有效
         bool has_valid_audio = false;
@@ -618,14 +807,14 @@ private:
             last_audio_debug = now_debug;
         }
         
-        // 将音频数据发送到播放器（data_size是字节数，直接使用）
-        SLresult result = (*player_buffer_queue_)->Enqueue(player_buffer_queue_, converted_audio.data(), data_size);
+        // 将音频数据发送到播放器（pcm_size是字节数，直接使用）
+        SLresult result = (*player_buffer_queue_)->Enqueue(player_buffer_queue_, converted_audio.data(), static_cast<SLuint32>(pcm_size));
         if (result != SL_RESULT_SUCCESS) {
             LOGE("Failed to enqueue audio data for playback: %d", result);
             // 如果缓冲区满了，等待一下再重试
             if (result == SL_RESULT_BUFFER_INSUFFICIENT) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                result = (*player_buffer_queue_)->Enqueue(player_buffer_queue_, converted_audio.data(), data_size);
+                result = (*player_buffer_queue_)->Enqueue(player_buffer_queue_, converted_audio.data(), static_cast<SLuint32>(pcm_size));
                 if (result != SL_RESULT_SUCCESS) {
                     LOGE("Retry failed to enqueue audio data: %d", result);
                 } else {
@@ -636,15 +825,17 @@ private:
             static auto last_play_log = std::chrono::steady_clock::now();
             auto now = std::chrono::steady_clock::now();
             if (now - last_play_log > std::chrono::seconds(5)) {
-                LOGI("Audio playback: sequence=%u, timestamp=%u, size=%u bytes", 
-                     sequence, timestamp, data_size);
+                LOGI("Audio playback: sequence=%u, timestamp=%u, size=%zu bytes", 
+                     sequence, timestamp, pcm_size);
                 last_play_log = now;
             }
         }
     }
     
     void SendAudioData(const int16_t* audio_data, size_t length) {
-        if (!running_ || muted_ || state_ != VOICE_CALL_STATE_CONNECTED) {
+        // 收到 JOIN_OK 之前没有会话ID，会话ID 0 属于房间里的其他用户，不能用来发送
+        uint32_t session_id = session_id_;
+        if (!running_ || muted_ || state_ != VOICE_CALL_STATE_CONNECTED || session_id == kUnassignedSessionId) {
             return;
         }
         
@@ -652,12 +843,18 @@ private:
         struct AudioPacket {
             uint32_t sequence;
             uint32_t timestamp;
-            uint32_t user_id;
+            uint32_t session_id;
             uint16_t data_size;
+            uint8_t payload_type;   // 0=PCM16，本端只发送PCM16
+            uint8_t flags;
             uint8_t data[1024];
         } __attribute__((packed));
         
         static uint32_t sequence = 0;
+        // 媒体时间戳，单位为采样帧，与Linux客户端保持一致
+        static uint32_t media_timestamp = 0;
+        uint32_t timestamp = media_timestamp;
+        media_timestamp += static_cast<uint32_t>(length / config_.audio_config.channels);
         
         // 限制音频数据大小（以字节为单位），与Linux客户端保持一致
         size_t data_bytes = length * sizeof(int16_t);
@@ -677,10 +874,11 @@ private:
         
         AudioPacket packet;
         packet.sequence = htonl(sequence++);
-        packet.timestamp = htonl(std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count());
-        packet.user_id = htonl(0x12345678); // 用户ID，暂时固定
+        packet.timestamp = htonl(timestamp);
+        packet.session_id = htonl(session_id); // 服务器在 JOIN_OK 中分配的会话ID
         packet.data_size = htons(data_bytes);
+        packet.payload_type = 0;   // PCM16
+        packet.flags = 0;
         
         // 复制音频数据
         memcpy(packet.data, audio_data, data_bytes);
@@ -693,6 +891,8 @@ private:
                              (struct sockaddr*)&server_addr_, sizeof(server_addr_));
         
         if (sent > 0) {
+            ++packets_sent_;
+            bytes_sent_ += sent;
             static auto last_send_log = std::chrono::steady_clock::now();
             auto now = std::chrono::steady_clock::now();
             if (now - last_send_log > std::chrono::seconds(5)) {
@@ -713,6 +913,29 @@ private:
     float speaker_volume_;
     std::atomic<bool> running_;
     
+    // 通话统计
+    std::atomic<uint64_t> packets_sent_;
+    std::atomic<uint64_t> bytes_sent_;
+    std::atomic<uint64_t> packets_received_;
+    std::atomic<uint64_t> bytes_received_;
+    
+    // 服务器分配的会话ID
+    std::atomic<uint32_t> session_id_;
+    
+    // 分片重组 (只在接收线程中使用)，按发送端的会话ID区分
+    struct FragmentAssembly {
+        uint32_t timestamp = 0;
+        uint32_t first_sequence = 0;
+        uint32_t received_mask = 0;     // 第i位表示第i个分片已收到
+        uint16_t frames = 0;
+        uint8_t count = 0;
+        uint8_t payload_type = 0;
+        std::vector<uint8_t> parts[kMaxFrameFragments];
+    };
+    std::map<uint32_t, FragmentAssembly> fragment_assemblies_;
+    std::vector<uint8_t> assembled_frame_;
+    uint64_t encrypted_packets_dropped_ = 0;   // 丢弃的加密包 (接收线程)
+    
     // OpenSL ES音频相关
     SLObjectItf engine_;
     SLEngineItf engine_interface_;
@@ -765,6 +988,15 @@ voice_call_error_t voice_call_disconnect(voice_call_handle_t handle) {
     return impl->Disconnect();
 }
 
+voice_call_error_t voice_call_switch_room(voice_call_handle_t handle, const char* room_id) {
+    if (!handle || !room_id) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    
+    AndroidVoiceCallImpl* impl = static_cast<AndroidVoiceCallImpl*>(handle);
+    return impl->SwitchRoom(room_id);
+}
+
 voice_call_state_t voice_call_get_state(voice_call_handle_t handle) {
     if (!handle) {
         return VOICE_CALL_STATE_ERROR;
@@ -822,6 +1054,15 @@ bool voice_call_is_muted(voice_call_handle_t handle) {
     return impl->IsMuted();
 }
 
+voice_call_error_t voice_call_get_stats(voice_call_handle_t handle, voice_call_stats_t* stats) {
+    if (!handle || !stats) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    
+    AndroidVoiceCallImpl* impl = static_cast<AndroidVoiceCallImpl*>(handle);
+    return impl->GetStats(stats);
+}
+
 void voice_call_destroy(voice_call_handle_t handle) {
     if (handle) {
         AndroidVoiceCallImpl* impl = static_cast<AndroidVoiceCallImpl*>(handle);
@@ -829,6 +1070,15 @@ void voice_call_destroy(voice_call_handle_t handle) {
     }
 }
 
+// 简化实现不支持帧级追踪
+voice_call_error_t voice_call_trace_start(uint32_t sample_interval) {
+    return VOICE_CALL_ERROR_NOT_SUPPORTED;
+}
+
+voice_call_error_t voice_call_trace_stop(const char* path) {
+    return VOICE_CALL_ERROR_NOT_SUPPORTED;
+}
+
 const char* voice_call_get_version(void) {
     return "1.0.0 (Android)";
 }
@@ -16,7 +16,8 @@ typedef enum {
     VOICE_CALL_ERROR_NETWORK = -3,
     VOICE_CALL_ERROR_AUDIO = -4,
     VOICE_CALL_ERROR_PEER_NOT_FOUND = -5,
-    VOICE_CALL_ERROR_ALREADY_IN_CALL = -6
+    VOICE_CALL_ERROR_ALREADY_IN_CALL = -6,
+    VOICE_CALL_ERROR_NOT_SUPPORTED = -7  // 当前平台的实现不支持该接口 (见各接口说明)
 } voice_call_error_t;
 
 // 通话状态
@@ -28,12 +29,30 @@ typedef enum {
     VOICE_CALL_STATE_ERROR
 } voice_call_state_t;
 
+// 音频与网络线程的调度策略
+typedef enum {
+    VOICE_CALL_SCHED_DEFAULT = 0,   // 普通分时调度，不修改线程优先级
+    VOICE_CALL_SCHED_FIFO,          // SCHED_FIFO 实时调度
+    VOICE_CALL_SCHED_RR             // SCHED_RR 实时调度 (同优先级轮转)
+} voice_call_sched_policy_t;
+
+// 音频设备的样点格式
+typedef enum {
+    VOICE_CALL_SAMPLE_FORMAT_AUTO = 0,  // 按 bits_per_sample 选择整数格式 (16/24/32)
+    VOICE_CALL_SAMPLE_FORMAT_S16,       // 16位整数
+    VOICE_CALL_SAMPLE_FORMAT_S24,       // 24位整数 (每个样点3字节)
+    VOICE_CALL_SAMPLE_FORMAT_S32,       // 32位整数
+    VOICE_CALL_SAMPLE_FORMAT_F32        // 32位浮点
+} voice_call_sample_format_t;
+
 // 音频配置
 typedef struct {
     int sample_rate;      // 采样率 (8000, 16000, 32000, 48000)
     int channels;         // 声道数 (1=单声道, 2=立体声)
-    int bits_per_sample;  // 位深度 (16, 24, 32)
-    int frame_size;       // 帧大小 (毫秒)
+    int bits_per_sample;  // 设备位深度 (16, 24, 32)，sample_format 为 AUTO 时生效
+    int frame_size;       // 包长 (毫秒): 10, 20, 40, 60，其他值按20处理
+    voice_call_sample_format_t sample_format; // 设备样点格式，设备不支持时依次尝试 S16、S32、S24、F32。
+                                              // 只影响设备读写，内部处理与网络负载格式不变
 } voice_call_audio_config_t;
 
 // 通话配置
@@ -45,17 +64,101 @@ typedef struct {
     bool enable_echo_cancellation;  // 回声消除
     bool enable_noise_suppression;  // 噪声抑制
     bool enable_automatic_gain_control; // 自动增益控制
+    bool enable_dtx;                // 静音期间不连续发送 (DTX)，只发送舒适噪声描述符
+    char audio_backend[256];        // 音频后端: "alsa" ("alsa:rw" 不使用 mmap)、"null"、"loopback" 或 "file:<输入>[,<输出>]"，
+                                    // 为空时读取环境变量 VOICE_CALL_AUDIO_BACKEND，都没有时使用 ALSA
+    bool use_shared_reactor;        // 不为本通话创建音频与网络线程，由进程内共享的 epoll 反应器线程驱动
+                                    // (线程数由环境变量 VOICE_CALL_REACTOR_THREADS 指定，默认为CPU核数)，
+                                    // 适合一个进程承载大量通话的网关
+    // 实时设置在线程启动时应用，没有权限 (CAP_SYS_NICE / RLIMIT_RTPRIO / RLIMIT_MEMLOCK) 时打印警告后按默认设置继续；
+    // 共享反应器模式下线程由所有通话共用，只有 lock_memory 生效
+    voice_call_sched_policy_t sched_policy; // 调度策略，默认不修改
+    int sched_priority;             // 实时优先级 (1-99)，音频线程使用该值，网络线程低一级
+    uint64_t audio_cpu_mask;        // 音频线程的CPU亲和性 (第n位对应CPU n)，0 表示不限制
+    uint64_t network_cpu_mask;      // 网络线程的CPU亲和性，0 表示不限制
+    bool lock_memory;               // mlockall 锁定进程内存，并预先触及线程栈与音频缓冲区，避免通话中缺页
+                                    // 注意: 锁定作用于整个进程且不会撤销 — mlockall(MCL_CURRENT | MCL_FUTURE) 同时
+                                    // 锁定宿主程序自己的内存，并关闭 malloc 的内存归还 (M_TRIM_THRESHOLD/M_MMAP_MAX)；
+                                    // 进程中第一个设置该字段的通话连接时执行一次，之后的通话与断开都不改变它
+    char media_key[65];             // 房间密钥 (32或64个十六进制字符，AES-128/256-GCM)，为空时不加密。
+                                    // 房间内所有成员必须使用同一密钥；配置后只接受加密的音频包，
+                                    // 包头保持明文，服务器无需密钥即可转发
+                                    // Android 的简化实现不支持加密，忽略该字段并丢弃收到的加密包
+    bool async_connect;             // voice_call_connect 发出 JOIN 后立即返回，音频设备的打开与 JOIN 握手并行；
+                                    // 收到 JOIN_OK 且设备就绪后才进入 CONNECTED，设备打开失败或等待 JOIN_OK 超时
+                                    // 时进入 ERROR 并回调 on_error。关闭时设备打开后才发送 JOIN，随即报告 CONNECTED
+    int join_timeout_ms;            // 异步连接等待 JOIN_OK 的超时 (毫秒)，0 表示默认的10秒；JOIN 按 250ms 起
+                                    // 加倍 (最长2秒) 的间隔重发
+    int device_keepalive_ms;        // 断开后保留音频设备 (暂停在已配置的状态) 的时长 (毫秒)，期间重新连接或切换房间
+                                    // 且设备参数相同时直接复用，不重新打开；0 表示默认的30秒，负数表示断开时立即关闭。
+                                    // voice_call_destroy 时关闭
 } voice_call_config_t;
 
-// 通话事件回调
+// 通话建立的耗时分解 (on_setup_complete)，时间均从 voice_call_connect 开始计
+typedef struct {
+    float total_ms;                 // 到收到 JOIN_OK 且音频设备就绪
+    float audio_open_ms;            // 打开并配置音频设备 (含处理链初始化)
+    float join_ms;                  // 第一次发送 JOIN 到收到 JOIN_OK
+    float join_rtt_ms;              // 最后一次发送 JOIN 到收到 JOIN_OK
+    uint32_t join_attempts;         // 发送 JOIN 的次数
+    bool overlapped;                // 设备打开与 JOIN 握手并行 (async_connect)
+} voice_call_setup_stats_t;
+
+// 通话事件回调。回调在库的内部线程上调用 (音频、网络或共享反应器线程)，其中不能调用
+// voice_call_disconnect 或 voice_call_destroy (它们会等待这些线程结束)。例外: 异步连接失败
+// (设备打开失败、JOIN 超时) 时的 on_state_changed(ERROR) 与 on_error 在单独的通知线程上调用，
+// 可以在其中断开或销毁通话；该通知线程不被等待，回调可能晚于 voice_call_disconnect 返回
 typedef struct {
     void (*on_state_changed)(voice_call_state_t state, const char* reason);
     void (*on_peer_joined)(const char* peer_id);
     void (*on_peer_left)(const char* peer_id);
     void (*on_audio_level)(const char* peer_id, float level);
     void (*on_error)(voice_call_error_t error, const char* message);
+    void (*on_setup_complete)(const voice_call_setup_stats_t* stats); // 每次连接收到 JOIN_OK 且设备就绪时回调一次
 } voice_call_callbacks_t;
 
+// 通话统计 (voice_call_get_stats)，计数从连接开始累计，接收侧为所有远端发送者的合计
+typedef struct {
+    // 发送
+    uint64_t packets_sent;            // 音频与舒适噪声包 (不含重传、接收报告与重传请求)
+    uint64_t bytes_sent;              // 含包头
+    uint64_t retransmits_sent;
+    uint64_t dtx_suppressed_frames;   // 静音期间没有发送的帧
+    int32_t target_bitrate;           // 码率控制的目标码率 (bps)
+    int32_t send_bitrate;             // 当前编码方式的码率 (bps)
+    int32_t fec_depth;                // 当前冗余深度
+    // 接收
+    uint64_t packets_received;        // 其他成员的音频包 (含重传)
+    uint64_t bytes_received;
+    uint64_t packets_lost;            // 没有收到的包 (冗余与重传恢复之前)
+    uint64_t packets_recovered;       // 由冗余副本恢复
+    uint64_t retransmits_recovered;   // 由重传恢复
+    uint64_t packets_reordered;       // 乱序到达
+    uint64_t packets_late;            // 晚于播放位置到达而丢弃
+    uint64_t queue_drops;             // 接收队列已满而丢弃
+    uint64_t concealed_frames;        // 播放时补静音的帧 (网络采样率)
+    uint64_t accelerated_frames;      // 队列高于目标时快放去掉的帧 (WSOLA，网络采样率)
+    uint64_t decelerated_frames;      // 队列即将取空时慢放插入的帧
+    uint64_t nack_requests;
+    uint64_t decrypt_failures;        // 认证失败、缺少密钥或未加密 (配置了 media_key 时) 而丢弃的音频包
+    uint32_t remote_streams;          // 当前的远端发送者数
+    float jitter_ms;                  // 到达间隔抖动 (各远端流的最大值，下同)
+    float rtt_ms;                     // 往返时间估计
+    float jitter_buffer_ms;           // 接收队列深度
+    // 音频设备
+    uint64_t capture_xruns;           // 捕获溢出
+    uint64_t playback_xruns;          // 播放欠载
+    // 各阶段处理耗时 (微秒)
+    float capture_process_avg_us;     // 采集处理 (回声消除、噪声抑制、增益)
+    float capture_process_max_us;
+    float encode_avg_us;              // 编码与发送
+    float encode_max_us;
+    float playback_avg_us;            // 拉取、混音与重采样
+    float playback_max_us;
+    float network_avg_us;             // 处理一个收到的包
+    float network_max_us;
+} voice_call_stats_t;
+
 // 通话句柄
 typedef void* voice_call_handle_t;
 
@@ -72,6 +175,7 @@ voice_call_handle_t voice_call_init(const voice_call_config_t* config,
 
 /**
  * 连接到通话房间
+ * async_connect 时发出 JOIN 后立即返回 (状态为 CONNECTING)，之后的结果通过 on_state_changed 与 on_error 报告
  * @param handle 通话句柄
  * @return 错误码
  */
@@ -79,11 +183,21 @@ voice_call_error_t voice_call_connect(voice_call_handle_t handle);
 
 /**
  * 断开通话连接
+ * 音频设备按 device_keepalive_ms 保留，之后的连接直接复用
  * @param handle 通话句柄
  * @return 错误码
  */
 voice_call_error_t voice_call_disconnect(voice_call_handle_t handle);
 
+/**
+ * 切换房间
+ * 已连接 (或正在连接) 时离开当前房间并按原来的连接方式加入新房间，音频设备保持打开；未连接时只修改之后连接的房间
+ * @param handle 通话句柄
+ * @param room_id 新的房间ID
+ * @return 错误码
+ */
+voice_call_error_t voice_call_switch_room(voice_call_handle_t handle, const char* room_id);
+
 /**
  * 获取当前通话状态
  * @param handle 通话句柄
@@ -140,12 +254,40 @@ voice_call_error_t voice_call_set_muted(voice_call_handle_t handle, bool muted);
  */
 bool voice_call_is_muted(voice_call_handle_t handle);
 
+/**
+ * 获取通话统计
+ * 计数由音频与网络线程无锁更新，这里读取一致的快照，可以在任意线程随时调用
+ * @param handle 通话句柄
+ * @param stats 输出的统计
+ * @return 错误码
+ */
+voice_call_error_t voice_call_get_stats(voice_call_handle_t handle, voice_call_stats_t* stats);
+
 /**
  * 销毁通话句柄
  * @param handle 通话句柄
  */
 void voice_call_destroy(voice_call_handle_t handle);
 
+/**
+ * 开始帧级追踪 (进程内所有通话)
+ * 发送端每 sample_interval 帧选一帧打上追踪标志，发送端、服务器 (udp_server --trace) 与接收端
+ * 记录这一帧的采集、编码、发送、服务器收发、接收、入队与播放时间。未开启时几乎没有开销
+ * Android 的简化实现不支持追踪，返回 VOICE_CALL_ERROR_NOT_SUPPORTED
+ * @param sample_interval 采样间隔 (帧)，1表示每帧都追踪
+ * @return 错误码
+ */
+voice_call_error_t voice_call_trace_start(uint32_t sample_interval);
+
+/**
+ * 停止帧级追踪，把本进程记录的事件导出为 Chrome trace JSON (chrome://tracing 或 Perfetto UI 打开)
+ * 与服务器导出的文件用 trace_merge 合并后得到同一时间轴上的完整路径
+ * Android 的简化实现不支持追踪，返回 VOICE_CALL_ERROR_NOT_SUPPORTED
+ * @param path 输出文件
+ * @return 错误码
+ */
+voice_call_error_t voice_call_trace_stop(const char* path);
+
 /**
  * 获取库版本信息
  * @return 版本字符串
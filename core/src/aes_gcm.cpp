@@ -0,0 +1,488 @@
+#include "aes_gcm.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AES_GCM_X86 1
+// 只有硬件路径的函数使用这些指令集，其余代码按默认目标编译，运行时检测后才调用
+#define AES_GCM_TARGET __attribute__((target("aes,pclmul,ssse3")))
+#endif
+
+namespace {
+
+inline uint32_t LoadBe32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline void StoreBe32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+inline uint64_t LoadBe64(const uint8_t* p) {
+    return (static_cast<uint64_t>(LoadBe32(p)) << 32) | LoadBe32(p + 4);
+}
+
+inline void StoreBe64(uint8_t* p, uint64_t value) {
+    StoreBe32(p, static_cast<uint32_t>(value >> 32));
+    StoreBe32(p + 4, static_cast<uint32_t>(value));
+}
+
+inline uint8_t Rotl8(uint8_t x, int shift) {
+    return static_cast<uint8_t>((x << shift) | (x >> (8 - shift)));
+}
+
+inline uint32_t Rotr32(uint32_t x, int shift) {
+    return (x >> shift) | (x << (32 - shift));
+}
+
+// S盒与T表 (进程内只计算一次)
+struct AesTables {
+    uint8_t sbox[256];
+    uint32_t te[4][256];
+
+    AesTables() {
+        // p 遍历 GF(2^8) 的非零元素 (每步乘3)，q 为其逆元 (每步除以3)，再做仿射变换
+        uint8_t p = 1;
+        uint8_t q = 1;
+        do {
+            p = static_cast<uint8_t>(p ^ (p << 1) ^ ((p & 0x80) ? 0x1b : 0));
+            q = static_cast<uint8_t>(q ^ (q << 1));
+            q = static_cast<uint8_t>(q ^ (q << 2));
+            q = static_cast<uint8_t>(q ^ (q << 4));
+            if (q & 0x80) q ^= 0x09;
+            sbox[p] = static_cast<uint8_t>(q ^ Rotl8(q, 1) ^ Rotl8(q, 2) ^ Rotl8(q, 3) ^ Rotl8(q, 4) ^ 0x63);
+        } while (p != 1);
+        sbox[0] = 0x63;
+
+        for (int i = 0; i < 256; ++i) {
+            uint32_t s = sbox[i];
+            uint32_t s2 = ((s << 1) ^ ((s & 0x80) ? 0x1b : 0)) & 0xff;
+            uint32_t s3 = s2 ^ s;
+            uint32_t word = (s2 << 24) | (s << 16) | (s << 8) | s3;
+            te[0][i] = word;
+            te[1][i] = Rotr32(word, 8);
+            te[2][i] = Rotr32(word, 16);
+            te[3][i] = Rotr32(word, 24);
+        }
+    }
+};
+
+const AesTables& Tables() {
+    static const AesTables tables;
+    return tables;
+}
+
+void SoftwareEncryptBlock(const uint32_t* rk, int rounds, const uint8_t* in, uint8_t* out) {
+    const AesTables& t = Tables();
+    uint32_t s0 = LoadBe32(in) ^ rk[0];
+    uint32_t s1 = LoadBe32(in + 4) ^ rk[1];
+    uint32_t s2 = LoadBe32(in + 8) ^ rk[2];
+    uint32_t s3 = LoadBe32(in + 12) ^ rk[3];
+    for (int round = 1; round < rounds; ++round) {
+        rk += 4;
+        uint32_t t0 = t.te[0][s0 >> 24] ^ t.te[1][(s1 >> 16) & 0xff] ^ t.te[2][(s2 >> 8) & 0xff] ^
+                      t.te[3][s3 & 0xff] ^ rk[0];
+        uint32_t t1 = t.te[0][s1 >> 24] ^ t.te[1][(s2 >> 16) & 0xff] ^ t.te[2][(s3 >> 8) & 0xff] ^
+                      t.te[3][s0 & 0xff] ^ rk[1];
+        uint32_t t2 = t.te[0][s2 >> 24] ^ t.te[1][(s3 >> 16) & 0xff] ^ t.te[2][(s0 >> 8) & 0xff] ^
+                      t.te[3][s1 & 0xff] ^ rk[2];
+        uint32_t t3 = t.te[0][s3 >> 24] ^ t.te[1][(s0 >> 16) & 0xff] ^ t.te[2][(s1 >> 8) & 0xff] ^
+                      t.te[3][s2 & 0xff] ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+    rk += 4;
+    const uint8_t* sbox = t.sbox;
+    StoreBe32(out, (static_cast<uint32_t>(sbox[s0 >> 24]) << 24) ^ (static_cast<uint32_t>(sbox[(s1 >> 16) & 0xff]) << 16) ^
+                   (static_cast<uint32_t>(sbox[(s2 >> 8) & 0xff]) << 8) ^ sbox[s3 & 0xff] ^ rk[0]);
+    StoreBe32(out + 4, (static_cast<uint32_t>(sbox[s1 >> 24]) << 24) ^ (static_cast<uint32_t>(sbox[(s2 >> 16) & 0xff]) << 16) ^
+                       (static_cast<uint32_t>(sbox[(s3 >> 8) & 0xff]) << 8) ^ sbox[s0 & 0xff] ^ rk[1]);
+    StoreBe32(out + 8, (static_cast<uint32_t>(sbox[s2 >> 24]) << 24) ^ (static_cast<uint32_t>(sbox[(s3 >> 16) & 0xff]) << 16) ^
+                       (static_cast<uint32_t>(sbox[(s0 >> 8) & 0xff]) << 8) ^ sbox[s1 & 0xff] ^ rk[2]);
+    StoreBe32(out + 12, (static_cast<uint32_t>(sbox[s3 >> 24]) << 24) ^ (static_cast<uint32_t>(sbox[(s0 >> 16) & 0xff]) << 16) ^
+                        (static_cast<uint32_t>(sbox[(s1 >> 8) & 0xff]) << 8) ^ sbox[s2 & 0xff] ^ rk[3]);
+}
+
+// 4bit查表 GHASH 每处理半字节移出的低4位对应的约简值
+const uint64_t kGhashLast4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+// 计数器块: nonce || 32位大端计数
+void CounterBlock(const uint8_t* nonce, uint32_t counter, uint8_t* block) {
+    memcpy(block, nonce, AesGcm::kNonceSize);
+    StoreBe32(block + AesGcm::kNonceSize, counter);
+}
+
+#if defined(AES_GCM_X86)
+
+AES_GCM_TARGET inline __m128i ByteSwap(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+AES_GCM_TARGET inline __m128i HardwareEncrypt1(const __m128i* rk, int rounds, __m128i block) {
+    block = _mm_xor_si128(block, _mm_load_si128(rk));
+    for (int round = 1; round < rounds; ++round) {
+        block = _mm_aesenc_si128(block, _mm_load_si128(rk + round));
+    }
+    return _mm_aesenclast_si128(block, _mm_load_si128(rk + rounds));
+}
+
+// 4个独立的块交错执行，隐藏 aesenc 的延迟
+AES_GCM_TARGET inline void HardwareEncrypt4(const __m128i* rk, int rounds, __m128i* b) {
+    __m128i key = _mm_load_si128(rk);
+    b[0] = _mm_xor_si128(b[0], key);
+    b[1] = _mm_xor_si128(b[1], key);
+    b[2] = _mm_xor_si128(b[2], key);
+    b[3] = _mm_xor_si128(b[3], key);
+    for (int round = 1; round < rounds; ++round) {
+        key = _mm_load_si128(rk + round);
+        b[0] = _mm_aesenc_si128(b[0], key);
+        b[1] = _mm_aesenc_si128(b[1], key);
+        b[2] = _mm_aesenc_si128(b[2], key);
+        b[3] = _mm_aesenc_si128(b[3], key);
+    }
+    key = _mm_load_si128(rk + rounds);
+    b[0] = _mm_aesenclast_si128(b[0], key);
+    b[1] = _mm_aesenclast_si128(b[1], key);
+    b[2] = _mm_aesenclast_si128(b[2], key);
+    b[3] = _mm_aesenclast_si128(b[3], key);
+}
+
+// 字节反序域中的无约简乘积 (256位，lo/hi)，多个乘积可以先异或再统一约简
+AES_GCM_TARGET inline void ClmulAccumulate(__m128i a, __m128i b, __m128i* lo, __m128i* hi) {
+    __m128i low = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i high = _mm_clmulepi64_si128(a, b, 0x11);
+    __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    *lo = _mm_xor_si128(*lo, _mm_xor_si128(low, _mm_slli_si128(mid, 8)));
+    *hi = _mm_xor_si128(*hi, _mm_xor_si128(high, _mm_srli_si128(mid, 8)));
+}
+
+// 256位乘积左移1位 (位反射的补偿) 后按 x^128 + x^7 + x^2 + x + 1 约简 (Intel CLMUL 白皮书算法5)
+AES_GCM_TARGET inline __m128i ClmulReduce(__m128i lo, __m128i hi) {
+    __m128i carry_lo = _mm_srli_epi32(lo, 31);
+    __m128i carry_hi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(carry_lo, 12);
+    carry_hi = _mm_slli_si128(carry_hi, 4);
+    carry_lo = _mm_slli_si128(carry_lo, 4);
+    lo = _mm_or_si128(lo, carry_lo);
+    hi = _mm_or_si128(_mm_or_si128(hi, carry_hi), cross);
+
+    __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    __m128i b = _mm_srli_si128(a, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+    __m128i c = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    c = _mm_xor_si128(c, b);
+    lo = _mm_xor_si128(lo, c);
+    return _mm_xor_si128(hi, lo);
+}
+
+AES_GCM_TARGET inline __m128i ClmulMultiply(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    ClmulAccumulate(a, b, &lo, &hi);
+    return ClmulReduce(lo, hi);
+}
+
+AES_GCM_TARGET void HardwarePowers(const uint8_t* h, uint8_t (*powers)[16]) {
+    __m128i h1 = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+    __m128i h2 = ClmulMultiply(h1, h1);
+    __m128i h3 = ClmulMultiply(h2, h1);
+    __m128i h4 = ClmulMultiply(h3, h1);
+    _mm_store_si128(reinterpret_cast<__m128i*>(powers[0]), h1);
+    _mm_store_si128(reinterpret_cast<__m128i*>(powers[1]), h2);
+    _mm_store_si128(reinterpret_cast<__m128i*>(powers[2]), h3);
+    _mm_store_si128(reinterpret_cast<__m128i*>(powers[3]), h4);
+}
+
+AES_GCM_TARGET void HardwareGhash(const uint8_t (*powers)[16], uint8_t* state, const uint8_t* data, size_t size) {
+    const __m128i h1 = _mm_load_si128(reinterpret_cast<const __m128i*>(powers[0]));
+    const __m128i h2 = _mm_load_si128(reinterpret_cast<const __m128i*>(powers[1]));
+    const __m128i h3 = _mm_load_si128(reinterpret_cast<const __m128i*>(powers[2]));
+    const __m128i h4 = _mm_load_si128(reinterpret_cast<const __m128i*>(powers[3]));
+    __m128i x = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)));
+    // 每4个块: X' = (X + B0)·H^4 + B1·H^3 + B2·H^2 + B3·H，只约简一次
+    for (; size >= 64; data += 64, size -= 64) {
+        const __m128i* blocks = reinterpret_cast<const __m128i*>(data);
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        ClmulAccumulate(_mm_xor_si128(x, ByteSwap(_mm_loadu_si128(blocks))), h4, &lo, &hi);
+        ClmulAccumulate(ByteSwap(_mm_loadu_si128(blocks + 1)), h3, &lo, &hi);
+        ClmulAccumulate(ByteSwap(_mm_loadu_si128(blocks + 2)), h2, &lo, &hi);
+        ClmulAccumulate(ByteSwap(_mm_loadu_si128(blocks + 3)), h1, &lo, &hi);
+        x = ClmulReduce(lo, hi);
+    }
+    for (; size >= 16; data += 16, size -= 16) {
+        x = ClmulMultiply(_mm_xor_si128(x, ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)))), h1);
+    }
+    if (size > 0) {
+        alignas(16) uint8_t last[16] = {0};
+        memcpy(last, data, size);
+        x = ClmulMultiply(_mm_xor_si128(x, ByteSwap(_mm_load_si128(reinterpret_cast<const __m128i*>(last)))), h1);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), ByteSwap(x));
+}
+
+AES_GCM_TARGET void HardwareCtr(const uint8_t (*round_keys)[16], int rounds, const uint8_t* nonce,
+                                const uint8_t* in, size_t size, uint8_t* out) {
+    const __m128i* rk = reinterpret_cast<const __m128i*>(round_keys);
+    uint8_t first[16];
+    CounterBlock(nonce, 2, first);
+    // 字节反序后大端计数位于最低的32位通道，直接整数加1 (与 inc32 一样按32位回绕)
+    __m128i counter = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)));
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    for (; size >= 64; in += 64, out += 64, size -= 64) {
+        __m128i blocks[4];
+        for (int i = 0; i < 4; ++i) {
+            blocks[i] = ByteSwap(counter);
+            counter = _mm_add_epi32(counter, one);
+        }
+        HardwareEncrypt4(rk, rounds, blocks);
+        for (int i = 0; i < 4; ++i) {
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, _mm_xor_si128(data, blocks[i]));
+        }
+    }
+    for (; size > 0; ) {
+        __m128i keystream = HardwareEncrypt1(rk, rounds, ByteSwap(counter));
+        counter = _mm_add_epi32(counter, one);
+        if (size >= 16) {
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_xor_si128(data, keystream));
+            in += 16;
+            out += 16;
+            size -= 16;
+        } else {
+            uint8_t stream[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(stream), keystream);
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = in[i] ^ stream[i];
+            }
+            size = 0;
+        }
+    }
+}
+
+AES_GCM_TARGET void HardwareEncryptBlock(const uint8_t (*round_keys)[16], int rounds, const uint8_t* in, uint8_t* out) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    block = HardwareEncrypt1(reinterpret_cast<const __m128i*>(round_keys), rounds, block);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), block);
+}
+
+#endif // AES_GCM_X86
+
+bool DetectHardware() {
+#if defined(AES_GCM_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+AesGcm::AesGcm()
+    : rounds_(0)
+    , hardware_(false) {
+    memset(round_words_, 0, sizeof(round_words_));
+    memset(round_keys_, 0, sizeof(round_keys_));
+    memset(h_table_high_, 0, sizeof(h_table_high_));
+    memset(h_table_low_, 0, sizeof(h_table_low_));
+    memset(h_powers_, 0, sizeof(h_powers_));
+}
+
+bool AesGcm::HardwareAvailable() {
+    static const bool available = DetectHardware();
+    return available;
+}
+
+bool AesGcm::SetKey(const uint8_t* key, size_t key_size) {
+    if (key_size != 16 && key_size != 32) {
+        return false;
+    }
+    const AesTables& t = Tables();
+    const int key_words = static_cast<int>(key_size / 4);
+    rounds_ = key_words + 6;
+    const int total_words = 4 * (rounds_ + 1);
+    for (int i = 0; i < key_words; ++i) {
+        round_words_[i] = LoadBe32(key + 4 * i);
+    }
+    uint8_t rcon = 1;
+    for (int i = key_words; i < total_words; ++i) {
+        uint32_t temp = round_words_[i - 1];
+        if (i % key_words == 0) {
+            temp = (temp << 8) | (temp >> 24);
+            temp = (static_cast<uint32_t>(t.sbox[temp >> 24]) << 24) | (static_cast<uint32_t>(t.sbox[(temp >> 16) & 0xff]) << 16) |
+                   (static_cast<uint32_t>(t.sbox[(temp >> 8) & 0xff]) << 8) | t.sbox[temp & 0xff];
+            temp ^= static_cast<uint32_t>(rcon) << 24;
+            rcon = static_cast<uint8_t>((rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0));
+        } else if (key_words > 6 && i % key_words == 4) {
+            temp = (static_cast<uint32_t>(t.sbox[temp >> 24]) << 24) | (static_cast<uint32_t>(t.sbox[(temp >> 16) & 0xff]) << 16) |
+                   (static_cast<uint32_t>(t.sbox[(temp >> 8) & 0xff]) << 8) | t.sbox[temp & 0xff];
+        }
+        round_words_[i] = round_words_[i - key_words] ^ temp;
+    }
+    for (int i = 0; i < total_words; ++i) {
+        StoreBe32(round_keys_[i / 4] + 4 * (i % 4), round_words_[i]);
+    }
+    hardware_ = HardwareAvailable();
+
+    // H = E(K, 0^128)
+    uint8_t h[16] = {0};
+    SoftwareEncryptBlock(round_words_, rounds_, h, h);
+
+    // 4bit乘法表: 第i项为 H 乘以半字节i (按GCM的位反射约定)
+    uint64_t high = LoadBe64(h);
+    uint64_t low = LoadBe64(h + 8);
+    h_table_high_[0] = 0;
+    h_table_low_[0] = 0;
+    h_table_high_[8] = high;
+    h_table_low_[8] = low;
+    for (int i = 4; i > 0; i >>= 1) {
+        uint64_t reduce = (low & 1) ? 0xe100000000000000ULL : 0;
+        low = (high << 63) | (low >> 1);
+        high = (high >> 1) ^ reduce;
+        h_table_high_[i] = high;
+        h_table_low_[i] = low;
+    }
+    for (int i = 2; i <= 8; i *= 2) {
+        for (int j = 1; j < i; ++j) {
+            h_table_high_[i + j] = h_table_high_[i] ^ h_table_high_[j];
+            h_table_low_[i + j] = h_table_low_[i] ^ h_table_low_[j];
+        }
+    }
+#if defined(AES_GCM_X86)
+    if (hardware_) {
+        HardwarePowers(h, h_powers_);
+    }
+#endif
+    return true;
+}
+
+void AesGcm::EncryptBlock(const uint8_t* in, uint8_t* out) const {
+#if defined(AES_GCM_X86)
+    if (hardware_) {
+        HardwareEncryptBlock(round_keys_, rounds_, in, out);
+        return;
+    }
+#endif
+    SoftwareEncryptBlock(round_words_, rounds_, in, out);
+}
+
+// x = x·H (4bit查表，按字节从后往前，每个半字节移位一次并约简)
+void AesGcm::GhashMultiply(uint8_t* x) const {
+    uint8_t nibble = x[15] & 0xf;
+    uint64_t high = h_table_high_[nibble];
+    uint64_t low = h_table_low_[nibble];
+    for (int i = 15; i >= 0; --i) {
+        uint8_t lo_nibble = x[i] & 0xf;
+        uint8_t hi_nibble = x[i] >> 4;
+        if (i != 15) {
+            uint8_t rem = low & 0xf;
+            low = (high << 60) | (low >> 4);
+            high = (high >> 4) ^ (kGhashLast4[rem] << 48);
+            high ^= h_table_high_[lo_nibble];
+            low ^= h_table_low_[lo_nibble];
+        }
+        uint8_t rem = low & 0xf;
+        low = (high << 60) | (low >> 4);
+        high = (high >> 4) ^ (kGhashLast4[rem] << 48);
+        high ^= h_table_high_[hi_nibble];
+        low ^= h_table_low_[hi_nibble];
+    }
+    StoreBe64(x, high);
+    StoreBe64(x + 8, low);
+}
+
+// 吸收 data (最后不足一块时补0)，state 为16字节的当前 GHASH 值
+void AesGcm::Ghash(uint8_t* state, const uint8_t* data, size_t size) const {
+#if defined(AES_GCM_X86)
+    if (hardware_) {
+        HardwareGhash(h_powers_, state, data, size);
+        return;
+    }
+#endif
+    while (size > 0) {
+        size_t length = size < kBlockSize ? size : kBlockSize;
+        for (size_t i = 0; i < length; ++i) {
+            state[i] ^= data[i];
+        }
+        GhashMultiply(state);
+        data += length;
+        size -= length;
+    }
+}
+
+// 计数器模式: 第一个数据块使用计数值2 (计数值1的块用于加密标签)
+void AesGcm::Ctr(const uint8_t* nonce, const uint8_t* in, size_t size, uint8_t* out) const {
+#if defined(AES_GCM_X86)
+    if (hardware_) {
+        HardwareCtr(round_keys_, rounds_, nonce, in, size, out);
+        return;
+    }
+#endif
+    uint8_t counter[16];
+    uint8_t stream[16];
+    uint32_t value = 2;
+    while (size > 0) {
+        CounterBlock(nonce, value++, counter);
+        SoftwareEncryptBlock(round_words_, rounds_, counter, stream);
+        size_t length = size < kBlockSize ? size : kBlockSize;
+        for (size_t i = 0; i < length; ++i) {
+            out[i] = in[i] ^ stream[i];
+        }
+        in += length;
+        out += length;
+        size -= length;
+    }
+}
+
+void AesGcm::ComputeTag(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+                        const uint8_t* ciphertext, size_t size, uint8_t* tag) const {
+    uint8_t state[16] = {0};
+    Ghash(state, aad, aad_size);
+    Ghash(state, ciphertext, size);
+    uint8_t lengths[16];
+    StoreBe64(lengths, static_cast<uint64_t>(aad_size) * 8);
+    StoreBe64(lengths + 8, static_cast<uint64_t>(size) * 8);
+    Ghash(state, lengths, sizeof(lengths));
+
+    uint8_t j0[16];
+    CounterBlock(nonce, 1, j0);
+    EncryptBlock(j0, j0);
+    for (size_t i = 0; i < kTagSize; ++i) {
+        tag[i] = state[i] ^ j0[i];
+    }
+}
+
+void AesGcm::Seal(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+                  const uint8_t* in, size_t size, uint8_t* out, uint8_t* tag) const {
+    Ctr(nonce, in, size, out);
+    ComputeTag(nonce, aad, aad_size, out, size, tag);
+}
+
+bool AesGcm::Open(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+                  const uint8_t* in, size_t size, uint8_t* out, const uint8_t* tag) const {
+    uint8_t expected[kTagSize];
+    ComputeTag(nonce, aad, aad_size, in, size, expected);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < kTagSize; ++i) {
+        diff |= expected[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        return false;
+    }
+    Ctr(nonce, in, size, out);
+    return true;
+}
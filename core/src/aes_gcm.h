@@ -0,0 +1,57 @@
+#ifndef AES_GCM_H
+#define AES_GCM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// AES-GCM 认证加密 (NIST SP 800-38D)，128/256位密钥，96位nonce，128位认证标签
+// x86 上 CPU 支持 AES-NI 与 PCLMULQDQ 时使用硬件指令 (运行时检测，不依赖编译选项):
+// 计数器模式每次交错加密4个块，GHASH 每4个块用 H^4..H 的预计算幂只做一次约简；
+// 不支持时使用T表 AES 与4bit查表 GHASH。两种实现的输出完全相同
+class AesGcm {
+public:
+    static const size_t kNonceSize = 12;
+    static const size_t kTagSize = 16;
+    static const size_t kBlockSize = 16;
+
+    AesGcm();
+
+    // key_size 为16或32字节，其他长度返回false
+    bool SetKey(const uint8_t* key, size_t key_size);
+
+    // 加密一个块 (ECB)，用于密钥派生
+    void EncryptBlock(const uint8_t* in, uint8_t* out) const;
+
+    // 加密 size 字节 (in 与 out 可以相同)，认证 aad 与密文，tag 写入16字节标签
+    void Seal(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+              const uint8_t* in, size_t size, uint8_t* out, uint8_t* tag) const;
+
+    // 先校验标签 (常数时间比较)，通过后解密 (in 与 out 可以相同)；校验失败返回false，out 不被写入
+    bool Open(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+              const uint8_t* in, size_t size, uint8_t* out, const uint8_t* tag) const;
+
+    // 之后的运算使用查表实现 (基准测试对比用)
+    void DisableHardware() { hardware_ = false; }
+    bool UsesHardware() const { return hardware_; }
+
+    // 当前CPU是否支持 AES-NI 与 PCLMULQDQ
+    static bool HardwareAvailable();
+
+private:
+    void ComputeTag(const uint8_t* nonce, const uint8_t* aad, size_t aad_size,
+                    const uint8_t* ciphertext, size_t size, uint8_t* tag) const;
+    void Ctr(const uint8_t* nonce, const uint8_t* in, size_t size, uint8_t* out) const;
+    void Ghash(uint8_t* state, const uint8_t* data, size_t size) const;
+    void GhashMultiply(uint8_t* x) const;
+
+    int rounds_;
+    bool hardware_;
+    uint32_t round_words_[60];                    // 扩展密钥 (大端字)，查表实现使用
+    alignas(16) uint8_t round_keys_[15][16];      // 同一扩展密钥的字节形式，AES-NI 使用
+    // GHASH: 查表实现的 H 的4bit乘法表 (高/低64位)；硬件实现为字节反序的 H、H^2、H^3、H^4
+    uint64_t h_table_high_[16];
+    uint64_t h_table_low_[16];
+    alignas(16) uint8_t h_powers_[4][16];
+};
+
+#endif // AES_GCM_H
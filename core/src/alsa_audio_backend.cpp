@@ -0,0 +1,409 @@
+#include "alsa_audio_backend.h"
+
+#include <cerrno>
+#include <iostream>
+
+namespace {
+
+snd_pcm_format_t ToAlsaFormat(SampleFormat format) {
+    switch (format) {
+    case kSampleS24: return SND_PCM_FORMAT_S24_3LE;
+    case kSampleS32: return SND_PCM_FORMAT_S32_LE;
+    case kSampleF32: return SND_PCM_FORMAT_FLOAT_LE;
+    default: return SND_PCM_FORMAT_S16_LE;
+    }
+}
+
+// 请求的格式不可用时的回退顺序: S16 无需转换，其次是精度不损失的格式
+const SampleFormat kFallbackFormats[] = {kSampleS16, kSampleS32, kSampleS24, kSampleF32};
+
+// 等待设备缓冲区中有 frames 帧可读 (采集) 或可写 (播放)，返回可用帧数或负的错误码。
+// 与 readi/writei 一样，阻塞模式下数据或空间不够时在这里等待
+snd_pcm_sframes_t WaitAvail(snd_pcm_t* handle, snd_pcm_uframes_t frames) {
+    while (true) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+        if (avail < 0 || static_cast<snd_pcm_uframes_t>(avail) >= frames) {
+            return avail;
+        }
+        int err = snd_pcm_wait(handle, 1000);
+        if (err < 0) {
+            return err;
+        }
+        if (err == 0) {
+            return -EIO;
+        }
+    }
+}
+
+// 交错访问时第一个声道的区域即整帧数据
+uint8_t* AreaAddress(const snd_pcm_channel_area_t* areas, snd_pcm_uframes_t offset) {
+    return static_cast<uint8_t*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+}
+
+} // namespace
+
+AlsaAudioBackend::AlsaAudioBackend(bool use_mmap)
+    : capture_handle_(nullptr)
+    , playback_handle_(nullptr)
+    , use_mmap_(use_mmap)
+    , capture_mmap_(false)
+    , playback_mmap_(false)
+    , capture_offset_(0)
+    , playback_offset_(0)
+    , capture_rate_(0)
+    , playback_rate_(0)
+    , channels_(0)
+    , requested_format_(kSampleS16)
+    , capture_format_(kSampleS16)
+    , playback_format_(kSampleS16)
+    , capture_conversion_(nullptr)
+    , playback_conversion_(nullptr) {
+}
+
+AlsaAudioBackend::~AlsaAudioBackend() {
+    Close();
+}
+
+bool AlsaAudioBackend::OpenDevice(snd_pcm_t** handle, snd_pcm_stream_t stream, const char* name) {
+    int err = snd_pcm_open(handle, "default", stream, 0);
+    if (err < 0) {
+        std::cerr << "Failed to open audio " << name << " device: " << snd_strerror(err) << std::endl;
+        std::cerr << "Trying to use 'hw:0,0'..." << std::endl;
+
+        // 尝试使用硬件设备
+        err = snd_pcm_open(handle, "hw:0,0", stream, 0);
+        if (err < 0) {
+            std::cerr << "Failed to open hardware audio " << name << " device: " << snd_strerror(err) << std::endl;
+            *handle = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AlsaAudioBackend::ConfigureDevice(snd_pcm_t* handle, const char* name, unsigned int* rate, int channels,
+                                       SampleFormat* format, snd_pcm_uframes_t* buffer_frames, bool* mmap) {
+    snd_pcm_hw_params_t* hw_params;
+    snd_pcm_hw_params_alloca(&hw_params);
+
+    snd_pcm_hw_params_any(handle, hw_params);
+    // mmap 访问时直接读写设备缓冲区，省去 readi/writei 在内核与用户缓冲区之间的复制；不支持时回退
+    *mmap = *mmap && snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!*mmap) {
+        snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    SampleFormat chosen = *format;
+    if (snd_pcm_hw_params_test_format(handle, hw_params, ToAlsaFormat(chosen)) < 0) {
+        for (SampleFormat fallback : kFallbackFormats) {
+            if (snd_pcm_hw_params_test_format(handle, hw_params, ToAlsaFormat(fallback)) == 0) {
+                chosen = fallback;
+                break;
+            }
+        }
+        if (chosen != *format) {
+            std::cerr << "ALSA " << name << " does not support " << SampleFormatName(*format)
+                      << ", using " << SampleFormatName(chosen) << std::endl;
+        }
+    }
+    *format = chosen;
+    snd_pcm_hw_params_set_format(handle, hw_params, ToAlsaFormat(chosen));
+    snd_pcm_hw_params_set_channels(handle, hw_params, channels);
+
+    // 设备不支持网络采样率时取最接近的采样率，由重采样器补偿
+    int err = snd_pcm_hw_params_set_rate_near(handle, hw_params, rate, 0);
+    if (err < 0) {
+        std::cerr << "Failed to set " << name << " sample rate: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+
+    // 周期20ms (按帧计)，缓冲区4个周期 (80ms)，减少欠载
+    snd_pcm_uframes_t period_size = *rate / 50;
+    snd_pcm_uframes_t buffer_size = period_size * 4;
+
+    // 设置缓冲区大小
+    err = snd_pcm_hw_params_set_buffer_size(handle, hw_params, buffer_size);
+    if (err < 0) {
+        std::cerr << "Failed to set " << name << " buffer size: " << snd_strerror(err) << std::endl;
+        // 尝试使用默认值
+        snd_pcm_hw_params_set_buffer_size_near(handle, hw_params, &buffer_size);
+    }
+
+    // 设置周期大小
+    err = snd_pcm_hw_params_set_period_size(handle, hw_params, period_size, 0);
+    if (err < 0) {
+        std::cerr << "Failed to set " << name << " period size: " << snd_strerror(err) << std::endl;
+        // 尝试使用默认值
+        snd_pcm_hw_params_set_period_size_near(handle, hw_params, &period_size, 0);
+    }
+
+    err = snd_pcm_hw_params(handle, hw_params);
+    if (err < 0) {
+        std::cerr << "Failed to set " << name << " parameters: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    // 设备只支持相近的值时以实际生效的为准
+    snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_size);
+    snd_pcm_hw_params_get_period_size(hw_params, &period_size, 0);
+
+    // 准备音频设备
+    err = snd_pcm_prepare(handle);
+    if (err < 0) {
+        std::cerr << "Failed to prepare " << name << " device: " << snd_strerror(err) << std::endl;
+    }
+
+    std::cout << "ALSA " << name << ": " << *rate << " Hz, " << SampleFormatName(chosen) << ", "
+              << (*mmap ? "mmap" : "rw") << ", buffer size "
+              << buffer_size << " frames, period size " << period_size << " frames" << std::endl;
+    *buffer_frames = buffer_size;
+    return true;
+}
+
+bool AlsaAudioBackend::Open(unsigned int sample_rate, int channels) {
+    if (!OpenDevice(&capture_handle_, SND_PCM_STREAM_CAPTURE, "capture")) {
+        return false;
+    }
+    if (!OpenDevice(&playback_handle_, SND_PCM_STREAM_PLAYBACK, "playback")) {
+        Close();
+        return false;
+    }
+
+    // 播放设备采样率可能与捕获设备不同，各自按实际采样率计算缓冲区
+    capture_rate_ = sample_rate;
+    playback_rate_ = sample_rate;
+    capture_format_ = requested_format_;
+    playback_format_ = requested_format_;
+    capture_mmap_ = use_mmap_;
+    playback_mmap_ = use_mmap_;
+    snd_pcm_uframes_t capture_frames = 0;
+    snd_pcm_uframes_t playback_frames = 0;
+    if (!ConfigureDevice(capture_handle_, "capture", &capture_rate_, channels, &capture_format_, &capture_frames,
+                         &capture_mmap_) ||
+        !ConfigureDevice(playback_handle_, "playback", &playback_rate_, channels, &playback_format_, &playback_frames,
+                         &playback_mmap_)) {
+        Close();
+        return false;
+    }
+
+    // 转换用的字节缓冲区按整个设备缓冲区预先分配，读写时只有超过该长度才会扩容；mmap 访问时直接在设备缓冲区转换
+    channels_ = channels;
+    capture_conversion_ = &GetSampleConversion(capture_format_, channels);
+    playback_conversion_ = &GetSampleConversion(playback_format_, channels);
+    if (!capture_mmap_ && capture_format_ != kSampleS16) {
+        capture_bytes_.resize(capture_frames * channels * SampleFormatBytes(capture_format_));
+    }
+    if (!playback_mmap_ && playback_format_ != kSampleS16) {
+        playback_bytes_.resize(playback_frames * channels * SampleFormatBytes(playback_format_));
+    }
+    return true;
+}
+
+void AlsaAudioBackend::Close() {
+    if (capture_handle_) {
+        snd_pcm_close(capture_handle_);
+        capture_handle_ = nullptr;
+    }
+    if (playback_handle_) {
+        snd_pcm_close(playback_handle_);
+        playback_handle_ = nullptr;
+    }
+}
+
+bool AlsaAudioBackend::Suspend() {
+    if (!capture_handle_ || !playback_handle_) {
+        return false;
+    }
+    // drop 立即停止并丢弃缓冲区中的数据，prepare 之后与刚配置完一样等待开始
+    for (snd_pcm_t* handle : {capture_handle_, playback_handle_}) {
+        snd_pcm_drop(handle);
+        int err = snd_pcm_prepare(handle);
+        if (err < 0) {
+            std::cerr << "Failed to prepare suspended audio device: " << snd_strerror(err) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void AlsaAudioBackend::Start() {
+    if (snd_pcm_state(capture_handle_) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(capture_handle_);
+    }
+}
+
+long AlsaAudioBackend::Read(int16_t* pcm, size_t frames) {
+    if (capture_mmap_) {
+        return MmapRead(pcm, frames);
+    }
+    if (capture_format_ == kSampleS16) {
+        snd_pcm_sframes_t result = snd_pcm_readi(capture_handle_, pcm, frames);
+        if (result < 0) {
+            snd_pcm_recover(capture_handle_, result, 0);
+        }
+        return result;
+    }
+
+    size_t bytes = frames * channels_ * SampleFormatBytes(capture_format_);
+    if (capture_bytes_.size() < bytes) {
+        capture_bytes_.resize(bytes);
+    }
+    snd_pcm_sframes_t result = snd_pcm_readi(capture_handle_, capture_bytes_.data(), frames);
+    if (result < 0) {
+        snd_pcm_recover(capture_handle_, result, 0);
+        return result;
+    }
+    capture_conversion_->to_s16(capture_bytes_.data(), pcm, static_cast<size_t>(result), channels_);
+    return result;
+}
+
+long AlsaAudioBackend::Write(const int16_t* pcm, size_t frames) {
+    if (playback_mmap_) {
+        return MmapWrite(pcm, frames);
+    }
+    const void* data = pcm;
+    if (playback_format_ != kSampleS16) {
+        size_t bytes = frames * channels_ * SampleFormatBytes(playback_format_);
+        if (playback_bytes_.size() < bytes) {
+            playback_bytes_.resize(bytes);
+        }
+        playback_conversion_->from_s16(pcm, playback_bytes_.data(), frames, channels_);
+        data = playback_bytes_.data();
+    }
+    snd_pcm_sframes_t result = snd_pcm_writei(playback_handle_, data, frames);
+    if (result < 0) {
+        snd_pcm_recover(playback_handle_, result, 0);
+    }
+    return result;
+}
+
+long AlsaAudioBackend::MmapRead(int16_t* pcm, size_t frames) {
+    // readi 会自动开始采集，mmap 访问需要显式开始
+    if (snd_pcm_state(capture_handle_) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(capture_handle_);
+    }
+    size_t done = 0;
+    while (done < frames) {
+        const snd_pcm_channel_area_t* areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t chunk = frames - done;
+        snd_pcm_sframes_t result = WaitAvail(capture_handle_, chunk);
+        if (result >= 0) {
+            result = snd_pcm_mmap_begin(capture_handle_, &areas, &offset, &chunk);
+        }
+        if (result >= 0) {
+            // 设备缓冲区回绕时分两段
+            capture_conversion_->to_s16(AreaAddress(areas, offset), pcm + done * channels_, chunk, channels_);
+            result = snd_pcm_mmap_commit(capture_handle_, offset, chunk);
+            if (result >= 0 && static_cast<snd_pcm_uframes_t>(result) != chunk) {
+                result = -EPIPE;
+            }
+        }
+        if (result < 0) {
+            snd_pcm_recover(capture_handle_, result, 0);
+            return result;
+        }
+        done += chunk;
+    }
+    return static_cast<long>(done);
+}
+
+long AlsaAudioBackend::MmapWrite(const int16_t* pcm, size_t frames) {
+    size_t done = 0;
+    while (done < frames) {
+        const snd_pcm_channel_area_t* areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t chunk = frames - done;
+        snd_pcm_sframes_t result = WaitAvail(playback_handle_, chunk);
+        if (result >= 0) {
+            result = snd_pcm_mmap_begin(playback_handle_, &areas, &offset, &chunk);
+        }
+        if (result >= 0) {
+            playback_conversion_->from_s16(pcm + done * channels_, AreaAddress(areas, offset), chunk, channels_);
+            result = snd_pcm_mmap_commit(playback_handle_, offset, chunk);
+            if (result >= 0 && static_cast<snd_pcm_uframes_t>(result) != chunk) {
+                result = -EPIPE;
+            }
+        }
+        if (result < 0) {
+            snd_pcm_recover(playback_handle_, result, 0);
+            return result;
+        }
+        done += chunk;
+    }
+    // 与 writei 一样写入数据后开始播放
+    if (snd_pcm_state(playback_handle_) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(playback_handle_);
+    }
+    return static_cast<long>(done);
+}
+
+int16_t* AlsaAudioBackend::BeginDirect(snd_pcm_t* handle, size_t frames, snd_pcm_uframes_t* offset) {
+    if (WaitAvail(handle, frames) < 0) {
+        return nullptr;
+    }
+    const snd_pcm_channel_area_t* areas = nullptr;
+    snd_pcm_uframes_t contiguous = frames;
+    if (snd_pcm_mmap_begin(handle, &areas, offset, &contiguous) < 0) {
+        return nullptr;
+    }
+    if (contiguous < frames || areas[0].step != 16u * channels_) {
+        // 区域在设备缓冲区末尾回绕，放弃本次直接访问
+        snd_pcm_mmap_commit(handle, *offset, 0);
+        return nullptr;
+    }
+    return reinterpret_cast<int16_t*>(AreaAddress(areas, *offset));
+}
+
+const int16_t* AlsaAudioBackend::BeginCapture(size_t frames) {
+    if (!capture_mmap_ || capture_format_ != kSampleS16) {
+        return nullptr;
+    }
+    if (snd_pcm_state(capture_handle_) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(capture_handle_);
+    }
+    return BeginDirect(capture_handle_, frames, &capture_offset_);
+}
+
+long AlsaAudioBackend::CommitCapture(size_t frames) {
+    snd_pcm_sframes_t result = snd_pcm_mmap_commit(capture_handle_, capture_offset_, frames);
+    if (result >= 0 && static_cast<size_t>(result) != frames) {
+        result = -EPIPE;
+    }
+    if (result < 0) {
+        snd_pcm_recover(capture_handle_, result, 0);
+    }
+    return result;
+}
+
+int16_t* AlsaAudioBackend::BeginPlayback(size_t frames) {
+    if (!playback_mmap_ || playback_format_ != kSampleS16) {
+        return nullptr;
+    }
+    return BeginDirect(playback_handle_, frames, &playback_offset_);
+}
+
+long AlsaAudioBackend::CommitPlayback(size_t frames) {
+    snd_pcm_sframes_t result = snd_pcm_mmap_commit(playback_handle_, playback_offset_, frames);
+    if (result >= 0 && static_cast<size_t>(result) != frames) {
+        result = -EPIPE;
+    }
+    if (result < 0) {
+        snd_pcm_recover(playback_handle_, result, 0);
+        return result;
+    }
+    if (snd_pcm_state(playback_handle_) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(playback_handle_);
+    }
+    return result;
+}
+
+long AlsaAudioBackend::GetCaptureDelay() {
+    snd_pcm_sframes_t delay = 0;
+    if (snd_pcm_delay(capture_handle_, &delay) < 0) delay = 0;
+    return delay;
+}
+
+long AlsaAudioBackend::GetPlaybackDelay() {
+    snd_pcm_sframes_t delay = 0;
+    if (snd_pcm_delay(playback_handle_, &delay) < 0) delay = 0;
+    return delay;
+}
@@ -0,0 +1,71 @@
+#ifndef ALSA_AUDIO_BACKEND_H
+#define ALSA_AUDIO_BACKEND_H
+
+#include <alsa/asoundlib.h>
+
+#include <vector>
+
+#include "audio_backend.h"
+
+// ALSA 后端: 打开默认设备 (失败时尝试 hw:0,0)，约80ms缓冲区、20ms周期的交错读写。
+// 默认使用 mmap 访问 (设备不支持时回退到 readi/writei)，Read/Write 在设备缓冲区与调用方的缓冲区之间
+// 直接复制或转换格式，BeginCapture/BeginPlayback 让调用方直接读写设备缓冲区。
+// RW 访问且设备格式不是S16时，读写经过按 (格式, 声道数) 选出的转换内核与字节缓冲区
+class AlsaAudioBackend : public AudioBackend {
+public:
+    // use_mmap 为 false 时只使用 readi/writei (后端 "alsa:rw")
+    explicit AlsaAudioBackend(bool use_mmap = true);
+    ~AlsaAudioBackend() override;
+
+    void SetSampleFormat(SampleFormat format) override { requested_format_ = format; }
+    bool Open(unsigned int sample_rate, int channels) override;
+    void Close() override;
+    bool Suspend() override;
+    void Start() override;
+
+    unsigned int GetCaptureRate() const override { return capture_rate_; }
+    unsigned int GetPlaybackRate() const override { return playback_rate_; }
+
+    long Read(int16_t* pcm, size_t frames) override;
+    long Write(const int16_t* pcm, size_t frames) override;
+
+    const int16_t* BeginCapture(size_t frames) override;
+    long CommitCapture(size_t frames) override;
+    int16_t* BeginPlayback(size_t frames) override;
+    long CommitPlayback(size_t frames) override;
+
+    long GetCaptureDelay() override;
+    long GetPlaybackDelay() override;
+
+    const char* GetName() const override { return "alsa"; }
+
+private:
+    bool OpenDevice(snd_pcm_t** handle, snd_pcm_stream_t stream, const char* name);
+    bool ConfigureDevice(snd_pcm_t* handle, const char* name, unsigned int* rate, int channels,
+                         SampleFormat* format, snd_pcm_uframes_t* buffer_frames, bool* mmap);
+    // 取得设备缓冲区中接下来 frames 帧连续的交错S16区域，不满足时返回 nullptr
+    int16_t* BeginDirect(snd_pcm_t* handle, size_t frames, snd_pcm_uframes_t* offset);
+    long MmapRead(int16_t* pcm, size_t frames);
+    long MmapWrite(const int16_t* pcm, size_t frames);
+
+    snd_pcm_t* capture_handle_;
+    snd_pcm_t* playback_handle_;
+    bool use_mmap_;
+    bool capture_mmap_;     // 各方向实际的访问方式
+    bool playback_mmap_;
+    snd_pcm_uframes_t capture_offset_;      // BeginCapture/BeginPlayback 取得的区域在设备缓冲区中的位置
+    snd_pcm_uframes_t playback_offset_;
+    unsigned int capture_rate_;
+    unsigned int playback_rate_;
+    int channels_;
+    SampleFormat requested_format_;
+    // 各方向实际使用的格式与转换内核，S16 时直接读写调用方的缓冲区
+    SampleFormat capture_format_;
+    SampleFormat playback_format_;
+    const SampleConversion* capture_conversion_;
+    const SampleConversion* playback_conversion_;
+    std::vector<uint8_t> capture_bytes_;
+    std::vector<uint8_t> playback_bytes_;
+};
+
+#endif // ALSA_AUDIO_BACKEND_H
@@ -0,0 +1,452 @@
+#include "audio_backend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef VOICE_CALL_HAVE_ALSA
+#include "alsa_audio_backend.h"
+#endif
+
+namespace {
+
+// 模拟设备的缓冲区长度 (毫秒)，与 ALSA 后端的配置相同
+const unsigned int kDeviceBufferMs = 80;
+
+// 按系统时钟模拟一个方向的设备节拍，第一次读写时开始计时
+class DeviceClock {
+public:
+    DeviceClock() : rate_(0), buffer_frames_(0), running_(false), position_(0) {}
+
+    void Configure(unsigned int rate) {
+        rate_ = rate;
+        buffer_frames_ = static_cast<uint64_t>(rate) * kDeviceBufferMs / 1000;
+        running_ = false;
+        position_ = 0;
+    }
+
+    // 开始计时，已开始时不变
+    void Start() {
+        if (!running_) {
+            running_ = true;
+            start_ = std::chrono::steady_clock::now();
+            position_ = 0;
+        }
+    }
+
+    // 采集: 等待 frames 帧采集完成；读取落后超过一个缓冲区时溢出，返回 false 并丢弃积压的数据
+    bool WaitCapture(size_t frames) {
+        Start();
+        uint64_t elapsed = Elapsed();
+        if (elapsed > position_ + buffer_frames_) {
+            position_ = elapsed;
+            return false;
+        }
+        position_ += frames;
+        std::this_thread::sleep_until(TimeAt(position_));
+        return true;
+    }
+
+    // 播放: 缓冲区中已有一个缓冲区的数据时等待；已写入的数据播放完毕 (欠载) 时返回 false 并重新开始
+    bool WaitPlayback(size_t frames) {
+        Start();
+        uint64_t elapsed = Elapsed();
+        if (position_ < elapsed) {
+            running_ = false;
+            position_ = 0;
+            return false;
+        }
+        if (position_ + frames > elapsed + buffer_frames_) {
+            std::this_thread::sleep_until(TimeAt(position_ + frames - buffer_frames_));
+        }
+        position_ += frames;
+        return true;
+    }
+
+    // 采集: 已采集未读取的帧数；播放: 已写入未播放的帧数
+    long CaptureDelay() const {
+        if (!running_) return 0;
+        uint64_t elapsed = Elapsed();
+        return elapsed > position_ ? static_cast<long>(elapsed - position_) : 0;
+    }
+    long PlaybackDelay() const {
+        if (!running_) return 0;
+        uint64_t elapsed = Elapsed();
+        return position_ > elapsed ? static_cast<long>(position_ - elapsed) : 0;
+    }
+
+private:
+    uint64_t Elapsed() const {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) *
+               rate_ / 1000000;
+    }
+    std::chrono::steady_clock::time_point TimeAt(uint64_t position) const {
+        return start_ + std::chrono::microseconds(position * 1000000 / rate_);
+    }
+
+    unsigned int rate_;
+    uint64_t buffer_frames_;
+    bool running_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t position_;   // 已读取/已写入的帧数
+};
+
+// 无声卡后端的公共部分: 采集和播放各自按系统时钟节拍
+class PacedAudioBackend : public AudioBackend {
+public:
+    PacedAudioBackend() : capture_rate_(0), playback_rate_(0), channels_(0) {}
+
+    void Start() override { capture_clock_.Start(); }
+
+    // 两个方向的节拍回到未开始的状态
+    bool Suspend() override {
+        capture_clock_.Configure(capture_rate_);
+        playback_clock_.Configure(playback_rate_);
+        return true;
+    }
+
+    unsigned int GetCaptureRate() const override { return capture_rate_; }
+    unsigned int GetPlaybackRate() const override { return playback_rate_; }
+
+    long Read(int16_t* pcm, size_t frames) override {
+        if (!capture_clock_.WaitCapture(frames)) {
+            return -EPIPE;
+        }
+        Capture(pcm, frames);
+        return static_cast<long>(frames);
+    }
+
+    long Write(const int16_t* pcm, size_t frames) override {
+        if (!playback_clock_.WaitPlayback(frames)) {
+            return -EPIPE;
+        }
+        Play(pcm, frames);
+        return static_cast<long>(frames);
+    }
+
+    long GetCaptureDelay() override { return capture_clock_.CaptureDelay(); }
+    long GetPlaybackDelay() override { return playback_clock_.PlaybackDelay(); }
+
+protected:
+    void ConfigureClocks(unsigned int capture_rate, unsigned int playback_rate, int channels) {
+        capture_rate_ = capture_rate;
+        playback_rate_ = playback_rate;
+        channels_ = channels;
+        capture_clock_.Configure(capture_rate);
+        playback_clock_.Configure(playback_rate);
+    }
+
+    // 产生采集数据/消费播放数据 (节拍已由基类处理)
+    virtual void Capture(int16_t* pcm, size_t frames) = 0;
+    virtual void Play(const int16_t* pcm, size_t frames) = 0;
+
+    unsigned int capture_rate_;
+    unsigned int playback_rate_;
+    int channels_;
+
+private:
+    DeviceClock capture_clock_;
+    DeviceClock playback_clock_;
+};
+
+// 静音采集，播放数据直接丢弃
+class NullAudioBackend : public PacedAudioBackend {
+public:
+    bool Open(unsigned int sample_rate, int channels) override {
+        ConfigureClocks(sample_rate, sample_rate, channels);
+        return true;
+    }
+    void Close() override {}
+    const char* GetName() const override { return "null"; }
+
+protected:
+    void Capture(int16_t* pcm, size_t frames) override {
+        std::fill(pcm, pcm + frames * channels_, 0);
+    }
+    void Play(const int16_t*, size_t) override {}
+};
+
+// 播放的数据回到采集
+class LoopbackAudioBackend : public PacedAudioBackend {
+public:
+    bool Open(unsigned int sample_rate, int channels) override {
+        ConfigureClocks(sample_rate, sample_rate, channels);
+        pending_.clear();
+        return true;
+    }
+    void Close() override { pending_.clear(); }
+    bool Suspend() override {
+        pending_.clear();
+        return PacedAudioBackend::Suspend();
+    }
+    const char* GetName() const override { return "loopback"; }
+
+protected:
+    void Capture(int16_t* pcm, size_t frames) override {
+        size_t available = std::min(pending_.size(), frames * channels_);
+        std::copy(pending_.begin(), pending_.begin() + available, pcm);
+        pending_.erase(pending_.begin(), pending_.begin() + available);
+        std::fill(pcm + available, pcm + frames * channels_, 0);
+    }
+    void Play(const int16_t* pcm, size_t frames) override {
+        pending_.insert(pending_.end(), pcm, pcm + frames * channels_);
+        // 静音 (不读取采集) 期间只保留最近几个缓冲区
+        size_t limit = static_cast<size_t>(playback_rate_) * kDeviceBufferMs / 1000 * 4 * channels_;
+        if (pending_.size() > limit) {
+            pending_.erase(pending_.begin(), pending_.begin() + (pending_.size() - limit));
+        }
+    }
+
+private:
+    std::deque<int16_t> pending_;
+};
+
+uint32_t ReadLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+uint16_t ReadLe16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+void WriteLe32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+void WriteLe16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+bool HasWavExtension(const std::string& path) {
+    return path.size() >= 4 && (path.compare(path.size() - 4, 4, ".wav") == 0 ||
+                                path.compare(path.size() - 4, 4, ".WAV") == 0);
+}
+
+// WAV/原始PCM 文件读写 (样点按小端存储，与 x86/ARM 主机字节序相同)
+class FileAudioBackend : public PacedAudioBackend {
+public:
+    FileAudioBackend(const std::string& input, const std::string& output)
+        : input_path_(input), output_path_(output), input_(nullptr), output_(nullptr),
+          data_start_(0), data_end_(0), output_wav_(false), output_frames_(0) {}
+    ~FileAudioBackend() override { Close(); }
+
+    bool Open(unsigned int sample_rate, int channels) override {
+        unsigned int capture_rate = sample_rate;
+        if (!input_path_.empty()) {
+            input_ = std::fopen(input_path_.c_str(), "rb");
+            if (!input_) {
+                std::cerr << "Failed to open audio input file: " << input_path_ << std::endl;
+                return false;
+            }
+            if (HasWavExtension(input_path_)) {
+                if (!ParseWavHeader(channels, &capture_rate)) {
+                    Close();
+                    return false;
+                }
+            } else {
+                std::fseek(input_, 0, SEEK_END);
+                data_start_ = 0;
+                data_end_ = std::ftell(input_);
+                std::fseek(input_, 0, SEEK_SET);
+            }
+            if (data_end_ - data_start_ < static_cast<long>(channels * sizeof(int16_t))) {
+                std::cerr << "Audio input file has no samples: " << input_path_ << std::endl;
+                Close();
+                return false;
+            }
+        }
+        if (!output_path_.empty()) {
+            output_ = std::fopen(output_path_.c_str(), "wb");
+            if (!output_) {
+                std::cerr << "Failed to open audio output file: " << output_path_ << std::endl;
+                Close();
+                return false;
+            }
+            output_wav_ = HasWavExtension(output_path_);
+            output_frames_ = 0;
+            if (output_wav_) {
+                // 先写入占位的文件头，关闭时回填长度
+                uint8_t header[44] = {};
+                std::fwrite(header, 1, sizeof(header), output_);
+            }
+        }
+        ConfigureClocks(capture_rate, sample_rate, channels);
+        return true;
+    }
+
+    void Close() override {
+        if (input_) {
+            std::fclose(input_);
+            input_ = nullptr;
+        }
+        if (output_) {
+            if (output_wav_) {
+                WriteWavHeader();
+            }
+            std::fclose(output_);
+            output_ = nullptr;
+        }
+    }
+    // 断开时关闭以写完输出文件，每次连接从输入文件开头重新读取
+    bool Suspend() override { return false; }
+
+    const char* GetName() const override { return "file"; }
+
+protected:
+    void Capture(int16_t* pcm, size_t frames) override {
+        size_t samples = frames * channels_;
+        if (!input_) {
+            std::fill(pcm, pcm + samples, 0);
+            return;
+        }
+        // 到达文件末尾时从头循环
+        size_t done = 0;
+        while (done < samples) {
+            long remaining = (data_end_ - std::ftell(input_)) / static_cast<long>(sizeof(int16_t));
+            if (remaining <= 0) {
+                std::fseek(input_, data_start_, SEEK_SET);
+                continue;
+            }
+            size_t count = std::min(samples - done, static_cast<size_t>(remaining));
+            size_t got = std::fread(pcm + done, sizeof(int16_t), count, input_);
+            if (got == 0) {
+                std::fill(pcm + done, pcm + samples, 0);
+                return;
+            }
+            done += got;
+        }
+    }
+
+    void Play(const int16_t* pcm, size_t frames) override {
+        if (!output_) return;
+        std::fwrite(pcm, sizeof(int16_t), frames * channels_, output_);
+        output_frames_ += frames;
+    }
+
+private:
+    // 找到 fmt 与 data 块，只接受16位PCM且声道数与配置一致的文件
+    bool ParseWavHeader(int channels, unsigned int* rate) {
+        uint8_t riff[12];
+        if (std::fread(riff, 1, sizeof(riff), input_) != sizeof(riff) ||
+            memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+            std::cerr << "Not a WAV file: " << input_path_ << std::endl;
+            return false;
+        }
+        bool have_format = false;
+        uint8_t chunk[8];
+        while (std::fread(chunk, 1, sizeof(chunk), input_) == sizeof(chunk)) {
+            uint32_t size = ReadLe32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                uint8_t format[16];
+                if (size < sizeof(format) || std::fread(format, 1, sizeof(format), input_) != sizeof(format)) {
+                    break;
+                }
+                if (ReadLe16(format) != 1 || ReadLe16(format + 14) != 16 || ReadLe16(format + 2) != channels) {
+                    std::cerr << "WAV input must be 16-bit PCM with " << channels << " channel(s): "
+                              << input_path_ << std::endl;
+                    return false;
+                }
+                *rate = ReadLe32(format + 4);
+                have_format = true;
+                std::fseek(input_, (size - sizeof(format) + 1) & ~1u, SEEK_CUR);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                if (!have_format) break;
+                data_start_ = std::ftell(input_);
+                std::fseek(input_, 0, SEEK_END);
+                data_end_ = std::min(std::ftell(input_), data_start_ + static_cast<long>(size));
+                std::fseek(input_, data_start_, SEEK_SET);
+                return true;
+            } else {
+                std::fseek(input_, (size + 1) & ~1u, SEEK_CUR);
+            }
+        }
+        std::cerr << "Invalid WAV file: " << input_path_ << std::endl;
+        return false;
+    }
+
+    void WriteWavHeader() {
+        uint32_t data_bytes = static_cast<uint32_t>(output_frames_ * channels_ * sizeof(int16_t));
+        uint8_t header[44];
+        memcpy(header, "RIFF", 4);
+        WriteLe32(header + 4, 36 + data_bytes);
+        memcpy(header + 8, "WAVEfmt ", 8);
+        WriteLe32(header + 16, 16);
+        WriteLe16(header + 20, 1);
+        WriteLe16(header + 22, static_cast<uint16_t>(channels_));
+        WriteLe32(header + 24, playback_rate_);
+        WriteLe32(header + 28, playback_rate_ * channels_ * sizeof(int16_t));
+        WriteLe16(header + 32, static_cast<uint16_t>(channels_ * sizeof(int16_t)));
+        WriteLe16(header + 34, 16);
+        memcpy(header + 36, "data", 4);
+        WriteLe32(header + 40, data_bytes);
+        std::fseek(output_, 0, SEEK_SET);
+        std::fwrite(header, 1, sizeof(header), output_);
+    }
+
+    std::string input_path_;
+    std::string output_path_;
+    std::FILE* input_;
+    std::FILE* output_;
+    long data_start_;
+    long data_end_;
+    bool output_wav_;
+    uint64_t output_frames_;
+};
+
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, AudioBackendFactory>& Registry() {
+    static std::map<std::string, AudioBackendFactory> registry;
+    return registry;
+}
+
+} // namespace
+
+void RegisterAudioBackend(const std::string& name, AudioBackendFactory factory) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry()[name] = factory;
+}
+
+std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& spec) {
+    if (spec.empty() || spec == "alsa" || spec == "alsa:rw") {
+#ifdef VOICE_CALL_HAVE_ALSA
+        return std::unique_ptr<AudioBackend>(new AlsaAudioBackend(spec != "alsa:rw"));
+#else
+        std::cerr << "ALSA backend not available in this build" << std::endl;
+        return nullptr;
+#endif
+    }
+    if (spec == "null") {
+        return std::unique_ptr<AudioBackend>(new NullAudioBackend());
+    }
+    if (spec == "loopback") {
+        return std::unique_ptr<AudioBackend>(new LoopbackAudioBackend());
+    }
+    if (spec.compare(0, 5, "file:") == 0) {
+        std::string files = spec.substr(5);
+        size_t comma = files.find(',');
+        std::string input = files.substr(0, comma);
+        std::string output = comma == std::string::npos ? std::string() : files.substr(comma + 1);
+        return std::unique_ptr<AudioBackend>(new FileAudioBackend(input, output));
+    }
+    {
+        size_t colon = spec.find(':');
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        auto found = Registry().find(spec.substr(0, colon));
+        if (found != Registry().end()) {
+            return found->second(colon == std::string::npos ? std::string() : spec.substr(colon + 1));
+        }
+    }
+    std::cerr << "Unknown audio backend: " << spec << std::endl;
+    return nullptr;
+}
@@ -0,0 +1,71 @@
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "sample_format.h"
+
+// 音频设备后端: 按设备采样率读写交错的16位PCM (设备为其他样点格式时由后端转换)
+// Read/Write 的返回值与 ALSA 一致: 非负为实际读写的帧数，-EPIPE 表示发生了溢出/欠载，
+// 后端已自行恢复，本次数据被丢弃；其他负值为错误码。
+// Open/Close 在音频线程之外调用，其余方法只在音频线程中调用
+class AudioBackend {
+public:
+    virtual ~AudioBackend() {}
+
+    // 期望的设备样点格式，在 Open 之前调用。不支持该格式的设备与后端 (ALSA 以外) 仍按S16读写
+    virtual void SetSampleFormat(SampleFormat) {}
+
+    // 打开采集与播放设备，设备不支持 sample_rate 时取最接近的采样率 (见 GetCaptureRate/GetPlaybackRate)
+    virtual bool Open(unsigned int sample_rate, int channels) = 0;
+    virtual void Close() = 0;
+    // 停止采集与播放并丢弃缓冲的数据，设备保持打开与已配置的状态，之后像刚打开一样使用 (Start/Read/Write)。
+    // 用于通话断开后保留设备 (audio_device_keeper.h)，不支持时返回 false
+    virtual bool Suspend() { return false; }
+
+    // 立即开始采集 (Read 在未开始时自动开始)。非阻塞调度时先调用，此后用 GetCaptureDelay 判断可读的帧数
+    virtual void Start() = 0;
+
+    virtual unsigned int GetCaptureRate() const = 0;
+    virtual unsigned int GetPlaybackRate() const = 0;
+
+    // 读取 frames 帧，没有数据时阻塞 (按设备时钟节拍)
+    virtual long Read(int16_t* pcm, size_t frames) = 0;
+    // 写入 frames 帧，设备缓冲区已满时阻塞
+    virtual long Write(const int16_t* pcm, size_t frames) = 0;
+
+    // 直接访问设备缓冲区 (ALSA mmap)，省去 Read/Write 的一次复制: 设备缓冲区中接下来 frames 帧连续且为交错S16时
+    // 返回其地址 (与 Read/Write 一样在数据或空间不够时阻塞)，调用方读完采集数据或写入播放数据后调用 Commit*，
+    // 返回提交的帧数或负的错误码 (与 Read/Write 相同)。不支持或区域不连续时返回 nullptr，改用 Read/Write
+    virtual const int16_t* BeginCapture(size_t /*frames*/) { return nullptr; }
+    virtual long CommitCapture(size_t /*frames*/) { return -1; }
+    virtual int16_t* BeginPlayback(size_t /*frames*/) { return nullptr; }
+    virtual long CommitPlayback(size_t /*frames*/) { return -1; }
+
+    // 采集/播放延迟 (帧)，用于回声参考对齐；不可用时返回0
+    virtual long GetCaptureDelay() = 0;
+    virtual long GetPlaybackDelay() = 0;
+
+    virtual const char* GetName() const = 0;
+};
+
+// 按描述创建后端:
+//   "alsa"                    ALSA 默认设备 (失败时尝试 hw:0,0)
+//   "null"                    静音采集，播放数据直接丢弃
+//   "file:<输入>[,<输出>]"    从 WAV/原始PCM 文件循环读取采集数据，播放数据写入 WAV/原始PCM 文件；
+//                             .wav 按文件头解析，其他扩展名按 16位小端交错PCM 处理，输入为空时静音，输出为空时丢弃
+//   "loopback"                播放的数据经过约一个设备缓冲区的延迟回到采集 (模拟扬声器到麦克风的回声路径)
+//   "<name>[:<参数>]"         通过 RegisterAudioBackend 注册的后端
+// 除 ALSA 外的后端按系统时钟节拍读写，可以在没有声卡的机器上以实时速度运行完整的处理链。
+// spec 为空时使用 "alsa"；未知描述或当前构建不支持时返回空
+std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& spec);
+
+// 注册自定义后端 (供嵌入方与测试工具使用)，spec 为 "<name>" 或 "<name>:<参数>" 时以参数调用 factory
+typedef std::function<std::unique_ptr<AudioBackend>(const std::string& args)> AudioBackendFactory;
+void RegisterAudioBackend(const std::string& name, AudioBackendFactory factory);
+
+#endif // AUDIO_BACKEND_H
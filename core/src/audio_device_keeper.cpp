@@ -0,0 +1,73 @@
+#include "audio_device_keeper.h"
+
+#include <iostream>
+
+AudioDeviceKeeper::AudioDeviceKeeper()
+    : stopping_(false) {
+}
+
+AudioDeviceKeeper::~AudioDeviceKeeper() {
+    Release();
+}
+
+void AudioDeviceKeeper::Keep(std::unique_ptr<AudioBackend> backend, const std::string& key, int idle_ms) {
+    if (!backend) {
+        return;
+    }
+    Release();
+    if (idle_ms <= 0 || !backend->Suspend()) {
+        backend->Close();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backend_ = std::move(backend);
+        key_ = key;
+        deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(idle_ms);
+        stopping_ = false;
+    }
+    reaper_ = std::thread(&AudioDeviceKeeper::ReaperLoop, this);
+}
+
+std::unique_ptr<AudioBackend> AudioDeviceKeeper::Take(const std::string& key) {
+    StopReaper();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (backend_ && key_ != key) {
+        std::cout << "保留的音频设备参数不同，关闭后重新打开" << std::endl;
+        backend_->Close();
+        backend_.reset();
+    }
+    return std::move(backend_);
+}
+
+void AudioDeviceKeeper::Release() {
+    StopReaper();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (backend_) {
+        backend_->Close();
+        backend_.reset();
+    }
+}
+
+void AudioDeviceKeeper::StopReaper() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_all();
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+}
+
+void AudioDeviceKeeper::ReaperLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wakeup_.wait_until(lock, deadline_, [this] { return stopping_; })) {
+        return;
+    }
+    if (backend_) {
+        std::cout << "音频设备空闲超时，关闭 (" << backend_->GetName() << ")" << std::endl;
+        backend_->Close();
+        backend_.reset();
+    }
+}
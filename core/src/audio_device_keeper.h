@@ -0,0 +1,41 @@
+#ifndef AUDIO_DEVICE_KEEPER_H
+#define AUDIO_DEVICE_KEEPER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "audio_backend.h"
+
+// 通话断开后保留已打开并配置好的音频设备: 设备暂停在 prepared 状态 (AudioBackend::Suspend)，
+// 重新连接或切换房间时按相同的打开参数直接取回，省去打开与配置设备的时间以及重新打开设备时的爆音。
+// 保留超过空闲时长后由后台线程关闭。所有方法可在任意线程调用 (不与音频线程同时使用同一设备)
+class AudioDeviceKeeper {
+public:
+    AudioDeviceKeeper();
+    ~AudioDeviceKeeper();
+
+    // 保留设备，key 描述打开参数 (后端、采样率、声道数与格式)。idle_ms <= 0 或后端不支持暂停时直接关闭
+    void Keep(std::unique_ptr<AudioBackend> backend, const std::string& key, int idle_ms);
+    // 取回打开参数相同的设备，没有时返回空；保留的设备参数不同时随即关闭
+    std::unique_ptr<AudioBackend> Take(const std::string& key);
+    // 关闭保留的设备
+    void Release();
+
+private:
+    void StopReaper();
+    void ReaperLoop();
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::unique_ptr<AudioBackend> backend_;     // 由 mutex_ 保护
+    std::string key_;
+    std::chrono::steady_clock::time_point deadline_;
+    bool stopping_;
+    std::thread reaper_;    // 只在保留设备期间运行
+};
+
+#endif // AUDIO_DEVICE_KEEPER_H
@@ -0,0 +1,183 @@
+#include "audio_fec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <arpa/inet.h>
+
+namespace {
+
+// 丢包估计衰减的时间常数 (秒)
+const double kLossDecaySeconds = 10.0;
+// 冗余深度切换门限 (升高/降低)
+const float kDepthUpThreshold[kMaxFecDepth] = {0.01f, 0.04f};
+const float kDepthDownThreshold[kMaxFecDepth] = {0.005f, 0.025f};
+
+} // namespace
+
+FecEncoder::FecEncoder()
+    : channels_(1)
+    , depth_(0)
+    , newest_(0) {
+    Reset();
+}
+
+void FecEncoder::Configure(int channels) {
+    channels_ = std::max(1, channels);
+    Reset();
+}
+
+void FecEncoder::Reset() {
+    ima_adpcm::ResetEncoder(&adpcm_state_);
+    for (auto& entry : history_) {
+        entry.valid = false;
+    }
+    newest_ = 0;
+}
+
+void FecEncoder::SetDepth(int depth) {
+    depth_ = std::max(0, std::min(kMaxFecDepth, depth));
+}
+
+size_t FecEncoder::BuildPayload(const int16_t* pcm, size_t frames, uint32_t sequence, uint32_t timestamp,
+                                uint8_t codec, uint8_t* out, size_t capacity, uint8_t* payload_type) {
+    const bool adpcm = codec == kPayloadTypeAdpcm;
+    *payload_type = adpcm ? kPayloadTypeAdpcm : kPayloadTypePcm16;
+
+    // ADPCM主负载与冗余副本共用同一次编码
+    current_.clear();
+    if (adpcm || depth_ > 0) {
+        current_.resize(ima_adpcm::EncodedSize(channels_, frames));
+        if (ima_adpcm::Encode(&adpcm_state_, pcm, channels_, frames, current_.data(), current_.size()) == 0) {
+            current_.clear();
+        }
+    }
+    if (adpcm && current_.empty()) {
+        return 0;
+    }
+    const uint8_t* primary = adpcm ? current_.data() : reinterpret_cast<const uint8_t*>(pcm);
+    const size_t pcm_size = adpcm ? current_.size() : frames * channels_ * sizeof(int16_t);
+    if (pcm_size > capacity) {
+        return 0;
+    }
+
+    // 选出仍可用的冗余块 (从最近的开始)
+    const HistoryEntry* selected[kMaxFecDepth];
+    int count = 0;
+    size_t used = 1 + pcm_size;
+    for (int i = 0; i < depth_; ++i) {
+        const HistoryEntry& entry = history_[(newest_ + kMaxFecDepth - i) % kMaxFecDepth];
+        uint32_t distance = sequence - entry.sequence;
+        uint32_t offset = timestamp - entry.timestamp;
+        if (!entry.valid || distance == 0 || distance > 255 || offset > 0xffff) {
+            continue;
+        }
+        size_t block_size = sizeof(RedundantBlockHeader) + entry.data.size();
+        if (used + block_size > capacity) {
+            break;
+        }
+        used += block_size;
+        selected[count++] = &entry;
+    }
+
+    size_t written = 0;
+    if (count == 0) {
+        memcpy(out, primary, pcm_size);
+        written = pcm_size;
+    } else {
+        uint8_t* p = out;
+        *p++ = static_cast<uint8_t>(count);
+        for (int i = 0; i < count; ++i) {
+            RedundantBlockHeader header;
+            header.sequence_distance = static_cast<uint8_t>(sequence - selected[i]->sequence);
+            header.timestamp_offset = htons(static_cast<uint16_t>(timestamp - selected[i]->timestamp));
+            header.length = htons(static_cast<uint16_t>(selected[i]->data.size()));
+            memcpy(p, &header, sizeof(header));
+            p += sizeof(header);
+        }
+        memcpy(p, primary, pcm_size);
+        p += pcm_size;
+        for (int i = 0; i < count; ++i) {
+            memcpy(p, selected[i]->data.data(), selected[i]->data.size());
+            p += selected[i]->data.size();
+        }
+        *payload_type = adpcm ? kPayloadTypeAdpcmRedundant : kPayloadTypePcm16Redundant;
+        written = p - out;
+    }
+
+    // 为后续包保存本帧的低码率副本
+    if (depth_ > 0) {
+        newest_ = (newest_ + 1) % kMaxFecDepth;
+        HistoryEntry& entry = history_[newest_];
+        entry.data.assign(current_.begin(), current_.end());
+        entry.sequence = sequence;
+        entry.timestamp = timestamp;
+        entry.frames = frames;
+        entry.valid = !current_.empty();
+    }
+    return written;
+}
+
+bool ParseRedundantPayload(const uint8_t* payload, size_t size, uint32_t sequence, uint32_t timestamp,
+                           const uint8_t** primary, size_t* primary_size,
+                           RedundantBlock* blocks, int* block_count) {
+    if (size < 1) return false;
+    int count = payload[0];
+    if (count > kMaxFecDepth) return false;
+    size_t header_bytes = 1 + count * sizeof(RedundantBlockHeader);
+    if (header_bytes > size) return false;
+
+    size_t redundant_bytes = 0;
+    for (int i = 0; i < count; ++i) {
+        RedundantBlockHeader header;
+        memcpy(&header, payload + 1 + i * sizeof(header), sizeof(header));
+        blocks[i].sequence = sequence - header.sequence_distance;
+        blocks[i].timestamp = timestamp - ntohs(header.timestamp_offset);
+        blocks[i].size = ntohs(header.length);
+        redundant_bytes += blocks[i].size;
+    }
+    if (header_bytes + redundant_bytes > size) return false;
+
+    *primary = payload + header_bytes;
+    *primary_size = size - header_bytes - redundant_bytes;
+    const uint8_t* p = *primary + *primary_size;
+    for (int i = 0; i < count; ++i) {
+        blocks[i].data = p;
+        p += blocks[i].size;
+    }
+    *block_count = count;
+    return true;
+}
+
+FecController::FecController() {
+    Reset();
+}
+
+void FecController::Reset() {
+    loss_estimate_ = 0.0f;
+    last_update_ = 0.0;
+    depth_ = 0;
+}
+
+void FecController::Decay(double now_seconds) {
+    if (last_update_ > 0.0 && now_seconds > last_update_) {
+        loss_estimate_ *= static_cast<float>(std::exp(-(now_seconds - last_update_) / kLossDecaySeconds));
+    }
+    last_update_ = now_seconds;
+}
+
+void FecController::OnLossReport(float fraction_lost, double now_seconds) {
+    Decay(now_seconds);
+    loss_estimate_ = std::max(loss_estimate_, fraction_lost);
+}
+
+int FecController::Update(double now_seconds) {
+    Decay(now_seconds);
+    while (depth_ < kMaxFecDepth && loss_estimate_ > kDepthUpThreshold[depth_]) {
+        ++depth_;
+    }
+    while (depth_ > 0 && loss_estimate_ < kDepthDownThreshold[depth_ - 1]) {
+        --depth_;
+    }
+    return depth_;
+}
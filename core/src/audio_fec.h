@@ -0,0 +1,94 @@
+#ifndef AUDIO_FEC_H
+#define AUDIO_FEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ima_adpcm.h"
+#include "voice_packet.h"
+
+// 冗余负载格式 (kPayloadTypePcm16Redundant / kPayloadTypeAdpcmRedundant，与 RFC 2198 类似):
+//   uint8 block_count
+//   block_count 个 RedundantBlockHeader
+//   主负载 (PCM16 或 IMA ADPCM，由负载类型决定)
+//   各冗余块数据 (IMA ADPCM)，按块头顺序排列
+// 冗余块是之前已发送的PCM包的低码率副本，由序列号差与时间戳差定位
+struct RedundantBlockHeader {
+    uint8_t sequence_distance;
+    uint16_t timestamp_offset;   // 网络字节序
+    uint16_t length;             // 网络字节序
+} __attribute__((packed));
+
+// 最多携带的冗余副本数
+const int kMaxFecDepth = 2;
+
+// 解析出的冗余块
+struct RedundantBlock {
+    uint32_t sequence;
+    uint32_t timestamp;
+    const uint8_t* data;
+    size_t size;
+};
+
+// 发送端: 保存最近发送的帧的ADPCM副本，按当前深度附加到新包上
+class FecEncoder {
+public:
+    FecEncoder();
+
+    void Configure(int channels);
+    void Reset();
+
+    void SetDepth(int depth);
+    int GetDepth() const { return depth_; }
+
+    // 组装一个音频包的负载，返回字节数并通过 payload_type 返回负载类型。
+    // codec 为主负载编码 (kPayloadTypePcm16 或 kPayloadTypeAdpcm)。
+    // 深度为0或没有可用历史时负载就是主负载本身，容量不足时丢弃放不下的冗余块
+    size_t BuildPayload(const int16_t* pcm, size_t frames, uint32_t sequence, uint32_t timestamp,
+                        uint8_t codec, uint8_t* out, size_t capacity, uint8_t* payload_type);
+
+private:
+    struct HistoryEntry {
+        uint32_t sequence;
+        uint32_t timestamp;
+        size_t frames;
+        std::vector<uint8_t> data;
+        bool valid;
+    };
+
+    int channels_;
+    int depth_;
+    ima_adpcm::EncoderState adpcm_state_;
+    HistoryEntry history_[kMaxFecDepth];
+    int newest_;
+    std::vector<uint8_t> current_;   // 本帧的ADPCM编码
+};
+
+// 解析冗余负载，格式错误返回false
+bool ParseRedundantPayload(const uint8_t* payload, size_t size, uint32_t sequence, uint32_t timestamp,
+                           const uint8_t** primary, size_t* primary_size,
+                           RedundantBlock* blocks, int* block_count);
+
+// 根据接收端报告的丢包率选择冗余深度
+// 丢包估计取各接收端报告的最大值，并随时间衰减，深度切换带迟滞
+class FecController {
+public:
+    FecController();
+
+    void Reset();
+    void OnLossReport(float fraction_lost, double now_seconds);
+    // 返回当前应使用的冗余深度
+    int Update(double now_seconds);
+
+    float GetLossEstimate() const { return loss_estimate_; }
+
+private:
+    void Decay(double now_seconds);
+
+    float loss_estimate_;
+    double last_update_;
+    int depth_;
+};
+
+#endif // AUDIO_FEC_H
@@ -0,0 +1,204 @@
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_KERNELS_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_KERNELS_NEON 1
+#endif
+
+namespace audio_kernels {
+
+namespace {
+
+const float kS16Scale = 1.0f / 32768.0f;
+
+inline int16_t SaturateToS16(float sample) {
+    float scaled = sample * 32768.0f;
+    if (scaled >= 32767.0f) return 32767;
+    if (scaled <= -32768.0f) return -32768;
+    return static_cast<int16_t>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+} // namespace
+
+float DotProduct(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(AUDIO_KERNELS_SSE)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc0);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(AUDIO_KERNELS_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float lanes[4];
+    vst1q_f32(lanes, acc0);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void S16ToFloat(const int16_t* in, float* out, size_t n) {
+    size_t i = 0;
+#if defined(AUDIO_KERNELS_SSE)
+    const __m128 scale = _mm_set1_ps(kS16Scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // 符号扩展到32位
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s16 = vld1q_s16(in + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+        vst1q_f32(out + i, vmulq_n_f32(lo, kS16Scale));
+        vst1q_f32(out + i + 4, vmulq_n_f32(hi, kS16Scale));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = static_cast<float>(in[i]) * kS16Scale;
+    }
+}
+
+void FloatToS16(const float* in, int16_t* out, size_t n) {
+    size_t i = 0;
+#if defined(AUDIO_KERNELS_SSE)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        // cvtps使用就近舍入，packs负责饱和
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(in + i), 32768.0f));
+        int32x4_t hi = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(in + i + 4), 32768.0f));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = SaturateToS16(in[i]);
+    }
+}
+
+void ApplyGainRamp(float* samples, size_t n, float start_gain, float end_gain) {
+    if (n == 0) return;
+    const float step = (end_gain - start_gain) / static_cast<float>(n);
+    size_t i = 0;
+    if (step == 0.0f) {
+#if defined(AUDIO_KERNELS_SSE)
+        const __m128 gain = _mm_set1_ps(end_gain);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        }
+#elif defined(AUDIO_KERNELS_NEON)
+        for (; i + 4 <= n; i += 4) {
+            vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), end_gain));
+        }
+#endif
+        for (; i < n; ++i) {
+            samples[i] *= end_gain;
+        }
+        return;
+    }
+#if defined(AUDIO_KERNELS_SSE)
+    // 样点序号保持为整数值浮点数，与标量尾部的计算结果一致
+    const __m128 start = _mm_set1_ps(start_gain);
+    const __m128 vstep = _mm_set1_ps(step);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 gain = _mm_add_ps(start, _mm_mul_ps(vstep, index));
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        index = _mm_add_ps(index, four);
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    const float init[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float32x4_t index = vld1q_f32(init);
+    const float32x4_t start = vdupq_n_f32(start_gain);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t gain = vaddq_f32(start, vmulq_n_f32(index, step));
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+        index = vaddq_f32(index, four);
+    }
+#endif
+    for (; i < n; ++i) {
+        samples[i] *= start_gain + step * static_cast<float>(i + 1);
+    }
+}
+
+float PeakAbs(const float* x, size_t n) {
+    size_t i = 0;
+    float peak = 0.0f;
+#if defined(AUDIO_KERNELS_SSE)
+    // 清除符号位即取绝对值
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(x + i), abs_mask));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(AUDIO_KERNELS_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        acc = vmaxq_f32(acc, vabsq_f32(vld1q_f32(x + i)));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < n; ++i) {
+        peak = std::max(peak, std::fabs(x[i]));
+    }
+    return peak;
+}
+
+void DeinterleaveS16ToFloat(const int16_t* in, int channels, int channel, float* out, size_t frames) {
+    if (channels == 1) {
+        S16ToFloat(in, out, frames);
+        return;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        out[i] = static_cast<float>(in[i * channels + channel]) * kS16Scale;
+    }
+}
+
+void InterleaveFloatToS16(const float* in, int channels, int channel, int16_t* out, size_t frames) {
+    if (channels == 1) {
+        FloatToS16(in, out, frames);
+        return;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        out[i * channels + channel] = SaturateToS16(in[i]);
+    }
+}
+
+} // namespace audio_kernels
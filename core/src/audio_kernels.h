@@ -0,0 +1,34 @@
+#ifndef AUDIO_KERNELS_H
+#define AUDIO_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 音频处理的基础向量化内核
+// 在x86上使用SSE，在ARM上使用NEON，其余平台退化为标量实现
+namespace audio_kernels {
+
+// 点积: sum(a[i] * b[i])
+float DotProduct(const float* a, const float* b, size_t n);
+
+// int16 -> float，归一化到[-1, 1)
+void S16ToFloat(const int16_t* in, float* out, size_t n);
+
+// float -> int16，带饱和截断
+void FloatToS16(const float* in, int16_t* out, size_t n);
+
+// 就地乘以增益，增益从 start_gain 线性过渡到 end_gain (第n个样点恰为 end_gain)，避免增益跳变产生咔嗒声
+void ApplyGainRamp(float* samples, size_t n, float start_gain, float end_gain);
+
+// 绝对值峰值: max(|x[i]|)
+float PeakAbs(const float* x, size_t n);
+
+// 交错int16 -> 单声道平面float (取第channel个声道)
+void DeinterleaveS16ToFloat(const int16_t* in, int channels, int channel, float* out, size_t frames);
+
+// 单声道平面float -> 交错int16的第channel个声道，带饱和截断
+void InterleaveFloatToS16(const float* in, int channels, int channel, int16_t* out, size_t frames);
+
+} // namespace audio_kernels
+
+#endif // AUDIO_KERNELS_H
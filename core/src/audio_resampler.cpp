@@ -0,0 +1,318 @@
+#include "audio_resampler.h"
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// 每侧过零点数，决定过渡带宽度和阻带衰减
+const int kZeroCrossings = 16;
+// Kaiser窗参数，约对应 80dB 阻带衰减
+const double kKaiserBeta = 8.0;
+// 截止频率相对于奈奎斯特频率的比例
+const double kCutoffRatio = 0.92;
+
+const int kCommonRates[] = {8000, 16000, 32000, 44100, 48000};
+
+// 分数重采样器的插值核: 抽头数与相位细分数
+const int kFractionalTaps = 16;
+const int kFractionalPhases = 128;
+
+// 零阶修正贝塞尔函数
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+std::shared_ptr<ResamplerFilterBank> DesignFilterBank(int in_rate, int out_rate) {
+    int g = std::gcd(in_rate, out_rate);
+    auto bank = std::make_shared<ResamplerFilterBank>();
+    bank->in_rate = in_rate;
+    bank->out_rate = out_rate;
+    bank->up = out_rate / g;
+    bank->down = in_rate / g;
+
+    // 抽取时按比例加长滤波器，保证过零点数不变
+    int decim = (bank->down + bank->up - 1) / bank->up;
+    int taps = 2 * kZeroCrossings * std::max(1, decim);
+    bank->taps = (taps + 7) / 8 * 8;
+
+    const int up = bank->up;
+    const int length = bank->taps * up;
+    // 原型滤波器工作在 in_rate * up 上，截止频率取两侧奈奎斯特频率的较小者
+    const double cutoff = 0.5 * kCutoffRatio / std::max(bank->up, bank->down);
+    const double center = (length - 1) / 2.0;
+    const double i0_beta = BesselI0(kKaiserBeta);
+
+    std::vector<double> prototype(length);
+    for (int n = 0; n < length; ++n) {
+        double t = n - center;
+        double sinc = (t == 0.0) ? 2.0 * cutoff
+                                 : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double r = 2.0 * n / (length - 1) - 1.0;
+        double window = BesselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        prototype[n] = sinc * window;
+    }
+
+    // 拆分为多相，每个相位单独归一化到单位直流增益，并倒序存放
+    bank->coeffs.assign(static_cast<size_t>(length), 0.0f);
+    for (int phase = 0; phase < up; ++phase) {
+        double sum = 0.0;
+        for (int j = 0; j < bank->taps; ++j) {
+            sum += prototype[phase + j * up];
+        }
+        float* dst = &bank->coeffs[static_cast<size_t>(phase) * bank->taps];
+        for (int j = 0; j < bank->taps; ++j) {
+            dst[bank->taps - 1 - j] = static_cast<float>(prototype[phase + j * up] / sum);
+        }
+    }
+    return bank;
+}
+
+// 分数重采样器的插值表，共 kFractionalPhases + 1 行，
+// 第p行对应输出位于 x[i] 之后 p/kFractionalPhases 处，
+// 系数与 x[i - taps/2 + 1 .. i + taps/2] 对应
+const std::vector<float>& GetFractionalTable() {
+    static const std::vector<float> table = [] {
+        const int half = kFractionalTaps / 2;
+        const double cutoff = 0.5 * kCutoffRatio;
+        const double i0_beta = BesselI0(kKaiserBeta);
+        std::vector<float> rows(static_cast<size_t>(kFractionalPhases + 1) * kFractionalTaps);
+        for (int p = 0; p <= kFractionalPhases; ++p) {
+            double frac = static_cast<double>(p) / kFractionalPhases;
+            double sum = 0.0;
+            std::vector<double> row(kFractionalTaps);
+            for (int j = 0; j < kFractionalTaps; ++j) {
+                double t = frac + (half - 1 - j);
+                double sinc = (std::fabs(t) < 1e-9) ? 2.0 * cutoff
+                                                    : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+                double r = t / half;
+                double window = BesselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+                row[j] = sinc * window;
+                sum += row[j];
+            }
+            for (int j = 0; j < kFractionalTaps; ++j) {
+                rows[static_cast<size_t>(p) * kFractionalTaps + j] = static_cast<float>(row[j] / sum);
+            }
+        }
+        return rows;
+    }();
+    return table;
+}
+
+std::mutex g_bank_mutex;
+std::map<std::pair<int, int>, std::shared_ptr<const ResamplerFilterBank>> g_banks;
+bool g_common_banks_ready = false;
+
+} // namespace
+
+std::shared_ptr<const ResamplerFilterBank> GetResamplerFilterBank(int in_rate, int out_rate) {
+    if (in_rate <= 0 || out_rate <= 0 || in_rate == out_rate) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_bank_mutex);
+    if (!g_common_banks_ready) {
+        for (int from : kCommonRates) {
+            for (int to : kCommonRates) {
+                if (from != to) {
+                    g_banks[{from, to}] = DesignFilterBank(from, to);
+                }
+            }
+        }
+        g_common_banks_ready = true;
+    }
+
+    auto& bank = g_banks[{in_rate, out_rate}];
+    if (!bank) {
+        bank = DesignFilterBank(in_rate, out_rate);
+    }
+    return bank;
+}
+
+PolyphaseResampler::PolyphaseResampler()
+    : in_rate_(0)
+    , out_rate_(0)
+    , channels_(1)
+    , max_input_frames_(0)
+    , position_(0) {
+}
+
+bool PolyphaseResampler::Configure(int in_rate, int out_rate, int channels, size_t max_input_frames) {
+    if (in_rate <= 0 || out_rate <= 0 || channels <= 0 || max_input_frames == 0) {
+        return false;
+    }
+
+    in_rate_ = in_rate;
+    out_rate_ = out_rate;
+    channels_ = channels;
+    max_input_frames_ = max_input_frames;
+    bank_ = GetResamplerFilterBank(in_rate, out_rate);
+
+    history_.clear();
+    if (bank_) {
+        history_.assign(channels, std::vector<float>(bank_->taps - 1 + max_input_frames, 0.0f));
+    }
+    Reset();
+    return true;
+}
+
+void PolyphaseResampler::Reset() {
+    for (auto& buffer : history_) {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+    // 第一个输出样点对齐到第一个新输入样点
+    position_ = bank_ ? static_cast<uint64_t>(bank_->taps - 1) * bank_->up : 0;
+}
+
+size_t PolyphaseResampler::MaxOutputFrames(size_t in_frames) const {
+    if (!bank_) {
+        return in_frames;
+    }
+    return in_frames * bank_->up / bank_->down + 2;
+}
+
+size_t PolyphaseResampler::Process(const int16_t* in, size_t in_frames, int16_t* out, size_t out_capacity_frames) {
+    if (!bank_) {
+        size_t frames = std::min(in_frames, out_capacity_frames);
+        memcpy(out, in, frames * channels_ * sizeof(int16_t));
+        return frames;
+    }
+
+    const int taps = bank_->taps;
+    const size_t hist = static_cast<size_t>(taps - 1);
+    const uint64_t up = static_cast<uint64_t>(bank_->up);
+    const uint64_t down = static_cast<uint64_t>(bank_->down);
+    size_t produced = 0;
+
+    while (in_frames > 0) {
+        size_t chunk = std::min(in_frames, max_input_frames_);
+        for (int ch = 0; ch < channels_; ++ch) {
+            audio_kernels::DeinterleaveS16ToFloat(in, channels_, ch, history_[ch].data() + hist, chunk);
+        }
+
+        const uint64_t end = (hist + chunk) * up;
+        uint64_t pos = position_;
+        float sample = 0.0f;
+        while (pos < end && produced < out_capacity_frames) {
+            size_t newest = static_cast<size_t>(pos / up);
+            const float* coeffs = &bank_->coeffs[static_cast<size_t>(pos % up) * taps];
+            int16_t* frame = out + produced * channels_;
+            for (int ch = 0; ch < channels_; ++ch) {
+                sample = audio_kernels::DotProduct(coeffs, history_[ch].data() + newest - hist, taps);
+                audio_kernels::InterleaveFloatToS16(&sample, channels_, ch, frame, 1);
+            }
+            pos += down;
+            ++produced;
+        }
+
+        // 保留最后 taps-1 个样点作为下一块的历史
+        for (int ch = 0; ch < channels_; ++ch) {
+            float* buffer = history_[ch].data();
+            memmove(buffer, buffer + chunk, hist * sizeof(float));
+        }
+        // 输出缓冲区不足时丢弃剩余输出，保持相位连续
+        while (pos < end) {
+            pos += down;
+        }
+        position_ = pos - chunk * up;
+
+        in += chunk * channels_;
+        in_frames -= chunk;
+    }
+    return produced;
+}
+
+FractionalResampler::FractionalResampler()
+    : channels_(1)
+    , max_input_frames_(0)
+    , ratio_(1.0)
+    , position_(0.0) {
+}
+
+bool FractionalResampler::Configure(int channels, size_t max_input_frames) {
+    if (channels <= 0 || max_input_frames == 0) {
+        return false;
+    }
+
+    channels_ = channels;
+    max_input_frames_ = max_input_frames;
+    history_.assign(channels, std::vector<float>(kFractionalTaps + max_input_frames, 0.0f));
+    GetFractionalTable();
+    Reset();
+    return true;
+}
+
+void FractionalResampler::Reset() {
+    for (auto& buffer : history_) {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+    ratio_ = 1.0;
+    position_ = kFractionalTaps / 2 - 1;
+}
+
+size_t FractionalResampler::MaxOutputFrames(size_t in_frames) const {
+    return static_cast<size_t>(in_frames / ratio_) + 2;
+}
+
+size_t FractionalResampler::Process(const int16_t* in, size_t in_frames, int16_t* out, size_t out_capacity_frames) {
+    const std::vector<float>& table = GetFractionalTable();
+    const size_t hist = kFractionalTaps;
+    const int half = kFractionalTaps / 2;
+    size_t produced = 0;
+
+    while (in_frames > 0) {
+        size_t chunk = std::min(in_frames, max_input_frames_);
+        for (int ch = 0; ch < channels_; ++ch) {
+            audio_kernels::DeinterleaveS16ToFloat(in, channels_, ch, history_[ch].data() + hist, chunk);
+        }
+
+        // 需要 x[i + half] 可用
+        const double end = static_cast<double>(hist + chunk - half);
+        double pos = position_;
+        while (pos < end && produced < out_capacity_frames) {
+            size_t index = static_cast<size_t>(pos);
+            double phase = (pos - index) * kFractionalPhases;
+            size_t row = static_cast<size_t>(phase);
+            float weight = static_cast<float>(phase - row);
+            const float* c0 = &table[row * kFractionalTaps];
+            const float* c1 = c0 + kFractionalTaps;
+            int16_t* frame = out + produced * channels_;
+            for (int ch = 0; ch < channels_; ++ch) {
+                const float* x = history_[ch].data() + index - (half - 1);
+                float a = audio_kernels::DotProduct(c0, x, kFractionalTaps);
+                float b = audio_kernels::DotProduct(c1, x, kFractionalTaps);
+                float sample = a + (b - a) * weight;
+                audio_kernels::InterleaveFloatToS16(&sample, channels_, ch, frame, 1);
+            }
+            pos += ratio_;
+            ++produced;
+        }
+        while (pos < end) {
+            pos += ratio_;
+        }
+
+        for (int ch = 0; ch < channels_; ++ch) {
+            float* buffer = history_[ch].data();
+            memmove(buffer, buffer + chunk, hist * sizeof(float));
+        }
+        position_ = pos - chunk;
+
+        in += chunk * channels_;
+        in_frames -= chunk;
+    }
+    return produced;
+}
@@ -0,0 +1,91 @@
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 多相滤波器组
+// 原型低通滤波器按 up 个相位拆分，每个相位的系数倒序存放，
+// 这样每个输出样点只需要一次连续的点积
+struct ResamplerFilterBank {
+    int in_rate;
+    int out_rate;
+    int up;     // 插值因子 L
+    int down;   // 抽取因子 M
+    int taps;   // 每个相位的抽头数 (8的倍数)
+    std::vector<float> coeffs;  // up * taps
+};
+
+// 获取 in_rate -> out_rate 的滤波器组
+// 常用采样率 (8/16/32/48 kHz 及 44.1 kHz) 之间的滤波器组在首次调用时统一预计算，
+// 其余比例按需生成并缓存，进程内共享
+std::shared_ptr<const ResamplerFilterBank> GetResamplerFilterBank(int in_rate, int out_rate);
+
+// 多相重采样器 (交错int16输入输出)
+// 用于设备采样率与网络采样率不一致时在两者之间转换
+class PolyphaseResampler {
+public:
+    PolyphaseResampler();
+
+    // 配置重采样器，max_input_frames 为单次 Process 的最大输入帧数
+    bool Configure(int in_rate, int out_rate, int channels, size_t max_input_frames);
+
+    // 清空历史样点
+    void Reset();
+
+    // 输入输出采样率相同时直接拷贝
+    bool IsPassthrough() const { return !bank_; }
+
+    // 给定输入帧数时的最大输出帧数
+    size_t MaxOutputFrames(size_t in_frames) const;
+
+    // 重采样，返回写入 out 的帧数
+    size_t Process(const int16_t* in, size_t in_frames, int16_t* out, size_t out_capacity_frames);
+
+    int GetInputRate() const { return in_rate_; }
+    int GetOutputRate() const { return out_rate_; }
+
+private:
+    std::shared_ptr<const ResamplerFilterBank> bank_;
+    int in_rate_;
+    int out_rate_;
+    int channels_;
+    size_t max_input_frames_;
+    uint64_t position_;  // 下一个输出样点的位置，单位为 1/up 个输入样点
+    std::vector<std::vector<float>> history_;  // 每个声道: taps-1 个历史样点 + 本次输入
+};
+
+// 分数比例重采样器 (交错int16输入输出)
+// 比例可以在运行中连续调整，用于补偿收发两端的时钟漂移。
+// 使用细分相位的窗函数sinc表，相邻相位之间线性插值
+class FractionalResampler {
+public:
+    FractionalResampler();
+
+    // 配置重采样器，max_input_frames 为单次 Process 的最大输入帧数
+    bool Configure(int channels, size_t max_input_frames);
+
+    // 清空历史样点，比例恢复为1
+    void Reset();
+
+    // 设置比例: 每个输出帧消耗的输入帧数 (>1 加快播放，<1 放慢播放)
+    void SetRatio(double ratio) { ratio_ = ratio; }
+    double GetRatio() const { return ratio_; }
+
+    // 给定输入帧数时的最大输出帧数
+    size_t MaxOutputFrames(size_t in_frames) const;
+
+    // 重采样，返回写入 out 的帧数
+    size_t Process(const int16_t* in, size_t in_frames, int16_t* out, size_t out_capacity_frames);
+
+private:
+    int channels_;
+    size_t max_input_frames_;
+    double ratio_;
+    double position_;  // 下一个输出样点在缓冲区中的位置 (输入帧)
+    std::vector<std::vector<float>> history_;
+};
+
+#endif // AUDIO_RESAMPLER_H
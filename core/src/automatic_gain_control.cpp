@@ -0,0 +1,132 @@
+#include "automatic_gain_control.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "audio_kernels.h"
+
+namespace {
+
+// 目标语音电平 (dBFS，RMS)
+const float kTargetLevelDb = -20.0f;
+const float kMinGainDb = -12.0f;
+const float kMaxGainDb = 24.0f;
+// 电平跟踪的攻击/释放时间常数 (毫秒)
+const float kAttackMs = 20.0f;
+const float kReleaseMs = 400.0f;
+// 增益变化速率上限 (dB/秒)，增大慢、减小快
+const float kGainRiseDbPerSecond = 6.0f;
+const float kGainFallDbPerSecond = 30.0f;
+// 限幅阈值 (约 -1dBFS)、子块长度与释放时间常数
+const float kLimiterThreshold = 0.891f;
+const int kLimiterSubblockMs = 1;
+const float kLimiterReleaseMs = 50.0f;
+
+float DbToLinear(float db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+
+} // namespace
+
+AutomaticGainControl::AutomaticGainControl()
+    : attack_coef_(1.0f)
+    , release_coef_(1.0f)
+    , max_gain_rise_db_(0.0f)
+    , max_gain_fall_db_(0.0f)
+    , speech_level_db_(kTargetLevelDb)
+    , gain_db_(0.0f)
+    , applied_gain_(1.0f)
+    , limiter_subblock_(1)
+    , limiter_release_(0.0f)
+    , limiter_envelope_(0.0f)
+    , limiter_gain_(1.0f) {
+}
+
+void AutomaticGainControl::Configure(int sample_rate, size_t frame_frames) {
+    if (sample_rate <= 0) sample_rate = 16000;
+    float frame_ms = 1000.0f * frame_frames / sample_rate;
+    attack_coef_ = 1.0f - std::exp(-frame_ms / kAttackMs);
+    release_coef_ = 1.0f - std::exp(-frame_ms / kReleaseMs);
+    max_gain_rise_db_ = kGainRiseDbPerSecond * frame_ms / 1000.0f;
+    max_gain_fall_db_ = kGainFallDbPerSecond * frame_ms / 1000.0f;
+
+    limiter_subblock_ = std::max<size_t>(1, static_cast<size_t>(sample_rate) * kLimiterSubblockMs / 1000);
+    limiter_release_ = std::exp(-static_cast<float>(kLimiterSubblockMs) / kLimiterReleaseMs);
+    limiter_targets_.assign(frame_frames / limiter_subblock_ + 1, 1.0f);
+    Reset();
+}
+
+void AutomaticGainControl::Reset() {
+    speech_level_db_ = kTargetLevelDb;
+    gain_db_ = 0.0f;
+    applied_gain_ = 1.0f;
+    limiter_envelope_ = 0.0f;
+    limiter_gain_ = 1.0f;
+}
+
+float AutomaticGainControl::GetLimiterGainDb() const {
+    return 20.0f * std::log10(limiter_gain_);
+}
+
+void AutomaticGainControl::Process(float* const* planes, int channels, size_t frames, bool speech, float post_gain) {
+    if (frames == 0 || channels <= 0) return;
+
+    // 1. 语音电平跟踪与增益更新，非语音帧保持增益不变，避免放大背景噪声
+    if (speech) {
+        float energy = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            energy += audio_kernels::DotProduct(planes[ch], planes[ch], frames);
+        }
+        float level_db = 10.0f * std::log10(energy / (frames * channels) + 1e-10f);
+        float coef = level_db > speech_level_db_ ? attack_coef_ : release_coef_;
+        speech_level_db_ += coef * (level_db - speech_level_db_);
+
+        float desired_db = std::max(kMinGainDb, std::min(kMaxGainDb, kTargetLevelDb - speech_level_db_));
+        float delta = std::max(-max_gain_fall_db_, std::min(max_gain_rise_db_, desired_db - gain_db_));
+        gain_db_ += delta;
+    }
+
+    // 2. 自适应增益与固定增益合并，逐样点从上一帧的增益过渡
+    float target_gain = DbToLinear(gain_db_) * post_gain;
+    for (int ch = 0; ch < channels; ++ch) {
+        audio_kernels::ApplyGainRamp(planes[ch], frames, applied_gain_, target_gain);
+    }
+    applied_gain_ = target_gain;
+
+    // 3. 峰值限幅
+    Limit(planes, channels, frames);
+}
+
+void AutomaticGainControl::Limit(float* const* planes, int channels, size_t frames) {
+    // 先求出每个子块的目标增益，子块边界取相邻两块目标的较小值，
+    // 块内线性插值的增益不超过该块的目标，因此不会过冲
+    const size_t sub = limiter_subblock_;
+    const size_t blocks = (frames + sub - 1) / sub;
+    if (limiter_targets_.size() < blocks) {
+        limiter_targets_.resize(blocks);
+    }
+    for (size_t b = 0; b < blocks; ++b) {
+        size_t start = b * sub;
+        size_t len = std::min(sub, frames - start);
+        float peak = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            peak = std::max(peak, audio_kernels::PeakAbs(planes[ch] + start, len));
+        }
+        limiter_envelope_ = std::max(peak, limiter_envelope_ * limiter_release_);
+        limiter_targets_[b] = limiter_envelope_ > kLimiterThreshold ? kLimiterThreshold / limiter_envelope_ : 1.0f;
+    }
+
+    float boundary = std::min(limiter_gain_, limiter_targets_[0]);
+    for (size_t b = 0; b < blocks; ++b) {
+        size_t start = b * sub;
+        size_t len = std::min(sub, frames - start);
+        float next = b + 1 < blocks ? std::min(limiter_targets_[b], limiter_targets_[b + 1]) : limiter_targets_[b];
+        if (boundary < 1.0f || next < 1.0f) {
+            for (int ch = 0; ch < channels; ++ch) {
+                audio_kernels::ApplyGainRamp(planes[ch] + start, len, boundary, next);
+            }
+        }
+        boundary = next;
+    }
+    limiter_gain_ = boundary;
+}
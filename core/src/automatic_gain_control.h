@@ -0,0 +1,47 @@
+#ifndef AUTOMATIC_GAIN_CONTROL_H
+#define AUTOMATIC_GAIN_CONTROL_H
+
+#include <cstddef>
+#include <vector>
+
+// 数字自动增益控制
+// 仅在语音帧上跟踪语音电平 (快攻慢释)，使其趋近目标电平；增益变化受速率限制，
+// 帧内逐样点线性过渡。增益之后叠加调用方给定的固定增益 (麦克风音量)，
+// 最后经过峰值限幅器，保证输出不超过 -1dBFS
+class AutomaticGainControl {
+public:
+    AutomaticGainControl();
+
+    void Configure(int sample_rate, size_t frame_frames);
+    void Reset();
+
+    // planes 为 channels 个平面缓冲，每个包含 frames 个样点，所有声道使用同一增益
+    // speech 为该帧的语音活动判决，post_gain 为自适应增益之后叠加的固定增益
+    void Process(float* const* planes, int channels, size_t frames, bool speech, float post_gain);
+
+    // 当前自适应增益与限幅器增益 (dB)
+    float GetGainDb() const { return gain_db_; }
+    float GetLimiterGainDb() const;
+    // 跟踪到的语音电平 (dBFS)
+    float GetSpeechLevelDb() const { return speech_level_db_; }
+
+private:
+    void Limit(float* const* planes, int channels, size_t frames);
+
+    float attack_coef_;
+    float release_coef_;
+    float max_gain_rise_db_;
+    float max_gain_fall_db_;
+
+    float speech_level_db_;
+    float gain_db_;
+    float applied_gain_;       // 上一帧结束时的线性总增益
+
+    size_t limiter_subblock_;
+    float limiter_release_;
+    float limiter_envelope_;
+    float limiter_gain_;
+    std::vector<float> limiter_targets_;
+};
+
+#endif // AUTOMATIC_GAIN_CONTROL_H
@@ -0,0 +1,123 @@
+#include "call_environment.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 连接到服务器的UDP socket
+class UdpTransport : public PacketTransport {
+public:
+    UdpTransport() : fd_(-1) {}
+    ~UdpTransport() override { Close(); }
+
+    bool Connect(const std::string& host, int port) override {
+        Close();
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            std::cerr << "Failed to create UDP socket" << std::endl;
+            return false;
+        }
+
+        // 设置socket选项
+        int opt = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        // 绑定本地端口
+        struct sockaddr_in local_addr;
+        memset(&local_addr, 0, sizeof(local_addr));
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        local_addr.sin_port = htons(0); // 随机端口
+
+        if (bind(fd_, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
+            std::cerr << "Failed to bind socket" << std::endl;
+            Close();
+            return false;
+        }
+
+        // 所有包都经过服务器，连接后的socket发送时不再查找目的地址，也只接收服务器的包
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port);
+        server_addr.sin_addr.s_addr = inet_addr(host.c_str());
+        if (connect(fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            std::cerr << "Failed to connect socket: " << strerror(errno) << std::endl;
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() override {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    long Send(const void* header, size_t header_size, const void* payload, size_t payload_size) override {
+        if (payload_size == 0) {
+            return send(fd_, header, header_size, 0);
+        }
+        // 包头和负载作为两段交给 sendmsg，不拼接
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(header);
+        iov[0].iov_len = header_size;
+        iov[1].iov_base = const_cast<void*>(payload);
+        iov[1].iov_len = payload_size;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        return sendmsg(fd_, &msg, 0);
+    }
+
+    long Receive(void* buffer, size_t size) override {
+        return recv(fd_, buffer, size, MSG_DONTWAIT);
+    }
+
+    bool WaitReadable(int timeout_ms) override {
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        return poll(&pfd, 1, timeout_ms) > 0;
+    }
+
+    int GetFd() const override { return fd_; }
+
+private:
+    int fd_;
+};
+
+class RealCallEnvironment : public CallEnvironment {
+public:
+    double Now() override {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::unique_ptr<PacketTransport> CreateTransport() override {
+        return std::unique_ptr<PacketTransport>(new UdpTransport());
+    }
+
+    std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& spec) override {
+        return ::CreateAudioBackend(spec);
+    }
+};
+
+} // namespace
+
+CallEnvironment& DefaultCallEnvironment() {
+    static RealCallEnvironment environment;
+    return environment;
+}
@@ -0,0 +1,68 @@
+#ifndef CALL_ENVIRONMENT_H
+#define CALL_ENVIRONMENT_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "audio_backend.h"
+#include "event_reactor.h"
+#include "voice_call.h"
+
+// 到服务器的数据报传输。默认实现为连接到服务器的UDP socket
+class PacketTransport {
+public:
+    virtual ~PacketTransport() {}
+
+    // 连接到服务器，之后只与服务器收发；失败时已输出原因
+    virtual bool Connect(const std::string& host, int port) = 0;
+    virtual void Close() = 0;
+
+    // 发送一个数据报，内容为 header 与 payload 两段 (payload 可以为空，调用方不必拼接)；
+    // 返回发送的字节数，失败时返回-1并设置 errno
+    virtual long Send(const void* header, size_t header_size, const void* payload, size_t payload_size) = 0;
+    // 接收一个数据报，没有数据时立即返回-1
+    virtual long Receive(void* buffer, size_t size) = 0;
+    // 等待可读 (线程模式的网络线程)，超时返回 false
+    virtual bool WaitReadable(int timeout_ms) = 0;
+    // 供共享反应器注册的描述符，没有时返回-1
+    virtual int GetFd() const = 0;
+};
+
+// 虚拟时间下驱动通话的调度器: 注册后由调度器回调 OnReadable (传输有数据) 与 OnTick (10ms节拍)，
+// 通话不创建线程
+class CallScheduler {
+public:
+    virtual ~CallScheduler() {}
+
+    virtual bool Add(PacketTransport* transport, ReactorHandler* handler) = 0;
+    // 返回后不会再回调该处理对象
+    virtual void Remove(PacketTransport* transport) = 0;
+};
+
+// 通话引擎的运行环境: 时钟、网络传输、音频后端与调度。
+// 默认环境使用单调时钟、UDP socket 与 CreateAudioBackend，按配置创建线程或注册到共享反应器；
+// 模拟器 (tools/call_simulator) 在一个线程中以虚拟时间驱动多个通话，结果只取决于随机种子
+class CallEnvironment {
+public:
+    virtual ~CallEnvironment() {}
+
+    // 单调时钟 (秒，正值)。接收时刻、重传请求、码率与冗余控制、接收报告间隔都以它为准；
+    // 日志间隔与处理耗时统计仍使用系统时钟
+    virtual double Now() = 0;
+
+    virtual std::unique_ptr<PacketTransport> CreateTransport() = 0;
+    virtual std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& spec) = 0;
+
+    // 返回非空时由它驱动通话 (忽略 use_shared_reactor)；默认环境返回空
+    virtual CallScheduler* GetScheduler() { return nullptr; }
+};
+
+// 进程内共享的默认环境
+CallEnvironment& DefaultCallEnvironment();
+
+// 在指定环境中创建通话，环境的生命周期须长于通话。voice_call_init 使用默认环境
+voice_call_handle_t CreateVoiceCall(const voice_call_config_t* config, const voice_call_callbacks_t* callbacks,
+                                    CallEnvironment* environment);
+
+#endif // CALL_ENVIRONMENT_H
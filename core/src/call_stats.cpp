@@ -0,0 +1,59 @@
+#include "call_stats.h"
+
+namespace {
+
+float AverageUs(const uint64_t* values, size_t first) {
+    uint64_t count = values[first + 1];
+    return count > 0 ? values[first] / 1000.0f / count : 0.0f;
+}
+
+float MaxUs(const uint64_t* values, size_t first) {
+    return values[first + 2] / 1000.0f;
+}
+
+} // namespace
+
+void CallStats::Fill(voice_call_stats_t* stats) const {
+    uint64_t a[kAudioStatCount];
+    uint64_t n[kNetworkStatCount];
+    audio_.Snapshot(a);
+    network_.Snapshot(n);
+
+    stats->packets_sent = a[kStatPacketsSent];
+    stats->bytes_sent = a[kStatBytesSent];
+    stats->retransmits_sent = n[kStatRetransmitsSent];
+    stats->dtx_suppressed_frames = a[kStatDtxSuppressedFrames];
+    stats->target_bitrate = static_cast<int32_t>(a[kStatTargetBitrate]);
+    stats->send_bitrate = static_cast<int32_t>(a[kStatSendBitrate]);
+    stats->fec_depth = static_cast<int32_t>(a[kStatFecDepth]);
+
+    stats->packets_received = n[kStatPacketsReceived];
+    stats->bytes_received = n[kStatBytesReceived];
+    stats->packets_lost = a[kStatStreamPacketsLost];
+    stats->packets_recovered = a[kStatStreamPacketsRecovered];
+    stats->retransmits_recovered = a[kStatStreamRetransmitsRecovered];
+    stats->packets_reordered = a[kStatStreamPacketsReordered];
+    stats->packets_late = a[kStatStreamPacketsLate];
+    stats->queue_drops = a[kStatStreamQueueDrops];
+    stats->concealed_frames = a[kStatStreamConcealedFrames];
+    stats->accelerated_frames = a[kStatStreamAcceleratedFrames];
+    stats->decelerated_frames = a[kStatStreamDeceleratedFrames];
+    stats->nack_requests = a[kStatStreamNackRequests];
+    stats->decrypt_failures = n[kStatDecryptFailures];
+    stats->remote_streams = static_cast<uint32_t>(a[kStatRemoteStreams]);
+    stats->jitter_ms = a[kStatJitterUs] / 1000.0f;
+    stats->rtt_ms = a[kStatRttUs] / 1000.0f;
+    stats->jitter_buffer_ms = a[kStatJitterBufferUs] / 1000.0f;
+
+    stats->capture_xruns = a[kStatCaptureXruns];
+    stats->playback_xruns = a[kStatPlaybackXruns];
+
+    stats->capture_process_avg_us = AverageUs(a, kStatCaptureProcessNs);
+    stats->capture_process_max_us = MaxUs(a, kStatCaptureProcessNs);
+    stats->encode_avg_us = AverageUs(a, kStatEncodeNs);
+    stats->encode_max_us = MaxUs(a, kStatEncodeNs);
+    stats->playback_avg_us = AverageUs(a, kStatPlaybackNs);
+    stats->playback_max_us = MaxUs(a, kStatPlaybackNs);
+    stats->network_avg_us = AverageUs(n, kStatNetworkProcessNs);
+    stats->network_max_us = MaxUs(n, kStatNetworkProcessNs);
+}
@@ -0,0 +1,160 @@
+#ifndef CALL_STATS_H
+#define CALL_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "voice_call.h"
+
+// 单写者的序列锁 (seqlock) 计数组
+// 写入方 (固定的一个线程) 在 BeginWrite/EndWrite 之间以 relaxed 原子操作修改字段，
+// 序列号在写入期间为奇数；读取方在序列号为偶数且读取前后一致时得到一致的快照，否则重试。
+// 写入方不加锁、不等待读取方，没有读取方时每次更新只多两次序列号写入
+template <size_t N>
+class SeqlockCounters {
+public:
+    SeqlockCounters() : sequence_(0) {
+        for (auto& value : values_) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void BeginWrite() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void EndWrite() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 以下只能在 BeginWrite/EndWrite 之间由写入方调用
+    void Set(size_t index, uint64_t value) {
+        values_[index].store(value, std::memory_order_relaxed);
+    }
+    void Add(size_t index, uint64_t delta) {
+        values_[index].store(values_[index].load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    void Max(size_t index, uint64_t value) {
+        if (value > values_[index].load(std::memory_order_relaxed)) {
+            values_[index].store(value, std::memory_order_relaxed);
+        }
+    }
+    // 耗时统计: first、first+1、first+2 依次为累计值、次数和最大值
+    void AddDuration(size_t first, uint64_t nanoseconds) {
+        Add(first, nanoseconds);
+        Add(first + 1, 1);
+        Max(first + 2, nanoseconds);
+    }
+
+    // 单个字段 (任意线程)
+    uint64_t Load(size_t index) const {
+        return values_[index].load(std::memory_order_relaxed);
+    }
+
+    // 一致的快照 (任意线程)
+    void Snapshot(uint64_t* out) const {
+        for (;;) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                out[i] = values_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+    }
+
+    // 清零 (没有写入方运行时调用)
+    void Reset() {
+        BeginWrite();
+        for (size_t i = 0; i < N; ++i) {
+            Set(i, 0);
+        }
+        EndWrite();
+    }
+
+private:
+    std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> values_[N];
+};
+
+// 音频线程写入的字段。接收流的统计在每次播放时汇总 (所有远端流合计，时延类取最大值)
+enum AudioStat {
+    kStatPacketsSent,
+    kStatBytesSent,
+    kStatDtxSuppressedFrames,
+    kStatTargetBitrate,
+    kStatSendBitrate,
+    kStatFecDepth,
+    kStatStreamPacketsLost,
+    kStatStreamPacketsRecovered,
+    kStatStreamRetransmitsRecovered,
+    kStatStreamPacketsReordered,
+    kStatStreamPacketsLate,
+    kStatStreamQueueDrops,
+    kStatStreamConcealedFrames,
+    kStatStreamAcceleratedFrames,
+    kStatStreamDeceleratedFrames,
+    kStatStreamNackRequests,
+    kStatRemoteStreams,
+    kStatJitterUs,
+    kStatRttUs,
+    kStatJitterBufferUs,
+    kStatCaptureXruns,
+    kStatPlaybackXruns,
+    kStatCaptureProcessNs,      // 采集处理链 (回声消除、噪声抑制、增益) 累计耗时
+    kStatCaptureProcessCount,
+    kStatCaptureProcessMaxNs,
+    kStatEncodeNs,              // 编码与发送
+    kStatEncodeCount,
+    kStatEncodeMaxNs,
+    kStatPlaybackNs,            // 拉取、混音与重采样
+    kStatPlaybackCount,
+    kStatPlaybackMaxNs,
+    kAudioStatCount
+};
+
+// 网络线程写入的字段
+enum NetworkStat {
+    kStatPacketsReceived,       // 其他成员的音频包 (含重传)
+    kStatBytesReceived,
+    kStatRetransmitsSent,
+    kStatDecryptFailures,       // 认证失败或未按要求加密而丢弃的音频包
+    kStatNetworkProcessNs,      // 处理一个收到的包
+    kStatNetworkProcessCount,
+    kStatNetworkProcessMaxNs,
+    kNetworkStatCount
+};
+
+// 通话统计: 音频线程与网络线程各写一组计数，读取方分别取快照后合并
+class CallStats {
+public:
+    SeqlockCounters<kAudioStatCount>& Audio() { return audio_; }
+    SeqlockCounters<kNetworkStatCount>& Network() { return network_; }
+    const SeqlockCounters<kNetworkStatCount>& Network() const { return network_; }
+
+    void Reset() {
+        audio_.Reset();
+        network_.Reset();
+    }
+    void Fill(voice_call_stats_t* stats) const;
+
+    static uint64_t NowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    SeqlockCounters<kAudioStatCount> audio_;
+    SeqlockCounters<kNetworkStatCount> network_;
+};
+
+#endif // CALL_STATS_H
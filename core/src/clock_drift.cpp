@@ -0,0 +1,139 @@
+#include "clock_drift.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 估计时钟比例所需的最小观测跨度 (秒)
+const double kMinTrendSpan = 10.0;
+// 前馈比例的合理范围，超出说明估计无效 (晶振偏差通常在 ±100ppm 内)
+const double kMaxDriftPpm = 1000.0;
+// 队列水位修正: 每秒水位误差对应的ppm，以及修正上限
+const double kLevelGainPpmPerSecond = 10000.0;
+const double kMaxLevelCorrectionPpm = 1000.0;
+// 总比例上限与每次更新的最大变化量
+const double kMaxRatioPpm = 2000.0;
+const double kMaxSlewPpm = 20.0;
+// 水位平滑系数
+const double kLevelSmoothing = 0.02;
+// 媒体时间与到达时间的偏差超过该值 (秒) 视为发送端重启
+const double kDiscontinuitySeconds = 1.0;
+
+} // namespace
+
+LinearTrendEstimator::LinearTrendEstimator(double forgetting)
+    : forgetting_(forgetting) {
+    Reset();
+}
+
+void LinearTrendEstimator::Reset() {
+    x0_ = 0.0;
+    y0_ = 0.0;
+    sw_ = sx_ = sy_ = sxx_ = sxy_ = 0.0;
+    first_x_ = 0.0;
+    last_x_ = 0.0;
+    count_ = 0;
+}
+
+void LinearTrendEstimator::AddPoint(double x, double y) {
+    if (count_ == 0) {
+        // 以第一个点为原点，避免累加量过大损失精度
+        x0_ = x;
+        y0_ = y;
+        first_x_ = x;
+    }
+    double dx = x - x0_;
+    double dy = y - y0_;
+    sw_ = sw_ * forgetting_ + 1.0;
+    sx_ = sx_ * forgetting_ + dx;
+    sy_ = sy_ * forgetting_ + dy;
+    sxx_ = sxx_ * forgetting_ + dx * dx;
+    sxy_ = sxy_ * forgetting_ + dx * dy;
+    last_x_ = x;
+    ++count_;
+}
+
+bool LinearTrendEstimator::GetSlope(double min_span, double* slope) const {
+    if (count_ < 3 || last_x_ - first_x_ < min_span) {
+        return false;
+    }
+    double denom = sw_ * sxx_ - sx_ * sx_;
+    if (denom <= 0.0) {
+        return false;
+    }
+    *slope = (sw_ * sxy_ - sx_ * sy_) / denom;
+    return true;
+}
+
+ClockDriftCompensator::ClockDriftCompensator()
+    : sample_rate_(16000)
+    , target_frames_(0) {
+    Reset();
+}
+
+void ClockDriftCompensator::Configure(int sample_rate, size_t target_frames) {
+    sample_rate_ = sample_rate;
+    target_frames_ = target_frames;
+    Reset();
+}
+
+void ClockDriftCompensator::Reset() {
+    arrival_trend_.Reset();
+    playout_trend_.Reset();
+    has_timestamp_ = false;
+    last_timestamp_ = 0;
+    extended_timestamp_ = 0;
+    last_arrival_ = 0.0;
+    played_frames_ = 0.0;
+    smoothed_level_ = static_cast<double>(target_frames_);
+    drift_ppm_ = 0.0;
+    ratio_ = 1.0;
+}
+
+void ClockDriftCompensator::OnPacketArrival(uint32_t media_timestamp, double arrival_seconds) {
+    if (has_timestamp_) {
+        int32_t delta = static_cast<int32_t>(media_timestamp - last_timestamp_);
+        double media_step = static_cast<double>(delta) / sample_rate_;
+        double arrival_step = arrival_seconds - last_arrival_;
+        if (std::fabs(media_step - arrival_step) > kDiscontinuitySeconds) {
+            arrival_trend_.Reset();
+        }
+        extended_timestamp_ += delta;
+    }
+    has_timestamp_ = true;
+    last_timestamp_ = media_timestamp;
+    last_arrival_ = arrival_seconds;
+
+    arrival_trend_.AddPoint(arrival_seconds, static_cast<double>(extended_timestamp_) / sample_rate_);
+}
+
+void ClockDriftCompensator::OnPlayout(size_t frames, double now_seconds) {
+    played_frames_ += static_cast<double>(frames);
+    playout_trend_.AddPoint(now_seconds, played_frames_ / sample_rate_);
+}
+
+double ClockDriftCompensator::UpdateRatio(size_t queued_frames) {
+    // 前馈: 发送端时钟 / 本地播放时钟
+    double arrival_slope = 1.0;
+    double playout_slope = 1.0;
+    if (arrival_trend_.GetSlope(kMinTrendSpan, &arrival_slope) &&
+        playout_trend_.GetSlope(kMinTrendSpan, &playout_slope) && playout_slope > 0.0) {
+        double ppm = (arrival_slope / playout_slope - 1.0) * 1e6;
+        if (std::fabs(ppm) <= kMaxDriftPpm) {
+            drift_ppm_ = ppm;
+        }
+    }
+
+    // 反馈: 队列水位偏离目标时缓慢加速或减速
+    smoothed_level_ += kLevelSmoothing * (static_cast<double>(queued_frames) - smoothed_level_);
+    double level_error = (smoothed_level_ - static_cast<double>(target_frames_)) / sample_rate_;
+    double correction_ppm = std::max(-kMaxLevelCorrectionPpm,
+                                     std::min(kMaxLevelCorrectionPpm, level_error * kLevelGainPpmPerSecond));
+
+    double target_ppm = std::max(-kMaxRatioPpm, std::min(kMaxRatioPpm, drift_ppm_ + correction_ppm));
+    double current_ppm = (ratio_ - 1.0) * 1e6;
+    double step = std::max(-kMaxSlewPpm, std::min(kMaxSlewPpm, target_ppm - current_ppm));
+    ratio_ = 1.0 + (current_ppm + step) * 1e-6;
+    return ratio_;
+}
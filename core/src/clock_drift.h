@@ -0,0 +1,70 @@
+#ifndef CLOCK_DRIFT_H
+#define CLOCK_DRIFT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 指数遗忘的在线线性回归，估计 y 相对 x 的斜率
+class LinearTrendEstimator {
+public:
+    explicit LinearTrendEstimator(double forgetting = 0.9995);
+
+    void Reset();
+    void AddPoint(double x, double y);
+
+    // 样点数与x的跨度足够时返回true并输出斜率
+    bool GetSlope(double min_span, double* slope) const;
+
+private:
+    double forgetting_;
+    double x0_;
+    double y0_;
+    double sw_, sx_, sy_, sxx_, sxy_;
+    double first_x_;
+    double last_x_;
+    size_t count_;
+};
+
+// 收发时钟漂移补偿
+// 由到达时间与媒体时间戳估计发送端采样时钟，由播放设备的实际消耗估计本地播放时钟，
+// 两者之比作为前馈比例；再叠加一个缓慢的队列水位修正，使接收队列收敛到目标深度。
+// 输出比例交给 FractionalResampler，每次调整的幅度受限，不会产生可闻的音调变化
+class ClockDriftCompensator {
+public:
+    ClockDriftCompensator();
+
+    // sample_rate 为网络采样率，target_frames 为期望的接收队列深度
+    void Configure(int sample_rate, size_t target_frames);
+    void Reset();
+
+    // 收到一个包: 媒体时间戳 (采样帧，32位回绕) 与本地到达时间 (秒)
+    void OnPacketArrival(uint32_t media_timestamp, double arrival_seconds);
+
+    // 播放设备消耗了 frames 帧 (换算到网络采样率，包含静音填充)
+    void OnPlayout(size_t frames, double now_seconds);
+
+    // 根据当前队列深度更新并返回重采样比例 (每个输出帧消耗的输入帧数)
+    double UpdateRatio(size_t queued_frames);
+
+    double GetRatio() const { return ratio_; }
+    // 估计的时钟漂移 (ppm)，正值表示发送端比本地播放快
+    double GetDriftPpm() const { return drift_ppm_; }
+
+private:
+    int sample_rate_;
+    size_t target_frames_;
+
+    LinearTrendEstimator arrival_trend_;
+    LinearTrendEstimator playout_trend_;
+    bool has_timestamp_;
+    uint32_t last_timestamp_;
+    int64_t extended_timestamp_;
+    double last_arrival_;
+    double played_frames_;
+
+    double smoothed_level_;
+    double drift_ppm_;
+    double ratio_;
+};
+
+#endif // CLOCK_DRIFT_H
@@ -0,0 +1,145 @@
+#include "comfort_noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio_kernels.h"
+
+namespace {
+
+// 自相关的帧间平滑
+const double kAutocorrSmoothing = 0.7;
+// 白噪声修正，保证Levinson递推数值稳定
+const double kWhiteNoiseCorrection = 1.0001;
+// 反射系数的幅度上限
+const double kMaxReflection = 0.99;
+
+// Levinson-Durbin 递推，由自相关求反射系数，返回预测误差与 r[0] 之比
+double ReflectionFromAutocorr(const double* r, double* k) {
+    double a[kComfortNoiseOrder + 1] = {1.0};
+    double tmp[kComfortNoiseOrder + 1];
+    double error = r[0] * kWhiteNoiseCorrection;
+    for (int i = 1; i <= kComfortNoiseOrder; ++i) {
+        if (error <= 0.0) {
+            std::fill(k + i - 1, k + kComfortNoiseOrder, 0.0);
+            break;
+        }
+        double acc = r[i];
+        for (int j = 1; j < i; ++j) {
+            acc += a[j] * r[i - j];
+        }
+        double ki = std::max(-kMaxReflection, std::min(kMaxReflection, -acc / error));
+        k[i - 1] = ki;
+        memcpy(tmp, a, sizeof(a));
+        for (int j = 1; j < i; ++j) {
+            a[j] = tmp[j] + ki * tmp[i - j];
+        }
+        a[i] = ki;
+        error *= 1.0 - ki * ki;
+    }
+    return r[0] > 0.0 ? error / r[0] : 1.0;
+}
+
+} // namespace
+
+ComfortNoiseEncoder::ComfortNoiseEncoder() {
+    Reset();
+}
+
+void ComfortNoiseEncoder::Reset() {
+    std::fill(autocorr_, autocorr_ + kComfortNoiseOrder + 1, 0.0);
+    initialized_ = false;
+}
+
+void ComfortNoiseEncoder::Analyze(const float* samples, size_t frames) {
+    if (frames <= static_cast<size_t>(kComfortNoiseOrder)) return;
+    for (int lag = 0; lag <= kComfortNoiseOrder; ++lag) {
+        double r = audio_kernels::DotProduct(samples, samples + lag, frames - lag) / static_cast<double>(frames);
+        autocorr_[lag] = initialized_ ? kAutocorrSmoothing * autocorr_[lag] + (1.0 - kAutocorrSmoothing) * r : r;
+    }
+    initialized_ = true;
+}
+
+float ComfortNoiseEncoder::GetLevelDb() const {
+    return static_cast<float>(10.0 * std::log10(autocorr_[0] + 1e-13));
+}
+
+size_t ComfortNoiseEncoder::Encode(uint8_t* out) const {
+    double k[kComfortNoiseOrder];
+    ReflectionFromAutocorr(autocorr_, k);
+    float level = std::max(0.0f, std::min(127.0f, -GetLevelDb()));
+    out[0] = static_cast<uint8_t>(level + 0.5f);
+    for (int i = 0; i < kComfortNoiseOrder; ++i) {
+        out[i + 1] = static_cast<uint8_t>(std::lround(k[i] * 127.0) + 127);
+    }
+    return kComfortNoiseDescriptorSize;
+}
+
+ComfortNoiseGenerator::ComfortNoiseGenerator()
+    : seed_(0x12345678u) {
+    Reset();
+}
+
+void ComfortNoiseGenerator::Reset() {
+    std::fill(lpc_, lpc_ + kComfortNoiseOrder, 0.0f);
+    std::fill(history_, history_ + kComfortNoiseOrder, 0.0f);
+    target_gain_ = 0.0f;
+    gain_ = 0.0f;
+    has_descriptor_ = false;
+}
+
+bool ComfortNoiseGenerator::Update(const uint8_t* data, size_t size) {
+    if (size < 1) return false;
+    double power = std::pow(10.0, -static_cast<double>(data[0]) / 10.0);
+
+    // 反射系数 -> 直接型LPC (step-up 递推)，同时累计预测误差比例
+    int order = static_cast<int>(std::min(size - 1, static_cast<size_t>(kComfortNoiseOrder)));
+    double a[kComfortNoiseOrder + 1] = {1.0};
+    double tmp[kComfortNoiseOrder + 1];
+    double residual = 1.0;
+    for (int i = 1; i <= order; ++i) {
+        double ki = (static_cast<int>(data[i]) - 127) / 127.0;
+        ki = std::max(-kMaxReflection, std::min(kMaxReflection, ki));
+        memcpy(tmp, a, sizeof(a));
+        for (int j = 1; j < i; ++j) {
+            a[j] = tmp[j] + ki * tmp[i - j];
+        }
+        a[i] = ki;
+        residual *= 1.0 - ki * ki;
+    }
+    for (int i = 0; i < kComfortNoiseOrder; ++i) {
+        lpc_[i] = i < order ? static_cast<float>(a[i + 1]) : 0.0f;
+    }
+    target_gain_ = static_cast<float>(std::sqrt(power * residual));
+    if (!has_descriptor_) {
+        gain_ = target_gain_;
+        std::fill(history_, history_ + kComfortNoiseOrder, 0.0f);
+    }
+    has_descriptor_ = true;
+    return true;
+}
+
+void ComfortNoiseGenerator::Generate(float* out, size_t frames) {
+    if (!has_descriptor_) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+    const float step = frames > 0 ? (target_gain_ - gain_) / static_cast<float>(frames) : 0.0f;
+    // 均匀分布 [-1, 1) 的方差为1/3，乘以sqrt(3)得到单位方差激励
+    const float kUniformScale = 1.7320508f / 2147483648.0f;
+    for (size_t n = 0; n < frames; ++n) {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        gain_ += step;
+        float y = gain_ * static_cast<float>(static_cast<int32_t>(seed_)) * kUniformScale;
+        for (int i = 0; i < kComfortNoiseOrder; ++i) {
+            y -= lpc_[i] * history_[i];
+        }
+        memmove(history_ + 1, history_, (kComfortNoiseOrder - 1) * sizeof(float));
+        history_[0] = y;
+        out[n] = y;
+    }
+    gain_ = target_gain_;
+}
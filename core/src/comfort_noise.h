@@ -0,0 +1,51 @@
+#ifndef COMFORT_NOISE_H
+#define COMFORT_NOISE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 舒适噪声描述符 (与 RFC 3389 类似):
+// 第0字节为噪声电平 (-dBFS，0~127)，其后为 order 个量化后的反射系数 (q = round(k*127)+127)
+const int kComfortNoiseOrder = 8;
+const size_t kComfortNoiseDescriptorSize = 1 + kComfortNoiseOrder;
+
+// 发送端: 在静音帧上平滑估计背景噪声的电平与频谱包络 (LPC)
+class ComfortNoiseEncoder {
+public:
+    ComfortNoiseEncoder();
+
+    void Reset();
+    // 分析一帧静音信号
+    void Analyze(const float* samples, size_t frames);
+    // 写出描述符，返回字节数
+    size_t Encode(uint8_t* out) const;
+    // 当前估计的噪声电平 (dBFS)
+    float GetLevelDb() const;
+
+private:
+    double autocorr_[kComfortNoiseOrder + 1];
+    bool initialized_;
+};
+
+// 接收端: 根据描述符用白噪声激励全极点滤波器生成舒适噪声
+class ComfortNoiseGenerator {
+public:
+    ComfortNoiseGenerator();
+
+    void Reset();
+    bool Update(const uint8_t* data, size_t size);
+    bool HasDescriptor() const { return has_descriptor_; }
+    // 生成 frames 个单声道样点，增益变化在帧内平滑过渡
+    void Generate(float* out, size_t frames);
+
+private:
+    float lpc_[kComfortNoiseOrder];
+    float history_[kComfortNoiseOrder];
+    float target_gain_;
+    float gain_;
+    uint32_t seed_;
+    bool has_descriptor_;
+};
+
+#endif // COMFORT_NOISE_H
@@ -0,0 +1,250 @@
+#include "echo_canceller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const size_t kMaxBlock = 128;
+const size_t kMinBlock = 16;
+// NLMS步长与其在双讲/收敛初期的下限比例
+const float kStepSize = 0.8f;
+const float kMinStepScale = 0.1f;
+// 正则化
+const float kRegularization = 1e-6f;
+// 远端块能量低于该值 (约 -60dBFS) 时不自适应
+const float kFarActiveEnergy = 1e-6f;
+// 持续发散多少个块后重置滤波器
+const int kDivergenceResetBlocks = 50;
+// 残差能量超过麦克风能量该倍数 (+3dB) 时视为发散。双讲时近端语音与回声的互相关项
+// 会使单个分块的残差略大于麦克风信号，不留余量会把这些分块的回声原样输出
+const float kDivergenceRatio = 2.0f;
+
+float Energy(const float* x, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * x[i];
+    }
+    return sum / static_cast<float>(n);
+}
+
+} // namespace
+
+EchoReferenceBuffer::EchoReferenceBuffer()
+    : write_pos_(0)
+    , written_(0) {
+}
+
+void EchoReferenceBuffer::Configure(size_t capacity_frames) {
+    buffer_.assign(capacity_frames, 0.0f);
+    Reset();
+}
+
+void EchoReferenceBuffer::Reset() {
+    std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+    write_pos_ = 0;
+    written_ = 0;
+}
+
+void EchoReferenceBuffer::Write(const float* samples, size_t frames) {
+    if (buffer_.empty()) return;
+    for (size_t i = 0; i < frames; ++i) {
+        buffer_[write_pos_] = samples[i];
+        write_pos_ = (write_pos_ + 1) % buffer_.size();
+    }
+    written_ += frames;
+}
+
+void EchoReferenceBuffer::WriteSilence(size_t frames) {
+    if (buffer_.empty()) return;
+    for (size_t i = 0; i < frames; ++i) {
+        buffer_[write_pos_] = 0.0f;
+        write_pos_ = (write_pos_ + 1) % buffer_.size();
+    }
+    written_ += frames;
+}
+
+void EchoReferenceBuffer::ReadAligned(float* out, size_t frames, size_t delay_frames) const {
+    const size_t capacity = buffer_.size();
+    size_t back = delay_frames + frames;
+    if (capacity == 0 || back > capacity) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+    size_t start = (write_pos_ + capacity - back) % capacity;
+    for (size_t i = 0; i < frames; ++i) {
+        // 尚未写入过的位置视为静音
+        bool valid = written_ >= back - i;
+        out[i] = valid ? buffer_[(start + i) % capacity] : 0.0f;
+    }
+}
+
+EchoCanceller::EchoCanceller()
+    : block_(0)
+    , partitions_(0)
+    , bins_(0)
+    , newest_(0)
+    , erle_db_(0.0f)
+    , divergence_blocks_(0) {
+}
+
+bool EchoCanceller::Configure(int sample_rate, size_t frame_frames, int tail_ms) {
+    block_ = 0;
+    size_t block = kMaxBlock;
+    while (block >= kMinBlock && frame_frames % block != 0) {
+        block /= 2;
+    }
+    if (block < kMinBlock || sample_rate <= 0 || tail_ms <= 0) {
+        return false;
+    }
+
+    block_ = block;
+    size_t tail_frames = static_cast<size_t>(sample_rate) * tail_ms / 1000;
+    partitions_ = std::max<size_t>(1, (tail_frames + block_ - 1) / block_);
+    fft_.reset(new RealFft(2 * block_));
+    bins_ = fft_->Bins();
+
+    far_prev_.assign(block_, 0.0f);
+    x_re_.assign(partitions_ * bins_, 0.0f);
+    x_im_.assign(partitions_ * bins_, 0.0f);
+    w_re_.assign(partitions_ * bins_, 0.0f);
+    w_im_.assign(partitions_ * bins_, 0.0f);
+    far_power_.assign(bins_, 0.0f);
+    time_buf_.assign(2 * block_, 0.0f);
+    y_re_.assign(bins_, 0.0f);
+    y_im_.assign(bins_, 0.0f);
+    e_re_.assign(bins_, 0.0f);
+    e_im_.assign(bins_, 0.0f);
+    g_re_.assign(bins_, 0.0f);
+    g_im_.assign(bins_, 0.0f);
+    Reset();
+    return true;
+}
+
+void EchoCanceller::Reset() {
+    std::fill(far_prev_.begin(), far_prev_.end(), 0.0f);
+    std::fill(x_re_.begin(), x_re_.end(), 0.0f);
+    std::fill(x_im_.begin(), x_im_.end(), 0.0f);
+    std::fill(w_re_.begin(), w_re_.end(), 0.0f);
+    std::fill(w_im_.begin(), w_im_.end(), 0.0f);
+    std::fill(far_power_.begin(), far_power_.end(), 0.0f);
+    newest_ = 0;
+    erle_db_ = 0.0f;
+    divergence_blocks_ = 0;
+}
+
+void EchoCanceller::Process(float* near, const float* far, size_t frames) {
+    if (!IsEnabled()) return;
+    for (size_t offset = 0; offset + block_ <= frames; offset += block_) {
+        ProcessBlock(near + offset, far + offset);
+    }
+}
+
+void EchoCanceller::ProcessBlock(float* near, const float* far) {
+    const size_t B = block_;
+    const size_t K = bins_;
+
+    // 1. 最新远端分块的频谱: FFT([上一块, 当前块])
+    newest_ = (newest_ + partitions_ - 1) % partitions_;
+    memcpy(time_buf_.data(), far_prev_.data(), B * sizeof(float));
+    memcpy(time_buf_.data() + B, far, B * sizeof(float));
+    memcpy(far_prev_.data(), far, B * sizeof(float));
+    float* xr0 = &x_re_[newest_ * K];
+    float* xi0 = &x_im_[newest_ * K];
+    fft_->Forward(time_buf_.data(), xr0, xi0);
+
+    // 2. 回声估计 Y = Σ W_p · X_p，取后半段；同时累计各频点在所有分块上的远端功率
+    std::fill(y_re_.begin(), y_re_.end(), 0.0f);
+    std::fill(y_im_.begin(), y_im_.end(), 0.0f);
+    std::fill(far_power_.begin(), far_power_.end(), 0.0f);
+    for (size_t p = 0; p < partitions_; ++p) {
+        size_t idx = ((newest_ + p) % partitions_) * K;
+        const float* xr = &x_re_[idx];
+        const float* xi = &x_im_[idx];
+        const float* wr = &w_re_[p * K];
+        const float* wi = &w_im_[p * K];
+        for (size_t k = 0; k < K; ++k) {
+            y_re_[k] += wr[k] * xr[k] - wi[k] * xi[k];
+            y_im_[k] += wr[k] * xi[k] + wi[k] * xr[k];
+            far_power_[k] += xr[k] * xr[k] + xi[k] * xi[k];
+        }
+    }
+    fft_->Inverse(y_re_.data(), y_im_.data(), time_buf_.data());
+    const float* echo = time_buf_.data() + B;
+
+    // 3. 残差
+    float error[kMaxBlock];
+    for (size_t i = 0; i < B; ++i) {
+        error[i] = near[i] - echo[i];
+    }
+    float near_energy = Energy(near, B);
+    float echo_energy = Energy(echo, B);
+    float error_energy = Energy(error, B);
+    float far_energy = Energy(far, B);
+
+    // 4. 自适应
+    if (far_energy > kFarActiveEnergy) {
+        float scale = echo_energy / (echo_energy + error_energy + kRegularization);
+        float step = kStepSize * std::max(kMinStepScale, std::min(1.0f, scale));
+
+        std::fill(time_buf_.begin(), time_buf_.begin() + B, 0.0f);
+        memcpy(time_buf_.data() + B, error, B * sizeof(float));
+        fft_->Forward(time_buf_.data(), e_re_.data(), e_im_.data());
+
+        float total_power = 0.0f;
+        for (size_t k = 0; k < K; ++k) {
+            total_power += far_power_[k];
+        }
+        const float floor = total_power / (K * partitions_) * 0.01f + kRegularization;
+        // 归一化功率取相邻频点的最大值: 梯度约束会把更新扩散到相邻频点，
+        // 浊音等谐波信号在谐波之间的频点功率极低，逐频点归一化会使这些频点的步长过大而发散
+        for (size_t k = 0; k < K; ++k) {
+            float power = far_power_[k];
+            if (k > 0) power = std::max(power, far_power_[k - 1]);
+            if (k + 1 < K) power = std::max(power, far_power_[k + 1]);
+            float norm = step / (power + floor);
+            e_re_[k] *= norm;
+            e_im_[k] *= norm;
+        }
+
+        for (size_t p = 0; p < partitions_; ++p) {
+            size_t idx = ((newest_ + p) % partitions_) * K;
+            const float* xr = &x_re_[idx];
+            const float* xi = &x_im_[idx];
+            // 梯度 conj(X) · E
+            for (size_t k = 0; k < K; ++k) {
+                g_re_[k] = xr[k] * e_re_[k] + xi[k] * e_im_[k];
+                g_im_[k] = xr[k] * e_im_[k] - xi[k] * e_re_[k];
+            }
+            // 约束: 时域后半段置零，避免循环卷积
+            fft_->Inverse(g_re_.data(), g_im_.data(), time_buf_.data());
+            std::fill(time_buf_.begin() + B, time_buf_.end(), 0.0f);
+            fft_->Forward(time_buf_.data(), g_re_.data(), g_im_.data());
+            float* wr = &w_re_[p * K];
+            float* wi = &w_im_[p * K];
+            for (size_t k = 0; k < K; ++k) {
+                wr[k] += g_re_[k];
+                wi[k] += g_im_[k];
+            }
+        }
+    }
+
+    // 5. 输出保护与发散检测
+    if (error_energy > near_energy * kDivergenceRatio && near_energy > kRegularization) {
+        if (++divergence_blocks_ > kDivergenceResetBlocks) {
+            std::fill(w_re_.begin(), w_re_.end(), 0.0f);
+            std::fill(w_im_.begin(), w_im_.end(), 0.0f);
+            divergence_blocks_ = 0;
+        }
+        // 滤波器明显增加能量时保留原信号
+        return;
+    }
+    divergence_blocks_ = 0;
+    memcpy(near, error, B * sizeof(float));
+
+    if (far_energy > kFarActiveEnergy && near_energy > kRegularization) {
+        float erle = 10.0f * std::log10((near_energy + kRegularization) / (error_energy + kRegularization));
+        erle_db_ = 0.98f * erle_db_ + 0.02f * erle;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef ECHO_CANCELLER_H
+#define ECHO_CANCELLER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+
+// 回声参考信号缓冲区
+// 播放路径写入混音器输出 (网络采样率)，捕获路径按估计的设备延迟取出与麦克风对齐的参考块
+class EchoReferenceBuffer {
+public:
+    EchoReferenceBuffer();
+
+    void Configure(size_t capacity_frames);
+    void Reset();
+
+    // 写入刚送往播放设备的参考信号
+    void Write(const float* samples, size_t frames);
+    // 写入静音
+    void WriteSilence(size_t frames);
+
+    // 读取结束于写指针之前 delay_frames 处的 frames 个样点，超出已写入范围的部分填0
+    void ReadAligned(float* out, size_t frames, size_t delay_frames) const;
+
+    size_t Capacity() const { return buffer_.size(); }
+
+private:
+    std::vector<float> buffer_;
+    size_t write_pos_;
+    size_t written_;
+};
+
+// 分块频域自适应回声消除器 (PBFDAF)
+// 回声路径被拆分为多个长度为B的分块，每个分块在2B点频域上独立自适应，
+// 梯度经过约束 (时域截断) 后更新，步长按频点 (及相邻频点) 在所有分块上的远端功率归一化。
+// 远端无信号时停止自适应，双讲时按回声估计与残差的比例降低步长，
+// 残差能量明显超过麦克风能量时直接输出麦克风信号并在持续发散时重置滤波器
+class EchoCanceller {
+public:
+    EchoCanceller();
+
+    // frame_frames 必须是分块长度的整数倍，分块长度取不超过128且能整除帧长的最大2的幂
+    bool Configure(int sample_rate, size_t frame_frames, int tail_ms = 128);
+    bool IsEnabled() const { return block_ > 0; }
+    void Reset();
+
+    // near 为麦克风信号 (就地写回消除后的信号)，far 为对齐后的参考信号，frames 为帧长的整数倍
+    void Process(float* near, const float* far, size_t frames);
+
+    // 平滑后的回声损耗增强 (dB)
+    float GetErleDb() const { return erle_db_; }
+    size_t GetBlockSize() const { return block_; }
+    size_t GetPartitions() const { return partitions_; }
+
+private:
+    void ProcessBlock(float* near, const float* far);
+
+    size_t block_;
+    size_t partitions_;
+    size_t bins_;
+    std::unique_ptr<RealFft> fft_;
+
+    std::vector<float> far_prev_;
+    std::vector<float> x_re_, x_im_;   // partitions_ * bins_ 远端频谱环
+    std::vector<float> w_re_, w_im_;   // partitions_ * bins_ 滤波器系数
+    size_t newest_;
+    std::vector<float> far_power_;     // 各频点在所有分块上的远端功率之和
+
+    std::vector<float> time_buf_;
+    std::vector<float> y_re_, y_im_;
+    std::vector<float> e_re_, e_im_;
+    std::vector<float> g_re_, g_im_;
+
+    float erle_db_;
+    int divergence_blocks_;
+};
+
+#endif // ECHO_CANCELLER_H
@@ -0,0 +1,186 @@
+#include "event_reactor.h"
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 节拍间隔 (毫秒)，与线程模式下音频循环的轮询间隔相同
+const int kReactorTickMs = 10;
+// 每次 epoll_wait 最多取出的事件数
+const int kMaxEvents = 64;
+
+} // namespace
+
+EventReactor::EventReactor(int tick_ms)
+    : tick_ms_(tick_ms), epoll_fd_(-1), timer_fd_(-1), wake_fd_(-1), running_(false) {
+}
+
+EventReactor::~EventReactor() {
+    Stop();
+}
+
+bool EventReactor::Start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || timer_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "Failed to create reactor: " << strerror(errno) << std::endl;
+        Stop();
+        return false;
+    }
+
+    itimerspec interval;
+    memset(&interval, 0, sizeof(interval));
+    interval.it_interval.tv_nsec = tick_ms_ * 1000000L;
+    interval.it_value = interval.it_interval;
+    timerfd_settime(timer_fd_, 0, &interval, nullptr);
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = timer_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    running_ = true;
+    thread_ = std::thread(&EventReactor::Loop, this);
+    return true;
+}
+
+void EventReactor::Stop() {
+    if (running_) {
+        running_ = false;
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            // 线程仍会在下一个节拍退出
+        }
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    for (int* fd : {&epoll_fd_, &timer_fd_, &wake_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool EventReactor::Add(int fd, ReactorHandler* handler) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        std::cerr << "Failed to add fd to reactor: " << strerror(errno) << std::endl;
+        return false;
+    }
+    handlers_[fd] = handler;
+    return true;
+}
+
+void EventReactor::Remove(int fd) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    handlers_.erase(fd);
+}
+
+size_t EventReactor::GetHandlerCount() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return handlers_.size();
+}
+
+void EventReactor::Loop() {
+    pthread_setname_np(pthread_self(), "vc-reactor");
+    epoll_event events[kMaxEvents];
+    while (running_) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Reactor epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        bool tick = false;
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == timer_fd_) {
+                uint64_t expirations;
+                if (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+                    tick = true;
+                }
+                continue;
+            }
+            if (fd == wake_fd_) {
+                continue;
+            }
+            // 取出事件后处理对象可能已注销
+            auto found = handlers_.find(fd);
+            if (found != handlers_.end()) {
+                found->second->OnReadable();
+            }
+        }
+
+        // 错过的节拍合并为一次，处理对象按设备的可读写数据量自行追赶
+        if (tick) {
+            tick_list_.assign(handlers_.begin(), handlers_.end());
+            for (const auto& entry : tick_list_) {
+                auto found = handlers_.find(entry.first);
+                if (found != handlers_.end() && found->second == entry.second) {
+                    entry.second->OnTick();
+                }
+            }
+        }
+    }
+}
+
+ReactorPool& ReactorPool::Instance() {
+    static ReactorPool pool;
+    return pool;
+}
+
+ReactorPool::ReactorPool() {
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    const char* env = std::getenv("VOICE_CALL_REACTOR_THREADS");
+    if (env && std::atoi(env) > 0) {
+        threads = std::atoi(env);
+    }
+    threads = std::max(threads, 1);
+    for (int i = 0; i < threads; ++i) {
+        std::unique_ptr<EventReactor> reactor(new EventReactor(kReactorTickMs));
+        if (reactor->Start()) {
+            reactors_.push_back(std::move(reactor));
+        }
+    }
+    std::cout << "Shared reactor pool started: " << reactors_.size() << " threads" << std::endl;
+}
+
+EventReactor* ReactorPool::Add(int fd, ReactorHandler* handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EventReactor* best = nullptr;
+    size_t best_count = 0;
+    for (const auto& reactor : reactors_) {
+        size_t count = reactor->GetHandlerCount();
+        if (!best || count < best_count) {
+            best = reactor.get();
+            best_count = count;
+        }
+    }
+    if (!best || !best->Add(fd, handler)) {
+        return nullptr;
+    }
+    return best;
+}
@@ -0,0 +1,67 @@
+#ifndef EVENT_REACTOR_H
+#define EVENT_REACTOR_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 反应器的处理对象: 套接字可读与周期节拍都在所属反应器的线程中回调，回调不能阻塞
+class ReactorHandler {
+public:
+    virtual ~ReactorHandler() {}
+    virtual void OnReadable() = 0;
+    virtual void OnTick() = 0;
+};
+
+// 单线程 epoll 事件循环。每个处理对象注册一个套接字，所有处理对象共享一个周期节拍 (timerfd)，
+// 同一个反应器上的回调串行执行
+class EventReactor {
+public:
+    explicit EventReactor(int tick_ms);
+    ~EventReactor();
+
+    bool Start();
+    void Stop();
+
+    // 可在任意线程调用 (包括回调中)；Remove 返回后不会再回调该处理对象
+    bool Add(int fd, ReactorHandler* handler);
+    void Remove(int fd);
+
+    size_t GetHandlerCount() const;
+
+private:
+    void Loop();
+
+    int tick_ms_;
+    int epoll_fd_;
+    int timer_fd_;
+    int wake_fd_;     // eventfd，Stop 时唤醒 epoll_wait
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    // 回调期间一直持有，Add/Remove 因此不会与回调并发；回调中注销自己时同一线程重入
+    mutable std::recursive_mutex mutex_;
+    std::map<int, ReactorHandler*> handlers_;
+    std::vector<std::pair<int, ReactorHandler*>> tick_list_;
+};
+
+// 进程内共享的反应器线程池，第一次使用时启动。
+// 线程数由环境变量 VOICE_CALL_REACTOR_THREADS 指定，默认为CPU核数
+class ReactorPool {
+public:
+    static ReactorPool& Instance();
+
+    // 注册到处理对象最少的反应器，失败时返回空
+    EventReactor* Add(int fd, ReactorHandler* handler);
+
+private:
+    ReactorPool();
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<EventReactor>> reactors_;
+};
+
+#endif // EVENT_REACTOR_H
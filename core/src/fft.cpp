@@ -0,0 +1,188 @@
+#include "fft.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_SSE 1
+#endif
+
+namespace {
+
+std::mutex g_plan_mutex;
+std::map<size_t, std::shared_ptr<const FftPlan>> g_plans;
+
+std::shared_ptr<FftPlan> CreatePlan(size_t size) {
+    auto plan = std::make_shared<FftPlan>();
+    plan->size = size;
+    plan->half = size / 2;
+    const size_t n = plan->half;
+
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < n) {
+        ++bits;
+    }
+    plan->bit_reverse.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            if (i & (static_cast<size_t>(1) << b)) {
+                r |= static_cast<size_t>(1) << (bits - 1 - b);
+            }
+        }
+        plan->bit_reverse[i] = r;
+    }
+
+    // 每一级 len 的旋转因子 e^{-2πij/len}, j = 0..len/2-1
+    for (size_t len = 2; len <= n; len <<= 1) {
+        for (size_t j = 0; j < len / 2; ++j) {
+            double angle = -2.0 * M_PI * j / len;
+            plan->stage_cos.push_back(static_cast<float>(std::cos(angle)));
+            plan->stage_sin.push_back(static_cast<float>(std::sin(angle)));
+        }
+    }
+
+    plan->post_cos.resize(n + 1);
+    plan->post_sin.resize(n + 1);
+    for (size_t k = 0; k <= n; ++k) {
+        double angle = -2.0 * M_PI * k / size;
+        plan->post_cos[k] = static_cast<float>(std::cos(angle));
+        plan->post_sin[k] = static_cast<float>(std::sin(angle));
+    }
+    return plan;
+}
+
+} // namespace
+
+std::shared_ptr<const FftPlan> GetFftPlan(size_t size) {
+    if (size < 4 || (size & (size - 1)) != 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(g_plan_mutex);
+    auto& plan = g_plans[size];
+    if (!plan) {
+        plan = CreatePlan(size);
+    }
+    return plan;
+}
+
+RealFft::RealFft(size_t size)
+    : plan_(GetFftPlan(size)) {
+    if (!plan_) {
+        plan_ = GetFftPlan(4);
+    }
+    work_re_.resize(plan_->half);
+    work_im_.resize(plan_->half);
+}
+
+void RealFft::ComplexTransform(float* re, float* im, bool inverse) {
+    const size_t n = plan_->half;
+    const std::vector<size_t>& rev = plan_->bit_reverse;
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = rev[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    const float sign = inverse ? -1.0f : 1.0f;
+    size_t twiddle_offset = 0;
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const size_t half = len / 2;
+        const float* wr = &plan_->stage_cos[twiddle_offset];
+        const float* wi = &plan_->stage_sin[twiddle_offset];
+        for (size_t start = 0; start < n; start += len) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+            size_t j = 0;
+#if defined(FFT_SSE)
+            const __m128 vsign = _mm_set1_ps(sign);
+            for (; j + 4 <= half; j += 4) {
+                __m128 cr = _mm_loadu_ps(wr + j);
+                __m128 ci = _mm_mul_ps(_mm_loadu_ps(wi + j), vsign);
+                __m128 xr = _mm_loadu_ps(br + j);
+                __m128 xi = _mm_loadu_ps(bi + j);
+                __m128 vr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                __m128 vi = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                __m128 ur = _mm_loadu_ps(ar + j);
+                __m128 ui = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(ar + j, _mm_add_ps(ur, vr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(ui, vi));
+                _mm_storeu_ps(br + j, _mm_sub_ps(ur, vr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(ui, vi));
+            }
+#endif
+            for (; j < half; ++j) {
+                float cr = wr[j];
+                float ci = wi[j] * sign;
+                float vr = br[j] * cr - bi[j] * ci;
+                float vi = br[j] * ci + bi[j] * cr;
+                float ur = ar[j];
+                float ui = ai[j];
+                ar[j] = ur + vr;
+                ai[j] = ui + vi;
+                br[j] = ur - vr;
+                bi[j] = ui - vi;
+            }
+        }
+        twiddle_offset += half;
+    }
+}
+
+void RealFft::Forward(const float* in, float* re, float* im) {
+    const size_t n = plan_->half;
+    float* zr = work_re_.data();
+    float* zi = work_im_.data();
+    for (size_t i = 0; i < n; ++i) {
+        zr[i] = in[2 * i];
+        zi[i] = in[2 * i + 1];
+    }
+    ComplexTransform(zr, zi, false);
+
+    // 由N/2点复数谱拆分出偶数/奇数样点的谱并合成实数谱
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0f;
+    re[n] = zr[0] - zi[0];
+    im[n] = 0.0f;
+    for (size_t k = 1; k < n; ++k) {
+        float ar = zr[k], ai = zi[k];
+        float br = zr[n - k], bi = -zi[n - k];   // conj(Z[n-k])
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        // Fo = (Zk - conj(Z[n-k])) / (2i)
+        float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+        float or_ = di, oi = -dr;
+        float wr = plan_->post_cos[k], wi = plan_->post_sin[k];
+        re[k] = er + (or_ * wr - oi * wi);
+        im[k] = ei + (or_ * wi + oi * wr);
+    }
+}
+
+void RealFft::Inverse(const float* re, const float* im, float* out) {
+    const size_t n = plan_->half;
+    float* zr = work_re_.data();
+    float* zi = work_im_.data();
+    for (size_t k = 0; k < n; ++k) {
+        float ar = re[k], ai = im[k];
+        float br = re[n - k], bi = -im[n - k];   // conj(X[n-k])
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+        // Fo = (Xk - conj(X[n-k])) / 2 * W^{-k}
+        float wr = plan_->post_cos[k], wi = -plan_->post_sin[k];
+        float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        // Z = Fe + i * Fo
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+    }
+    ComplexTransform(zr, zi, true);
+
+    const float scale = 1.0f / static_cast<float>(n);
+    for (size_t i = 0; i < n; ++i) {
+        out[2 * i] = zr[i] * scale;
+        out[2 * i + 1] = zi[i] * scale;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// 实数FFT
+// 长度为N的实数变换通过N/2点复数FFT实现，复数部分采用实部/虚部分离存储，
+// 蝶形运算在x86上使用SSE。旋转因子与位反转表按长度缓存，进程内共享，
+// 同一长度的多个 RealFft 实例不会重复计算
+struct FftPlan {
+    size_t size;                       // 实数长度 N (2的幂)
+    size_t half;                       // 复数长度 N/2
+    std::vector<size_t> bit_reverse;   // N/2 点位反转表
+    std::vector<float> stage_cos;      // 各级蝶形的旋转因子，按级连续存放
+    std::vector<float> stage_sin;
+    std::vector<float> post_cos;       // 实数后处理的旋转因子 e^{-2πik/N}
+    std::vector<float> post_sin;
+};
+
+// 获取长度为 size 的FFT计划 (size为2的幂且不小于4)
+std::shared_ptr<const FftPlan> GetFftPlan(size_t size);
+
+class RealFft {
+public:
+    explicit RealFft(size_t size);
+
+    size_t Size() const { return plan_->size; }
+    // 频点数 N/2 + 1
+    size_t Bins() const { return plan_->half + 1; }
+
+    // 正变换: in 为N个实数，re/im 各 N/2+1 个频点
+    void Forward(const float* in, float* re, float* im);
+
+    // 逆变换: 输出N个实数，已除以N
+    void Inverse(const float* re, const float* im, float* out);
+
+private:
+    void ComplexTransform(float* re, float* im, bool inverse);
+
+    std::shared_ptr<const FftPlan> plan_;
+    std::vector<float> work_re_;
+    std::vector<float> work_im_;
+};
+
+#endif // FFT_H
@@ -0,0 +1,194 @@
+#include "frame_trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+// 每个线程缓冲的事件数 (约192KB)，每帧都追踪时发送端音频线程约可记录50秒
+const size_t kEventsPerThread = 8192;
+
+const char* const kStageNames[kTraceStageCount] = {
+    "captured", "encoded", "sent", "server_rx", "server_tx", "received", "buffered", "played",
+};
+
+// 导出文件中事件行的开头，MergeTraceFiles 按它识别事件
+const char kEventLinePrefix[] = "{\"ph\":";
+
+// 当前线程的缓冲区 (FrameTracer::ThreadBuffer)
+thread_local void* t_buffer = nullptr;
+
+int64_t RealtimeMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t TraceId(uint32_t session_id, uint32_t timestamp) {
+    return (static_cast<uint64_t>(session_id) << 32) | timestamp;
+}
+
+void WriteHeader(std::ostream& out) {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+}
+
+void WriteFooter(std::ostream& out) {
+    out << "\n]}\n";
+}
+
+// 一个线程的事件: 每个阶段为一个切片，持续到同一线程上同一帧的下一阶段 (没有时为1微秒)，
+// 同一帧各阶段的切片由流事件 (s/t/f) 连起来
+void WriteThreadEvents(std::ostream& out, int pid, int tid, const std::vector<TraceEvent>& events, bool* first) {
+    std::vector<int64_t> durations(events.size(), 1);
+    std::unordered_map<uint64_t, size_t> last;
+    for (size_t i = 0; i < events.size(); ++i) {
+        uint64_t id = TraceId(events[i].session_id, events[i].timestamp);
+        auto found = last.find(id);
+        if (found != last.end() && events[found->second].stage + 1 == events[i].stage) {
+            durations[found->second] = std::max<int64_t>(events[i].time_us - events[found->second].time_us, 1);
+        }
+        last[id] = i;
+    }
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        if (event.stage >= kTraceStageCount) continue;
+        const char* flow = event.stage == kTraceCaptured ? "\"s\"" : event.stage == kTracePlayed ? "\"f\"" : "\"t\"";
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "%s{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"frame\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,"
+                 "\"args\":{\"session\":%u,\"timestamp\":%u}},\n"
+                 "{\"ph\":%s,\"name\":\"frame\",\"cat\":\"frame\",\"id\":%llu,\"pid\":%d,\"tid\":%d,\"ts\":%lld%s}",
+                 *first ? "" : ",\n", kStageNames[event.stage], pid, tid, static_cast<long long>(event.time_us),
+                 static_cast<long long>(durations[i]), event.session_id, event.timestamp, flow,
+                 static_cast<unsigned long long>(TraceId(event.session_id, event.timestamp)), pid, tid,
+                 static_cast<long long>(event.time_us), event.stage == kTraceCaptured ? "" : ",\"bp\":\"e\"");
+        out << line;
+        *first = false;
+    }
+}
+
+void WriteMetadata(std::ostream& out, const char* kind, int pid, int tid, const std::string& name, bool* first) {
+    out << (*first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"" << kind << "\",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"args\":{\"name\":\"" << name << "\"}}";
+    *first = false;
+}
+
+} // namespace
+
+FrameTracer& FrameTracer::Instance() {
+    // 不析构: 进程退出时其他线程可能仍在记录
+    static FrameTracer* tracer = new FrameTracer();
+    return *tracer;
+}
+
+FrameTracer::FrameTracer() : enabled_(false), sample_interval_(1), dropped_(0) {
+}
+
+void FrameTracer::Start(uint32_t sample_interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        buffer->count.store(0, std::memory_order_relaxed);
+    }
+    dropped_.store(0, std::memory_order_relaxed);
+    sample_interval_.store(std::max<uint32_t>(sample_interval, 1), std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+}
+
+bool FrameTracer::Stop(const std::string& path) {
+    enabled_.store(false, std::memory_order_relaxed);
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "无法写入追踪文件: " << path << std::endl;
+        return false;
+    }
+    const int pid = static_cast<int>(getpid());
+    bool first = true;
+    size_t total = 0;
+    WriteHeader(out);
+    WriteMetadata(out, "process_name", pid, 0, std::string(program_invocation_short_name) + " (voice_call)", &first);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        // 只读取已发布的事件，之后仍在写入的事件被忽略
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0) continue;
+        std::vector<TraceEvent> events(buffer->events.get(), buffer->events.get() + count);
+        WriteMetadata(out, "thread_name", pid, buffer->tid, buffer->name, &first);
+        WriteThreadEvents(out, pid, buffer->tid, events, &first);
+        total += count;
+    }
+    WriteFooter(out);
+    std::cout << "追踪已导出: " << path << ", 事件=" << total << ", 丢弃=" << dropped_.load() << std::endl;
+    return static_cast<bool>(out);
+}
+
+FrameTracer::ThreadBuffer* FrameTracer::RegisterThread() {
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    char name[16] = {0};
+    if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) {
+        buffer->name = name;
+    }
+    buffer->events.reset(new TraceEvent[kEventsPerThread]);
+    buffer->count.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(std::move(buffer));
+    return buffers_.back().get();
+}
+
+void FrameTracer::RecordEvent(TraceStage stage, uint32_t session_id, uint32_t timestamp) {
+    if (!t_buffer) {
+        t_buffer = RegisterThread();
+    }
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(t_buffer);
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= kEventsPerThread) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = buffer->events[index];
+    event.time_us = RealtimeMicros();
+    event.session_id = session_id;
+    event.timestamp = timestamp;
+    event.stage = stage;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool MergeTraceFiles(const std::vector<std::string>& inputs, const std::string& output) {
+    std::vector<std::unique_ptr<std::ifstream>> files;
+    for (const auto& input : inputs) {
+        files.emplace_back(new std::ifstream(input));
+        if (!*files.back()) {
+            std::cerr << "无法读取追踪文件: " << input << std::endl;
+            return false;
+        }
+    }
+    std::ofstream out(output);
+    if (!out) {
+        std::cerr << "无法写入追踪文件: " << output << std::endl;
+        return false;
+    }
+    bool first = true;
+    WriteHeader(out);
+    for (const auto& file : files) {
+        std::istream& in = *file;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, sizeof(kEventLinePrefix) - 1, kEventLinePrefix) != 0) continue;
+            if (!line.empty() && line.back() == ',') {
+                line.pop_back();
+            }
+            out << (first ? "" : ",\n") << line;
+            first = false;
+        }
+    }
+    WriteFooter(out);
+    return static_cast<bool>(out);
+}
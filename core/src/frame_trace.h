@@ -0,0 +1,83 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一帧经过的阶段，按先后顺序排列。发送端、服务器与接收端各自记录，
+// 追踪ID为 (发送者会话ID, 帧的媒体时间戳)，导出后同一帧的事件连成一条流
+enum TraceStage : uint8_t {
+    kTraceCaptured = 0,   // 发送端: 这一帧的第一个采集周期读出 (音频线程)
+    kTraceEncoded,        // 发送端: 编码完成
+    kTraceSent,           // 发送端: 调用 send (分片的帧为第一个分片)
+    kTraceServerRx,       // 服务器: 收到
+    kTraceServerTx,       // 服务器: 转发给房间内其他成员
+    kTraceReceived,       // 接收端: 网络线程收到
+    kTraceBuffered,       // 接收端: 放入接收队列
+    kTracePlayed,         // 接收端: 从接收队列取出解码，同一周期内混音写入播放设备 (音频线程)
+    kTraceStageCount
+};
+
+struct TraceEvent {
+    int64_t time_us;      // CLOCK_REALTIME 微秒，客户端与服务器在不同机器上时依赖NTP对时
+    uint32_t session_id;
+    uint32_t timestamp;
+    uint8_t stage;
+};
+
+// 进程内的帧追踪器 (单例)
+// 发送端按采样间隔给选中的帧打上 kPacketFlagTraced，服务器与接收端只记录带标志的包。
+// 每个记录事件的线程第一次记录时分配自己的定长缓冲区，线程只写自己的缓冲区 (单写者，无锁)，
+// 写满后丢弃之后的事件。未开启时 Record 只有一次 relaxed 原子读
+class FrameTracer {
+public:
+    static FrameTracer& Instance();
+
+    // 清空之前的事件并开始追踪，发送端每 sample_interval 帧追踪一帧
+    void Start(uint32_t sample_interval);
+    // 停止追踪，把事件导出为 Chrome trace JSON (chrome://tracing 与 Perfetto UI 均可打开)
+    bool Stop(const std::string& path);
+
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 发送端在每帧开始时调用，决定这一帧是否追踪 (counter 为发送者自己的帧计数)
+    bool ShouldSample(uint32_t* counter) const {
+        return IsEnabled() && (*counter)++ % sample_interval_.load(std::memory_order_relaxed) == 0;
+    }
+
+    void Record(TraceStage stage, uint32_t session_id, uint32_t timestamp) {
+        if (IsEnabled()) {
+            RecordEvent(stage, session_id, timestamp);
+        }
+    }
+
+private:
+    struct ThreadBuffer {
+        int tid;
+        std::string name;
+        std::unique_ptr<TraceEvent[]> events;
+        std::atomic<size_t> count;
+    };
+
+    FrameTracer();
+    void RecordEvent(TraceStage stage, uint32_t session_id, uint32_t timestamp);
+    ThreadBuffer* RegisterThread();
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint32_t> sample_interval_;
+    std::atomic<uint64_t> dropped_;
+    std::mutex mutex_;
+    // 缓冲区在进程内一直保留，线程退出后仍可导出它记录的事件
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// 合并多个导出的追踪文件 (例如客户端与服务器各自导出的文件)。
+// 各文件的时间戳都是 CLOCK_REALTIME 微秒，按行取出事件拼接即可，同一帧的流按追踪ID自动连上
+bool MergeTraceFiles(const std::vector<std::string>& inputs, const std::string& output);
+
+#endif // FRAME_TRACE_H
@@ -0,0 +1,121 @@
+#include "ima_adpcm.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ima_adpcm {
+
+namespace {
+
+const int kIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+const int kStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+const size_t kChannelHeaderSize = 4;
+const int kMaxChannels = 8;
+
+inline int ClampIndex(int index) {
+    return std::max(0, std::min(88, index));
+}
+
+// 由4bit码字更新预测值与步长索引
+inline void DecodeNibble(int nibble, int* predictor, int* index) {
+    int step = kStepTable[*index];
+    int diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    *predictor += (nibble & 8) ? -diff : diff;
+    *predictor = std::max(-32768, std::min(32767, *predictor));
+    *index = ClampIndex(*index + kIndexTable[nibble]);
+}
+
+} // namespace
+
+void ResetEncoder(EncoderState* state) {
+    std::fill(state->index, state->index + kMaxChannels, 0);
+}
+
+size_t EncodedSize(int channels, size_t frames) {
+    if (channels <= 0 || frames == 0) return 0;
+    return static_cast<size_t>(channels) * (kChannelHeaderSize + frames / 2);
+}
+
+size_t DecodedFrames(int channels, size_t size) {
+    if (channels <= 0 || size % channels != 0 || size / channels <= kChannelHeaderSize) return 0;
+    return (size / channels - kChannelHeaderSize) * 2;
+}
+
+size_t Encode(EncoderState* state, const int16_t* pcm, int channels, size_t frames,
+              uint8_t* out, size_t capacity) {
+    size_t total = EncodedSize(channels, frames);
+    if (total == 0 || total > capacity || channels > kMaxChannels) {
+        return 0;
+    }
+    const size_t per_channel = kChannelHeaderSize + frames / 2;
+    for (int ch = 0; ch < channels; ++ch) {
+        uint8_t* block = out + ch * per_channel;
+        int predictor = pcm[ch];
+        int index = ClampIndex(state->index[ch]);
+        uint16_t first = static_cast<uint16_t>(static_cast<int16_t>(predictor));
+        block[0] = static_cast<uint8_t>(first & 0xff);
+        block[1] = static_cast<uint8_t>(first >> 8);
+        block[2] = static_cast<uint8_t>(index);
+        block[3] = 0;
+        memset(block + kChannelHeaderSize, 0, frames / 2);
+
+        for (size_t i = 1; i < frames; ++i) {
+            int diff = pcm[i * channels + ch] - predictor;
+            int step = kStepTable[index];
+            int nibble = 0;
+            if (diff < 0) {
+                nibble = 8;
+                diff = -diff;
+            }
+            if (diff >= step) { nibble |= 4; diff -= step; }
+            if (diff >= (step >> 1)) { nibble |= 2; diff -= step >> 1; }
+            if (diff >= (step >> 2)) { nibble |= 1; }
+            DecodeNibble(nibble, &predictor, &index);
+
+            size_t pos = i - 1;
+            block[kChannelHeaderSize + pos / 2] |= static_cast<uint8_t>(nibble << ((pos & 1) * 4));
+        }
+        state->index[ch] = index;
+    }
+    return total;
+}
+
+bool Decode(const uint8_t* data, size_t size, int channels, size_t frames, int16_t* pcm) {
+    if (size != EncodedSize(channels, frames) || size == 0) {
+        return false;
+    }
+    const size_t per_channel = kChannelHeaderSize + frames / 2;
+    for (int ch = 0; ch < channels; ++ch) {
+        const uint8_t* block = data + ch * per_channel;
+        int predictor = static_cast<int16_t>(static_cast<uint16_t>(block[0] | (block[1] << 8)));
+        int index = ClampIndex(block[2]);
+        pcm[ch] = static_cast<int16_t>(predictor);
+        for (size_t i = 1; i < frames; ++i) {
+            size_t pos = i - 1;
+            int nibble = (block[kChannelHeaderSize + pos / 2] >> ((pos & 1) * 4)) & 0x0f;
+            DecodeNibble(nibble, &predictor, &index);
+            pcm[i * channels + ch] = static_cast<int16_t>(predictor);
+        }
+    }
+    return true;
+}
+
+} // namespace ima_adpcm
@@ -0,0 +1,33 @@
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM 编解码 (4 bit/样点，约为PCM16的1/4)
+// 每个块独立可解码: 每个声道以4字节块头 (首样点int16、步长索引、保留) 开始，
+// 其后为该声道其余样点的4bit编码 (低半字节在前)，各声道依次排列
+namespace ima_adpcm {
+
+// 编码器在块之间保留的状态，使步长索引连续自适应
+struct EncoderState {
+    int index[8];
+};
+
+void ResetEncoder(EncoderState* state);
+
+// 编码 frames 帧的交错PCM，返回写入字节数，容量不足返回0
+size_t Encode(EncoderState* state, const int16_t* pcm, int channels, size_t frames,
+              uint8_t* out, size_t capacity);
+
+// 一个块的编码长度
+size_t EncodedSize(int channels, size_t frames);
+// 由编码长度反推帧数 (帧数按偶数计)，长度无效时返回0
+size_t DecodedFrames(int channels, size_t size);
+
+// 解码为交错PCM，数据长度与 frames 不匹配时返回false
+bool Decode(const uint8_t* data, size_t size, int channels, size_t frames, int16_t* pcm);
+
+} // namespace ima_adpcm
+
+#endif // IMA_ADPCM_H
@@ -0,0 +1,136 @@
+#include "noise_suppressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const size_t kMinHop = 32;
+// 功率谱的时间平滑
+const float kPowerSmoothing = 0.7f;
+// 噪声底上升速度 (dB/秒)，语音结束后噪声估计缓慢回升
+const float kNoiseRiseDbPerSecond = 3.0f;
+// 平滑功率的最小值跟踪会低估噪声均值，按约1.8dB补偿
+const float kNoiseBias = 1.5f;
+// 判决引导的平滑系数
+const float kDecisionDirectedAlpha = 0.98f;
+// 最大抑制量 (增益下限)，约 -18dB
+const float kMinGain = 0.125f;
+// 启动阶段直接用平滑功率初始化噪声估计的跳数
+const size_t kStartupHops = 10;
+const float kEpsilon = 1e-10f;
+
+} // namespace
+
+NoiseSuppressor::NoiseSuppressor()
+    : hop_(0)
+    , bins_(0)
+    , rise_factor_(1.0f)
+    , hops_processed_(0)
+    , average_gain_db_(0.0f) {
+}
+
+bool NoiseSuppressor::Configure(int sample_rate, size_t frame_frames) {
+    hop_ = 0;
+    if (sample_rate <= 0) {
+        return false;
+    }
+    size_t hop = kMinHop;
+    while (hop * 2 <= static_cast<size_t>(sample_rate) / 125) {
+        hop *= 2;
+    }
+    while (hop >= kMinHop && frame_frames % hop != 0) {
+        hop /= 2;
+    }
+    if (hop < kMinHop) {
+        return false;
+    }
+
+    hop_ = hop;
+    const size_t n = 2 * hop_;
+    fft_.reset(new RealFft(n));
+    bins_ = fft_->Bins();
+    rise_factor_ = std::pow(10.0f, kNoiseRiseDbPerSecond / 10.0f * hop_ / sample_rate);
+
+    // 周期sqrt-Hann窗，分析与合成各用一次，50%重叠时满足完全重构
+    window_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        window_[i] = std::sqrt(0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / n));
+    }
+    analysis_.assign(n, 0.0f);
+    overlap_.assign(hop_, 0.0f);
+    time_buf_.assign(n, 0.0f);
+    re_.assign(bins_, 0.0f);
+    im_.assign(bins_, 0.0f);
+    smoothed_power_.assign(bins_, 0.0f);
+    noise_power_.assign(bins_, 0.0f);
+    prev_gain_.assign(bins_, 1.0f);
+    prev_post_snr_.assign(bins_, 1.0f);
+    Reset();
+    return true;
+}
+
+void NoiseSuppressor::Reset() {
+    std::fill(analysis_.begin(), analysis_.end(), 0.0f);
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    std::fill(smoothed_power_.begin(), smoothed_power_.end(), 0.0f);
+    std::fill(noise_power_.begin(), noise_power_.end(), 0.0f);
+    std::fill(prev_gain_.begin(), prev_gain_.end(), 1.0f);
+    std::fill(prev_post_snr_.begin(), prev_post_snr_.end(), 1.0f);
+    hops_processed_ = 0;
+    average_gain_db_ = 0.0f;
+}
+
+void NoiseSuppressor::Process(float* samples, size_t frames) {
+    if (!IsEnabled()) return;
+    for (size_t offset = 0; offset + hop_ <= frames; offset += hop_) {
+        ProcessHop(samples + offset);
+    }
+}
+
+void NoiseSuppressor::ProcessHop(float* samples) {
+    const size_t n = 2 * hop_;
+
+    memmove(analysis_.data(), analysis_.data() + hop_, hop_ * sizeof(float));
+    memcpy(analysis_.data() + hop_, samples, hop_ * sizeof(float));
+    for (size_t i = 0; i < n; ++i) {
+        time_buf_[i] = analysis_[i] * window_[i];
+    }
+    fft_->Forward(time_buf_.data(), re_.data(), im_.data());
+
+    const bool startup = hops_processed_ < kStartupHops;
+    float gain_sum = 0.0f;
+    for (size_t k = 0; k < bins_; ++k) {
+        float power = re_[k] * re_[k] + im_[k] * im_[k];
+        smoothed_power_[k] = kPowerSmoothing * smoothed_power_[k] + (1.0f - kPowerSmoothing) * power;
+
+        // 噪声底跟踪: 低于估计时立即跟随，高于估计时按固定速度缓慢上升
+        float& noise = noise_power_[k];
+        if (startup || smoothed_power_[k] < noise) {
+            noise = smoothed_power_[k];
+        } else {
+            noise = noise * rise_factor_ + kEpsilon;
+        }
+
+        // 维纳增益，先验信噪比由判决引导法估计
+        float post_snr = power / (kNoiseBias * noise + kEpsilon);
+        float prior_snr = kDecisionDirectedAlpha * prev_gain_[k] * prev_gain_[k] * prev_post_snr_[k] +
+                          (1.0f - kDecisionDirectedAlpha) * std::max(post_snr - 1.0f, 0.0f);
+        float gain = std::max(kMinGain, prior_snr / (1.0f + prior_snr));
+
+        prev_gain_[k] = gain;
+        prev_post_snr_[k] = post_snr;
+        re_[k] *= gain;
+        im_[k] *= gain;
+        gain_sum += gain;
+    }
+    ++hops_processed_;
+    average_gain_db_ = 20.0f * std::log10(gain_sum / bins_ + kEpsilon);
+
+    fft_->Inverse(re_.data(), im_.data(), time_buf_.data());
+    for (size_t i = 0; i < hop_; ++i) {
+        samples[i] = overlap_[i] + time_buf_[i] * window_[i];
+        overlap_[i] = time_buf_[hop_ + i] * window_[hop_ + i];
+    }
+}
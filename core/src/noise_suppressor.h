@@ -0,0 +1,53 @@
+#ifndef NOISE_SUPPRESSOR_H
+#define NOISE_SUPPRESSOR_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+
+// 低复杂度谱减噪声抑制器
+// 50%重叠的sqrt-Hann窗STFT，每个频点跟踪噪声底 (快降慢升)，
+// 用判决引导的先验信噪比计算维纳增益，增益下限限制最大抑制量以避免音乐噪声。
+// 所有缓冲区在 Configure 中分配，处理过程中不再分配内存。
+// 输出相对输入延迟一个跳步 (hop) 的长度
+class NoiseSuppressor {
+public:
+    NoiseSuppressor();
+
+    // frame_frames 必须是跳步长度的整数倍，跳步取不超过 sample_rate/125 且能整除帧长的最大2的幂
+    bool Configure(int sample_rate, size_t frame_frames);
+    bool IsEnabled() const { return hop_ > 0; }
+    void Reset();
+
+    // 就地处理单声道信号，frames 为跳步长度的整数倍
+    void Process(float* samples, size_t frames);
+
+    size_t GetHopSize() const { return hop_; }
+    // 最近一帧的平均增益 (dB，<=0)
+    float GetAverageGainDb() const { return average_gain_db_; }
+
+private:
+    void ProcessHop(float* samples);
+
+    size_t hop_;
+    size_t bins_;
+    float rise_factor_;
+    std::unique_ptr<RealFft> fft_;
+
+    std::vector<float> window_;
+    std::vector<float> analysis_;   // 最近 2*hop 个输入样点
+    std::vector<float> overlap_;    // 上一跳合成输出的后半段
+    std::vector<float> time_buf_;
+    std::vector<float> re_, im_;
+
+    std::vector<float> smoothed_power_;
+    std::vector<float> noise_power_;
+    std::vector<float> prev_gain_;
+    std::vector<float> prev_post_snr_;
+    size_t hops_processed_;
+    float average_gain_db_;
+};
+
+#endif // NOISE_SUPPRESSOR_H
@@ -0,0 +1,213 @@
+#include "payload_crypto.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <random>
+
+namespace {
+
+// 附加认证数据: 序列号、时间戳、会话ID (包头前12字节)、负载类型、参与认证的标志位
+const size_t kAadSize = 14;
+const uint8_t kAuthenticatedFlags = kPacketFlagFragment | kPacketFlagEncrypted;
+const uint8_t kKeyLabel[4] = {'V', 'C', 'M', 'K'};
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+uint32_t RandomEpoch() {
+    std::random_device device;
+    return static_cast<uint32_t>(device());
+}
+
+} // namespace
+
+PayloadCrypto::PayloadCrypto()
+    : enabled_(false)
+    , key_size_(0)
+    , send_ready_(false)
+    , send_session_(kUnassignedSessionId)
+    , send_epoch_(0)
+    , last_sequence_(0) {
+}
+
+bool PayloadCrypto::SetKey(const char* hex_key) {
+    enabled_ = false;
+    send_ready_ = false;
+    receive_sessions_.clear();
+    size_t length = hex_key ? strlen(hex_key) : 0;
+    if (length == 0) {
+        return true;
+    }
+    if (length != 32 && length != 64) {
+        return false;
+    }
+    uint8_t key[32];
+    for (size_t i = 0; i < length / 2; ++i) {
+        int high = HexValue(hex_key[2 * i]);
+        int low = HexValue(hex_key[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        key[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    key_size_ = length / 2;
+    room_cipher_.SetKey(key, key_size_);
+    memset(key, 0, sizeof(key));
+    enabled_ = true;
+    return true;
+}
+
+// 会话密钥的每个16字节块为 AES_房间密钥(标签 | 会话ID | 纪元 | 块号)
+void PayloadCrypto::DeriveSessionKey(uint32_t session_id, uint32_t epoch, AesGcm* cipher) const {
+    uint8_t key[32];
+    for (size_t block = 0; block < key_size_ / AesGcm::kBlockSize; ++block) {
+        uint8_t input[AesGcm::kBlockSize] = {0};
+        memcpy(input, kKeyLabel, sizeof(kKeyLabel));
+        uint32_t value = htonl(session_id);
+        memcpy(input + 4, &value, 4);
+        value = htonl(epoch);
+        memcpy(input + 8, &value, 4);
+        input[15] = static_cast<uint8_t>(block + 1);
+        room_cipher_.EncryptBlock(input, key + block * AesGcm::kBlockSize);
+    }
+    cipher->SetKey(key, key_size_);
+    memset(key, 0, sizeof(key));
+}
+
+void PayloadCrypto::BuildNonce(uint32_t session_id, uint32_t epoch, uint32_t sequence, uint8_t* nonce) {
+    uint32_t values[3] = {htonl(session_id), htonl(epoch), htonl(sequence)};
+    memcpy(nonce, values, AesGcm::kNonceSize);
+}
+
+void PayloadCrypto::BuildAad(const AudioPacket& packet, uint8_t* aad) {
+    memcpy(aad, &packet, 12);
+    aad[12] = packet.payload_type;
+    aad[13] = packet.flags & kAuthenticatedFlags;
+}
+
+size_t PayloadCrypto::Seal(AudioPacket* packet, size_t size) {
+    const uint32_t session_id = ntohl(packet->session_id);
+    const uint32_t sequence = ntohl(packet->sequence);
+    // 会话ID变化 (重新加入) 或序列号回绕后换新的纪元，保证 nonce 在同一密钥下不重复
+    if (!send_ready_ || session_id != send_session_ || sequence <= last_sequence_) {
+        send_session_ = session_id;
+        send_epoch_ = RandomEpoch();
+        DeriveSessionKey(send_session_, send_epoch_, &send_cipher_);
+        send_ready_ = true;
+    }
+    last_sequence_ = sequence;
+
+    uint8_t nonce[AesGcm::kNonceSize];
+    uint8_t aad[kAadSize];
+    BuildNonce(session_id, send_epoch_, sequence, nonce);
+    BuildAad(*packet, aad);
+    uint8_t* trailer = packet->data + size;
+    uint32_t epoch = htonl(send_epoch_);
+    memcpy(trailer, &epoch, sizeof(epoch));
+    send_cipher_.Seal(nonce, aad, sizeof(aad), packet->data, size, packet->data, trailer + sizeof(epoch));
+    return size + kPayloadCryptoTrailerSize;
+}
+
+bool PayloadCrypto::ReplayWindow::IsReplay(uint32_t sequence) const {
+    if (!has_sequence || sequence > highest) {
+        return false;
+    }
+    const uint32_t age = highest - sequence;
+    return age >= kReplayWindowSize || ((bitmap >> age) & 1) != 0;
+}
+
+void PayloadCrypto::ReplayWindow::Accept(uint32_t sequence) {
+    if (!has_sequence) {
+        has_sequence = true;
+        highest = sequence;
+        bitmap = 1;
+    } else if (sequence > highest) {
+        const uint32_t shift = sequence - highest;
+        bitmap = shift >= kReplayWindowSize ? 1 : (bitmap << shift) | 1;
+        highest = sequence;
+    } else {
+        bitmap |= uint64_t(1) << (highest - sequence);
+    }
+}
+
+PayloadCrypto::OpenResult PayloadCrypto::Open(const AudioPacket& packet, size_t size, AudioPacket* out) {
+    if (!enabled_ || !(packet.flags & kPacketFlagEncrypted) || size < kPayloadCryptoTrailerSize) {
+        return kOpenRejected;
+    }
+    const size_t plain_size = size - kPayloadCryptoTrailerSize;
+    const uint8_t* trailer = packet.data + plain_size;
+    uint32_t epoch;
+    memcpy(&epoch, trailer, sizeof(epoch));
+    epoch = ntohl(epoch);
+    const uint32_t session_id = ntohl(packet.session_id);
+    const uint32_t sequence = ntohl(packet.sequence);
+
+    // 已缓存的纪元: 先查重放窗口 (不需要解密)，认证通过后才记入窗口
+    auto found = receive_sessions_.find(session_id);
+    ReceiveKey* key = nullptr;
+    if (found != receive_sessions_.end()) {
+        ReceiveSession& session = found->second;
+        if (session.current.epoch == epoch) {
+            key = &session.current;
+        } else if (session.has_previous && session.previous.epoch == epoch) {
+            key = &session.previous;
+        } else {
+            const size_t retired = session.retired_count < kRetiredEpochs ? session.retired_count : kRetiredEpochs;
+            for (size_t i = 0; i < retired; ++i) {
+                if (session.retired_epochs[i] == epoch) {
+                    return kOpenReplayed;
+                }
+            }
+        }
+    }
+    if (key && key->window.IsReplay(sequence)) {
+        return kOpenReplayed;
+    }
+
+    uint8_t nonce[AesGcm::kNonceSize];
+    uint8_t aad[kAadSize];
+    BuildNonce(session_id, epoch, sequence, nonce);
+    BuildAad(packet, aad);
+    memcpy(out, &packet, kAudioPacketHeaderSize);
+    out->data_size = htons(static_cast<uint16_t>(plain_size));
+
+    if (key) {
+        if (!key->cipher.Open(nonce, aad, sizeof(aad), packet.data, plain_size, out->data, trailer + sizeof(epoch))) {
+            return kOpenRejected;
+        }
+        key->window.Accept(sequence);
+        return kOpenOk;
+    }
+    // 新的发送者或新的纪元: 认证通过后才换成当前纪元，伪造的包不会影响正常的流
+    ReceiveKey candidate;
+    candidate.epoch = epoch;
+    DeriveSessionKey(session_id, epoch, &candidate.cipher);
+    if (!candidate.cipher.Open(nonce, aad, sizeof(aad), packet.data, plain_size, out->data,
+                               trailer + sizeof(epoch))) {
+        return kOpenRejected;
+    }
+    candidate.window.Accept(sequence);
+    if (found == receive_sessions_.end()) {
+        receive_sessions_[session_id].current = candidate;
+        return kOpenOk;
+    }
+    ReceiveSession& session = found->second;
+    if (session.has_previous) {
+        // 最早换下的纪元被覆盖
+        session.retired_epochs[session.retired_count % kRetiredEpochs] = session.previous.epoch;
+        ++session.retired_count;
+    }
+    session.previous = session.current;
+    session.has_previous = true;
+    session.current = candidate;
+    return kOpenOk;
+}
+
+void PayloadCrypto::RemoveSession(uint32_t session_id) {
+    receive_sessions_.erase(session_id);
+}
@@ -0,0 +1,96 @@
+#ifndef PAYLOAD_CRYPTO_H
+#define PAYLOAD_CRYPTO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "aes_gcm.h"
+#include "voice_packet.h"
+
+// 音频负载的端到端认证加密 (AES-GCM)
+// 房间内所有成员配置同一个房间密钥 (media_key)。每个发送者连接时随机选取32位密钥纪元，
+// 会话密钥 = AES_房间密钥("VCMK" | 会话ID | 纪元 | 块号)，因此服务器重新分配会话ID或重新连接后
+// 不会重复使用同一个 (密钥, nonce)；序列号回绕时也换新的纪元。
+// 加密后的 data 为 密文 | 纪元 (4字节) | 认证标签 (16字节)，nonce 为 会话ID | 纪元 | 序列号。
+// 包头明文传输，序列号、时间戳、会话ID、负载类型与分片/加密标志作为附加认证数据，
+// 服务器不解密即可路由、缓存与应答重传；重传与追踪标志由转发方设置，不参与认证。
+// 接收报告与重传请求不含音频，服务器需要读取，不加密
+class PayloadCrypto {
+public:
+    PayloadCrypto();
+
+    // 设置房间密钥 (32或64个十六进制字符，对应 AES-128/256)，空字符串关闭加密。
+    // 格式错误时返回false并保持关闭。同时换新的发送纪元并清空已派生的接收密钥与重放窗口
+    bool SetKey(const char* hex_key);
+    bool IsEnabled() const { return enabled_; }
+
+    // 发送端 (只在音频线程调用): 包头已填好 (flags 含 kPacketFlagEncrypted)，data 前 size 字节为明文，
+    // 原地加密并追加尾部，返回加密后的负载长度 (size + kPayloadCryptoTrailerSize)
+    size_t Seal(AudioPacket* packet, size_t size);
+
+    enum OpenResult {
+        kOpenOk,
+        kOpenRejected,      // 未开启加密、缺少加密标志、尾部不完整或认证失败
+        kOpenReplayed,      // 该纪元内已认证过的序列号，或比已认证的最高序列号早 kReplayWindowSize 个以上
+    };
+
+    // 接收端 (只在网络线程调用): 校验并解密 size 字节的负载到 out (包头一并复制，data_size 为明文长度)。
+    // 重放的包不解密直接返回 kOpenReplayed；正常的重传包 (原包已收到) 也属于这种情况
+    OpenResult Open(const AudioPacket& packet, size_t size, AudioPacket* out);
+
+    // 接收端: 发送者离开后丢弃它的会话密钥与重放窗口
+    void RemoveSession(uint32_t session_id);
+
+    // 重放窗口覆盖的序列号个数，与发送端和服务器缓存的重传包个数相同，更早的包不会再被重传
+    static const uint32_t kReplayWindowSize = 64;
+
+private:
+    // 每个 (会话, 纪元) 的重放窗口: 已认证的最高序列号与其前63个序列号的位图。
+    // 同一纪元内发送端的序列号严格递增 (回绕时换纪元)，比较时不需要处理回绕
+    struct ReplayWindow {
+        bool has_sequence = false;
+        uint32_t highest = 0;
+        uint64_t bitmap = 0;        // 第i位: highest - i 已认证
+
+        bool IsReplay(uint32_t sequence) const;
+        void Accept(uint32_t sequence);
+    };
+
+    struct ReceiveKey {
+        uint32_t epoch;
+        AesGcm cipher;
+        ReplayWindow window;
+    };
+
+    // 每个发送会话缓存当前与上一个纪元的密钥，换纪元前后乱序到达的包不必重新派生密钥。
+    // 换下的纪元记在 retired_epochs 中，重放的旧纪元的包即使能认证也不会再成为当前纪元
+    static const size_t kRetiredEpochs = 8;
+    struct ReceiveSession {
+        ReceiveKey current;
+        ReceiveKey previous;
+        bool has_previous = false;
+        uint32_t retired_epochs[kRetiredEpochs];
+        size_t retired_count = 0;
+    };
+
+    void DeriveSessionKey(uint32_t session_id, uint32_t epoch, AesGcm* cipher) const;
+    static void BuildNonce(uint32_t session_id, uint32_t epoch, uint32_t sequence, uint8_t* nonce);
+    static void BuildAad(const AudioPacket& packet, uint8_t* aad);
+
+    bool enabled_;
+    size_t key_size_;
+    AesGcm room_cipher_;
+
+    // 发送端状态
+    bool send_ready_;
+    uint32_t send_session_;
+    uint32_t send_epoch_;
+    uint32_t last_sequence_;
+    AesGcm send_cipher_;
+
+    // 接收端状态
+    std::unordered_map<uint32_t, ReceiveSession> receive_sessions_;
+};
+
+#endif // PAYLOAD_CRYPTO_H
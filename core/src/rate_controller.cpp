@@ -0,0 +1,286 @@
+#include "rate_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "audio_fec.h"
+#include "ima_adpcm.h"
+#include "voice_packet.h"
+
+namespace {
+
+// 超过该时间 (秒) 没有报告的接收端不再参与决策
+const double kReporterTimeoutSeconds = 5.0;
+// 丢包率门限: 高于上限时降低码率，低于下限时允许升高
+const float kLossHigh = 0.10f;
+const float kLossLow = 0.02f;
+// 升高速度 (每秒乘以该系数)
+const double kIncreasePerSecond = 1.08;
+// 过载时的降低系数
+const double kOveruseDecrease = 0.85;
+// 排队时延超过该值 (毫秒) 且不再下降时认为过载
+const float kOveruseQueuingMs = 30.0f;
+// 时延梯度超过该值 (毫秒/秒) 时直接认为过载
+const float kOveruseGradientMsPerSecond = 20.0f;
+// 排队时延低于该值 (毫秒) 时允许升高
+const float kNormalQueuingMs = 10.0f;
+// 最小传输时延每秒允许上升的量 (微秒)，跟随两端时钟漂移与路由变化
+const int64_t kBaseRiseUsPerSecond = 1000;
+// 升级后该时间 (秒) 内出现拥塞视为试探失败
+const double kProbeWindowSeconds = 5.0;
+// 试探失败后的上限保持时间 (秒)
+const double kMinProbeBackoffSeconds = 30.0;
+const double kMaxProbeBackoffSeconds = 300.0;
+// IPv4 + UDP 头
+const int kIpUdpOverhead = 28;
+
+size_t PrimarySize(uint8_t codec, size_t frames, int channels) {
+    if (codec == kPayloadTypeAdpcm) {
+        return ima_adpcm::EncodedSize(channels, frames);
+    }
+    return frames * channels * sizeof(int16_t);
+}
+
+// 按质量从高到低排列的编码方式 (编码, 包长毫秒)
+struct Candidate {
+    uint8_t codec;
+    int packet_ms;
+};
+// 最低一档使用的最短包长 (毫秒)
+const int kLowRatePacketMs = 40;
+
+// 配置包长下的候选编码方式: PCM、ADPCM，以及不短于40ms包长的ADPCM (与前一种相同时省略)，返回个数
+int BuildCandidates(int packet_ms, Candidate* candidates) {
+    int count = 0;
+    candidates[count++] = {kPayloadTypePcm16, packet_ms};
+    candidates[count++] = {kPayloadTypeAdpcm, packet_ms};
+    if (packet_ms < kLowRatePacketMs) {
+        candidates[count++] = {kPayloadTypeAdpcm, kLowRatePacketMs};
+    }
+    return count;
+}
+
+// 带冗余的负载必须放进一个包 (冗余块按序列号恢复整帧)，不带冗余的可以分片
+bool PayloadFits(uint8_t codec, size_t frames, int fec_depth, int channels) {
+    size_t size = EncodingPayloadSize(codec, frames, fec_depth, channels);
+    return size <= (fec_depth > 0 ? kMaxPayloadSize : kMaxFramePayload);
+}
+
+} // namespace
+
+size_t EncodingPayloadSize(uint8_t codec, size_t packet_frames, int fec_depth, int channels) {
+    size_t size = PrimarySize(codec, packet_frames, channels);
+    if (fec_depth > 0) {
+        size += 1 + fec_depth * (sizeof(RedundantBlockHeader) + ima_adpcm::EncodedSize(channels, packet_frames));
+    }
+    return size;
+}
+
+RateController::RateController()
+    : min_bitrate_(0)
+    , max_bitrate_(0)
+    , target_bitrate_(0)
+    , next_sequence_(0)
+    , has_hold_(false)
+    , hold_sequence_(0)
+    , current_bitrate_(0)
+    , probe_bitrate_(0)
+    , probe_start_(0.0)
+    , probe_backoff_(kMinProbeBackoffSeconds)
+    , ceiling_bitrate_(0)
+    , ceiling_until_(0.0) {
+}
+
+void RateController::Configure(int min_bitrate, int max_bitrate) {
+    min_bitrate_ = min_bitrate;
+    max_bitrate_ = std::max(min_bitrate, max_bitrate);
+    Reset();
+}
+
+void RateController::Reset() {
+    reporters_.clear();
+    target_bitrate_ = max_bitrate_;
+    has_hold_ = false;
+    current_bitrate_ = 0;
+    probe_bitrate_ = 0;
+    probe_backoff_ = kMinProbeBackoffSeconds;
+    ceiling_bitrate_ = 0;
+    ceiling_until_ = 0.0;
+}
+
+void RateController::OnReceiverReport(uint32_t reporter_id, float fraction_lost, uint32_t highest_sequence,
+                                      uint32_t transit_us, double now_seconds) {
+    auto found = reporters_.find(reporter_id);
+    if (found == reporters_.end()) {
+        Reporter reporter;
+        reporter.highest_sequence = highest_sequence;
+        reporter.last_transit = transit_us;
+        reporter.transit_us = 0;
+        reporter.base_transit_us = 0;
+        reporter.last_report = now_seconds;
+        reporter.queuing_ms = 0.0f;
+        reporter.loss_bitrate = max_bitrate_;
+        reporter.delay_bitrate = max_bitrate_;
+        reporters_[reporter_id] = reporter;
+        return;
+    }
+    Reporter& reporter = found->second;
+    // 乱序或重复的报告
+    if (static_cast<int32_t>(highest_sequence - reporter.highest_sequence) <= 0) {
+        return;
+    }
+    reporter.highest_sequence = highest_sequence;
+    double dt = std::max(0.1, now_seconds - reporter.last_report);
+    reporter.last_report = now_seconds;
+    double increase = std::pow(kIncreasePerSecond, dt);
+
+    // 降低以当前实际码率为基准，否则目标码率高于实际码率时要多次报告才能降到实际码率以下
+    double current = current_bitrate_ > 0 ? current_bitrate_ : max_bitrate_;
+
+    // 丢包估计
+    if (fraction_lost > kLossHigh) {
+        if (OnCongestion(highest_sequence, now_seconds)) {
+            reporter.loss_bitrate = std::min(reporter.loss_bitrate, current) * (1.0 - 0.5 * fraction_lost);
+        }
+    } else if (fraction_lost < kLossLow) {
+        reporter.loss_bitrate *= increase;
+    }
+
+    // 时延估计
+    int64_t previous = reporter.transit_us;
+    reporter.transit_us += static_cast<int32_t>(transit_us - reporter.last_transit);
+    reporter.last_transit = transit_us;
+    reporter.base_transit_us = std::min(reporter.base_transit_us + static_cast<int64_t>(kBaseRiseUsPerSecond * dt),
+                                        reporter.transit_us);
+    reporter.queuing_ms = (reporter.transit_us - reporter.base_transit_us) / 1000.0f;
+    float gradient = static_cast<float>((reporter.transit_us - previous) / 1000.0 / dt);
+    if (gradient > kOveruseGradientMsPerSecond || (reporter.queuing_ms > kOveruseQueuingMs && gradient >= 0.0f)) {
+        if (OnCongestion(highest_sequence, now_seconds)) {
+            reporter.delay_bitrate = std::min(reporter.delay_bitrate, current) * kOveruseDecrease;
+        }
+    } else if (reporter.queuing_ms < kNormalQueuingMs) {
+        reporter.delay_bitrate *= increase;
+    }
+
+    // 上限有效期间估计值也不越过上限，到期后先重新试探失败的那一级，而不是直接跳到最高码率
+    double upper = max_bitrate_;
+    if (ceiling_bitrate_ != 0) {
+        upper = std::max<double>(min_bitrate_, ceiling_bitrate_ - 1);
+    }
+    reporter.loss_bitrate = std::max<double>(min_bitrate_, std::min(upper, reporter.loss_bitrate));
+    reporter.delay_bitrate = std::max<double>(min_bitrate_, std::min(upper, reporter.delay_bitrate));
+}
+
+bool RateController::OnCongestion(uint32_t highest_sequence, double now_seconds) {
+    if (has_hold_ && static_cast<int32_t>(highest_sequence - hold_sequence_) < 0) {
+        return false;
+    }
+    has_hold_ = true;
+    hold_sequence_ = next_sequence_;
+    if (probe_bitrate_ != 0) {
+        ceiling_bitrate_ = probe_bitrate_;
+        ceiling_until_ = now_seconds + probe_backoff_;
+        probe_backoff_ = std::min(probe_backoff_ * 2.0, kMaxProbeBackoffSeconds);
+        probe_bitrate_ = 0;
+    }
+    return true;
+}
+
+int RateController::Update(double now_seconds, int current_bitrate, uint32_t next_sequence) {
+    next_sequence_ = next_sequence;
+    if (current_bitrate > current_bitrate_ && current_bitrate_ > 0) {
+        probe_bitrate_ = current_bitrate;
+        probe_start_ = now_seconds;
+    } else if (current_bitrate < current_bitrate_) {
+        probe_bitrate_ = 0;
+    }
+    current_bitrate_ = current_bitrate;
+    if (probe_bitrate_ != 0 && now_seconds - probe_start_ > kProbeWindowSeconds) {
+        // 试探成功
+        probe_bitrate_ = 0;
+        probe_backoff_ = kMinProbeBackoffSeconds;
+    }
+    if (ceiling_bitrate_ != 0 && now_seconds >= ceiling_until_) {
+        ceiling_bitrate_ = 0;
+    }
+
+    double target = max_bitrate_;
+    for (auto it = reporters_.begin(); it != reporters_.end();) {
+        if (now_seconds - it->second.last_report > kReporterTimeoutSeconds) {
+            it = reporters_.erase(it);
+            continue;
+        }
+        target = std::min(target, std::min(it->second.loss_bitrate, it->second.delay_bitrate));
+        ++it;
+    }
+    if (ceiling_bitrate_ != 0) {
+        target = std::min<double>(target, ceiling_bitrate_ - 1);
+    }
+    target_bitrate_ = static_cast<int>(target);
+    return target_bitrate_;
+}
+
+float RateController::GetQueuingDelayMs() const {
+    float queuing = 0.0f;
+    for (const auto& entry : reporters_) {
+        queuing = std::max(queuing, entry.second.queuing_ms);
+    }
+    return queuing;
+}
+
+int EncodingBitrate(uint8_t codec, size_t packet_frames, int fec_depth, int sample_rate, int channels) {
+    if (packet_frames == 0) return 0;
+    // 超过一个包的帧按分片数计算包头开销
+    size_t payload = EncodingPayloadSize(codec, packet_frames, fec_depth, channels);
+    size_t packets = 1;
+    if (payload > kMaxPayloadSize) {
+        packets = (payload + kFragmentPayloadSize - 1) / kFragmentPayloadSize;
+        payload += packets * sizeof(FragmentHeader);
+    }
+    size_t bytes = packets * (kIpUdpOverhead + kAudioPacketHeaderSize) + payload;
+    return static_cast<int>(bytes * 8 * static_cast<int64_t>(sample_rate) / packet_frames);
+}
+
+EncodingMode SelectEncoding(int target_bitrate, int sample_rate, int channels, int packet_ms, int wanted_fec_depth) {
+    EncodingMode lowest = {kPayloadTypeAdpcm, 0, 0, 0};
+    Candidate candidates[3];
+    int candidate_count = BuildCandidates(packet_ms, candidates);
+    for (int i = 0; i < candidate_count; ++i) {
+        const Candidate& candidate = candidates[i];
+        size_t frames = static_cast<size_t>(sample_rate) * candidate.packet_ms / 1000;
+        for (int depth = std::min(wanted_fec_depth, kMaxFecDepth); depth >= 0; --depth) {
+            if (!PayloadFits(candidate.codec, frames, depth, channels)) {
+                continue;
+            }
+            int bitrate = EncodingBitrate(candidate.codec, frames, depth, sample_rate, channels);
+            EncodingMode mode = {candidate.codec, frames, depth, bitrate};
+            if (bitrate <= target_bitrate) {
+                return mode;
+            }
+            if (lowest.packet_frames == 0 || bitrate < lowest.bitrate) {
+                lowest = mode;
+            }
+        }
+    }
+    return lowest;
+}
+
+int MinEncodingBitrate(int sample_rate, int channels, int packet_ms) {
+    return SelectEncoding(0, sample_rate, channels, packet_ms, 0).bitrate;
+}
+
+int MaxEncodingBitrate(int sample_rate, int channels, int packet_ms) {
+    int highest = 0;
+    Candidate candidates[3];
+    int candidate_count = BuildCandidates(packet_ms, candidates);
+    for (int i = 0; i < candidate_count; ++i) {
+        const Candidate& candidate = candidates[i];
+        size_t frames = static_cast<size_t>(sample_rate) * candidate.packet_ms / 1000;
+        for (int depth = 0; depth <= kMaxFecDepth; ++depth) {
+            if (PayloadFits(candidate.codec, frames, depth, channels)) {
+                highest = std::max(highest, EncodingBitrate(candidate.codec, frames, depth, sample_rate, channels));
+            }
+        }
+    }
+    return highest;
+}
@@ -0,0 +1,90 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// 发送码率控制
+// 每个接收端的报告分别驱动两个估计，取较小者:
+//   丢包估计: 丢包率超过10%时按丢包率降低，低于2%时缓慢升高
+//   时延估计: 由相邻报告的平均相对传输时延求时延梯度，并相对历史最小值估计排队时延；
+//             排队时延明显且仍在增长 (过载) 时从当前实际码率乘性降低，排队时延很小时缓慢升高
+// 降低后要等接收端收到降低之后发出的包才会再次降低，避免按已在途的排队重复降低
+// 目标码率取所有活跃接收端中最小的，保证房间里最差的链路也不会持续排队。
+// 编码方式之间码率跨度很大，升级后很快出现拥塞说明链路容纳不了新码率，
+// 此后一段时间 (30s起，每次失败加倍，最长300s) 目标码率不超过失败的码率，避免反复试探
+class RateController {
+public:
+    RateController();
+
+    void Configure(int min_bitrate, int max_bitrate);
+    void Reset();
+
+    // fraction_lost 为0~1，transit_us 为接收端本周期的平均相对传输时延 (32位回绕)
+    void OnReceiverReport(uint32_t reporter_id, float fraction_lost, uint32_t highest_sequence,
+                          uint32_t transit_us, double now_seconds);
+    // 丢弃长时间没有报告的接收端，返回目标码率 (bps)
+    // current_bitrate 为当前编码方式的实际码率，用于过载时的降低基准与判断升级试探；
+    // next_sequence 为下一个要发送的序列号
+    int Update(double now_seconds, int current_bitrate, uint32_t next_sequence);
+
+    int GetTargetBitrate() const { return target_bitrate_; }
+    // 所有接收端中最大的排队时延估计 (毫秒)
+    float GetQueuingDelayMs() const;
+
+private:
+    struct Reporter {
+        uint32_t highest_sequence;
+        uint32_t last_transit;
+        int64_t transit_us;       // 展开后的相对传输时延
+        int64_t base_transit_us;  // 相对传输时延的 (缓慢上升的) 最小值
+        double last_report;
+        float queuing_ms;
+        double loss_bitrate;
+        double delay_bitrate;
+    };
+
+    // 返回是否允许降低 (接收端已收到上次降低之后的包)
+    bool OnCongestion(uint32_t highest_sequence, double now_seconds);
+
+    int min_bitrate_;
+    int max_bitrate_;
+    int target_bitrate_;
+    std::map<uint32_t, Reporter> reporters_;
+    uint32_t next_sequence_;
+    bool has_hold_;
+    uint32_t hold_sequence_;     // 上次降低时的下一个序列号
+    // 升级试探
+    int current_bitrate_;
+    int probe_bitrate_;          // 最近一次升级后的码率，0表示不在试探期
+    double probe_start_;
+    double probe_backoff_;       // 试探失败后的上限保持时间 (秒)
+    int ceiling_bitrate_;        // 试探失败的码率，0表示没有上限
+    double ceiling_until_;
+};
+
+// 一种发送编码方式
+struct EncodingMode {
+    uint8_t codec;            // kPayloadTypePcm16 或 kPayloadTypeAdpcm
+    size_t packet_frames;     // 每个包的帧数 (网络采样率)
+    int fec_depth;
+    int bitrate;              // 含IP/UDP与包头的估计码率 (bps)
+};
+
+// 某种编码方式一帧的负载字节数 (超过一个包时分片发送，不含分片头)
+size_t EncodingPayloadSize(uint8_t codec, size_t packet_frames, int fec_depth, int channels);
+
+// 估计某种编码方式的码率 (含分片的包头开销)
+int EncodingBitrate(uint8_t codec, size_t packet_frames, int fec_depth, int sample_rate, int channels);
+
+// 按质量从高到低 (PCM、ADPCM，包长为配置的 packet_ms；再加上不短于40ms包长的ADPCM)
+// 选出码率不超过目标的第一种编码方式，每种方式先尝试 wanted_fec_depth，放不下一个包时减少冗余深度；
+// 都超过目标时返回码率最低的方式
+EncodingMode SelectEncoding(int target_bitrate, int sample_rate, int channels, int packet_ms, int wanted_fec_depth);
+
+// 所有编码方式中的最低/最高码率
+int MinEncodingBitrate(int sample_rate, int channels, int packet_ms);
+int MaxEncodingBitrate(int sample_rate, int channels, int packet_ms);
+
+#endif // RATE_CONTROLLER_H
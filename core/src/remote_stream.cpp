@@ -0,0 +1,699 @@
+#include "remote_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <arpa/inet.h>
+
+#include "audio_kernels.h"
+#include "frame_trace.h"
+#include "ima_adpcm.h"
+
+namespace {
+
+// 接收队列上限 (按拉取次数计的帧数，不低于两倍目标深度)，超出时丢弃新包
+const size_t kMaxQueuedPackets = 10;
+// 队列中的包数上限 (分片各计一个)
+const size_t kMaxQueuedDatagrams = 128;
+// 漂移补偿的目标队列深度 (拉取次数)
+const size_t kTargetQueuedPackets = 3;
+// 超过该时间 (秒) 没有收到任何包时停止生成舒适噪声 (描述符约每0.4秒一个)
+const double kComfortNoiseTimeoutSeconds = 1.5;
+// 序列号跳变超过该值时认为发送端重新开始 (例如重连)
+const int64_t kMaxSequenceJump = 3000;
+// 一次空缺最多跟踪的缺失包数，更长的空缺 (例如发送端停顿) 不值得重传
+const int64_t kMaxMissingPackets = 16;
+// 每个缺失包最多请求的次数
+const int kMaxNackRequests = 3;
+// 还没有往返时间测量值时的初始估计 (秒)，按同一局域网/同一地区的路径取值
+const double kInitialRttSeconds = 0.03;
+// 重复请求的最小间隔 (秒)
+const double kMinNackIntervalSeconds = 0.01;
+// 已请求的包错过播放位置后继续等待应答的时间 (秒)，迟到的重传仍用于测量往返时间
+const double kMaxNackWaitSeconds = 1.0;
+// 队列深度平滑系数 (每次拉取)，20ms拉取时约200ms的时间常数
+const double kLevelSmoothing = 0.1;
+
+} // namespace
+
+RemoteStream::RemoteStream(uint32_t session_id, int sample_rate, int channels, size_t packet_frames, size_t pull_frames)
+    : session_id_(session_id)
+    , sample_rate_(sample_rate)
+    , channels_(channels)
+    , last_arrival_(0.0)
+    , queue_(kMaxQueuedDatagrams)
+    , queued_packets_(0)
+    , queued_frames_(0)
+    , pending_read_(0)
+    , nominal_frames_(pull_frames)
+    , frame_frames_(packet_frames)
+    , frame_fragments_(1)
+    , target_frames_(std::max(pull_frames * kTargetQueuedPackets, packet_frames + 2 * pull_frames))
+    , max_queued_frames_(std::max(pull_frames * kMaxQueuedPackets, 2 * target_frames_))
+    , underrun_frames_(0)
+    , comfort_noise_active_(false)
+    , time_stretch_enabled_(true)
+    , smoothed_level_(0.0)
+    , has_sequence_(false)
+    , packets_received_(0)
+    , packets_lost_before_(0)
+    , packets_recovered_(0)
+    , packets_late_(0)
+    , packets_reordered_(0)
+    , queue_drops_(0)
+    , concealed_frames_(0)
+    , accelerated_frames_(0)
+    , decelerated_frames_(0)
+    , rtt_seconds_(kInitialRttSeconds)
+    , nack_requests_(0)
+    , retransmits_recovered_(0)
+    , retransmits_late_(0)
+    , retransmits_useless_(0) {
+    drift_.Configure(sample_rate, target_frames_);
+    // ADPCM包解码后的帧数最多；分片拼接的更长的帧分段重采样
+    max_packet_frames_ = std::max(sizeof(AudioPacket::data) / sizeof(int16_t) / channels,
+                                  ima_adpcm::DecodedFrames(channels, sizeof(AudioPacket::data)));
+    resampler_.Configure(channels, max_packet_frames_);
+    decode_buffer_.resize(max_packet_frames_ * channels);
+    // 比例最多偏离1约0.2%，预留少量余量
+    resample_buffer_.resize((resampler_.MaxOutputFrames(max_packet_frames_) + 16) * channels);
+    stretcher_.Configure(sample_rate, channels);
+    stretch_buffer_.resize((stretcher_.MaxInputFrames() + stretcher_.MaxInputFrames() / 2) * channels);
+    ResetSequencing();
+}
+
+void RemoteStream::ResetSequencing() {
+    // 序列号重新开始 (发送端重连): 上一段的丢包累加，新的一段从头统计
+    packets_lost_before_ = GetPacketsLost();
+    for (QueueSlot& slot : queue_) {
+        slot.sequence = -1;
+    }
+    queued_packets_ = 0;
+    missing_.clear();
+    queued_frames_ = 0;
+    underrun_frames_ = 0;
+    has_sequence_ = false;
+    base_sequence_ = 0;
+    sequence_received_ = 0;
+    highest_sequence_ = 0;
+    last_played_ = -1;
+    report_highest_ = 0;
+    report_received_ = 0;
+    report_transit_sum_ = 0.0;
+    report_transit_count_ = 0;
+    has_transit_ = false;
+    last_transit_ = 0.0;
+    jitter_ = 0.0;
+}
+
+int64_t RemoteStream::ExtendSequence(uint32_t sequence) const {
+    // 以目前最高序列号为参照展开32位回绕
+    int32_t delta = static_cast<int32_t>(sequence - static_cast<uint32_t>(highest_sequence_));
+    return highest_sequence_ + delta;
+}
+
+bool RemoteStream::ReadFragmentHeader(const AudioPacket& packet, FragmentHeader* header) {
+    if (!(packet.flags & kPacketFlagFragment) || ntohs(packet.data_size) <= sizeof(FragmentHeader)) {
+        return false;
+    }
+    memcpy(header, packet.data, sizeof(FragmentHeader));
+    return header->count > 1 && header->count <= kMaxFrameFragments && header->index < header->count &&
+           ntohs(header->frames) > 0;
+}
+
+size_t RemoteStream::FrameFrames(const AudioPacket& packet) const {
+    FragmentHeader header;
+    if (ReadFragmentHeader(packet, &header)) {
+        return ntohs(header.frames);
+    }
+    return PacketFrames(packet);
+}
+
+size_t RemoteStream::PacketFrames(const AudioPacket& packet) const {
+    FragmentHeader header;
+    if (ReadFragmentHeader(packet, &header)) {
+        // 各分片分摊的帧数之和等于整帧的帧数
+        size_t frames = ntohs(header.frames);
+        return frames * (header.index + 1) / header.count - frames * header.index / header.count;
+    }
+    size_t size = ntohs(packet.data_size);
+    if (packet.payload_type == kPayloadTypePcm16) {
+        return size / sizeof(int16_t) / channels_;
+    }
+    if (packet.payload_type == kPayloadTypeAdpcm) {
+        return ima_adpcm::DecodedFrames(channels_, size);
+    }
+    return 0;
+}
+
+bool RemoteStream::ExtractPrimary(const AudioPacket& packet, AudioPacket* primary_packet) {
+    const uint8_t* primary = nullptr;
+    size_t primary_size = 0;
+    RedundantBlock blocks[kMaxFecDepth];
+    int block_count = 0;
+    if (!ParseRedundantPayload(packet.data, ntohs(packet.data_size), ntohl(packet.sequence),
+                               ntohl(packet.timestamp), &primary, &primary_size, blocks, &block_count)) {
+        return false;
+    }
+    memcpy(primary_packet, &packet, kAudioPacketHeaderSize);
+    primary_packet->payload_type =
+        packet.payload_type == kPayloadTypeAdpcmRedundant ? kPayloadTypeAdpcm : kPayloadTypePcm16;
+    primary_packet->data_size = htons(static_cast<uint16_t>(primary_size));
+    memcpy(primary_packet->data, primary, primary_size);
+    return true;
+}
+
+void RemoteStream::PushRetransmit(const AudioPacket& packet, double arrival_seconds) {
+    // 重传包不参与漂移估计和丢包统计，冗余块也已过时，只取主负载
+    int64_t extended = ExtendSequence(ntohl(packet.sequence));
+    auto missing = missing_.find(extended);
+    if (missing != missing_.end()) {
+        // 只用只请求过一次的包测量往返时间，避免无法区分应答对应哪次请求
+        if (missing->second.requests == 1) {
+            double sample = arrival_seconds - missing->second.last_request;
+            rtt_seconds_ = 0.875 * rtt_seconds_ + 0.125 * sample;
+        }
+        missing_.erase(missing);
+    }
+
+    if (extended <= last_played_) {
+        ++retransmits_late_;
+        return;
+    }
+    if (IsQueued(extended)) {
+        ++retransmits_useless_;
+        return;
+    }
+    AudioPacket pcm;
+    const AudioPacket* primary = &packet;
+    if (packet.payload_type == kPayloadTypePcm16Redundant || packet.payload_type == kPayloadTypeAdpcmRedundant) {
+        if (!ExtractPrimary(packet, &pcm)) return;
+        primary = &pcm;
+    } else if (packet.payload_type != kPayloadTypePcm16 && packet.payload_type != kPayloadTypeAdpcm &&
+               packet.payload_type != kPayloadTypeComfortNoise) {
+        return;
+    }
+    if (Insert(extended, *primary)) {
+        ++retransmits_recovered_;
+    }
+}
+
+void RemoteStream::PushReplayedRetransmit(uint32_t sequence) {
+    if (!has_sequence_) {
+        return;
+    }
+    if (ExtendSequence(sequence) <= last_played_) {
+        ++retransmits_late_;
+    } else {
+        ++retransmits_useless_;
+    }
+}
+
+bool RemoteStream::Push(const AudioPacket& packet, double arrival_seconds) {
+    if (packet.flags & kPacketFlagRetransmit) {
+        if (has_sequence_) {
+            PushRetransmit(packet, arrival_seconds);
+        }
+        return false;
+    }
+    FragmentHeader fragment;
+    const bool is_fragment = (packet.flags & kPacketFlagFragment) != 0;
+    if (is_fragment && !ReadFragmentHeader(packet, &fragment)) {
+        return false;
+    }
+    last_arrival_ = arrival_seconds;
+    // 同一帧的分片时间戳相同，只用第一个分片估计漂移
+    if (!is_fragment || fragment.index == 0) {
+        drift_.OnPacketArrival(ntohl(packet.timestamp), arrival_seconds);
+    }
+
+    uint32_t sequence = ntohl(packet.sequence);
+    if (has_sequence_) {
+        int64_t extended = ExtendSequence(sequence);
+        if (extended > highest_sequence_ + kMaxSequenceJump || extended < highest_sequence_ - kMaxSequenceJump) {
+            ResetSequencing();
+        }
+    }
+    if (!has_sequence_) {
+        has_sequence_ = true;
+        base_sequence_ = sequence;
+        highest_sequence_ = sequence;
+        report_highest_ = base_sequence_ - 1;
+        last_played_ = base_sequence_ - 1;
+    }
+    int64_t extended = ExtendSequence(sequence);
+    if (extended > highest_sequence_ + 1) {
+        // 新出现的空缺，记录缺失的包等待重传
+        for (int64_t missing = std::max(highest_sequence_ + 1, extended - kMaxMissingPackets);
+             missing < extended; ++missing) {
+            missing_[missing] = MissingPacket{0.0, 0};
+        }
+    } else {
+        if (extended < highest_sequence_) {
+            ++packets_reordered_;
+        }
+        missing_.erase(extended);
+    }
+    highest_sequence_ = std::max(highest_sequence_, extended);
+    ++packets_received_;
+    ++sequence_received_;
+    ++report_received_;
+
+    if (packet.payload_type == kPayloadTypePcm16Redundant || packet.payload_type == kPayloadTypeAdpcmRedundant) {
+        const uint8_t* primary = nullptr;
+        size_t primary_size = 0;
+        RedundantBlock blocks[kMaxFecDepth];
+        int block_count = 0;
+        if (!ParseRedundantPayload(packet.data, ntohs(packet.data_size), sequence, ntohl(packet.timestamp),
+                                   &primary, &primary_size, blocks, &block_count)) {
+            return false;
+        }
+        // 先用冗余副本补上之前的空缺，再插入主负载
+        RecoverRedundant(packet, extended, blocks, block_count);
+        AudioPacket pcm;
+        memcpy(&pcm, &packet, kAudioPacketHeaderSize);
+        pcm.payload_type = packet.payload_type == kPayloadTypeAdpcmRedundant ? kPayloadTypeAdpcm : kPayloadTypePcm16;
+        pcm.data_size = htons(static_cast<uint16_t>(primary_size));
+        memcpy(pcm.data, primary, primary_size);
+        UpdateTransit(pcm, arrival_seconds);
+        return Insert(extended, pcm);
+    }
+    if (packet.payload_type != kPayloadTypePcm16 && packet.payload_type != kPayloadTypeAdpcm &&
+        packet.payload_type != kPayloadTypeComfortNoise) {
+        return false;
+    }
+    UpdateTransit(packet, arrival_seconds);
+    return Insert(extended, packet);
+}
+
+void RemoteStream::UpdateTransit(const AudioPacket& packet, double arrival_seconds) {
+    // 相对传输时延: 平均值供发送端判断排队时延的变化，相邻包的差值更新到达间隔抖动 (RFC 3550)。
+    // 从包内最后一帧算起，不包含打包时长，切换包长时不会被误判为排队时延变化
+    double transit = arrival_seconds * sample_rate_ - ntohl(packet.timestamp) - static_cast<double>(FrameFrames(packet));
+    if (has_transit_) {
+        double d = transit - last_transit_;
+        // 时间戳回绕 (约3天一次，16kHz下) 时差值异常，跳过这一次
+        if (std::fabs(d) < sample_rate_) {
+            jitter_ += (std::fabs(d) - jitter_) / 16.0;
+        }
+    }
+    last_transit_ = transit;
+    has_transit_ = true;
+    report_transit_sum_ += transit * 1e6 / sample_rate_;
+    ++report_transit_count_;
+}
+
+bool RemoteStream::Insert(int64_t sequence, const AudioPacket& packet) {
+    FragmentHeader header;
+    if (sequence <= last_played_) {
+        ++packets_late_;
+        return false;
+    }
+    if (IsQueued(sequence)) {
+        return false;
+    }
+    if ((packet.flags & kPacketFlagFragment) && !ReadFragmentHeader(packet, &header)) {
+        return false;
+    }
+    // 超出环的范围: 队列里没有包时 (长时间断流之后) 把播放位置移到能放下它的地方，中间的包按丢失处理
+    if (sequence - last_played_ > static_cast<int64_t>(queue_.size()) && queued_packets_ == 0) {
+        last_played_ = sequence - static_cast<int64_t>(queue_.size());
+    }
+    if (queued_frames_ + PacketFrames(packet) > max_queued_frames_ || queued_packets_ >= queue_.size() ||
+        sequence - last_played_ > static_cast<int64_t>(queue_.size())) {
+        ++queue_drops_;
+        return false;
+    }
+    QueueSlot& slot = queue_[static_cast<size_t>(sequence) % queue_.size()];
+    slot.sequence = sequence;
+    slot.packet = packet;
+    ++queued_packets_;
+    queued_frames_ += PacketFrames(packet);
+    return true;
+}
+
+bool RemoteStream::IsQueued(int64_t sequence) const {
+    return sequence > last_played_ && queue_[static_cast<size_t>(sequence) % queue_.size()].sequence == sequence;
+}
+
+int64_t RemoteStream::HeadSequence() const {
+    int64_t sequence = last_played_ + 1;
+    while (!IsQueued(sequence)) {
+        ++sequence;
+    }
+    return sequence;
+}
+
+void RemoteStream::Remove(int64_t sequence) {
+    QueueSlot& slot = queue_[static_cast<size_t>(sequence) % queue_.size()];
+    if (slot.sequence == sequence) {
+        slot.sequence = -1;
+        --queued_packets_;
+    }
+}
+
+void RemoteStream::RecoverRedundant(const AudioPacket& packet, int64_t sequence,
+                                    const RedundantBlock* blocks, int block_count) {
+    for (int i = 0; i < block_count; ++i) {
+        int64_t target = sequence - static_cast<int64_t>(ntohl(packet.sequence) - blocks[i].sequence);
+        // 原包已经在队列中或已错过播放位置时副本没有用处
+        if (target <= last_played_ || IsQueued(target)) {
+            continue;
+        }
+        AudioPacket recovered;
+        recovered.sequence = htonl(blocks[i].sequence);
+        recovered.timestamp = htonl(blocks[i].timestamp);
+        recovered.session_id = packet.session_id;
+        recovered.payload_type = kPayloadTypeAdpcm;
+        recovered.flags = 0;
+        recovered.data_size = htons(static_cast<uint16_t>(blocks[i].size));
+        if (blocks[i].size > sizeof(recovered.data) || ima_adpcm::DecodedFrames(channels_, blocks[i].size) == 0) {
+            continue;
+        }
+        memcpy(recovered.data, blocks[i].data, blocks[i].size);
+        if (Insert(target, recovered)) {
+            ++packets_recovered_;
+        }
+    }
+}
+
+bool RemoteStream::TakeReport(ReceiverReportBlock* block) {
+    if (!has_sequence_) return false;
+    int64_t expected = highest_sequence_ - report_highest_;
+    uint64_t received = report_received_;
+    double transit_sum = report_transit_sum_;
+    uint64_t transit_count = report_transit_count_;
+    report_highest_ = highest_sequence_;
+    report_received_ = 0;
+    report_transit_sum_ = 0.0;
+    report_transit_count_ = 0;
+    if (expected <= 0 || received == 0 || transit_count == 0) {
+        return false;
+    }
+    int64_t lost = std::max<int64_t>(0, expected - static_cast<int64_t>(received));
+    block->source_id = htonl(session_id_);
+    block->fraction_lost = static_cast<uint8_t>(std::min<int64_t>(255, lost * 256 / expected));
+    block->highest_sequence = htonl(static_cast<uint32_t>(highest_sequence_));
+    block->jitter = htonl(static_cast<uint32_t>(jitter_));
+    // 取模保留低32位，发送端按差值使用
+    block->transit = htonl(static_cast<uint32_t>(static_cast<int64_t>(transit_sum / transit_count)));
+    return true;
+}
+
+size_t RemoteStream::BuildNack(double now_seconds, NackBlock* blocks, size_t capacity) {
+    size_t count = 0;
+    // 缺失包的截止时间由排在它之前的音频长度决定
+    size_t frames_ahead = PendingSamples() / channels_;
+    int64_t packets_ahead = 0;
+    int64_t queued = last_played_ + 1;
+    const int64_t queue_end = last_played_ + static_cast<int64_t>(queue_.size());
+    for (auto it = missing_.begin(); it != missing_.end();) {
+        const int64_t sequence = it->first;
+        MissingPacket& missing = it->second;
+        if (IsQueued(sequence) ||
+            (sequence <= last_played_ &&
+             (missing.requests == 0 || now_seconds - missing.last_request > kMaxNackWaitSeconds))) {
+            it = missing_.erase(it);
+            continue;
+        }
+        ++it;
+        if (sequence <= last_played_ || missing.requests >= kMaxNackRequests) {
+            continue;
+        }
+        for (; queued < sequence && queued <= queue_end; ++queued) {
+            if (IsQueued(queued)) {
+                ++packets_ahead;
+                frames_ahead += PacketFrames(QueuedPacket(queued));
+            }
+        }
+        // 排在前面的其他缺失包播放时按最近的包长补静音；音频线程按整帧拉取，
+        // 缺失包在它之前的数据不足一帧时就会被取走，因此再减去一帧
+        int64_t missing_ahead = sequence - last_played_ - 1 - packets_ahead;
+        double until_playout = (static_cast<double>(frames_ahead + missing_ahead * frame_frames_ / frame_fragments_) -
+                                static_cast<double>(nominal_frames_)) / sample_rate_;
+        if (until_playout < rtt_seconds_) {
+            continue;
+        }
+        if (missing.requests > 0 &&
+            now_seconds - missing.last_request < std::max(kMinNackIntervalSeconds, 1.5 * rtt_seconds_)) {
+            continue;
+        }
+
+        uint32_t wire_sequence = static_cast<uint32_t>(sequence);
+        if (count > 0) {
+            NackBlock& last = blocks[count - 1];
+            uint32_t distance = wire_sequence - ntohl(last.sequence);
+            if (distance >= 1 && distance <= 16) {
+                last.bitmask = htons(ntohs(last.bitmask) | (1u << (distance - 1)));
+                missing.last_request = now_seconds;
+                ++missing.requests;
+                ++nack_requests_;
+                continue;
+            }
+        }
+        if (count == capacity) {
+            continue;
+        }
+        blocks[count].source_id = htonl(session_id_);
+        blocks[count].sequence = htonl(wire_sequence);
+        blocks[count].bitmask = 0;
+        ++count;
+        missing.last_request = now_seconds;
+        ++missing.requests;
+        ++nack_requests_;
+    }
+    return count;
+}
+
+size_t RemoteStream::AssembleFrame(int64_t head) {
+    const AudioPacket& head_packet = QueuedPacket(head);
+    FragmentHeader first;
+    if (!ReadFragmentHeader(head_packet, &first) || first.index != 0) {
+        return 0;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < first.count; ++i) {
+        const int64_t sequence = head + static_cast<int64_t>(i);
+        FragmentHeader header;
+        if (!IsQueued(sequence)) {
+            return 0;
+        }
+        const AudioPacket& packet = QueuedPacket(sequence);
+        if (!ReadFragmentHeader(packet, &header) || header.index != i || header.count != first.count ||
+            packet.timestamp != head_packet.timestamp || packet.payload_type != head_packet.payload_type) {
+            return 0;
+        }
+        total += ntohs(packet.data_size) - sizeof(FragmentHeader);
+    }
+    if (assembly_.size() < total) {
+        assembly_.resize(total);
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < first.count; ++i) {
+        const AudioPacket& packet = QueuedPacket(head + static_cast<int64_t>(i));
+        size_t size = ntohs(packet.data_size) - sizeof(FragmentHeader);
+        memcpy(assembly_.data() + offset, packet.data + sizeof(FragmentHeader), size);
+        offset += size;
+    }
+    return total;
+}
+
+uint64_t RemoteStream::GetPacketsLost() const {
+    if (!has_sequence_) return packets_lost_before_;
+    int64_t expected = highest_sequence_ - base_sequence_ + 1;
+    return packets_lost_before_ +
+           static_cast<uint64_t>(std::max<int64_t>(0, expected - static_cast<int64_t>(sequence_received_)));
+}
+
+size_t RemoteStream::QueuedFrames() const {
+    return queued_frames_ + PendingSamples() / channels_;
+}
+
+void RemoteStream::CompactPending() {
+    if (pending_read_ == 0 || pending_read_ < PendingSamples()) {
+        return;
+    }
+    // 剩余数据不多于已取走的部分，移动的总量不超过取走的样点数
+    std::copy(pending_.begin() + pending_read_, pending_.end(), pending_.begin());
+    pending_.resize(PendingSamples());
+    pending_read_ = 0;
+}
+
+RemoteStream::StretchMode RemoteStream::ChooseStretch() {
+    const double level = static_cast<double>(QueuedFrames());
+    smoothed_level_ += (level - smoothed_level_) * kLevelSmoothing;
+    if (!time_stretch_enabled_ || comfort_noise_active_ || !has_sequence_) {
+        return kStretchNone;
+    }
+    const double target = static_cast<double>(target_frames_);
+    // 平滑值超过目标一个包以上且当前仍高于目标: 突发到达后积压的延迟，快放消化
+    if (smoothed_level_ > target + static_cast<double>(std::max(frame_frames_, nominal_frames_)) && level > target) {
+        return kStretchAccelerate;
+    }
+    // 剩下的数据不够本次拉取 (下一个包晚到): 慢放已有的数据，减少补的静音
+    if (level < static_cast<double>(nominal_frames_)) {
+        return kStretchDecelerate;
+    }
+    return kStretchNone;
+}
+
+void RemoteStream::Stretch(StretchMode mode) {
+    const size_t frames = std::min(PendingSamples() / channels_, stretcher_.MaxInputFrames());
+    if (frames < stretcher_.MinInputFrames()) {
+        return;
+    }
+    const auto start = pending_.begin() + static_cast<std::ptrdiff_t>(pending_read_);
+    const int16_t* input = pending_.data() + pending_read_;
+    size_t produced = mode == kStretchAccelerate ? stretcher_.Accelerate(input, frames, stretch_buffer_.data())
+                                                 : stretcher_.Decelerate(input, frames, stretch_buffer_.data());
+    if (produced < frames) {
+        std::copy(stretch_buffer_.begin(), stretch_buffer_.begin() + produced * channels_, start);
+        pending_.erase(start + produced * channels_, start + frames * channels_);
+        accelerated_frames_ += frames - produced;
+    } else if (produced > frames) {
+        std::copy(stretch_buffer_.begin(), stretch_buffer_.begin() + frames * channels_, start);
+        pending_.insert(start + frames * channels_, stretch_buffer_.begin() + frames * channels_,
+                        stretch_buffer_.begin() + produced * channels_);
+        decelerated_frames_ += produced - frames;
+    }
+}
+
+size_t RemoteStream::Pull(int16_t* out, size_t frames, double now_seconds) {
+    const size_t wanted = frames * channels_;
+
+    // 每次拉取最多变速一次，运算量有界。快放时先多解码一些，凑够查找最长周期需要的长度
+    // (此时队列高于目标，缺失包本来就直接跳过，提前解码不影响重传与冗余恢复)，去掉的部分再补上
+    const StretchMode stretch = ChooseStretch();
+    if (stretch == kStretchAccelerate) {
+        FillPending(std::max(wanted, stretcher_.MaxInputFrames() * channels_));
+    } else {
+        FillPending(wanted);
+    }
+    if (stretch != kStretchNone) {
+        Stretch(stretch);
+        FillPending(wanted);
+    }
+
+    size_t available = std::min(PendingSamples(), wanted);
+    std::copy(pending_.begin() + pending_read_, pending_.begin() + pending_read_ + available, out);
+    std::fill(out + available, out + wanted, 0);
+    pending_read_ += available;
+    if (!comfort_noise_active_ && has_sequence_) {
+        underrun_frames_ += (wanted - available) / channels_;
+        concealed_frames_ += (wanted - available) / channels_;
+    }
+
+    if (comfort_noise_active_ && now_seconds - last_arrival_ > kComfortNoiseTimeoutSeconds) {
+        comfort_noise_active_ = false;
+    }
+    if (comfort_noise_active_ && available < wanted) {
+        // 舒适噪声为单声道，复制到各声道
+        size_t missing = frames - available / channels_;
+        comfort_noise_buffer_.resize(missing);
+        comfort_noise_.Generate(comfort_noise_buffer_.data(), missing);
+        for (int ch = 0; ch < channels_; ++ch) {
+            audio_kernels::InterleaveFloatToS16(comfort_noise_buffer_.data(), channels_, ch,
+                                                out + available, missing);
+        }
+        available = wanted;
+    }
+
+    // 不论是否有数据，播放设备都消耗了这么多帧
+    drift_.OnPlayout(frames, now_seconds);
+    return available / channels_;
+}
+
+void RemoteStream::FillPending(size_t samples) {
+    CompactPending();
+    while (PendingSamples() < samples && queued_packets_ > 0) {
+        const int64_t head = HeadSequence();
+        const AudioPacket& packet = QueuedPacket(head);
+        if (packet.payload_type == kPayloadTypeComfortNoise) {
+            comfort_noise_.Update(packet.data, ntohs(packet.data_size));
+            comfort_noise_active_ = comfort_noise_.HasDescriptor();
+            Remove(head);
+            last_played_ = head;
+            continue;
+        }
+        // 静音后的第一个语音段: 继续播放舒适噪声直到队列重新达到目标深度
+        if (comfort_noise_active_ && queued_frames_ < target_frames_) {
+            break;
+        }
+        // 队首之前有缺失包: 补一帧静音占住它的位置 (舒适噪声期间缺失的可能是描述符，不补；
+        // 最近的帧是分片时每个缺失的分片补均摊的帧数)。
+        // 缺失包之前队列已经空过时，空的那段已经占用了它的时间，只补剩余部分
+        if (!comfort_noise_active_ && head > last_played_ + 1 && queued_frames_ <= target_frames_) {
+            const size_t missing_frames = frame_frames_ / frame_fragments_;
+            size_t credit = std::min(underrun_frames_, missing_frames);
+            underrun_frames_ -= credit;
+            pending_.insert(pending_.end(), (missing_frames - credit) * channels_, 0);
+            concealed_frames_ += missing_frames - credit;
+            ++last_played_;
+            continue;
+        }
+        if (head == last_played_ + 1) {
+            underrun_frames_ = 0;
+        }
+        comfort_noise_active_ = false;
+
+        size_t in_frames = PacketFrames(packet);
+        const uint8_t* payload = packet.data;
+        size_t payload_size = ntohs(packet.data_size);
+        size_t fragments = 1;
+        if (packet.flags & kPacketFlagFragment) {
+            payload_size = AssembleFrame(head);
+            if (payload_size == 0) {
+                // 分片不全或前面的分片已经错过: 不超过目标深度时按它分摊的帧数补静音，否则直接丢弃
+                queued_frames_ -= std::min(queued_frames_, in_frames);
+                if (queued_frames_ <= target_frames_) {
+                    pending_.insert(pending_.end(), in_frames * channels_, 0);
+                    concealed_frames_ += in_frames;
+                }
+                Remove(head);
+                last_played_ = head;
+                continue;
+            }
+            FragmentHeader header;
+            memcpy(&header, packet.data, sizeof(header));
+            fragments = header.count;
+            in_frames = ntohs(header.frames);
+            payload = assembly_.data();
+        }
+        if (packet.flags & kPacketFlagTraced) {
+            FrameTracer::Instance().Record(kTracePlayed, session_id_, ntohl(packet.timestamp));
+        }
+        queued_frames_ -= std::min(queued_frames_, in_frames);
+        const int64_t frame_end = head + static_cast<int64_t>(fragments) - 1;
+        const int16_t* samples = reinterpret_cast<const int16_t*>(payload);
+        if (packet.payload_type == kPayloadTypeAdpcm) {
+            if (decode_buffer_.size() < in_frames * channels_) {
+                decode_buffer_.resize(in_frames * channels_);
+            }
+            if (!ima_adpcm::Decode(payload, payload_size, channels_, in_frames, decode_buffer_.data())) {
+                in_frames = 0;
+            }
+            samples = decode_buffer_.data();
+        } else if (payload_size < in_frames * channels_ * sizeof(int16_t)) {
+            in_frames = 0;
+        }
+        if (in_frames > 0) {
+            frame_frames_ = in_frames;
+            frame_fragments_ = fragments;
+            // 每个包更新一次比例，变化量很小，包内保持恒定；
+            // 分片拼接的帧超过重采样器的单次上限时分段处理，比例不变，结果与一次处理相同
+            resampler_.SetRatio(drift_.UpdateRatio(QueuedFrames() + in_frames));
+            for (size_t offset = 0; offset < in_frames; offset += max_packet_frames_) {
+                size_t chunk = std::min(max_packet_frames_, in_frames - offset);
+                size_t produced = resampler_.Process(samples + offset * channels_, chunk,
+                                                     resample_buffer_.data(), resample_buffer_.size() / channels_);
+                pending_.insert(pending_.end(), resample_buffer_.begin(),
+                                resample_buffer_.begin() + produced * channels_);
+            }
+        }
+        for (int64_t sequence = head; sequence <= frame_end; ++sequence) {
+            Remove(sequence);
+        }
+        last_played_ = frame_end;
+    }
+}
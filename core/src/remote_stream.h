@@ -0,0 +1,202 @@
+#ifndef REMOTE_STREAM_H
+#define REMOTE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "audio_fec.h"
+#include "audio_resampler.h"
+#include "clock_drift.h"
+#include "comfort_noise.h"
+#include "time_stretcher.h"
+#include "voice_packet.h"
+
+// 单个远端发送者的接收流
+// 每个发送者有独立的采样时钟，因此接收队列、漂移估计和分数重采样都按发送者维护，
+// 播放时由音频线程从各个流拉取同样长度的数据后混音。
+// 队列按 (展开后的) 序列号排序: 乱序包归位，冗余副本 (FEC) 填补尚未播放的空缺，
+// 已经错过播放位置的包计为迟到并丢弃。队列不超过目标深度时，缺失包到了播放位置按标称帧长补静音，
+// 保持队列深度，为后续的重传和冗余恢复留出时间；超过目标深度时直接跳过以降低延迟。
+// 序列号出现空缺时记录缺失的包，在估计的往返时间内仍能赶上播放的才发出重传请求 (NACK)。
+// 发送端静音 (DTX) 期间按收到的描述符生成舒适噪声，新的语音段开始时先积累到目标队列深度再恢复播放。
+// 发送端会按码率在PCM与ADPCM、配置包长与40ms包之间切换，队列按每个包实际的帧数计算深度。
+// 超过一个包的帧以连续序列号的分片到达 (见 FragmentHeader)，分片按各自分摊的帧数计入队列，
+// 播放到第一个分片时整帧到齐则拼接解码，否则按分片占用的帧数补静音。
+// 网络突发之后队列持续高于目标时用 WSOLA 快放 (每次拉取最多去掉一个基音周期)，把延迟降回目标；
+// 数据不够一次拉取时慢放已有的数据，减少补的静音。时钟漂移补偿仍只做缓慢的比例修正
+class RemoteStream {
+public:
+    // packet_frames 为每个包的标称帧数 (网络采样率)，在收到第一个音频包之前用于补静音；
+    // pull_frames 为音频线程每次拉取的帧数。目标深度取三次拉取与一个包加两次拉取中的较大者
+    RemoteStream(uint32_t session_id, int sample_rate, int channels, size_t packet_frames, size_t pull_frames);
+
+    // 收到音频包 (网络线程)，队列已满、重复或迟到时丢弃并返回false
+    bool Push(const AudioPacket& packet, double arrival_seconds);
+    // 负载加密时原包已收到的重传包在解密前即被重放窗口拒绝，只按序列号计入迟到或无用的重传 (网络线程)
+    void PushReplayedRetransmit(uint32_t sequence);
+
+    // 拉取 frames 帧到 out (音频线程)，不足部分填0 (舒适噪声期间填充噪声)，返回有效帧数
+    size_t Pull(int16_t* out, size_t frames, double now_seconds);
+
+    // 队列中尚未播放的帧数 (包含已重采样未取走的部分)
+    size_t QueuedFrames() const;
+    // 变速调整 (默认开启)，关闭时只靠漂移补偿的比例修正与队列上限控制延迟
+    void SetTimeStretchEnabled(bool enabled) { time_stretch_enabled_ = enabled; }
+    // 目标队列深度 (帧)
+    size_t TargetFrames() const { return target_frames_; }
+    // 队列中的包数 (分片各计一个)
+    size_t QueuedPackets() const { return queued_packets_; }
+
+    uint32_t GetSessionId() const { return session_id_; }
+    double GetLastArrival() const { return last_arrival_; }
+    double GetDriftPpm() const { return drift_.GetDriftPpm(); }
+    double GetRatio() const { return drift_.GetRatio(); }
+    // 是否处于发送端静音 (舒适噪声) 状态
+    bool IsComfortNoiseActive() const { return comfort_noise_active_; }
+
+    // 填写接收报告块 (网络字节序)，内容为自上次调用以来的统计，同时开始新的统计周期；
+    // 周期内没有包时返回false
+    bool TakeReport(ReceiverReportBlock* block);
+    // 累计统计 (序列号重新开始之前的丢包也计入)
+    uint64_t GetPacketsReceived() const { return packets_received_; }
+    uint64_t GetPacketsLost() const;
+    uint64_t GetPacketsRecovered() const { return packets_recovered_; }
+    uint64_t GetPacketsLate() const { return packets_late_; }
+    // 序列号小于已收到的最高序列号的包
+    uint64_t GetPacketsReordered() const { return packets_reordered_; }
+    // 队列已满而丢弃的包
+    uint64_t GetQueueDrops() const { return queue_drops_; }
+    // 播放时补静音的帧 (缺失包占位与队列取空)
+    uint64_t GetConcealedFrames() const { return concealed_frames_; }
+    // 快放去掉的帧与慢放插入的帧 (网络采样率)
+    uint64_t GetAcceleratedFrames() const { return accelerated_frames_; }
+    uint64_t GetDeceleratedFrames() const { return decelerated_frames_; }
+    double GetJitterSeconds() const { return jitter_ / sample_rate_; }
+
+    // 生成需要重传的请求 (网络线程)，返回块数。只请求在估计往返时间内还来得及播放的包，
+    // 每个包最多请求 kMaxNackRequests 次，两次之间至少间隔约1.5倍往返时间
+    size_t BuildNack(double now_seconds, NackBlock* blocks, size_t capacity);
+    double GetRttSeconds() const { return rtt_seconds_; }
+    // 重传统计: 请求的包数、填补了空缺的重传、晚于播放位置到达的重传、重复 (已由原包或FEC补上) 的重传
+    uint64_t GetNackRequests() const { return nack_requests_; }
+    uint64_t GetRetransmitsRecovered() const { return retransmits_recovered_; }
+    uint64_t GetRetransmitsLate() const { return retransmits_late_; }
+    uint64_t GetRetransmitsUseless() const { return retransmits_useless_; }
+
+private:
+    enum StretchMode {
+        kStretchNone,
+        kStretchAccelerate,
+        kStretchDecelerate
+    };
+
+    int64_t ExtendSequence(uint32_t sequence) const;
+    // 取出主负载 (冗余包去掉冗余块，类型改为对应的单一编码)，负载格式错误返回false
+    static bool ExtractPrimary(const AudioPacket& packet, AudioPacket* primary);
+    // 包含的音频帧数，舒适噪声描述符为0，分片为它分摊的帧数
+    size_t PacketFrames(const AudioPacket& packet) const;
+    // 包所属整帧的音频帧数 (分片取分片头中的帧数)
+    size_t FrameFrames(const AudioPacket& packet) const;
+    // 分片头格式错误 (或不是分片) 时返回false
+    static bool ReadFragmentHeader(const AudioPacket& packet, FragmentHeader* header);
+    // 队首 (序列号 head) 为第一个分片且整帧已到齐时拼接到 assembly_，返回整帧负载长度，否则返回0
+    size_t AssembleFrame(int64_t head);
+    void PushRetransmit(const AudioPacket& packet, double arrival_seconds);
+    bool Insert(int64_t sequence, const AudioPacket& packet);
+    // 接收队列的环: 序列号是否在队列中、第一个 (序列号最小的) 排队的包，移除一个包
+    bool IsQueued(int64_t sequence) const;
+    int64_t HeadSequence() const;
+    AudioPacket& QueuedPacket(int64_t sequence) { return queue_[static_cast<size_t>(sequence) % queue_.size()].packet; }
+    void Remove(int64_t sequence);
+    // 更新相对传输时延与抖动 (packet 为主负载)
+    void UpdateTransit(const AudioPacket& packet, double arrival_seconds);
+    // 冗余块 (ADPCM) 插入尚未播放的空缺，播放时再解码
+    void RecoverRedundant(const AudioPacket& packet, int64_t sequence,
+                          const RedundantBlock* blocks, int block_count);
+    void ResetSequencing();
+    // 从队列解码到 pending_，直到达到 samples 个样点或队列取空 (或舒适噪声之后仍在积累)
+    void FillPending(size_t samples);
+    // 按队列深度 (平滑值与当前值) 决定本次拉取是否变速
+    StretchMode ChooseStretch();
+    // 对 pending_ 中未取走的数据的开头快放或慢放一个周期
+    void Stretch(StretchMode mode);
+    // pending_ 中未取走的样点数；读位置超过剩余数据时把剩余数据移到开头
+    size_t PendingSamples() const { return pending_.size() - pending_read_; }
+    void CompactPending();
+
+    uint32_t session_id_;
+    int sample_rate_;
+    int channels_;
+    double last_arrival_;
+
+    // 接收队列: 按 序列号 % 槽数 下标的定长环，只接受 last_played_ 之后一个环长以内的序列号
+    // (队列的包数本来就受 kMaxQueuedDatagrams 与 max_queued_frames_ 限制)
+    struct QueueSlot {
+        int64_t sequence;        // -1 表示空槽
+        AudioPacket packet;
+    };
+    std::vector<QueueSlot> queue_;
+    size_t queued_packets_;
+    size_t queued_frames_;
+    ClockDriftCompensator drift_;
+    FractionalResampler resampler_;
+    std::vector<int16_t> pending_;       // 已重采样等待取走的样点，pending_read_ 之前的已经取走
+    size_t pending_read_;
+    std::vector<int16_t> resample_buffer_;
+    std::vector<int16_t> decode_buffer_; // ADPCM解码输出
+    std::vector<uint8_t> assembly_;      // 分片拼接的整帧负载 (第一次收到分片帧时分配)
+
+    size_t nominal_frames_;      // 音频线程每次拉取的帧数
+    size_t frame_frames_;        // 最近播放的音频帧的帧数
+    size_t frame_fragments_;     // 最近播放的音频帧的分片数 (没有分片为1)，缺失包按帧数的均摊补静音
+    size_t target_frames_;
+    size_t max_queued_frames_;   // 队列上限 (帧)，超出时丢弃新包
+    size_t max_packet_frames_;   // 重采样器单次处理的帧数上限
+    size_t underrun_frames_;     // 上次按序播放以来队列空时补的帧数，抵扣之后缺失包的补静音
+    bool comfort_noise_active_;
+    ComfortNoiseGenerator comfort_noise_;
+    std::vector<float> comfort_noise_buffer_;
+    TimeStretcher stretcher_;
+    bool time_stretch_enabled_;
+    double smoothed_level_;               // 每次拉取时队列深度 (帧) 的平滑值
+    std::vector<int16_t> stretch_buffer_;
+
+    // 序列号状态与接收统计 (序列号重新开始时清零，之前的丢包累加到 packets_lost_before_)
+    bool has_sequence_;
+    int64_t base_sequence_;
+    uint64_t sequence_received_;    // 自 base_sequence_ 以来收到的包
+    int64_t highest_sequence_;
+    int64_t last_played_;
+    int64_t report_highest_;
+    uint64_t report_received_;
+    double report_transit_sum_;  // 本周期相对传输时延之和 (微秒)
+    uint64_t report_transit_count_;
+    double last_transit_;        // 上一个包的相对传输时延 (采样帧)，用于抖动
+    bool has_transit_;
+    double jitter_;              // 到达间隔抖动 (采样帧)
+    uint64_t packets_received_;
+    uint64_t packets_lost_before_;
+    uint64_t packets_recovered_;
+    uint64_t packets_late_;
+    uint64_t packets_reordered_;
+    uint64_t queue_drops_;
+    uint64_t concealed_frames_;
+    uint64_t accelerated_frames_;
+    uint64_t decelerated_frames_;
+
+    // 等待重传的缺失包
+    struct MissingPacket {
+        double last_request;
+        int requests;
+    };
+    std::map<int64_t, MissingPacket> missing_;
+    double rtt_seconds_;
+    uint64_t nack_requests_;
+    uint64_t retransmits_recovered_;
+    uint64_t retransmits_late_;
+    uint64_t retransmits_useless_;
+};
+
+#endif // REMOTE_STREAM_H
@@ -0,0 +1,470 @@
+#include "sample_format.h"
+
+#include <cstring>
+
+#include "audio_kernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SAMPLE_FORMAT_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SAMPLE_FORMAT_NEON 1
+#endif
+
+namespace {
+
+const float kS16Scale = 1.0f / 32768.0f;
+const float kS24Scale = 1.0f / 8388608.0f;
+const float kS32Scale = 1.0f / 2147483648.0f;
+
+inline int16_t SaturateToS16(float sample) {
+    float scaled = sample * 32768.0f;
+    if (scaled >= 32767.0f) return 32767;
+    if (scaled <= -32768.0f) return -32768;
+    return static_cast<int16_t>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+// 就近舍入 (与 audio_kernels 一致，不调用 lrintf，循环可以被向量化)
+inline int32_t RoundToInt(float scaled) {
+    return static_cast<int32_t>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+// 每种格式单个样点的读写 (通用版本与向量化版本的尾部使用)
+template <SampleFormat F> struct SampleTraits;
+
+template <> struct SampleTraits<kSampleS16> {
+    static const size_t kBytes = 2;
+    static int16_t ToS16(const uint8_t* p) {
+        int16_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    static void FromS16(int16_t value, uint8_t* p) { memcpy(p, &value, sizeof(value)); }
+    static float ToFloat(const uint8_t* p) { return static_cast<float>(ToS16(p)) * kS16Scale; }
+    static void FromFloat(float value, uint8_t* p) { FromS16(SaturateToS16(value), p); }
+};
+
+template <> struct SampleTraits<kSampleS24> {
+    static const size_t kBytes = 3;
+    static int32_t Load(const uint8_t* p) {
+        // 放到高24位再算术右移完成符号扩展
+        uint32_t bits = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+                        (static_cast<uint32_t>(p[2]) << 24);
+        return static_cast<int32_t>(bits) >> 8;
+    }
+    static int16_t ToS16(const uint8_t* p) { return static_cast<int16_t>(p[1] | (p[2] << 8)); }
+    static void FromS16(int16_t value, uint8_t* p) {
+        p[0] = 0;
+        p[1] = static_cast<uint8_t>(value);
+        p[2] = static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8);
+    }
+    static float ToFloat(const uint8_t* p) { return static_cast<float>(Load(p)) * kS24Scale; }
+    static void FromFloat(float value, uint8_t* p) {
+        float scaled = value * 8388608.0f;
+        int32_t sample = scaled >= 8388607.0f ? 8388607 : scaled <= -8388608.0f ? -8388608
+                                                        : RoundToInt(scaled);
+        p[0] = static_cast<uint8_t>(sample);
+        p[1] = static_cast<uint8_t>(sample >> 8);
+        p[2] = static_cast<uint8_t>(sample >> 16);
+    }
+};
+
+template <> struct SampleTraits<kSampleS32> {
+    static const size_t kBytes = 4;
+    static int32_t Load(const uint8_t* p) {
+        int32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    static void Store(int32_t value, uint8_t* p) { memcpy(p, &value, sizeof(value)); }
+    static int16_t ToS16(const uint8_t* p) { return static_cast<int16_t>(Load(p) >> 16); }
+    static void FromS16(int16_t value, uint8_t* p) {
+        Store(static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(value)) << 16), p);
+    }
+    static float ToFloat(const uint8_t* p) { return static_cast<float>(Load(p)) * kS32Scale; }
+    static void FromFloat(float value, uint8_t* p) {
+        // float 只有24位精度，2^31 - 1 不可表示，达到 2^31 即饱和
+        float scaled = value * 2147483648.0f;
+        Store(scaled >= 2147483648.0f ? INT32_MAX : scaled <= -2147483648.0f ? INT32_MIN
+                                                    : RoundToInt(scaled), p);
+    }
+};
+
+template <> struct SampleTraits<kSampleF32> {
+    static const size_t kBytes = 4;
+    static float ToFloat(const uint8_t* p) {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    static void FromFloat(float value, uint8_t* p) { memcpy(p, &value, sizeof(value)); }
+    static int16_t ToS16(const uint8_t* p) { return SaturateToS16(ToFloat(p)); }
+    static void FromS16(int16_t value, uint8_t* p) { FromFloat(static_cast<float>(value) * kS16Scale, p); }
+};
+
+// 交错的样点数与声道无关，设备格式 <-> S16 只按格式特化
+
+template <SampleFormat F>
+void ConvertToS16(const uint8_t* in, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = SampleTraits<F>::ToS16(in + i * SampleTraits<F>::kBytes);
+    }
+}
+
+template <SampleFormat F>
+void ConvertFromS16(const int16_t* in, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        SampleTraits<F>::FromS16(in[i], out + i * SampleTraits<F>::kBytes);
+    }
+}
+
+template <>
+void ConvertToS16<kSampleS16>(const uint8_t* in, int16_t* out, size_t n) {
+    memcpy(out, in, n * sizeof(int16_t));
+}
+
+template <>
+void ConvertFromS16<kSampleS16>(const int16_t* in, uint8_t* out, size_t n) {
+    memcpy(out, in, n * sizeof(int16_t));
+}
+
+template <>
+void ConvertToS16<kSampleS32>(const uint8_t* in, int16_t* out, size_t n) {
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    for (; i + 8 <= n; i += 8) {
+        // 取高16位 (算术右移后不会超出int16，packs 不会饱和)
+        __m128i lo = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4)), 16);
+        __m128i hi = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4 + 16)), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = vld1q_s32(reinterpret_cast<const int32_t*>(in + i * 4));
+        int32x4_t hi = vld1q_s32(reinterpret_cast<const int32_t*>(in + i * 4 + 16));
+        vst1q_s16(out + i, vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = SampleTraits<kSampleS32>::ToS16(in + i * 4);
+    }
+}
+
+template <>
+void ConvertFromS16<kSampleS32>(const int16_t* in, uint8_t* out, size_t n) {
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        // 低16位补0
+        __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_unpacklo_epi16(zero, s16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4 + 16), _mm_unpackhi_epi16(zero, s16));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s16 = vld1q_s16(in + i);
+        vst1q_s32(reinterpret_cast<int32_t*>(out + i * 4), vshll_n_s16(vget_low_s16(s16), 16));
+        vst1q_s32(reinterpret_cast<int32_t*>(out + i * 4 + 16), vshll_n_s16(vget_high_s16(s16), 16));
+    }
+#endif
+    for (; i < n; ++i) {
+        SampleTraits<kSampleS32>::FromS16(in[i], out + i * 4);
+    }
+}
+
+template <>
+void ConvertToS16<kSampleF32>(const uint8_t* in, int16_t* out, size_t n) {
+    audio_kernels::FloatToS16(reinterpret_cast<const float*>(in), out, n);
+}
+
+template <>
+void ConvertFromS16<kSampleF32>(const int16_t* in, uint8_t* out, size_t n) {
+    audio_kernels::S16ToFloat(in, reinterpret_cast<float*>(out), n);
+}
+
+template <int Channels>
+inline int ChannelCount(int channels) {
+    return Channels > 0 ? Channels : channels;
+}
+
+template <SampleFormat F, int Channels>
+void ToS16(const void* in, int16_t* out, size_t frames, int channels) {
+    ConvertToS16<F>(static_cast<const uint8_t*>(in), out, frames * ChannelCount<Channels>(channels));
+}
+
+template <SampleFormat F, int Channels>
+void FromS16(const int16_t* in, void* out, size_t frames, int channels) {
+    ConvertFromS16<F>(in, static_cast<uint8_t*>(out), frames * ChannelCount<Channels>(channels));
+}
+
+// 设备格式 <-> 平面float: 声道数为编译期常量时内层循环完全展开
+
+template <SampleFormat F, int Channels>
+void ToPlanarFloat(const void* in, float* const* planes, size_t frames, int channels) {
+    const int count = ChannelCount<Channels>(channels);
+    const uint8_t* bytes = static_cast<const uint8_t*>(in);
+    for (size_t i = 0; i < frames; ++i) {
+        for (int ch = 0; ch < count; ++ch) {
+            planes[ch][i] = SampleTraits<F>::ToFloat(bytes + (i * count + ch) * SampleTraits<F>::kBytes);
+        }
+    }
+}
+
+template <SampleFormat F, int Channels>
+void FromPlanarFloat(const float* const* planes, void* out, size_t frames, int channels) {
+    const int count = ChannelCount<Channels>(channels);
+    uint8_t* bytes = static_cast<uint8_t*>(out);
+    for (size_t i = 0; i < frames; ++i) {
+        for (int ch = 0; ch < count; ++ch) {
+            SampleTraits<F>::FromFloat(planes[ch][i], bytes + (i * count + ch) * SampleTraits<F>::kBytes);
+        }
+    }
+}
+
+template <>
+void ToPlanarFloat<kSampleS16, 1>(const void* in, float* const* planes, size_t frames, int) {
+    audio_kernels::S16ToFloat(static_cast<const int16_t*>(in), planes[0], frames);
+}
+
+template <>
+void FromPlanarFloat<kSampleS16, 1>(const float* const* planes, void* out, size_t frames, int) {
+    audio_kernels::FloatToS16(planes[0], static_cast<int16_t*>(out), frames);
+}
+
+template <>
+void ToPlanarFloat<kSampleF32, 1>(const void* in, float* const* planes, size_t frames, int) {
+    memcpy(planes[0], in, frames * sizeof(float));
+}
+
+template <>
+void FromPlanarFloat<kSampleF32, 1>(const float* const* planes, void* out, size_t frames, int) {
+    memcpy(out, planes[0], frames * sizeof(float));
+}
+
+template <>
+void ToPlanarFloat<kSampleS16, 2>(const void* in, float* const* planes, size_t frames, int) {
+    const int16_t* pcm = static_cast<const int16_t*>(in);
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    const __m128 scale = _mm_set1_ps(kS16Scale);
+    for (; i + 4 <= frames; i += 4) {
+        // 每个32位通道为一帧 (低16位左声道，高16位右声道)，移位完成拆分与符号扩展
+        __m128i frame = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pcm + i * 2));
+        __m128i l = _mm_srai_epi32(_mm_slli_epi32(frame, 16), 16);
+        __m128i r = _mm_srai_epi32(frame, 16);
+        _mm_storeu_ps(left + i, _mm_mul_ps(_mm_cvtepi32_ps(l), scale));
+        _mm_storeu_ps(right + i, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        int16x4x2_t frame = vld2_s16(pcm + i * 2);
+        vst1q_f32(left + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(frame.val[0])), kS16Scale));
+        vst1q_f32(right + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(frame.val[1])), kS16Scale));
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] = static_cast<float>(pcm[i * 2]) * kS16Scale;
+        right[i] = static_cast<float>(pcm[i * 2 + 1]) * kS16Scale;
+    }
+}
+
+template <>
+void FromPlanarFloat<kSampleS16, 2>(const float* const* planes, void* out, size_t frames, int) {
+    int16_t* pcm = static_cast<int16_t*>(out);
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    for (; i + 4 <= frames; i += 4) {
+        // packs 饱和得到 L0..L3 R0..R3，再与自身的高半部分交织
+        __m128i l = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(left + i), scale));
+        __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(right + i), scale));
+        __m128i packed = _mm_packs_epi32(l, r);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pcm + i * 2),
+                         _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8)));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        int16x4x2_t frame;
+        frame.val[0] = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(left + i), 32768.0f)));
+        frame.val[1] = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(right + i), 32768.0f)));
+        vst2_s16(pcm + i * 2, frame);
+    }
+#endif
+    for (; i < frames; ++i) {
+        pcm[i * 2] = SaturateToS16(left[i]);
+        pcm[i * 2 + 1] = SaturateToS16(right[i]);
+    }
+}
+
+template <>
+void ToPlanarFloat<kSampleF32, 2>(const void* in, float* const* planes, size_t frames, int) {
+    const float* samples = static_cast<const float*>(in);
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    for (; i + 4 <= frames; i += 4) {
+        __m128 a = _mm_loadu_ps(samples + i * 2);
+        __m128 b = _mm_loadu_ps(samples + i * 2 + 4);
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t frame = vld2q_f32(samples + i * 2);
+        vst1q_f32(left + i, frame.val[0]);
+        vst1q_f32(right + i, frame.val[1]);
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] = samples[i * 2];
+        right[i] = samples[i * 2 + 1];
+    }
+}
+
+template <>
+void FromPlanarFloat<kSampleF32, 2>(const float* const* planes, void* out, size_t frames, int) {
+    float* samples = static_cast<float*>(out);
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    for (; i + 4 <= frames; i += 4) {
+        __m128 l = _mm_loadu_ps(left + i);
+        __m128 r = _mm_loadu_ps(right + i);
+        _mm_storeu_ps(samples + i * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(samples + i * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t frame;
+        frame.val[0] = vld1q_f32(left + i);
+        frame.val[1] = vld1q_f32(right + i);
+        vst2q_f32(samples + i * 2, frame);
+    }
+#endif
+    for (; i < frames; ++i) {
+        samples[i * 2] = left[i];
+        samples[i * 2 + 1] = right[i];
+    }
+}
+
+#if defined(SAMPLE_FORMAT_SSE)
+// float -> S32 (4个样点): cvtps 对超出 int32 的值返回 0x80000000，先在 float 域截断到可表示的范围
+inline __m128i FloatToS32x4(__m128 samples) {
+    __m128 scaled = _mm_mul_ps(samples, _mm_set1_ps(2147483648.0f));
+    scaled = _mm_max_ps(_mm_min_ps(scaled, _mm_set1_ps(2147483520.0f)), _mm_set1_ps(-2147483648.0f));
+    return _mm_cvtps_epi32(scaled);
+}
+#elif defined(SAMPLE_FORMAT_NEON)
+// vcvtq 本身饱和
+inline int32x4_t FloatToS32x4(float32x4_t samples) {
+    return vcvtq_s32_f32(vmulq_n_f32(samples, 2147483648.0f));
+}
+#endif
+
+template <>
+void FromPlanarFloat<kSampleS32, 1>(const float* const* planes, void* out, size_t frames, int) {
+    const float* mono = planes[0];
+    uint8_t* bytes = static_cast<uint8_t*>(out);
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 4), FloatToS32x4(_mm_loadu_ps(mono + i)));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_s32(reinterpret_cast<int32_t*>(bytes + i * 4), FloatToS32x4(vld1q_f32(mono + i)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        SampleTraits<kSampleS32>::FromFloat(mono[i], bytes + i * 4);
+    }
+}
+
+template <>
+void FromPlanarFloat<kSampleS32, 2>(const float* const* planes, void* out, size_t frames, int) {
+    const float* left = planes[0];
+    const float* right = planes[1];
+    uint8_t* bytes = static_cast<uint8_t*>(out);
+    size_t i = 0;
+#if defined(SAMPLE_FORMAT_SSE)
+    for (; i + 4 <= frames; i += 4) {
+        __m128i l = FloatToS32x4(_mm_loadu_ps(left + i));
+        __m128i r = FloatToS32x4(_mm_loadu_ps(right + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 8), _mm_unpacklo_epi32(l, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 8 + 16), _mm_unpackhi_epi32(l, r));
+    }
+#elif defined(SAMPLE_FORMAT_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        int32x4x2_t frame;
+        frame.val[0] = FloatToS32x4(vld1q_f32(left + i));
+        frame.val[1] = FloatToS32x4(vld1q_f32(right + i));
+        vst2q_s32(reinterpret_cast<int32_t*>(bytes + i * 8), frame);
+    }
+#endif
+    for (; i < frames; ++i) {
+        SampleTraits<kSampleS32>::FromFloat(left[i], bytes + i * 8);
+        SampleTraits<kSampleS32>::FromFloat(right[i], bytes + i * 8 + 4);
+    }
+}
+
+template <SampleFormat F, int Channels>
+constexpr SampleConversion MakeConversion() {
+    return SampleConversion{F, Channels, &ToS16<F, Channels>, &FromS16<F, Channels>,
+                            &ToPlanarFloat<F, Channels>, &FromPlanarFloat<F, Channels>};
+}
+
+// [格式][单声道, 立体声, 通用]
+const SampleConversion kConversions[kSampleFormatCount][3] = {
+    {MakeConversion<kSampleS16, 1>(), MakeConversion<kSampleS16, 2>(), MakeConversion<kSampleS16, 0>()},
+    {MakeConversion<kSampleS24, 1>(), MakeConversion<kSampleS24, 2>(), MakeConversion<kSampleS24, 0>()},
+    {MakeConversion<kSampleS32, 1>(), MakeConversion<kSampleS32, 2>(), MakeConversion<kSampleS32, 0>()},
+    {MakeConversion<kSampleF32, 1>(), MakeConversion<kSampleF32, 2>(), MakeConversion<kSampleF32, 0>()},
+};
+
+} // namespace
+
+size_t SampleFormatBytes(SampleFormat format) {
+    switch (format) {
+    case kSampleS24: return 3;
+    case kSampleS32: return 4;
+    case kSampleF32: return 4;
+    default: return 2;
+    }
+}
+
+const char* SampleFormatName(SampleFormat format) {
+    switch (format) {
+    case kSampleS24: return "S24_3LE";
+    case kSampleS32: return "S32_LE";
+    case kSampleF32: return "FLOAT_LE";
+    default: return "S16_LE";
+    }
+}
+
+SampleFormat SampleFormatFromConfig(const voice_call_audio_config_t& config) {
+    switch (config.sample_format) {
+    case VOICE_CALL_SAMPLE_FORMAT_S16: return kSampleS16;
+    case VOICE_CALL_SAMPLE_FORMAT_S24: return kSampleS24;
+    case VOICE_CALL_SAMPLE_FORMAT_S32: return kSampleS32;
+    case VOICE_CALL_SAMPLE_FORMAT_F32: return kSampleF32;
+    default: break;
+    }
+    if (config.bits_per_sample == 24) return kSampleS24;
+    if (config.bits_per_sample == 32) return kSampleS32;
+    return kSampleS16;
+}
+
+const SampleConversion& GetSampleConversion(SampleFormat format, int channels) {
+    if (format < kSampleS16 || format >= kSampleFormatCount) {
+        format = kSampleS16;
+    }
+    return kConversions[format][channels == 1 ? 0 : channels == 2 ? 1 : 2];
+}
@@ -0,0 +1,42 @@
+#ifndef SAMPLE_FORMAT_H
+#define SAMPLE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "voice_call.h"
+
+// 设备样点格式 (均为小端交错存储)
+enum SampleFormat {
+    kSampleS16 = 0,   // 16位整数
+    kSampleS24,       // 24位整数，每个样点3字节 (ALSA S24_3LE)
+    kSampleS32,       // 32位整数
+    kSampleF32,       // 32位浮点，[-1, 1)
+    kSampleFormatCount
+};
+
+size_t SampleFormatBytes(SampleFormat format);
+const char* SampleFormatName(SampleFormat format);
+
+// 配置对应的设备格式: sample_format 为 AUTO 时按 bits_per_sample (16/24/32) 选择整数格式，其他值按S16
+SampleFormat SampleFormatFromConfig(const voice_call_audio_config_t& config);
+
+// 一种 (设备格式, 声道数) 组合的转换内核。
+// 内部定点格式 (重采样、混音与网络负载) 为交错的S16，处理链 (回声消除、降噪、增益) 为逐声道的平面float。
+// 每个组合是单独编译的模板特化，选出后整段数据只调用一次，循环内没有按格式或声道数的分支；
+// 1、2声道按声道数特化，其余声道数使用运行时声道数的版本。frames 为帧数，channels 为实际声道数
+struct SampleConversion {
+    SampleFormat format;
+    int channels;         // 特化的声道数，0表示通用版本
+    // 设备格式 <-> 交错S16 (设备读写)
+    void (*to_s16)(const void* in, int16_t* out, size_t frames, int channels);
+    void (*from_s16)(const int16_t* in, void* out, size_t frames, int channels);
+    // 设备格式 <-> 平面float (planes[ch] 为第ch个声道)
+    void (*to_planar_float)(const void* in, float* const* planes, size_t frames, int channels);
+    void (*from_planar_float)(const float* const* planes, void* out, size_t frames, int channels);
+};
+
+// 选出 format 与 channels 对应的转换内核 (在初始化时调用一次，不会返回空)
+const SampleConversion& GetSampleConversion(SampleFormat format, int channels);
+
+#endif // SAMPLE_FORMAT_H
@@ -0,0 +1,104 @@
+#include "thread_scheduling.h"
+
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+// 每种失败原因只警告一次，多个通话的线程不会重复刷屏
+std::atomic<bool> g_priority_warned(false);
+std::atomic<bool> g_affinity_warned(false);
+
+// 返回 pthread_setschedparam 的错误码
+int SetPriority(int policy, int priority) {
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), policy, &param);
+}
+
+} // namespace
+
+void ApplyThreadScheduling(const char* name, voice_call_sched_policy_t policy, int priority, uint64_t cpu_mask) {
+    pthread_setname_np(pthread_self(), name);
+
+    if (cpu_mask != 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+            if (cpu_mask & (1ULL << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result != 0 && !g_affinity_warned.exchange(true)) {
+            std::cerr << "Failed to set CPU affinity 0x" << std::hex << cpu_mask << std::dec << " for " << name
+                      << ": " << strerror(result) << ", running on all CPUs" << std::endl;
+        }
+    }
+
+    if (policy == VOICE_CALL_SCHED_DEFAULT) {
+        return;
+    }
+    const int sched = policy == VOICE_CALL_SCHED_RR ? SCHED_RR : SCHED_FIFO;
+    priority = std::max(sched_get_priority_min(sched), std::min(priority, sched_get_priority_max(sched)));
+    int error = SetPriority(sched, priority);
+    if (error == 0) {
+        return;
+    }
+
+    // 没有 CAP_SYS_NICE 时非特权用户可以使用 RLIMIT_RTPRIO 以内的优先级
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0) {
+        int allowed = static_cast<int>(std::min<rlim_t>(limit.rlim_cur, static_cast<rlim_t>(priority)));
+        if (allowed < priority && SetPriority(sched, allowed) == 0) {
+            if (!g_priority_warned.exchange(true)) {
+                std::cerr << "Real-time priority " << priority << " not permitted, using " << allowed
+                          << " (RLIMIT_RTPRIO)" << std::endl;
+            }
+            return;
+        }
+    }
+    if (!g_priority_warned.exchange(true)) {
+        std::cerr << "Failed to set real-time priority " << priority << " for " << name << ": " << strerror(error)
+                  << ", using default scheduling (needs CAP_SYS_NICE or RLIMIT_RTPRIO)" << std::endl;
+    }
+}
+
+bool LockProcessMemory() {
+    static std::once_flag once;
+    static bool locked = false;
+    std::call_once(once, []() {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            std::cerr << "Failed to lock memory: " << strerror(errno)
+                      << ", continuing without (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)" << std::endl;
+            return;
+        }
+        // 释放的堆内存不归还系统、大块分配也从堆上取，已锁定的页可以被重复使用
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+        locked = true;
+        std::cout << "Process memory locked" << std::endl;
+    });
+    return locked;
+}
+
+__attribute__((noinline)) void PrefaultStack(size_t bytes) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        stack[offset] = 0;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef THREAD_SCHEDULING_H
+#define THREAD_SCHEDULING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "voice_call.h"
+
+// 设置当前线程的名称、调度策略与CPU亲和性 (在线程开始时由线程自己调用)。
+// 没有权限使用 priority 时退回 RLIMIT_RTPRIO 允许的最高优先级，仍然失败则保持默认调度；
+// 失败只打印警告 (每种原因每个进程一次)，不影响通话。name 最长15字节
+void ApplyThreadScheduling(const char* name, voice_call_sched_policy_t policy, int priority, uint64_t cpu_mask);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE) 锁定已有与以后分配的内存，并让 malloc 不再把释放的内存还给系统，
+// 避免实时线程中的分配重新缺页。两者都是进程级设置且不撤销；每个进程只执行一次 (失败也不重试)，
+// 之后的调用直接返回第一次的结果
+bool LockProcessMemory();
+
+// 预先触及当前线程栈顶之下 bytes 字节，实时循环中用到的栈页此后不再缺页
+void PrefaultStack(size_t bytes);
+
+#endif // THREAD_SCHEDULING_H
@@ -0,0 +1,142 @@
+#include "time_stretcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 周期范围 (秒)，覆盖约67~400Hz的基音
+const double kMinPeriodSeconds = 0.0025;
+const double kMaxPeriodSeconds = 0.015;
+// 粗搜的采样率
+const int kSearchRate = 4000;
+// 归一化互相关达到该值才认为两个周期足够相似
+const float kCorrelationThreshold = 0.9f;
+// 均方根低于该值 (约 -50dBFS) 的段视为静音，直接按最大周期调整
+const float kQuietLevel = 100.0f;
+
+float NormalizedCorrelation(const float* x, size_t lag) {
+    float cross = 0.0f;
+    float energy_a = 0.0f;
+    float energy_b = 0.0f;
+    for (size_t i = 0; i < lag; ++i) {
+        cross += x[i] * x[i + lag];
+        energy_a += x[i] * x[i];
+        energy_b += x[i + lag] * x[i + lag];
+    }
+    if (energy_a <= 0.0f || energy_b <= 0.0f) {
+        return 0.0f;
+    }
+    return cross / std::sqrt(energy_a * energy_b);
+}
+
+} // namespace
+
+TimeStretcher::TimeStretcher()
+    : channels_(1)
+    , min_lag_(0)
+    , max_lag_(0)
+    , decimation_(1) {
+}
+
+void TimeStretcher::Configure(int sample_rate, int channels) {
+    channels_ = std::max(1, channels);
+    min_lag_ = std::max<size_t>(2, static_cast<size_t>(sample_rate * kMinPeriodSeconds));
+    max_lag_ = std::max(min_lag_, static_cast<size_t>(sample_rate * kMaxPeriodSeconds));
+    decimation_ = static_cast<size_t>(std::max(1, sample_rate / kSearchRate));
+    mono_.assign(2 * max_lag_, 0.0f);
+    decimated_.assign(2 * max_lag_ / decimation_ + 1, 0.0f);
+}
+
+size_t TimeStretcher::FindPeriod(const int16_t* in, size_t frames) {
+    const size_t lag_limit = std::min(max_lag_, frames / 2);
+    if (lag_limit < min_lag_) {
+        return 0;
+    }
+    const size_t length = 2 * lag_limit;
+    float energy = 0.0f;
+    for (size_t i = 0; i < length; ++i) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < channels_; ++ch) {
+            sum += in[i * channels_ + ch];
+        }
+        mono_[i] = sum / channels_;
+        energy += mono_[i] * mono_[i];
+    }
+    if (energy < kQuietLevel * kQuietLevel * length) {
+        return lag_limit;
+    }
+
+    // 粗搜: 降采样信号 (相邻 decimation_ 个样点求和) 上逐个周期计算
+    const size_t d = decimation_;
+    for (size_t k = 0; k < length / d; ++k) {
+        float sum = 0.0f;
+        for (size_t j = 0; j < d; ++j) {
+            sum += mono_[k * d + j];
+        }
+        decimated_[k] = sum;
+    }
+    size_t best_coarse = 0;
+    float best = -1.0f;
+    for (size_t lag = std::max<size_t>(1, (min_lag_ + d - 1) / d); lag <= lag_limit / d; ++lag) {
+        float correlation = NormalizedCorrelation(decimated_.data(), lag);
+        if (correlation > best) {
+            best = correlation;
+            best_coarse = lag;
+        }
+    }
+    if (best_coarse == 0) {
+        return 0;
+    }
+
+    // 细化: 原采样率上在粗搜结果附近 ±(d-1) 帧内搜索
+    const size_t low = std::max(min_lag_, best_coarse * d > d - 1 ? best_coarse * d - (d - 1) : 0);
+    const size_t high = std::min(lag_limit, best_coarse * d + (d - 1));
+    size_t period = 0;
+    best = -1.0f;
+    for (size_t lag = low; lag <= high; ++lag) {
+        float correlation = NormalizedCorrelation(mono_.data(), lag);
+        if (correlation > best) {
+            best = correlation;
+            period = lag;
+        }
+    }
+    return best >= kCorrelationThreshold ? period : 0;
+}
+
+void TimeStretcher::CrossFade(const int16_t* fade_out, const int16_t* fade_in, size_t length, int16_t* out) const {
+    // 权重从 1/(length+1) 到 length/(length+1)，两端分别与前后的样点衔接
+    const float step = 1.0f / static_cast<float>(length + 1);
+    for (size_t i = 0; i < length; ++i) {
+        const float weight = static_cast<float>(i + 1) * step;
+        for (int ch = 0; ch < channels_; ++ch) {
+            const size_t index = i * channels_ + ch;
+            const float a = fade_out[index];
+            out[index] = static_cast<int16_t>(std::lrint(a + (fade_in[index] - a) * weight));
+        }
+    }
+}
+
+size_t TimeStretcher::Accelerate(const int16_t* in, size_t frames, int16_t* out) {
+    const size_t period = FindPeriod(in, frames);
+    if (period == 0) {
+        std::copy(in, in + frames * channels_, out);
+        return frames;
+    }
+    CrossFade(in, in + period * channels_, period, out);
+    std::copy(in + 2 * period * channels_, in + frames * channels_, out + period * channels_);
+    return frames - period;
+}
+
+size_t TimeStretcher::Decelerate(const int16_t* in, size_t frames, int16_t* out) {
+    const size_t period = FindPeriod(in, frames);
+    if (period == 0) {
+        std::copy(in, in + frames * channels_, out);
+        return frames;
+    }
+    std::copy(in, in + period * channels_, out);
+    CrossFade(in + period * channels_, in, period, out + period * channels_);
+    std::copy(in + period * channels_, in + frames * channels_, out + 2 * period * channels_);
+    return frames + period;
+}
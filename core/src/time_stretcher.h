@@ -0,0 +1,47 @@
+#ifndef TIME_STRETCHER_H
+#define TIME_STRETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 基于波形相似叠加 (WSOLA) 的变速不变调 (交错int16输入输出)
+// 接收队列偏离目标深度较多时由接收流调用: 快放去掉一个基音周期，慢放重复一个基音周期。
+// 周期 T 取输入开头 [0,T) 与 [T,2T) 归一化互相关最大的值，只在相关足够高 (浊音) 或信号很弱
+// (静音、补的静音) 时调整，清音和噪声段原样输出；拼接处做 T 帧的线性交叉淡化，首尾与前后样点连续。
+// 先在约4kHz的降采样单声道信号上粗搜，再在原采样率上细化，每次调用的运算量只取决于最大周期
+class TimeStretcher {
+public:
+    TimeStretcher();
+
+    // 配置采样率与声道数，周期范围为 2.5~15ms
+    void Configure(int sample_rate, int channels);
+
+    // 查找最长周期需要的输入帧数 (两倍最大周期)，更多的输入不参与运算
+    size_t MaxInputFrames() const { return 2 * max_lag_; }
+    // 少于该帧数 (两倍最小周期) 时不做调整
+    size_t MinInputFrames() const { return 2 * min_lag_; }
+
+    // 快放: 把 [0,2T) 交叉淡化为 T 帧，out 至少 frames 帧，返回输出帧数 (frames - T)；
+    // 没有合适的周期时原样复制并返回 frames
+    size_t Accelerate(const int16_t* in, size_t frames, int16_t* out);
+
+    // 慢放: 在 T 处重复一个周期，out 至少 frames + MaxInputFrames() / 2 帧，返回输出帧数 (frames + T)；
+    // 没有合适的周期时原样复制并返回 frames
+    size_t Decelerate(const int16_t* in, size_t frames, int16_t* out);
+
+private:
+    // 返回周期 (帧)，没有合适的周期时返回0
+    size_t FindPeriod(const int16_t* in, size_t frames);
+    // out[i] = in_a[i] 淡出 + in_b[i] 淡入，i < length
+    void CrossFade(const int16_t* fade_out, const int16_t* fade_in, size_t length, int16_t* out) const;
+
+    int channels_;
+    size_t min_lag_;
+    size_t max_lag_;
+    size_t decimation_;             // 粗搜的降采样因子
+    std::vector<float> mono_;       // 单声道信号 (2 * max_lag_)
+    std::vector<float> decimated_;  // 降采样的单声道信号
+};
+
+#endif // TIME_STRETCHER_H
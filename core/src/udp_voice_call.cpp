@@ -6,54 +6,134 @@
 #include <mutex>
 #include <atomic>
 #include <vector>
-#include <queue>
+#include <map>
 #include <chrono>
 #include <cstring>
 #include <cmath>
+#include <cstdlib>
 
 // 网络相关头文件
-#include <sys/socket.h>
-#include <netinet/in.h>
 #include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <poll.h>
 #include <errno.h>
 
-// 音频相关头文件
-#include <alsa/asoundlib.h>
 #include <pthread.h>
 
-// 音频包结构
-struct AudioPacket {
-    uint32_t sequence;
-    uint32_t timestamp;
-    uint32_t user_id;
-    uint16_t data_size;
-    uint8_t data[1024];
-} __attribute__((packed));
+#include "audio_backend.h"
+#include "audio_device_keeper.h"
+#include "audio_fec.h"
+#include "audio_kernels.h"
+#include "audio_resampler.h"
+#include "automatic_gain_control.h"
+#include "call_environment.h"
+#include "call_stats.h"
+#include "comfort_noise.h"
+#include "echo_canceller.h"
+#include "event_reactor.h"
+#include "frame_trace.h"
+#include "noise_suppressor.h"
+#include "payload_crypto.h"
+#include "rate_controller.h"
+#include "remote_stream.h"
+#include "sample_format.h"
+#include "thread_scheduling.h"
+#include "voice_activity_detector.h"
+#include "voice_packet.h"
+
+// 远端流超过该时间 (秒) 没有收到数据时释放
+const double kRemoteStreamIdleSeconds = 10.0;
+// 回声参考缓冲区长度 (毫秒)，需覆盖播放与捕获设备缓冲的总延迟
+const int kEchoReferenceMs = 1000;
+// 对齐参考信号时预留的提前量 (毫秒)，保证声学路径落在自适应滤波器内
+const int kEchoDelayMarginMs = 4;
+// 静音期间舒适噪声描述符的发送间隔 (毫秒)，噪声电平变化超过 kComfortNoiseLevelChangeDb 时立即发送
+const int kComfortNoiseIntervalMs = 400;
+const float kComfortNoiseLevelChangeDb = 3.0f;
+// 接收报告的发送间隔 (毫秒)
+const int kReceiverReportIntervalMs = 1000;
+// 没有收到 JOIN_OK 时重发 JOIN 的间隔 (毫秒)，从 kJoinRetryInitialMs 起每次加倍，不超过 kJoinRetryMaxMs
+const int kJoinRetryInitialMs = 250;
+const int kJoinRetryMaxMs = 2000;
+// 异步连接等待 JOIN_OK 的默认超时 (毫秒)
+const int kDefaultJoinTimeoutMs = 10000;
+// 网络线程等待数据的最长时间 (毫秒)
+const int kNetworkWaitMs = 100;
+// 断开后保留音频设备的默认时长 (毫秒)
+const int kDefaultDeviceKeepaliveMs = 30000;
+// 发送历史保存的包数 (按序列号取模索引，分片各占一个)，20ms一包约1.3秒
+const size_t kSendHistorySize = 64;
+// 同一个包两次重传的最小间隔 (秒)，多个接收端同时请求时只重传一次
+const double kRetransmitHoldoffSeconds = 0.02;
+// 每个收到的包之后最多发送的NACK块数
+const size_t kMaxNackBlocks = 8;
+// 共享反应器模式: 每次可读事件最多处理的包数，每个节拍最多追赶的音频周期数
+const int kMaxPacketsPerWakeup = 16;
+const int kMaxAudioCyclesPerTick = 4;
+// 支持的包长 (audio_config.frame_size，毫秒)，其他值按默认的20ms处理
+const int kSupportedFrameSizes[] = {10, 20, 40, 60};
+const int kDefaultFrameSizeMs = 20;
+// 音频循环周期的上限 (毫秒): 包长更长时由多个周期累积成一个包，采集与播放的延迟不随包长增加
+const int kMaxAudioCycleMs = 20;
+// lock_memory 时音频与网络线程开始前预先触及的栈空间
+const size_t kPrefaultStackBytes = 256 * 1024;
 
 // UDP语音通话实现类
-class UDPVoiceCallImpl {
+// 默认每个通话有独立的音频线程与网络线程；use_shared_reactor 时不创建线程，
+// 由共享反应器在其线程中回调 OnReadable/OnTick。时钟、传输与音频后端取自运行环境 (call_environment.h)，
+// 环境提供调度器时由调度器回调
+class UDPVoiceCallImpl : public ReactorHandler {
 public:
-    UDPVoiceCallImpl(const voice_call_config_t* config, const voice_call_callbacks_t* callbacks)
+    UDPVoiceCallImpl(const voice_call_config_t* config, const voice_call_callbacks_t* callbacks,
+                     CallEnvironment* environment)
         : config_(*config)
         , callbacks_(*callbacks)
+        , environment_(environment)
         , state_(VOICE_CALL_STATE_IDLE)
         , muted_(false)
         , mic_volume_(1.0f)
         , speaker_volume_(1.0f)
-        , socket_fd_(-1)
-        , audio_capture_handle_(nullptr)
-        , audio_playback_handle_(nullptr)
+        , capture_device_rate_(0)
+        , playback_device_rate_(0)
+        , echo_delay_frames_(0)
+        , echo_delay_pending_(0)
+        , agc_enabled_(false)
+        , applied_mic_volume_(1.0f)
+        , capture_conversion_(nullptr)
+        , dtx_enabled_(false)
+        , dtx_active_(false)
+        , dtx_frames_since_descriptor_(0)
+        , dtx_sent_level_db_(0.0f)
+        , comfort_noise_packets_(0)
+        , packet_ms_(kDefaultFrameSizeMs)
+        , cycle_ms_(kDefaultFrameSizeMs)
         , running_(false)
-        , sequence_(0) {
+        , reactor_(nullptr)
+        , scheduler_(nullptr)
+        , audio_ready_(false)
+        , last_report_(0.0)
+        , connect_start_(0.0)
+        , first_join_(0.0)
+        , last_join_(0.0)
+        , next_join_(0.0)
+        , join_retry_ms_(kJoinRetryInitialMs)
+        , join_attempts_(0)
+        , setup_joined_(false)
+        , setup_reported_(false)
+        , sequence_(0)
+        , encoding_()
+        , packet_capture_frames_(0)
+        , packet_timestamp_(0)
+        , packet_traced_(false)
+        , trace_counter_(0)
+        , send_history_(kSendHistorySize)
+        , local_id_(kUnassignedSessionId)
+        , media_timestamp_(0) {
         
         std::cout << "UDP VoiceCall initialized for user: " << config->user_id << std::endl;
     }
     
     ~UDPVoiceCallImpl() {
         Disconnect();
+        device_keeper_.Release();
         std::cout << "UDP VoiceCall destroyed" << std::endl;
     }
     
@@ -84,55 +164,86 @@ public:
             port = std::stoi(server_url.substr(colon_pos + 1));
         }
         
-        // 创建UDP socket
-        socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
-        if (socket_fd_ < 0) {
-            std::cerr << "Failed to create UDP socket" << std::endl;
+        // 房间密钥: 每次连接换新的发送纪元
+        if (!payload_crypto_.SetKey(config_.media_key)) {
+            std::cerr << "Invalid media key: expected 32 or 64 hex characters" << std::endl;
             SetState(VOICE_CALL_STATE_ERROR);
-            return VOICE_CALL_ERROR_NETWORK;
+            return VOICE_CALL_ERROR_INVALID_PARAM;
+        }
+        if (payload_crypto_.IsEnabled()) {
+            std::cout << "音频负载加密: AES-" << strlen(config_.media_key) * 4 << "-GCM ("
+                      << (AesGcm::HardwareAvailable() ? "AES-NI/PCLMUL" : "查表实现") << ")" << std::endl;
         }
         
-        // 设置socket选项
-        int opt = 1;
-        setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-        
-        // 绑定本地端口
-        struct sockaddr_in local_addr;
-        memset(&local_addr, 0, sizeof(local_addr));
-        local_addr.sin_family = AF_INET;
-        local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        local_addr.sin_port = htons(0); // 随机端口
+        // 新的通话重新开始媒体时间线、接收流和统计，会话ID等待服务器在 JOIN_OK 中分配
+        local_id_ = kUnassignedSessionId;
+        media_timestamp_ = 0;
+        {
+            std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+            remote_streams_.clear();
+            retired_stream_totals_ = StreamTotals();
+        }
+        stats_.Reset();
+        {
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            setup_stats_ = voice_call_setup_stats_t();
+            setup_stats_.overlapped = config_.async_connect;
+            setup_joined_ = false;
+            setup_reported_ = false;
+        }
+        audio_ready_ = false;
+        join_retry_ms_ = kJoinRetryInitialMs;
+        join_attempts_ = 0;
+        connect_start_ = environment_->Now();
         
-        if (bind(socket_fd_, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
-            std::cerr << "Failed to bind socket" << std::endl;
-            close(socket_fd_);
-            socket_fd_ = -1;
+        // 创建到服务器的传输 (默认为连接到服务器的UDP socket)
+        transport_ = environment_->CreateTransport();
+        if (!transport_ || !transport_->Connect(host, port)) {
+            transport_.reset();
             SetState(VOICE_CALL_STATE_ERROR);
             return VOICE_CALL_ERROR_NETWORK;
         }
+        server_name_ = host + ":" + std::to_string(port);
+        
+        // 先锁定内存，之后分配的处理链与接收队列缓冲区直接驻留
+        if (config_.lock_memory) {
+            LockProcessMemory();
+        }
         
-        // 设置服务器地址
-        memset(&server_addr_, 0, sizeof(server_addr_));
-        server_addr_.sin_family = AF_INET;
-        server_addr_.sin_port = htons(port);
-        server_addr_.sin_addr.s_addr = inet_addr(host.c_str());
+        if (config_.async_connect) {
+            return ConnectAsync();
+        }
         
         // 初始化音频设备
-        if (!InitializeAudio()) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+        if (!SetupAudio()) {
+            transport_.reset();
             SetState(VOICE_CALL_STATE_ERROR);
             return VOICE_CALL_ERROR_AUDIO;
         }
         
-        // 启动音频处理线程
-        running_ = true;
-        audio_thread_ = std::thread(&UDPVoiceCallImpl::AudioLoop, this);
-        network_thread_ = std::thread(&UDPVoiceCallImpl::NetworkLoop, this);
-        
-        // 发送加入房间消息
+        // 发送加入房间消息 (JOIN_OK 在网络处理开始后读取)
         SendJoinMessage();
         
+        // 启动音频处理线程，共享反应器模式下注册到反应器，环境提供调度器时注册到调度器
+        last_report_ = environment_->Now();
+        running_ = true;
+        CallScheduler* scheduler = environment_->GetScheduler();
+        if (scheduler) {
+            scheduler_ = scheduler->Add(transport_.get(), this) ? scheduler : nullptr;
+        } else if (config_.use_shared_reactor) {
+            reactor_ = ReactorPool::Instance().Add(transport_->GetFd(), this);
+        } else {
+            audio_thread_ = std::thread(&UDPVoiceCallImpl::AudioLoop, this);
+            network_thread_ = std::thread(&UDPVoiceCallImpl::NetworkLoop, this);
+        }
+        if ((scheduler || config_.use_shared_reactor) && !reactor_ && !scheduler_) {
+            running_ = false;
+            CloseAudio();
+            transport_.reset();
+            SetState(VOICE_CALL_STATE_ERROR);
+            return VOICE_CALL_ERROR_INIT_FAILED;
+        }
+        
         SetState(VOICE_CALL_STATE_CONNECTED);
         return VOICE_CALL_SUCCESS;
     }
@@ -142,26 +253,38 @@ public:
             return VOICE_CALL_SUCCESS;
         }
         
-        // 停止线程
+        // 停止线程 (Remove 返回后反应器不会再回调本通话)
         running_ = false;
+        if (reactor_) {
+            reactor_->Remove(transport_->GetFd());
+            reactor_ = nullptr;
+        }
+        if (scheduler_) {
+            scheduler_->Remove(transport_.get());
+            scheduler_ = nullptr;
+        }
         
+        if (setup_thread_.joinable()) {
+            setup_thread_.join();
+        }
         if (audio_thread_.joinable()) {
             audio_thread_.join();
         }
         if (network_thread_.joinable()) {
             network_thread_.join();
         }
+        audio_ready_ = false;
         
         // 发送离开消息
         SendLeaveMessage();
         
-        // 关闭音频设备
-        CloseAudio();
+        // 暂停并保留音频设备，之后的连接直接复用
+        ParkAudio();
         
-        // 关闭socket
-        if (socket_fd_ >= 0) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+        // 关闭传输
+        if (transport_) {
+            transport_->Close();
+            transport_.reset();
         }
         
         SetState(VOICE_CALL_STATE_DISCONNECTED);
@@ -172,6 +295,21 @@ public:
         return state_;
     }
     
+    // 切换房间: 通话进行中时断开后加入新房间，音频设备由 device_keeper_ 保留，重新连接时直接复用
+    voice_call_error_t SwitchRoom(const char* room_id) {
+        if (strlen(room_id) == 0 || strlen(room_id) >= sizeof(config_.room_id)) {
+            return VOICE_CALL_ERROR_INVALID_PARAM;
+        }
+        if (state_ == VOICE_CALL_STATE_IDLE || state_ == VOICE_CALL_STATE_DISCONNECTED) {
+            strcpy(config_.room_id, room_id);
+            return VOICE_CALL_SUCCESS;
+        }
+        std::cout << "切换房间: " << config_.room_id << " -> " << room_id << std::endl;
+        Disconnect();
+        strcpy(config_.room_id, room_id);
+        return Connect();
+    }
+    
     voice_call_error_t SetMuted(bool muted) {
         muted_ = muted;
         std::cout << "Microphone " << (muted ? "muted" : "unmuted") << std::endl;
@@ -199,350 +337,864 @@ public:
         std::cout << "Speaker volume set to: " << volume << std::endl;
         return VOICE_CALL_SUCCESS;
     }
+    
+    voice_call_error_t GetStats(voice_call_stats_t* stats) const {
+        stats_.Fill(stats);
+        return VOICE_CALL_SUCCESS;
+    }
 
 private:
+    // 异步连接: 先发出 JOIN 并开始网络处理，音频设备在音频线程 (共享反应器模式下为单独的线程) 中打开，
+    // 两者都完成后才报告 CONNECTED。设备就绪前收到的音频包丢弃
+    voice_call_error_t ConnectAsync() {
+        SendJoinMessage();
+        last_report_ = environment_->Now();
+        running_ = true;
+        CallScheduler* scheduler = environment_->GetScheduler();
+        if (scheduler) {
+            scheduler_ = scheduler->Add(transport_.get(), this) ? scheduler : nullptr;
+        } else if (config_.use_shared_reactor) {
+            reactor_ = ReactorPool::Instance().Add(transport_->GetFd(), this);
+        } else {
+            network_thread_ = std::thread(&UDPVoiceCallImpl::NetworkLoop, this);
+            audio_thread_ = std::thread(&UDPVoiceCallImpl::AudioLoop, this);
+            return VOICE_CALL_SUCCESS;
+        }
+        if (!reactor_ && !scheduler_) {
+            running_ = false;
+            transport_.reset();
+            SetState(VOICE_CALL_STATE_ERROR);
+            return VOICE_CALL_ERROR_INIT_FAILED;
+        }
+        if (scheduler_) {
+            // 虚拟时间中打开设备不占用时间，直接在调用线程中进行
+            SetupAudioAsync();
+        } else {
+            setup_thread_ = std::thread(&UDPVoiceCallImpl::SetupAudioAsync, this);
+        }
+        return VOICE_CALL_SUCCESS;
+    }
+    
+    // 打开音频设备并准备音频循环，完成后音频周期与接收处理开始运行
+    bool SetupAudio() {
+        double start = environment_->Now();
+        if (!InitializeAudio()) {
+            return false;
+        }
+        stats_.Audio().BeginWrite();
+        stats_.Audio().Set(kStatSendBitrate, static_cast<uint64_t>(encoding_.bitrate));
+        stats_.Audio().Set(kStatTargetBitrate, static_cast<uint64_t>(encoding_.bitrate));
+        stats_.Audio().EndWrite();
+        PrepareAudioLoop();
+        // 反应器与调度器按可读的帧数调度音频周期，先开始采集
+        if (config_.use_shared_reactor || environment_->GetScheduler()) {
+            audio_backend_->Start();
+        }
+        {
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            setup_stats_.audio_open_ms = static_cast<float>((environment_->Now() - start) * 1000.0);
+        }
+        audio_ready_.store(true, std::memory_order_release);
+        MaybeCompleteSetup();
+        return true;
+    }
+    
+    void SetupAudioAsync() {
+        if (!SetupAudio()) {
+            FailConnect(VOICE_CALL_ERROR_AUDIO, "Failed to open audio devices");
+        }
+    }
+    
+    // 异步连接失败: 停止音频与网络处理，等待应用调用 voice_call_disconnect 释放资源。
+    // 失败发生在网络、音频、设备打开或反应器线程中，而 Disconnect 会等待这些线程结束，所以 ERROR 状态与
+    // on_error 在单独的通知线程上回调，应用可以在回调中断开或销毁通话。通知线程只使用回调与消息的副本，
+    // 不被 Disconnect 或销毁等待。调度器驱动 (虚拟时间) 时失败发生在驱动调度器的应用线程上，直接回调
+    void FailConnect(voice_call_error_t error, const char* message) {
+        std::cerr << "连接失败: " << message << std::endl;
+        running_ = false;
+        if (environment_->GetScheduler()) {
+            SetState(VOICE_CALL_STATE_ERROR);
+            if (callbacks_.on_error) {
+                callbacks_.on_error(error, message);
+            }
+            return;
+        }
+        if (state_.exchange(VOICE_CALL_STATE_ERROR) == VOICE_CALL_STATE_ERROR) {
+            return;
+        }
+        voice_call_callbacks_t callbacks = callbacks_;
+        std::string text = message;
+        std::thread([callbacks, error, text]() {
+            if (callbacks.on_state_changed) {
+                callbacks.on_state_changed(VOICE_CALL_STATE_ERROR, "Connection error");
+            }
+            if (callbacks.on_error) {
+                callbacks.on_error(error, text.c_str());
+            }
+        }).detach();
+    }
+    
+    // 收到 JOIN_OK 且设备就绪时报告一次建立耗时，异步连接此时进入 CONNECTED
+    void MaybeCompleteSetup() {
+        voice_call_setup_stats_t setup;
+        {
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            if (setup_reported_ || !setup_joined_ || !audio_ready_ || !running_) {
+                return;
+            }
+            setup_reported_ = true;
+            setup_stats_.total_ms = static_cast<float>((environment_->Now() - connect_start_) * 1000.0);
+            setup = setup_stats_;
+        }
+        std::cout << "通话建立耗时: " << setup.total_ms << "ms (设备 " << setup.audio_open_ms << "ms, JOIN "
+                  << setup.join_ms << "ms / " << setup.join_attempts << " 次, "
+                  << (setup.overlapped ? "并行" : "串行") << ")" << std::endl;
+        if (config_.async_connect) {
+            SetState(VOICE_CALL_STATE_CONNECTED);
+        }
+        if (callbacks_.on_setup_complete) {
+            callbacks_.on_setup_complete(&setup);
+        }
+    }
+    
+    // 本次连接第一次收到 JOIN_OK (网络线程/反应器线程)
+    void OnJoined() {
+        double now = environment_->Now();
+        {
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            setup_stats_.join_ms = static_cast<float>((now - first_join_) * 1000.0);
+            setup_stats_.join_rtt_ms = static_cast<float>((now - last_join_) * 1000.0);
+            setup_stats_.join_attempts = join_attempts_;
+            setup_joined_ = true;
+        }
+        MaybeCompleteSetup();
+    }
+    
     bool InitializeAudio() {
-        int err;
-        
         std::cout << "Initializing audio devices..." << std::endl;
         
-        // 打开音频捕获设备
-        err = snd_pcm_open(&audio_capture_handle_, "default", SND_PCM_STREAM_CAPTURE, 0);
-        if (err < 0) {
-            std::cerr << "Failed to open audio capture device: " << snd_strerror(err) << std::endl;
-            std::cerr << "Trying to use 'hw:0,0'..." << std::endl;
-            
-            // 尝试使用硬件设备
-            err = snd_pcm_open(&audio_capture_handle_, "hw:0,0", SND_PCM_STREAM_CAPTURE, 0);
-            if (err < 0) {
-                std::cerr << "Failed to open hardware audio capture device: " << snd_strerror(err) << std::endl;
+        // 音频后端: 配置优先，其次是环境变量，默认使用 ALSA
+        std::string backend_spec = config_.audio_backend;
+        if (backend_spec.empty()) {
+            const char* env = std::getenv("VOICE_CALL_AUDIO_BACKEND");
+            backend_spec = env ? env : "alsa";
+        }
+        // 上次通话保留的设备打开参数相同时直接复用
+        const SampleFormat sample_format = SampleFormatFromConfig(config_.audio_config);
+        audio_device_key_ = backend_spec + "|" + std::to_string(config_.audio_config.sample_rate) + "|" +
+                            std::to_string(config_.audio_config.channels) + "|" + SampleFormatName(sample_format);
+        audio_backend_ = device_keeper_.Take(audio_device_key_);
+        if (audio_backend_) {
+            std::cout << "复用保留的音频设备 (backend " << audio_backend_->GetName() << ")" << std::endl;
+        } else {
+            audio_backend_ = environment_->CreateAudioBackend(backend_spec);
+            if (audio_backend_) {
+                audio_backend_->SetSampleFormat(sample_format);
+            }
+            if (!audio_backend_ ||
+                !audio_backend_->Open(config_.audio_config.sample_rate, config_.audio_config.channels)) {
+                std::cerr << "Failed to open audio backend: " << backend_spec << std::endl;
+                audio_backend_.reset();
                 return false;
             }
         }
+        capture_device_rate_ = audio_backend_->GetCaptureRate();
+        playback_device_rate_ = audio_backend_->GetPlaybackRate();
+        // 处理链的 S16 <-> 平面float 转换按声道数选定一次
+        capture_conversion_ = &GetSampleConversion(kSampleS16, config_.audio_config.channels);
         
-        // 打开音频播放设备
-        err = snd_pcm_open(&audio_playback_handle_, "default", SND_PCM_STREAM_PLAYBACK, 0);
-        if (err < 0) {
-            std::cerr << "Failed to open audio playback device: " << snd_strerror(err) << std::endl;
-            std::cerr << "Trying to use 'hw:0,0'..." << std::endl;
-            
-            // 尝试使用硬件设备
-            err = snd_pcm_open(&audio_playback_handle_, "hw:0,0", SND_PCM_STREAM_PLAYBACK, 0);
-            if (err < 0) {
-                std::cerr << "Failed to open hardware audio playback device: " << snd_strerror(err) << std::endl;
-                snd_pcm_close(audio_capture_handle_);
-                audio_capture_handle_ = nullptr;
-                return false;
+        // 包长与音频循环周期: 10ms包每个周期发送一个，更长的包由多个20ms周期累积
+        packet_ms_ = kDefaultFrameSizeMs;
+        for (int frame_size : kSupportedFrameSizes) {
+            if (config_.audio_config.frame_size == frame_size) {
+                packet_ms_ = frame_size;
             }
         }
-        
-        // 设置音频参数
-        snd_pcm_hw_params_t* hw_params;
-        snd_pcm_hw_params_alloca(&hw_params);
-        
-        // 配置捕获设备
-        snd_pcm_hw_params_any(audio_capture_handle_, hw_params);
-        snd_pcm_hw_params_set_access(audio_capture_handle_, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-        snd_pcm_hw_params_set_format(audio_capture_handle_, hw_params, SND_PCM_FORMAT_S16_LE);
-        snd_pcm_hw_params_set_rate(audio_capture_handle_, hw_params, config_.audio_config.sample_rate, 0);
-        snd_pcm_hw_params_set_channels(audio_capture_handle_, hw_params, config_.audio_config.channels);
-        
-        // 计算合适的缓冲区大小 (20ms)
-        snd_pcm_uframes_t buffer_size = config_.audio_config.sample_rate * config_.audio_config.channels * 2 / 50;
-        snd_pcm_uframes_t period_size = buffer_size / 4;
-        
-        // 增加缓冲区大小以减少underrun
-        buffer_size *= 4; // 增加到80ms缓冲区
-        
-        // 设置缓冲区大小
-        err = snd_pcm_hw_params_set_buffer_size(audio_capture_handle_, hw_params, buffer_size);
-        if (err < 0) {
-            std::cerr << "Failed to set capture buffer size: " << snd_strerror(err) << std::endl;
-            // 尝试使用默认值
-            snd_pcm_hw_params_set_buffer_size_near(audio_capture_handle_, hw_params, &buffer_size);
+        if (packet_ms_ != config_.audio_config.frame_size) {
+            std::cerr << "Unsupported frame size " << config_.audio_config.frame_size << " ms, using "
+                      << packet_ms_ << " ms" << std::endl;
         }
+        cycle_ms_ = std::min(packet_ms_, kMaxAudioCycleMs);
         
-        // 设置周期大小
-        err = snd_pcm_hw_params_set_period_size(audio_capture_handle_, hw_params, period_size, 0);
-        if (err < 0) {
-            std::cerr << "Failed to set capture period size: " << snd_strerror(err) << std::endl;
-            // 尝试使用默认值
-            snd_pcm_hw_params_set_period_size_near(audio_capture_handle_, hw_params, &period_size, 0);
-        }
+        // 设备采样率与网络采样率不一致时在两者之间插入重采样
+        const int network_rate = config_.audio_config.sample_rate;
+        const int channels = config_.audio_config.channels;
+        const size_t cycle_frames = static_cast<size_t>(network_rate) * cycle_ms_ / 1000;
+        capture_resampler_.Configure(capture_device_rate_, network_rate, channels,
+                                     static_cast<size_t>(capture_device_rate_) * cycle_ms_ / 1000);
+        playback_resampler_.Configure(network_rate, playback_device_rate_, channels, cycle_frames);
         
-        err = snd_pcm_hw_params(audio_capture_handle_, hw_params);
-        if (err < 0) {
-            std::cerr << "Failed to set capture parameters: " << snd_strerror(err) << std::endl;
-            return false;
+        // 回声消除工作在网络采样率上，参考信号取自混音器输出
+        echo_cancellers_.clear();
+        echo_delay_frames_ = 0;
+        echo_delay_pending_ = 0;
+        if (config_.enable_echo_cancellation) {
+            echo_cancellers_.resize(channels);
+            for (auto& canceller : echo_cancellers_) {
+                if (!canceller.Configure(network_rate, cycle_frames)) {
+                    echo_cancellers_.clear();
+                    break;
+                }
+            }
+            if (echo_cancellers_.empty()) {
+                std::cerr << "Echo cancellation not supported at " << network_rate << " Hz, disabled" << std::endl;
+            } else {
+                echo_reference_.Configure(network_rate * kEchoReferenceMs / 1000);
+                std::cout << "Echo cancellation enabled: block=" << echo_cancellers_[0].GetBlockSize()
+                          << " frames, partitions=" << echo_cancellers_[0].GetPartitions() << std::endl;
+            }
         }
         
-        // 配置播放设备
-        snd_pcm_hw_params_any(audio_playback_handle_, hw_params);
-        snd_pcm_hw_params_set_access(audio_playback_handle_, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-        snd_pcm_hw_params_set_format(audio_playback_handle_, hw_params, SND_PCM_FORMAT_S16_LE);
-        snd_pcm_hw_params_set_rate(audio_playback_handle_, hw_params, config_.audio_config.sample_rate, 0);
-        snd_pcm_hw_params_set_channels(audio_playback_handle_, hw_params, config_.audio_config.channels);
-        
-        // 设置缓冲区大小
-        err = snd_pcm_hw_params_set_buffer_size(audio_playback_handle_, hw_params, buffer_size);
-        if (err < 0) {
-            std::cerr << "Failed to set playback buffer size: " << snd_strerror(err) << std::endl;
-            snd_pcm_hw_params_set_buffer_size_near(audio_playback_handle_, hw_params, &buffer_size);
+        // 噪声抑制位于回声消除之后，同样按声道独立处理
+        noise_suppressors_.clear();
+        if (config_.enable_noise_suppression) {
+            noise_suppressors_.resize(channels);
+            for (auto& suppressor : noise_suppressors_) {
+                if (!suppressor.Configure(network_rate, cycle_frames)) {
+                    noise_suppressors_.clear();
+                    break;
+                }
+            }
+            if (noise_suppressors_.empty()) {
+                std::cerr << "Noise suppression not supported at " << network_rate << " Hz, disabled" << std::endl;
+            } else {
+                std::cout << "Noise suppression enabled: hop=" << noise_suppressors_[0].GetHopSize() << " frames" << std::endl;
+            }
         }
         
-        // 设置周期大小
-        err = snd_pcm_hw_params_set_period_size(audio_playback_handle_, hw_params, period_size, 0);
-        if (err < 0) {
-            std::cerr << "Failed to set playback period size: " << snd_strerror(err) << std::endl;
-            snd_pcm_hw_params_set_period_size_near(audio_playback_handle_, hw_params, &period_size, 0);
+        // 语音检测供自动增益判断何时跟踪电平
+        vad_.Configure(network_rate, cycle_frames);
+        agc_enabled_ = config_.enable_automatic_gain_control;
+        agc_.Configure(network_rate, cycle_frames);
+        applied_mic_volume_ = mic_volume_;
+        if (agc_enabled_) {
+            std::cout << "Automatic gain control enabled" << std::endl;
         }
-        
-        err = snd_pcm_hw_params(audio_playback_handle_, hw_params);
-        if (err < 0) {
-            std::cerr << "Failed to set playback parameters: " << snd_strerror(err) << std::endl;
-            return false;
+        dtx_enabled_ = config_.enable_dtx;
+        dtx_active_ = false;
+        if (dtx_enabled_) {
+            std::cout << "DTX enabled: comfort noise descriptor every " << kComfortNoiseIntervalMs << " ms" << std::endl;
         }
-        
-        // 准备音频设备
-        err = snd_pcm_prepare(audio_capture_handle_);
-        if (err < 0) {
-            std::cerr << "Failed to prepare capture device: " << snd_strerror(err) << std::endl;
+        // 冗余深度与码率由接收报告驱动，初始不附加冗余，按最高码率发送
+        fec_encoder_.Configure(channels);
+        {
+            std::lock_guard<std::mutex> lock(feedback_mutex_);
+            fec_controller_.Reset();
+            rate_controller_.Configure(MinEncodingBitrate(network_rate, channels, packet_ms_),
+                                       MaxEncodingBitrate(network_rate, channels, packet_ms_));
         }
+        encoding_ = SelectEncoding(MaxEncodingBitrate(network_rate, channels, packet_ms_), network_rate, channels,
+                                   packet_ms_, 0);
+        packet_capture_frames_ = 0;
+        // 超过一个包的帧先编码到这里再分片，按最长的包 (最低一档不短于40ms) 的PCM分配
+        frame_payload_.resize(EncodingPayloadSize(kPayloadTypePcm16,
+                                                  static_cast<size_t>(network_rate) * std::max(packet_ms_, 40) / 1000,
+                                                  0, channels));
         
-        err = snd_pcm_prepare(audio_playback_handle_);
-        if (err < 0) {
-            std::cerr << "Failed to prepare playback device: " << snd_strerror(err) << std::endl;
+        std::cout << "Audio devices initialized successfully (backend " << audio_backend_->GetName() << ")" << std::endl;
+        std::cout << "Sample rate: " << network_rate << " Hz (capture device " << capture_device_rate_
+                  << " Hz, playback device " << playback_device_rate_ << " Hz)" << std::endl;
+        if (!capture_resampler_.IsPassthrough() || !playback_resampler_.IsPassthrough()) {
+            std::cout << "Resampling enabled between device and network sample rates" << std::endl;
         }
-        
-        std::cout << "Audio devices initialized successfully" << std::endl;
-        std::cout << "Sample rate: " << config_.audio_config.sample_rate << " Hz" << std::endl;
-        std::cout << "Channels: " << config_.audio_config.channels << std::endl;
-        std::cout << "Buffer size: " << buffer_size << " frames" << std::endl;
-        std::cout << "Period size: " << period_size << " frames" << std::endl;
+        std::cout << "Channels: " << config_.audio_config.channels << ", frame size: " << packet_ms_
+                  << " ms (audio cycle " << cycle_ms_ << " ms)" << std::endl;
         return true;
     }
     
     void CloseAudio() {
-        if (audio_capture_handle_) {
-            snd_pcm_close(audio_capture_handle_);
-            audio_capture_handle_ = nullptr;
+        if (audio_backend_) {
+            audio_backend_->Close();
+            audio_backend_.reset();
         }
-        if (audio_playback_handle_) {
-            snd_pcm_close(audio_playback_handle_);
-            audio_playback_handle_ = nullptr;
+    }
+    
+    // 断开时把设备交给 device_keeper_ 保留 device_keepalive_ms，后端不支持暂停或配置为负数时关闭
+    void ParkAudio() {
+        if (audio_backend_) {
+            int keepalive_ms = config_.device_keepalive_ms != 0 ? config_.device_keepalive_ms
+                                                                : kDefaultDeviceKeepaliveMs;
+            device_keeper_.Keep(std::move(audio_backend_), audio_device_key_, keepalive_ms);
         }
     }
     
     void SendJoinMessage() {
         std::string message = "JOIN:" + std::string(config_.room_id) + ":" + std::string(config_.user_id);
         std::cout << "发送JOIN消息: " << message << std::endl;
-        int sent = sendto(socket_fd_, message.c_str(), message.length(), 0, 
-               (struct sockaddr*)&server_addr_, sizeof(server_addr_));
+        long sent = transport_->Send(message.c_str(), message.length(), nullptr, 0);
         if (sent < 0) {
             std::cerr << "发送JOIN消息失败: " << strerror(errno) << std::endl;
         } else {
             std::cout << "JOIN消息发送成功 (" << sent << " bytes)" << std::endl;
         }
+        double now = environment_->Now();
+        if (join_attempts_++ == 0) {
+            first_join_ = now;
+        }
+        last_join_ = now;
+        next_join_ = now + join_retry_ms_ / 1000.0;
+        join_retry_ms_ = std::min(join_retry_ms_ * 2, kJoinRetryMaxMs);
+    }
+    
+    // JOIN 或 JOIN_OK 丢失时按退避间隔重发，服务器对同一地址的重复 JOIN 只重发 JOIN_OK；
+    // 异步连接超过 join_timeout_ms 仍未收到时报错
+    void MaybeResendJoin() {
+        if (local_id_ != kUnassignedSessionId || !running_) {
+            return;
+        }
+        double now = environment_->Now();
+        int timeout_ms = config_.join_timeout_ms > 0 ? config_.join_timeout_ms : kDefaultJoinTimeoutMs;
+        if (config_.async_connect && now - connect_start_ >= timeout_ms / 1000.0) {
+            FailConnect(VOICE_CALL_ERROR_NETWORK, "No response from server (JOIN timed out)");
+            return;
+        }
+        if (now >= next_join_) {
+            SendJoinMessage();
+        }
     }
     
     void SendLeaveMessage() {
+        if (!transport_) return;
         std::string message = "LEAVE:" + std::string(config_.room_id) + ":" + std::string(config_.user_id);
-        sendto(socket_fd_, message.c_str(), message.length(), 0, 
-               (struct sockaddr*)&server_addr_, sizeof(server_addr_));
+        transport_->Send(message.c_str(), message.length(), nullptr, 0);
+    }
+    
+    // 分配音频循环的缓冲区 (设备侧按设备采样率读写，网络侧按配置采样率收发)
+    void PrepareAudioLoop() {
+        const int channels = config_.audio_config.channels;
+        AudioLoopState& loop = audio_loop_;
+        loop.capture_frames = static_cast<size_t>(capture_device_rate_) * cycle_ms_ / 1000;
+        loop.capture_buffer.assign(loop.capture_frames * channels, 0);
+        loop.audio_buffer.assign(capture_resampler_.MaxOutputFrames(loop.capture_frames) * channels, 0);
+        // 播放侧: 每次从远端流拉取一个周期的网络帧，混音后转换到设备采样率
+        loop.network_frames = static_cast<size_t>(config_.audio_config.sample_rate) * cycle_ms_ / 1000;
+        loop.stream_buffer.assign(loop.network_frames * channels, 0);
+        loop.mix_buffer.assign(loop.network_frames * channels, 0);
+        loop.network_buffer.assign(loop.network_frames * channels, 0);
+        loop.playback_buffer.assign(playback_resampler_.MaxOutputFrames(loop.network_frames) * channels, 0);
+        // 静音与采集同为一个周期，否则播放缓冲区写满后阻塞音频线程，采集跟不上而溢出
+        loop.silence_buffer.assign(static_cast<size_t>(playback_device_rate_) * cycle_ms_ / 1000 * channels, 0);
+        loop.silence_frames = loop.silence_buffer.size() / channels;
+        loop.playback_primed = false;
+        loop.last_tick = environment_->Now();
     }
     
     void AudioLoop() {
-        const int frame_size = config_.audio_config.sample_rate * config_.audio_config.channels * 2 / 50; // 20ms
-        std::vector<int16_t> audio_buffer(frame_size);
-        std::vector<int16_t> silence_buffer(frame_size, 0);
-        
-        std::cout << "Audio loop started, frame size: " << frame_size << " bytes" << std::endl;
+        ApplyThreadScheduling("vc-audio", config_.sched_policy, config_.sched_priority, config_.audio_cpu_mask);
+        if (config_.lock_memory) {
+            PrefaultStack(kPrefaultStackBytes);
+        }
+        // 异步连接时由音频线程打开设备，与网络线程的 JOIN 握手并行
+        if (!audio_ready_) {
+            if (!SetupAudio()) {
+                FailConnect(VOICE_CALL_ERROR_AUDIO, "Failed to open audio devices");
+                return;
+            }
+        }
+        const size_t frame_size = audio_loop_.network_frames * config_.audio_config.channels * 2;
+        std::cout << "Audio loop started, frame size: " << frame_size << " bytes (" << cycle_ms_ << " ms)" << std::endl;
         
         while (running_) {
-            // 捕获音频
-            if (!muted_ && audio_capture_handle_) {
-                snd_pcm_sframes_t frames = snd_pcm_readi(audio_capture_handle_, audio_buffer.data(), frame_size / 2);
-                if (frames > 0) {
-                    // 应用音量
-                    for (int i = 0; i < frames * config_.audio_config.channels; ++i) {
-                        audio_buffer[i] = static_cast<int16_t>(audio_buffer[i] * mic_volume_);
-                    }
-                    
-                    // 记录音频采集日志
-                    static auto last_capture_log = std::chrono::steady_clock::now();
-                    auto now = std::chrono::steady_clock::now();
-                    if (now - last_capture_log > std::chrono::seconds(5)) {
-                        std::cout << "[AUDIO_CAPTURE] frames=" << frames << ", data_size=" << (frames * config_.audio_config.channels * 2) 
-                                  << " bytes, first_sample=" << audio_buffer[0] << ", last_sample=" << audio_buffer[frames * config_.audio_config.channels - 1] 
-                                  << ", mic_volume=" << mic_volume_ << std::endl;
-                        last_capture_log = now;
+            RunAudioCycle(false);
+            // 半个周期 (20ms周期时为100Hz)，Read 按设备时钟阻塞，轮询间隔不能超过周期
+            std::this_thread::sleep_for(std::chrono::milliseconds(cycle_ms_ / 2));
+        }
+        
+        std::cout << "Audio loop stopped" << std::endl;
+    }
+    
+    // 共享反应器模式下，采集 (静音时为播放) 有一个周期的数据时 RunAudioCycle 不会阻塞
+    bool AudioCycleReady() {
+        if (!audio_backend_) return false;
+        if (muted_) {
+            return audio_backend_->GetPlaybackDelay() <= static_cast<long>(audio_loop_.silence_frames);
+        }
+        return audio_backend_->GetCaptureDelay() >= static_cast<long>(audio_loop_.capture_frames);
+    }
+    
+    // 音频循环的一个周期 (包长不超过20ms时为包长，否则为20ms): 采集、处理并发送一个周期，
+    // 拉取远端流混音后播放一个周期。
+    // nonblocking 为 true 时 (共享反应器) 调用方已确认采集数据足够，播放缓冲区将满时跳过播放
+    void RunAudioCycle(bool nonblocking) {
+        const int channels = config_.audio_config.channels;
+        const size_t capture_frames = audio_loop_.capture_frames;
+        const size_t network_frames = audio_loop_.network_frames;
+        const size_t silence_frames = audio_loop_.silence_frames;
+        std::vector<int16_t>& capture_buffer = audio_loop_.capture_buffer;
+        std::vector<int16_t>& audio_buffer = audio_loop_.audio_buffer;
+        std::vector<int16_t>& stream_buffer = audio_loop_.stream_buffer;
+        std::vector<int32_t>& mix_buffer = audio_loop_.mix_buffer;
+        std::vector<int16_t>& network_buffer = audio_loop_.network_buffer;
+        std::vector<int16_t>& playback_buffer = audio_loop_.playback_buffer;
+        std::vector<int16_t>& silence_buffer = audio_loop_.silence_buffer;
+        bool& playback_primed = audio_loop_.playback_primed;
+        
+        // 静音期间不发送数据，但媒体时间戳按实际时间继续前进，与RTP语义一致
+        double tick = environment_->Now();
+        if (muted_) {
+            media_timestamp_ += static_cast<uint32_t>((tick - audio_loop_.last_tick) * config_.audio_config.sample_rate);
+            // 丢弃未凑满的包
+            packet_capture_frames_ = 0;
+        }
+        audio_loop_.last_tick = tick;
+        
+        // 捕获音频
+        if (!muted_ && audio_backend_) {
+            // 后端支持时重采样直接读取设备缓冲区，否则先读到 capture_buffer
+            const int16_t* device_capture = audio_backend_->BeginCapture(capture_frames);
+            long frames = device_capture ? static_cast<long>(capture_frames)
+                                         : audio_backend_->Read(capture_buffer.data(), capture_frames);
+            uint64_t process_start = CallStats::NowNanoseconds();
+            if (frames > 0) {
+                // 转换到网络采样率
+                frames = capture_resampler_.Process(device_capture ? device_capture : capture_buffer.data(), frames,
+                                                    audio_buffer.data(), audio_buffer.size() / channels);
+            }
+            if (device_capture) {
+                long committed = audio_backend_->CommitCapture(capture_frames);
+                if (committed < 0) {
+                    // 读取期间发生溢出，数据可能已被覆盖
+                    frames = committed;
+                }
+            }
+            if (frames > 0) {
+                // 回声消除、噪声抑制、自动增益与麦克风音量
+                ProcessCapture(audio_buffer.data(), frames);
+                uint64_t encode_start = CallStats::NowNanoseconds();
+                stats_.Audio().BeginWrite();
+                stats_.Audio().AddDuration(kStatCaptureProcessNs, encode_start - process_start);
+                stats_.Audio().EndWrite();
+                
+                // 记录音频采集日志
+                static auto last_capture_log = std::chrono::steady_clock::now();
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_capture_log > std::chrono::seconds(5)) {
+                    std::cout << "[AUDIO_CAPTURE] frames=" << frames << ", data_size=" << (frames * config_.audio_config.channels * 2) 
+                              << " bytes, first_sample=" << audio_buffer[0] << ", last_sample=" << audio_buffer[frames * config_.audio_config.channels - 1] 
+                              << ", mic_volume=" << mic_volume_;
+                    if (!echo_cancellers_.empty()) {
+                        std::cout << ", aec_erle=" << echo_cancellers_[0].GetErleDb() << "dB, aec_delay="
+                                  << echo_delay_frames_ << " frames";
                     }
-                    
-                    // 发送音频包
-                    size_t data_size = frames * config_.audio_config.channels * 2;
-                    SendAudioPacket(audio_buffer.data(), data_size);
-                    
-                    // 记录发送日志
-                    static auto last_send_log = std::chrono::steady_clock::now();
-                    auto now_send = std::chrono::steady_clock::now();
-                    if (now_send - last_send_log > std::chrono::seconds(5)) {
-                        std::cout << "[AUDIO_SEND] data_size=" << data_size << " bytes, packet_size=" << (14 + data_size) 
-                                  << " bytes, sequence=" << sequence_ << std::endl;
-                        last_send_log = now_send;
+                    if (!noise_suppressors_.empty()) {
+                        std::cout << ", ns_gain=" << noise_suppressors_[0].GetAverageGainDb() << "dB";
                     }
-                    
-                    // 显示音频电平
-                    if (callbacks_.on_audio_level) {
-                        float level = CalculateAudioLevel(audio_buffer.data(), frames * config_.audio_config.channels);
-                        callbacks_.on_audio_level(config_.user_id, level);
+                    if (agc_enabled_) {
+                        std::cout << ", agc_gain=" << agc_.GetGainDb() << "dB, limiter_gain="
+                                  << agc_.GetLimiterGainDb() << "dB, vad=" << vad_.IsSpeech();
                     }
-                } else if (frames < 0) {
-                    // 处理音频错误
-                    snd_pcm_recover(audio_capture_handle_, frames, 0);
+                    std::cout << std::endl;
+                    last_capture_log = now;
                 }
-            }
-            
-            // 播放接收到的音频
-            if (audio_playback_handle_) {
-                std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-                static auto last_queue_print = std::chrono::steady_clock::now();
-                auto now = std::chrono::steady_clock::now();
-                if (now - last_queue_print > std::chrono::seconds(5)) {
-                    std::cout << "音频队列状态: 大小=" << audio_queue_.size() << std::endl;
-                    last_queue_print = now;
+                
+                // 发送音频包，开启DTX时静音帧只发送舒适噪声描述符
+                size_t data_size = frames * config_.audio_config.channels * 2;
+                if (!dtx_enabled_ || vad_.IsSpeech()) {
+                    dtx_active_ = false;
+                    SendPcm(audio_buffer.data(), frames);
+                } else {
+                    FlushPcm();
+                    SendComfortNoise(frames);
                 }
+                media_timestamp_ += static_cast<uint32_t>(frames);
+                stats_.Audio().BeginWrite();
+                stats_.Audio().AddDuration(kStatEncodeNs, CallStats::NowNanoseconds() - encode_start);
+                stats_.Audio().EndWrite();
                 
-                if (!audio_queue_.empty()) {
-                    AudioPacket packet = audio_queue_.front();
-                    audio_queue_.pop();
-                    
-                    // 转换字节序
-                    uint16_t data_size = ntohs(packet.data_size);
-                    
-                    // 记录接收日志
-                    static auto last_recv_log = std::chrono::steady_clock::now();
-                    auto now_recv = std::chrono::steady_clock::now();
-                    if (now_recv - last_recv_log > std::chrono::seconds(5)) {
-                        std::cout << "[AUDIO_RECV] data_size=" << data_size << " bytes, sequence=" << ntohl(packet.sequence) 
-                                  << ", user_id=" << ntohl(packet.user_id) << std::endl;
-                        last_recv_log = now_recv;
+                // 记录发送日志
+                static auto last_send_log = std::chrono::steady_clock::now();
+                auto now_send = std::chrono::steady_clock::now();
+                if (now_send - last_send_log > std::chrono::seconds(5)) {
+                    std::cout << "[AUDIO_SEND] data_size=" << data_size << " bytes, packet_size=" << (kAudioPacketHeaderSize + data_size) 
+                              << " bytes, sequence=" << sequence_;
+                    int target_bitrate = 0;
+                    float queuing_delay_ms = 0.0f;
+                    {
+                        std::lock_guard<std::mutex> lock(feedback_mutex_);
+                        target_bitrate = rate_controller_.GetTargetBitrate();
+                        queuing_delay_ms = rate_controller_.GetQueuingDelayMs();
                     }
-                    
-                    // 安全检查
-                    if (data_size > sizeof(packet.data) || data_size == 0) {
-                        std::cout << "[AUDIO_ERROR] 无效的音频数据大小: " << data_size << std::endl;
-                        continue;
+                    std::cout << ", codec=" << (encoding_.codec == kPayloadTypeAdpcm ? "adpcm" : "pcm16")
+                              << ", packet_frames=" << encoding_.packet_frames
+                              << ", fec_depth=" << fec_encoder_.GetDepth()
+                              << ", bitrate=" << encoding_.bitrate
+                              << ", target_bitrate=" << target_bitrate
+                              << ", queuing_delay=" << queuing_delay_ms << "ms"
+                              << ", retransmits=" << stats_.Network().Load(kStatRetransmitsSent);
+                    if (dtx_enabled_) {
+                        std::cout << ", dtx=" << dtx_active_ << ", dtx_suppressed_frames="
+                                  << stats_.Audio().Load(kStatDtxSuppressedFrames)
+                                  << ", comfort_noise_packets=" << comfort_noise_packets_;
                     }
-                    
-                    // 应用音量
-                    std::vector<int16_t> playback_buffer(data_size / 2);
-                    memcpy(playback_buffer.data(), packet.data, data_size);
-                    
-                    // 记录播放前音频数据
-                    static auto last_play_debug = std::chrono::steady_clock::now();
-                    auto now_play = std::chrono::steady_clock::now();
-                    if (now_play - last_play_debug > std::chrono::seconds(5)) {
-                        std::cout << "[AUDIO_PLAY_DEBUG] raw_first_sample=" << playback_buffer[0] 
-                                  << ", raw_last_sample=" << playback_buffer[playback_buffer.size()-1] 
-                                  << ", samples_count=" << playback_buffer.size() << std::endl;
-                        last_play_debug = now_play;
+                    std::cout << std::endl;
+                    last_send_log = now_send;
+                }
+                
+                // 显示音频电平
+                if (callbacks_.on_audio_level) {
+                    float level = CalculateAudioLevel(audio_buffer.data(), frames * config_.audio_config.channels);
+                    callbacks_.on_audio_level(config_.user_id, level);
+                }
+            } else if (frames == -EPIPE) {
+                // 溢出，后端已恢复
+                stats_.Audio().BeginWrite();
+                stats_.Audio().Add(kStatCaptureXruns, 1);
+                stats_.Audio().EndWrite();
+            }
+        }
+        
+        // 播放接收到的音频。非阻塞调度时设备中已有三个周期 (两种后端的缓冲区都是80ms) 的数据则跳过本周期，
+        // 避免 Write 阻塞反应器线程，远端流的数据留到下一个周期拉取
+        if (audio_backend_ &&
+            !(nonblocking && audio_backend_->GetPlaybackDelay() >= 3 * static_cast<long>(silence_frames))) {
+            std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+            uint64_t playback_start = CallStats::NowNanoseconds();
+            double now_seconds = environment_->Now();
+            static auto last_queue_print = std::chrono::steady_clock::now();
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_queue_print > std::chrono::seconds(5)) {
+                for (const auto& entry : remote_streams_) {
+                    std::cout << "音频队列状态: 会话ID=" << entry.first << ", 大小=" << entry.second->QueuedPackets()
+                              << ", 时钟漂移=" << entry.second->GetDriftPpm() << "ppm, 比例="
+                              << entry.second->GetRatio() << ", 丢包=" << entry.second->GetPacketsLost()
+                              << ", FEC恢复=" << entry.second->GetPacketsRecovered()
+                              << ", 迟到=" << entry.second->GetPacketsLate()
+                              << ", NACK请求=" << entry.second->GetNackRequests()
+                              << ", 重传恢复=" << entry.second->GetRetransmitsRecovered()
+                              << ", 重传迟到=" << entry.second->GetRetransmitsLate()
+                              << ", 重传重复=" << entry.second->GetRetransmitsUseless()
+                              << ", RTT=" << entry.second->GetRttSeconds() * 1000.0 << "ms" << std::endl;
+                }
+                last_queue_print = now;
+            }
+            
+            // 从每个远端流拉取一帧并混音
+            size_t mixed_frames = 0;
+            std::fill(mix_buffer.begin(), mix_buffer.end(), 0);
+            for (auto it = remote_streams_.begin(); it != remote_streams_.end();) {
+                RemoteStream& stream = *it->second;
+                size_t frames = stream.Pull(stream_buffer.data(), network_frames, now_seconds);
+                if (frames > 0) {
+                    for (size_t i = 0; i < mix_buffer.size(); ++i) {
+                        mix_buffer[i] += stream_buffer[i];
                     }
-                    
-                    for (int i = 0; i < playback_buffer.size(); ++i) {
-                        playback_buffer[i] = static_cast<int16_t>(playback_buffer[i] * speaker_volume_);
+                    mixed_frames = std::max(mixed_frames, frames);
+                } else if (stream.QueuedPackets() == 0 && now_seconds - stream.GetLastArrival() > kRemoteStreamIdleSeconds) {
+                    // 长时间没有数据的发送者
+                    RetireStream(stream);
+                    it = remote_streams_.erase(it);
+                    continue;
+                }
+                ++it;
+            }
+            PublishStreamStats();
+            
+            // 开始播放和欠载恢复后先多写一个周期的静音，此后每次写入一个周期，缓冲区保持一个周期的余量
+            if (!playback_primed) {
+                if (!echo_cancellers_.empty()) {
+                    echo_reference_.WriteSilence(silence_frames * config_.audio_config.sample_rate / playback_device_rate_);
+                }
+                playback_primed = audio_backend_->Write(silence_buffer.data(), silence_frames) >= 0;
+            }
+            
+            if (mixed_frames > 0) {
+                for (size_t i = 0; i < mix_buffer.size(); ++i) {
+                    network_buffer[i] = static_cast<int16_t>(std::max(-32768, std::min(32767, mix_buffer[i])));
+                }
+                if (!echo_cancellers_.empty()) {
+                    WriteEchoReference(network_buffer.data(), network_frames);
+                }
+                
+                // 转换到播放设备采样率，后端支持时直接写入设备缓冲区
+                const size_t playback_capacity = playback_buffer.size() / channels;
+                int16_t* device_playback = audio_backend_->BeginPlayback(playback_capacity);
+                int16_t* playback_out = device_playback ? device_playback : playback_buffer.data();
+                size_t frames_to_write = playback_resampler_.Process(network_buffer.data(), network_frames,
+                                                                     playback_out, playback_capacity);
+                
+                // 记录播放前音频数据
+                static auto last_play_debug = std::chrono::steady_clock::now();
+                auto now_play = std::chrono::steady_clock::now();
+                if (now_play - last_play_debug > std::chrono::seconds(5)) {
+                    std::cout << "[AUDIO_PLAY_DEBUG] raw_first_sample=" << network_buffer[0] 
+                              << ", raw_last_sample=" << network_buffer[network_buffer.size()-1] 
+                              << ", samples_count=" << network_buffer.size()
+                              << ", streams=" << remote_streams_.size() << std::endl;
+                    last_play_debug = now_play;
+                }
+                
+                // 应用音量
+                for (size_t i = 0; i < frames_to_write * channels; ++i) {
+                    playback_out[i] = static_cast<int16_t>(playback_out[i] * speaker_volume_);
+                }
+                stats_.Audio().BeginWrite();
+                stats_.Audio().AddDuration(kStatPlaybackNs, CallStats::NowNanoseconds() - playback_start);
+                stats_.Audio().EndWrite();
+                
+                long frames = device_playback ? audio_backend_->CommitPlayback(frames_to_write)
+                                              : audio_backend_->Write(playback_buffer.data(), frames_to_write);
+                if (frames < 0) {
+                    // 静默处理音频错误，避免刷屏
+                    CountPlaybackXrun(frames);
+                    playback_primed = false;
+                } else if (static_cast<size_t>(frames) != frames_to_write) {
+                    // 静默处理不完整播放
+                } else {
+                    static auto last_play_print = std::chrono::steady_clock::now();
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - last_play_print > std::chrono::seconds(5)) {
+                        std::cout << "[AUDIO_PLAY] frames=" << frames << ", buffer_size=" << frames_to_write * channels 
+                                  << ", mixed_frames=" << mixed_frames << ", speaker_volume=" << speaker_volume_ << std::endl;
+                        last_play_print = now;
                     }
-                    
-                    size_t frames_to_write = playback_buffer.size() / config_.audio_config.channels;
-                    snd_pcm_sframes_t frames = snd_pcm_writei(audio_playback_handle_, 
-                                                             playback_buffer.data(), 
-                                                             frames_to_write);
+                }
+            } else {
+                // 播放静音以避免音频设备停止
+                if (!echo_cancellers_.empty()) {
+                    echo_reference_.WriteSilence(silence_frames * config_.audio_config.sample_rate / playback_device_rate_);
+                }
+                if (silence_frames > 0) {
+                    long frames = audio_backend_->Write(silence_buffer.data(), silence_frames);
                     if (frames < 0) {
-                        // 静默处理音频错误，避免刷屏
-                        snd_pcm_recover(audio_playback_handle_, frames, 0);
-                    } else if (frames != frames_to_write) {
-                        // 静默处理不完整播放
-                    } else {
-                        static auto last_play_print = std::chrono::steady_clock::now();
-                        auto now = std::chrono::steady_clock::now();
-                        if (now - last_play_print > std::chrono::seconds(5)) {
-                            std::cout << "[AUDIO_PLAY] frames=" << frames << ", buffer_size=" << playback_buffer.size() 
-                                      << ", data_size=" << data_size << " bytes, speaker_volume=" << speaker_volume_ << std::endl;
-                            last_play_print = now;
-                        }
-                    }
-                } else {
-                    // 播放静音以避免音频设备停止
-                    size_t silence_frames = silence_buffer.size() / config_.audio_config.channels;
-                    if (silence_frames > 0) {
-                        snd_pcm_sframes_t frames = snd_pcm_writei(audio_playback_handle_, 
-                                                                 silence_buffer.data(), 
-                                                                 silence_frames);
-                        if (frames < 0) {
-                            // 静默处理静音播放错误
-                            snd_pcm_recover(audio_playback_handle_, frames, 0);
-                        }
+                        // 静默处理静音播放错误
+                        CountPlaybackXrun(frames);
+                        playback_primed = false;
                     }
                 }
             }
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 100Hz
         }
         
-        std::cout << "Audio loop stopped" << std::endl;
+    }
+    
+    // 反应器回调: 每次最多处理 kMaxPacketsPerWakeup 个包，其余留给下一次 epoll_wait，避免一个通话占住反应器线程
+    void OnReadable() override {
+        char buffer[2048];
+        for (int i = 0; i < kMaxPacketsPerWakeup && ReceivePacket(buffer, sizeof(buffer)); ++i) {
+        }
+    }
+    
+    // 反应器节拍 (10ms): 有数据时运行音频周期，积压时每个节拍最多追赶 kMaxAudioCyclesPerTick 个周期
+    void OnTick() override {
+        if (!running_) return;
+        MaybeResendJoin();
+        if (!audio_ready_.load(std::memory_order_acquire)) return;
+        for (int i = 0; i < kMaxAudioCyclesPerTick && AudioCycleReady(); ++i) {
+            RunAudioCycle(true);
+        }
+        MaybeSendReceiverReport();
     }
     
     void NetworkLoop() {
+        // 网络线程只把包放入接收队列，比音频线程低一级，两者在同一CPU上时不抢占音频周期
+        ApplyThreadScheduling("vc-network", config_.sched_policy, std::max(config_.sched_priority - 1, 1),
+                              config_.network_cpu_mask);
+        if (config_.lock_memory) {
+            PrefaultStack(kPrefaultStackBytes);
+        }
         char buffer[2048];
         
         while (running_) {
-            struct pollfd pfd;
-            pfd.fd = socket_fd_;
-            pfd.events = POLLIN;
+            MaybeResendJoin();
+            MaybeSendReceiverReport();
             
-            if (poll(&pfd, 1, 100) > 0) {
-                struct sockaddr_in from_addr;
-                socklen_t from_len = sizeof(from_addr);
-                
-                int received = recvfrom(socket_fd_, buffer, sizeof(buffer), 0, 
-                                       (struct sockaddr*)&from_addr, &from_len);
-                if (received > 0) {
-                    static auto last_network_print = std::chrono::steady_clock::now();
-                    auto now = std::chrono::steady_clock::now();
-                    if (now - last_network_print > std::chrono::seconds(5)) {
-                        std::cout << "网络线程收到数据: " << received << " bytes, 来自=" 
-                                  << inet_ntoa(from_addr.sin_addr) << ":" << ntohs(from_addr.sin_port) << std::endl;
-                        last_network_print = now;
-                    }
-                    ProcessNetworkMessage(buffer, received, from_addr);
-                }
+            // 等待 JOIN_OK 时最迟在下次重发 JOIN 的时刻醒来
+            int wait_ms = kNetworkWaitMs;
+            if (local_id_ == kUnassignedSessionId) {
+                double until_join = next_join_ - environment_->Now();
+                wait_ms = std::max(1, std::min(wait_ms, static_cast<int>(until_join * 1000.0) + 1));
+            }
+            if (transport_->WaitReadable(wait_ms)) {
+                ReceivePacket(buffer, sizeof(buffer));
             }
         }
     }
     
-    void SendAudioPacket(const void* data, size_t size) {
-        // 限制音频数据大小，避免UDP包过大
-        const size_t max_audio_size = 640; // 20ms音频数据大小
-        
-        if (size > max_audio_size) {
-            size = max_audio_size;
+    void MaybeSendReceiverReport() {
+        double now = environment_->Now();
+        if (now - last_report_ >= kReceiverReportIntervalMs / 1000.0) {
+            SendReceiverReport();
+            last_report_ = now;
+        }
+    }
+    
+    // 接收并处理一个包，没有数据时返回 false
+    bool ReceivePacket(char* buffer, size_t size) {
+        long received = transport_->Receive(buffer, size);
+        if (received <= 0) {
+            return false;
+        }
+        static auto last_network_print = std::chrono::steady_clock::now();
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_network_print > std::chrono::seconds(5)) {
+            std::cout << "网络线程收到数据: " << received << " bytes, 来自=" << server_name_ << std::endl;
+            last_network_print = now;
+        }
+        uint64_t process_start = CallStats::NowNanoseconds();
+        ProcessNetworkMessage(buffer, static_cast<int>(received));
+        stats_.Network().BeginWrite();
+        stats_.Network().AddDuration(kStatNetworkProcessNs, CallStats::NowNanoseconds() - process_start);
+        stats_.Network().EndWrite();
+        return true;
+    }
+    
+    // 累积采集周期组成一个包 (配置的包长，最低一档不短于40ms)，编码方式在每个包开始时选择
+    void SendPcm(const int16_t* pcm, size_t frames) {
+        const int channels = config_.audio_config.channels;
+        if (packet_capture_frames_ == 0) {
+            SelectEncodingMode();
+            packet_timestamp_ = media_timestamp_;
+            packet_pcm_.clear();
+            uint32_t session_id = local_id_.load(std::memory_order_relaxed);
+            packet_traced_ = session_id != kUnassignedSessionId &&
+                             FrameTracer::Instance().ShouldSample(&trace_counter_);
+            if (packet_traced_) {
+                FrameTracer::Instance().Record(kTraceCaptured, session_id, packet_timestamp_);
+            }
+        }
+        packet_pcm_.insert(packet_pcm_.end(), pcm, pcm + frames * channels);
+        ++packet_capture_frames_;
+        if (packet_capture_frames_ * audio_loop_.network_frames >= encoding_.packet_frames) {
+            FlushPcm();
+        }
+    }
+    
+    // 按目标码率与丢包情况选择编码、包长和冗余深度
+    void SelectEncodingMode() {
+        const int network_rate = config_.audio_config.sample_rate;
+        int fec_depth = 0;
+        int target_bitrate = 0;
+        float queuing_delay_ms = 0.0f;
+        {
+            std::lock_guard<std::mutex> lock(feedback_mutex_);
+            double now = environment_->Now();
+            fec_depth = fec_controller_.Update(now);
+            target_bitrate = rate_controller_.Update(now, encoding_.bitrate, sequence_);
+            queuing_delay_ms = rate_controller_.GetQueuingDelayMs();
+        }
+        EncodingMode mode = SelectEncoding(target_bitrate, network_rate, config_.audio_config.channels, packet_ms_,
+                                           fec_depth);
+        if (mode.codec != encoding_.codec || mode.packet_frames != encoding_.packet_frames) {
+            std::cout << "切换编码: " << (mode.codec == kPayloadTypeAdpcm ? "ADPCM" : "PCM16") << ", 包长="
+                      << mode.packet_frames * 1000 / network_rate << "ms, 目标码率=" << target_bitrate
+                      << "bps, 排队时延=" << queuing_delay_ms << "ms" << std::endl;
+        }
+        encoding_ = mode;
+        fec_encoder_.SetDepth(mode.fec_depth);
+        stats_.Audio().BeginWrite();
+        stats_.Audio().Set(kStatTargetBitrate, static_cast<uint64_t>(target_bitrate));
+        stats_.Audio().Set(kStatSendBitrate, static_cast<uint64_t>(mode.bitrate));
+        stats_.Audio().Set(kStatFecDepth, static_cast<uint64_t>(mode.fec_depth));
+        stats_.Audio().EndWrite();
+    }
+    
+    // 发送已累积的帧 (进入静音时可能不足一个完整的包)
+    void FlushPcm() {
+        if (packet_capture_frames_ == 0) return;
+        packet_capture_frames_ = 0;
+        const int channels = config_.audio_config.channels;
+        const size_t frames = packet_pcm_.size() / channels;
+        const uint8_t trace_flag = packet_traced_ ? kPacketFlagTraced : 0;
+        uint8_t payload_type = kPayloadTypePcm16;
+        if (EncodingPayloadSize(encoding_.codec, frames, fec_encoder_.GetDepth(), channels) <= kMaxPayloadSize) {
+            uint8_t* payload = ReservePacket();
+            size_t size = fec_encoder_.BuildPayload(packet_pcm_.data(), frames, sequence_, packet_timestamp_,
+                                                    encoding_.codec, payload, kMaxPayloadSize, &payload_type);
+            if (size > 0) {
+                TraceEncoded();
+                SendAudioPacket(size, packet_timestamp_, payload_type, trace_flag);
+            }
+            return;
+        }
+        // 超过一个包: 编码整帧后分片 (选择编码方式时已去掉冗余)
+        size_t size = fec_encoder_.BuildPayload(packet_pcm_.data(), frames, sequence_, packet_timestamp_,
+                                                encoding_.codec, frame_payload_.data(), frame_payload_.size(),
+                                                &payload_type);
+        if (size > 0) {
+            TraceEncoded();
+            SendFragments(frame_payload_.data(), size, frames, packet_timestamp_, payload_type, trace_flag);
+        }
+    }
+    
+    void TraceEncoded() {
+        if (packet_traced_) {
+            FrameTracer::Instance().Record(kTraceEncoded, local_id_.load(std::memory_order_relaxed), packet_timestamp_);
+        }
+    }
+    
+    // 整帧负载平均拆成最少的分片，每个分片写入各自序列号的发送历史槽位后发送 (追踪标志只给第一个分片)
+    void SendFragments(const uint8_t* frame, size_t size, size_t frames, uint32_t timestamp, uint8_t payload_type,
+                       uint8_t trace_flag) {
+        const size_t count = (size + kFragmentPayloadSize - 1) / kFragmentPayloadSize;
+        if (count > kMaxFrameFragments || frames > 0xffff) {
+            return;
+        }
+        const size_t fragment_size = (size + count - 1) / count;
+        FragmentHeader header;
+        header.count = static_cast<uint8_t>(count);
+        header.frames = htons(static_cast<uint16_t>(frames));
+        for (size_t i = 0; i < count; ++i) {
+            size_t offset = i * fragment_size;
+            size_t length = std::min(fragment_size, size - offset);
+            header.index = static_cast<uint8_t>(i);
+            uint8_t* payload = ReservePacket();
+            memcpy(payload, &header, sizeof(header));
+            memcpy(payload + sizeof(header), frame + offset, length);
+            SendAudioPacket(sizeof(header) + length, timestamp, payload_type,
+                            kPacketFlagFragment | (i == 0 ? trace_flag : 0));
+        }
+    }
+    
+    // 取下一个序列号对应的发送历史槽位作为负载缓冲区: 编码器直接写入，发送和NACK重传都从这里读取，
+    // 每个包不再拼接或复制。槽位先标记为无效，写入期间网络线程不会重传它
+    uint8_t* ReservePacket() {
+        std::lock_guard<std::mutex> lock(send_history_mutex_);
+        SentPacket& slot = send_history_[sequence_ % kSendHistorySize];
+        slot.size = 0;
+        return slot.packet.data;
+    }
+    
+    // 发送 ReservePacket() 返回的缓冲区中已写入的 size 字节负载
+    // 还没有会话ID时服务器不会转发，直接丢弃 (不占用序列号)
+    void SendAudioPacket(size_t size, uint32_t timestamp, uint8_t payload_type, uint8_t flags) {
+        uint32_t session_id = local_id_.load(std::memory_order_relaxed);
+        if (session_id == kUnassignedSessionId) {
+            return;
+        }
+        uint32_t sequence = sequence_++;
+        SentPacket& slot = send_history_[sequence % kSendHistorySize];
+        AudioPacket& packet = slot.packet;
+        packet.session_id = htonl(session_id);
+        packet.sequence = htonl(sequence);
+        packet.timestamp = htonl(timestamp);
+        packet.payload_type = payload_type;
+        packet.flags = flags;
+        // 原地加密，发送历史中保存的是密文，NACK重传不再重新加密
+        if (payload_crypto_.IsEnabled()) {
+            packet.flags |= kPacketFlagEncrypted;
+            size = payload_crypto_.Seal(&packet, size);
         }
-        
-        AudioPacket packet;
-        packet.sequence = htonl(sequence_++);
-        packet.timestamp = htonl(std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count());
-        packet.user_id = htonl(std::hash<std::string>{}(config_.user_id));
         packet.data_size = htons(size);
         
-        memcpy(packet.data, data, size);
+        int packet_size = kAudioPacketHeaderSize + size;
+        if (flags & kPacketFlagTraced) {
+            FrameTracer::Instance().Record(kTraceSent, session_id, timestamp);
+        }
+        long sent = transport_->Send(&packet, packet_size, nullptr, 0);
         
-        int packet_size = sizeof(AudioPacket) - sizeof(AudioPacket::data) + size;
-        int sent = sendto(socket_fd_, &packet, packet_size, 0,
-               (struct sockaddr*)&server_addr_, sizeof(server_addr_));
+        // 发布到发送历史，供NACK重传
+        {
+            std::lock_guard<std::mutex> lock(send_history_mutex_);
+            slot.size = packet_size;
+            slot.last_retransmit = -1.0;
+        }
         
         static auto last_send_print = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
         if (sent > 0) {
+            stats_.Audio().BeginWrite();
+            stats_.Audio().Add(kStatPacketsSent, 1);
+            stats_.Audio().Add(kStatBytesSent, static_cast<uint64_t>(sent));
+            stats_.Audio().EndWrite();
             if (now - last_send_print > std::chrono::seconds(5)) {
                 std::cout << "发送音频包: 原始大小=" << size << ", 包大小=" << packet_size << ", 发送=" << sent << " bytes, 序列=" << ntohl(packet.sequence) << std::endl;
                 last_send_print = now;
@@ -552,69 +1204,422 @@ private:
         }
     }
     
-    void ProcessNetworkMessage(const char* buffer, int size, const struct sockaddr_in& from_addr) {
-        if (size >= 14) { // AudioPacket的最小大小（头部）
+    void ProcessNetworkMessage(const char* buffer, int size) {
+        // 文本控制消息优先识别，避免较长的控制消息被当作音频包
+        bool is_control = (size >= 5 && memcmp(buffer, "JOIN:", 5) == 0) ||
+                          (size >= 6 && memcmp(buffer, "LEAVE:", 6) == 0) ||
+                          (size >= 8 && memcmp(buffer, "JOIN_OK:", 8) == 0);
+        if (!is_control && size >= static_cast<int>(kAudioPacketHeaderSize)) {
+            // 异步连接的设备就绪前还没有接收流与码率控制的配置，只处理控制消息
+            if (!audio_ready_.load(std::memory_order_acquire)) {
+                return;
+            }
             const AudioPacket* packet = reinterpret_cast<const AudioPacket*>(buffer);
+            size_t data_size = ntohs(packet->data_size);
+            if (data_size > sizeof(packet->data) || kAudioPacketHeaderSize + data_size > static_cast<size_t>(size)) {
+                std::cout << "[AUDIO_ERROR] 无效的音频数据大小: " << data_size << std::endl;
+                return;
+            }
             
             // 检查是否是其他用户的音频包
-            uint32_t my_id = std::hash<std::string>{}(config_.user_id);
-            uint32_t packet_user_id = ntohl(packet->user_id);
+            uint32_t my_id = local_id_;
+            uint32_t packet_session_id = ntohl(packet->session_id);
             
             static auto last_id_print = std::chrono::steady_clock::now();
             auto now = std::chrono::steady_clock::now();
             if (now - last_id_print > std::chrono::seconds(5)) {
-                std::cout << "用户ID检查: 我的ID=" << my_id << ", 包中ID=" << packet_user_id 
-                          << ", 匹配=" << (packet_user_id != my_id ? "是" : "否") << std::endl;
+                std::cout << "会话ID检查: 我的ID=" << my_id << ", 包中ID=" << packet_session_id 
+                          << ", 匹配=" << (packet_session_id != my_id ? "是" : "否") << std::endl;
                 last_id_print = now;
             }
             
-            if (packet_user_id != my_id) {
-                // 添加到播放队列
+            if (packet->payload_type == kPayloadTypeReceiverReport) {
+                if (packet_session_id != my_id) {
+                    HandleReceiverReport(*packet, my_id);
+                }
+                return;
+            }
+            if (packet->payload_type == kPayloadTypeNack) {
+                if (packet_session_id != my_id) {
+                    HandleNack(*packet, my_id);
+                }
+                return;
+            }
+            
+            NackBlock nack_blocks[kMaxNackBlocks];
+            size_t nack_count = 0;
+            if (packet_session_id != my_id) {
+                // 配置了密钥时只接受认证通过的加密包；没有密钥时无法解码加密包
+                AudioPacket decrypted;
+                if (payload_crypto_.IsEnabled() || (packet->flags & kPacketFlagEncrypted)) {
+                    const PayloadCrypto::OpenResult opened = payload_crypto_.Open(*packet, data_size, &decrypted);
+                    if (opened == PayloadCrypto::kOpenReplayed) {
+                        // 已收到过的序列号: 重传包照常计入迟到或无用的重传，其余 (重复或重放的包) 直接丢弃
+                        if (packet->flags & kPacketFlagRetransmit) {
+                            stats_.Network().BeginWrite();
+                            stats_.Network().Add(kStatPacketsReceived, 1);
+                            stats_.Network().Add(kStatBytesReceived, static_cast<uint64_t>(size));
+                            stats_.Network().EndWrite();
+                            std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+                            auto found = remote_streams_.find(packet_session_id);
+                            if (found != remote_streams_.end()) {
+                                found->second->PushReplayedRetransmit(ntohl(packet->sequence));
+                            }
+                        }
+                        return;
+                    }
+                    if (opened != PayloadCrypto::kOpenOk) {
+                        stats_.Network().BeginWrite();
+                        stats_.Network().Add(kStatDecryptFailures, 1);
+                        stats_.Network().EndWrite();
+                        static auto last_decrypt_print = std::chrono::steady_clock::time_point();
+                        if (now - last_decrypt_print > std::chrono::seconds(5)) {
+                            std::cout << "[AUDIO_ERROR] 丢弃无法认证的音频包: 会话ID=" << packet_session_id
+                                      << (payload_crypto_.IsEnabled() ? "" : " (未配置密钥)") << std::endl;
+                            last_decrypt_print = now;
+                        }
+                        return;
+                    }
+                    packet = &decrypted;
+                }
+                // 重传包不再记录 (原包的接收已记录或已丢失)
+                const bool traced = (packet->flags & (kPacketFlagTraced | kPacketFlagRetransmit)) == kPacketFlagTraced;
+                if (traced) {
+                    FrameTracer::Instance().Record(kTraceReceived, packet_session_id, ntohl(packet->timestamp));
+                }
+                stats_.Network().BeginWrite();
+                stats_.Network().Add(kStatPacketsReceived, 1);
+                stats_.Network().Add(kStatBytesReceived, static_cast<uint64_t>(size));
+                stats_.Network().EndWrite();
+
+                // 添加到该发送者的播放队列
                 std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-                if (audio_queue_.size() < 10) { // 限制队列大小
-                    audio_queue_.push(*packet);
+                auto& stream = remote_streams_[packet_session_id];
+                if (!stream) {
+                    const size_t rate = static_cast<size_t>(config_.audio_config.sample_rate);
+                    stream.reset(new RemoteStream(packet_session_id, config_.audio_config.sample_rate,
+                                                  config_.audio_config.channels,
+                                                  rate * packet_ms_ / 1000, rate * cycle_ms_ / 1000));
+                }
+                if (stream->Push(*packet, environment_->Now())) {
+                    if (traced) {
+                        FrameTracer::Instance().Record(kTraceBuffered, packet_session_id, ntohl(packet->timestamp));
+                    }
                     static auto last_recv_print = std::chrono::steady_clock::now();
                     auto now = std::chrono::steady_clock::now();
                     if (now - last_recv_print > std::chrono::seconds(5)) {
-                        std::cout << "收到音频包: 大小=" << size << " bytes, 队列大小=" << audio_queue_.size() 
-                                  << ", 用户ID=" << ntohl(packet->user_id) << ", 数据大小=" << ntohs(packet->data_size) << std::endl;
+                        std::cout << "收到音频包: 大小=" << size << " bytes, 队列大小=" << stream->QueuedPackets() 
+                                  << ", 会话ID=" << packet_session_id << ", 数据大小=" << ntohs(packet->data_size) << std::endl;
                         last_recv_print = now;
                     }
                 }
+                nack_count = stream->BuildNack(environment_->Now(), nack_blocks, kMaxNackBlocks);
+            }
+            if (nack_count > 0) {
+                SendNack(nack_blocks, nack_count);
             }
         } else {
-            // 处理控制消息
+            // 处理控制消息: 服务器发送的格式为 "JOIN_OK|JOIN|LEAVE:房间:用户:会话ID"
             std::string message(buffer, size);
-            if (message.find("JOIN:") == 0) {
-                // 用户加入
-                size_t pos1 = message.find(':', 5);
-                size_t pos2 = message.find(':', pos1 + 1);
-                if (pos1 != std::string::npos && pos2 != std::string::npos) {
-                    std::string room_id = message.substr(5, pos1 - 5);
-                    std::string user_id = message.substr(pos1 + 1, pos2 - pos1 - 1);
-                    
-                    if (room_id == config_.room_id && user_id != config_.user_id) {
-                        if (callbacks_.on_peer_joined) {
-                            callbacks_.on_peer_joined(user_id.c_str());
-                        }
+            std::string room_id;
+            std::string user_id;
+            uint32_t session_id = kUnassignedSessionId;
+            if (!ParseControlMessage(message, &room_id, &user_id, &session_id) || room_id != config_.room_id) {
+                return;
+            }
+            if (message.find("JOIN_OK:") == 0) {
+                if (user_id == config_.user_id && session_id != kUnassignedSessionId) {
+                    uint32_t previous = local_id_.exchange(session_id);
+                    if (previous != session_id) {
+                        std::cout << "加入房间成功，会话ID=" << session_id << std::endl;
+                    }
+                    if (previous == kUnassignedSessionId) {
+                        OnJoined();
                     }
                 }
+            } else if (message.find("JOIN:") == 0) {
+                // 用户加入
+                if (user_id != config_.user_id && callbacks_.on_peer_joined) {
+                    callbacks_.on_peer_joined(user_id.c_str());
+                }
             } else if (message.find("LEAVE:") == 0) {
                 // 用户离开
-                size_t pos1 = message.find(':', 6);
-                size_t pos2 = message.find(':', pos1 + 1);
-                if (pos1 != std::string::npos && pos2 != std::string::npos) {
-                    std::string room_id = message.substr(6, pos1 - 6);
-                    std::string user_id = message.substr(pos1 + 1, pos2 - pos1 - 1);
-                    
-                    if (room_id == config_.room_id && user_id != config_.user_id) {
-                        if (callbacks_.on_peer_left) {
-                            callbacks_.on_peer_left(user_id.c_str());
+                if (user_id != config_.user_id) {
+                    {
+                        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+                        auto found = remote_streams_.find(session_id);
+                        if (found != remote_streams_.end()) {
+                            RetireStream(*found->second);
+                            remote_streams_.erase(found);
                         }
                     }
+                    payload_crypto_.RemoveSession(session_id);
+                    if (callbacks_.on_peer_left) {
+                        callbacks_.on_peer_left(user_id.c_str());
+                    }
+                }
+            }
+        }
+    }
+    
+    // 解析 "类型:房间:用户[:会话ID]"，没有会话ID时 session_id 不变
+    static bool ParseControlMessage(const std::string& message, std::string* room_id, std::string* user_id,
+                                    uint32_t* session_id) {
+        size_t pos1 = message.find(':');
+        size_t pos2 = pos1 == std::string::npos ? std::string::npos : message.find(':', pos1 + 1);
+        if (pos2 == std::string::npos) {
+            return false;
+        }
+        size_t pos3 = message.find(':', pos2 + 1);
+        *room_id = message.substr(pos1 + 1, pos2 - pos1 - 1);
+        *user_id = message.substr(pos2 + 1, pos3 == std::string::npos ? std::string::npos : pos3 - pos2 - 1);
+        if (pos3 != std::string::npos) {
+            char* end = nullptr;
+            unsigned long parsed = std::strtoul(message.c_str() + pos3 + 1, &end, 10);
+            if (end != message.c_str() + pos3 + 1 && *end == '\0' && parsed < kUnassignedSessionId) {
+                *session_id = static_cast<uint32_t>(parsed);
+            }
+        }
+        return true;
+    }
+    
+    // 对每个远端流报告上个周期的丢包率、最高序列号、抖动与平均相对传输时延，由服务器转发给房间内其他成员
+    void SendReceiverReport() {
+        ReceiverReportBlock blocks[sizeof(AudioPacket::data) / sizeof(ReceiverReportBlock)];
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+            for (auto& entry : remote_streams_) {
+                if (count == sizeof(blocks) / sizeof(blocks[0])) break;
+                if (entry.second->TakeReport(&blocks[count])) {
+                    ++count;
                 }
             }
         }
+        if (count == 0) return;
+        SendControlPacket(kPayloadTypeReceiverReport, blocks, count * sizeof(ReceiverReportBlock));
+    }
+    
+    // 控制包 (接收报告、重传请求) 不占用序列号: 包头和负载作为两段交给传输 (sendmsg)，不拼接
+    void SendControlPacket(uint8_t payload_type, const void* data, size_t size) {
+        uint32_t session_id = local_id_.load(std::memory_order_relaxed);
+        if (session_id == kUnassignedSessionId) {
+            return;
+        }
+        AudioPacketHeader header;
+        memset(&header, 0, sizeof(header));
+        header.session_id = htonl(session_id);
+        header.data_size = htons(size);
+        header.payload_type = payload_type;
+        transport_->Send(&header, sizeof(header), data, size);
+    }
+    
+    // 处理其他成员发来的接收报告，取出关于本端的块驱动冗余深度与码率
+    void HandleReceiverReport(const AudioPacket& packet, uint32_t my_id) {
+        uint32_t reporter_id = ntohl(packet.session_id);
+        size_t count = ntohs(packet.data_size) / sizeof(ReceiverReportBlock);
+        double now = environment_->Now();
+        for (size_t i = 0; i < count; ++i) {
+            ReceiverReportBlock block;
+            memcpy(&block, packet.data + i * sizeof(block), sizeof(block));
+            if (ntohl(block.source_id) != my_id) continue;
+            std::lock_guard<std::mutex> lock(feedback_mutex_);
+            fec_controller_.OnLossReport(block.fraction_lost / 256.0f, now);
+            rate_controller_.OnReceiverReport(reporter_id, block.fraction_lost / 256.0f, ntohl(block.highest_sequence),
+                                              ntohl(block.transit), now);
+        }
+    }
+    
+    // 发送重传请求，由服务器从缓存应答或转发给发送者
+    void SendNack(const NackBlock* blocks, size_t count) {
+        SendControlPacket(kPayloadTypeNack, blocks, count * sizeof(NackBlock));
+    }
+    
+    // 从发送历史中重传请求的包
+    void HandleNack(const AudioPacket& packet, uint32_t my_id) {
+        size_t count = ntohs(packet.data_size) / sizeof(NackBlock);
+        double now = environment_->Now();
+        for (size_t i = 0; i < count; ++i) {
+            NackBlock block;
+            memcpy(&block, packet.data + i * sizeof(block), sizeof(block));
+            if (ntohl(block.source_id) != my_id) continue;
+            uint32_t first = ntohl(block.sequence);
+            uint16_t bitmask = ntohs(block.bitmask);
+            for (int bit = -1; bit < 16; ++bit) {
+                if (bit >= 0 && !(bitmask & (1u << bit))) continue;
+                RetransmitPacket(first + bit + 1, now);
+            }
+        }
+    }
+    
+    void RetransmitPacket(uint32_t sequence, double now) {
+        AudioPacket packet;
+        size_t size = 0;
+        {
+            std::lock_guard<std::mutex> lock(send_history_mutex_);
+            SentPacket& slot = send_history_[sequence % kSendHistorySize];
+            if (slot.size == 0 || ntohl(slot.packet.sequence) != sequence ||
+                now - slot.last_retransmit < kRetransmitHoldoffSeconds) {
+                return;
+            }
+            slot.last_retransmit = now;
+            size = slot.size;
+            memcpy(&packet, &slot.packet, size);
+        }
+        packet.flags |= kPacketFlagRetransmit;
+        transport_->Send(&packet, size, nullptr, 0);
+        stats_.Network().BeginWrite();
+        stats_.Network().Add(kStatRetransmitsSent, 1);
+        stats_.Network().EndWrite();
+    }
+    
+    // 静音帧: 更新背景噪声估计，进入静音、到达发送间隔或噪声电平明显变化时发送描述符
+    void SendComfortNoise(size_t frames) {
+        if (!dtx_active_) {
+            comfort_noise_encoder_.Reset();
+        }
+        comfort_noise_encoder_.Analyze(capture_plane_ptrs_[0], frames);
+        dtx_frames_since_descriptor_ += frames;
+        stats_.Audio().BeginWrite();
+        stats_.Audio().Add(kStatDtxSuppressedFrames, frames);
+        stats_.Audio().EndWrite();
+        
+        float level_db = comfort_noise_encoder_.GetLevelDb();
+        size_t interval = static_cast<size_t>(config_.audio_config.sample_rate) * kComfortNoiseIntervalMs / 1000;
+        if (!dtx_active_ || dtx_frames_since_descriptor_ >= interval ||
+            std::fabs(level_db - dtx_sent_level_db_) > kComfortNoiseLevelChangeDb) {
+            size_t size = comfort_noise_encoder_.Encode(ReservePacket());
+            SendAudioPacket(size, media_timestamp_, kPayloadTypeComfortNoise, 0);
+            dtx_frames_since_descriptor_ = 0;
+            dtx_sent_level_db_ = level_db;
+            ++comfort_noise_packets_;
+        }
+        dtx_active_ = true;
+    }
+    
+    // 写入回声参考: 混音器输出按扬声器音量缩放并下混为单声道
+    void WriteEchoReference(const int16_t* mixed, size_t frames) {
+        const int channels = config_.audio_config.channels;
+        echo_far_.resize(frames);
+        const float scale = speaker_volume_ / (32768.0f * channels);
+        for (size_t i = 0; i < frames; ++i) {
+            int sum = 0;
+            for (int ch = 0; ch < channels; ++ch) {
+                sum += mixed[i * channels + ch];
+            }
+            echo_far_[i] = sum * scale;
+        }
+        echo_reference_.Write(echo_far_.data(), frames);
+    }
+    
+    // 捕获信号 (网络采样率) 的处理链，在平面浮点缓冲上完成:
+    // 回声消除 -> 噪声抑制 (逐声道) -> 语音检测 -> 自动增益与限幅 (各声道共用增益) -> 麦克风音量
+    void ProcessCapture(int16_t* audio, size_t frames) {
+        const int channels = config_.audio_config.channels;
+        if (!echo_cancellers_.empty()) {
+            UpdateEchoDelay(frames);
+            echo_far_.resize(frames);
+            echo_reference_.ReadAligned(echo_far_.data(), frames, echo_delay_frames_);
+        }
+        capture_planes_.resize(channels);
+        capture_plane_ptrs_.resize(channels);
+        for (int ch = 0; ch < channels; ++ch) {
+            capture_planes_[ch].resize(frames);
+            capture_plane_ptrs_[ch] = capture_planes_[ch].data();
+        }
+        capture_conversion_->to_planar_float(audio, capture_plane_ptrs_.data(), frames, channels);
+        for (int ch = 0; ch < channels; ++ch) {
+            std::vector<float>& plane = capture_planes_[ch];
+            if (!echo_cancellers_.empty()) {
+                echo_cancellers_[ch].Process(plane.data(), echo_far_.data(), frames);
+            }
+            if (!noise_suppressors_.empty()) {
+                noise_suppressors_[ch].Process(plane.data(), frames);
+            }
+        }
+        
+        bool speech = vad_.Process(capture_plane_ptrs_[0], frames);
+        float mic_volume = mic_volume_;
+        if (agc_enabled_) {
+            agc_.Process(capture_plane_ptrs_.data(), channels, frames, speech, mic_volume);
+        } else {
+            // 音量变化在帧内平滑过渡，转换回int16时饱和截断
+            for (int ch = 0; ch < channels; ++ch) {
+                audio_kernels::ApplyGainRamp(capture_plane_ptrs_[ch], frames, applied_mic_volume_, mic_volume);
+            }
+        }
+        applied_mic_volume_ = mic_volume;
+        
+        capture_conversion_->from_planar_float(capture_plane_ptrs_.data(), audio, frames, channels);
+    }
+    
+    // 根据两个设备的当前延迟估计回声参考的对齐位置
+    void UpdateEchoDelay(size_t frames) {
+        const int network_rate = config_.audio_config.sample_rate;
+        
+        // 麦克风样点被采集的时刻比读取时早 capture_delay，参考样点写入后要经过 playback_delay 才被播放，
+        // 因此对应的参考信号位于写指针之前 capture_delay + playback_delay 处
+        long capture_delay = audio_backend_->GetCaptureDelay();
+        long playback_delay = audio_backend_->GetPlaybackDelay();
+        long delay = capture_delay * network_rate / static_cast<long>(capture_device_rate_) +
+                     playback_delay * network_rate / static_cast<long>(playback_device_rate_) -
+                     network_rate * kEchoDelayMarginMs / 1000;
+        delay = std::max(0L, std::min(delay, static_cast<long>(echo_reference_.Capacity() - frames)));
+        
+        // 设备延迟的读数有抖动，偏差持续超过2ms时才重新对齐，避免滤波器频繁失配
+        long tolerance = network_rate * 2 / 1000;
+        if (std::labs(delay - static_cast<long>(echo_delay_frames_)) > tolerance) {
+            if (++echo_delay_pending_ >= 5) {
+                echo_delay_frames_ = static_cast<size_t>(delay);
+                echo_delay_pending_ = 0;
+            }
+        } else {
+            echo_delay_pending_ = 0;
+        }
+    }
+    
+    // 流释放前把它的累计统计并入 retired_stream_totals_ (调用方持有 audio_queue_mutex_)
+    void RetireStream(const RemoteStream& stream) {
+        retired_stream_totals_.Add(stream);
+    }
+    
+    // 汇总所有远端流的统计 (音频线程，持有 audio_queue_mutex_)
+    void PublishStreamStats() {
+        StreamTotals totals = retired_stream_totals_;
+        double jitter = 0.0;
+        double rtt = 0.0;
+        size_t queued_frames = 0;
+        for (const auto& entry : remote_streams_) {
+            const RemoteStream& stream = *entry.second;
+            totals.Add(stream);
+            jitter = std::max(jitter, stream.GetJitterSeconds());
+            rtt = std::max(rtt, stream.GetRttSeconds());
+            queued_frames = std::max(queued_frames, stream.QueuedFrames());
+        }
+        SeqlockCounters<kAudioStatCount>& audio = stats_.Audio();
+        audio.BeginWrite();
+        audio.Set(kStatStreamPacketsLost, totals.lost);
+        audio.Set(kStatStreamPacketsRecovered, totals.recovered);
+        audio.Set(kStatStreamRetransmitsRecovered, totals.retransmits_recovered);
+        audio.Set(kStatStreamPacketsReordered, totals.reordered);
+        audio.Set(kStatStreamPacketsLate, totals.late);
+        audio.Set(kStatStreamQueueDrops, totals.queue_drops);
+        audio.Set(kStatStreamConcealedFrames, totals.concealed_frames);
+        audio.Set(kStatStreamAcceleratedFrames, totals.accelerated_frames);
+        audio.Set(kStatStreamDeceleratedFrames, totals.decelerated_frames);
+        audio.Set(kStatStreamNackRequests, totals.nack_requests);
+        audio.Set(kStatRemoteStreams, remote_streams_.size());
+        audio.Set(kStatJitterUs, static_cast<uint64_t>(jitter * 1e6));
+        audio.Set(kStatRttUs, static_cast<uint64_t>(rtt * 1e6));
+        audio.Set(kStatJitterBufferUs, queued_frames * 1000000ull / config_.audio_config.sample_rate);
+        audio.EndWrite();
+    }
+    
+    void CountPlaybackXrun(long error) {
+        if (error != -EPIPE) return;
+        stats_.Audio().BeginWrite();
+        stats_.Audio().Add(kStatPlaybackXruns, 1);
+        stats_.Audio().EndWrite();
     }
     
     float CalculateAudioLevel(const int16_t* audio_data, int samples) {
@@ -664,44 +1669,179 @@ private:
     
     voice_call_config_t config_;
     voice_call_callbacks_t callbacks_;
+    CallEnvironment* environment_;  // 时钟、传输与音频后端 (不拥有)
     std::atomic<voice_call_state_t> state_;
     std::atomic<bool> muted_;
     float mic_volume_;
     float speaker_volume_;
     
-    int socket_fd_;
-    struct sockaddr_in server_addr_;
+    std::unique_ptr<PacketTransport> transport_;
+    std::string server_name_;   // 服务器地址 (日志)
+    
+    std::unique_ptr<AudioBackend> audio_backend_;
+    AudioDeviceKeeper device_keeper_;   // 断开后保留的设备
+    std::string audio_device_key_;      // 当前设备的打开参数 (后端、采样率、声道数与格式)
+    unsigned int capture_device_rate_;
+    unsigned int playback_device_rate_;
+    PolyphaseResampler capture_resampler_;
+    PolyphaseResampler playback_resampler_;
+    
+    // 回声消除 (每个声道一个实例，仅在音频线程中使用)
+    std::vector<EchoCanceller> echo_cancellers_;
+    EchoReferenceBuffer echo_reference_;
+    size_t echo_delay_frames_;
+    int echo_delay_pending_;
+    std::vector<float> echo_far_;
     
-    snd_pcm_t* audio_capture_handle_;
-    snd_pcm_t* audio_playback_handle_;
+    // 噪声抑制 (每个声道一个实例，仅在音频线程中使用)
+    std::vector<NoiseSuppressor> noise_suppressors_;
+    
+    // 语音检测与自动增益 (仅在音频线程中使用)
+    VoiceActivityDetector vad_;
+    AutomaticGainControl agc_;
+    bool agc_enabled_;
+    float applied_mic_volume_;
+    std::vector<std::vector<float>> capture_planes_;
+    std::vector<float*> capture_plane_ptrs_;
+    const SampleConversion* capture_conversion_;
+    
+    // 音频负载加密 (发送部分只在音频线程中使用，接收部分只在网络线程中使用)
+    PayloadCrypto payload_crypto_;
+    
+    // 不连续发送 (仅在音频线程中使用)
+    bool dtx_enabled_;
+    bool dtx_active_;
+    ComfortNoiseEncoder comfort_noise_encoder_;
+    size_t dtx_frames_since_descriptor_;
+    float dtx_sent_level_db_;
+    uint64_t comfort_noise_packets_;
+    
+    // 包长与音频循环周期 (毫秒)，InitializeAudio 中由 audio_config.frame_size 确定
+    int packet_ms_;
+    int cycle_ms_;
     
     std::thread audio_thread_;
     std::thread network_thread_;
+    std::thread setup_thread_;  // 共享反应器模式下异步连接时打开音频设备
     std::atomic<bool> running_;
+    EventReactor* reactor_;     // 共享反应器模式下所属的反应器
+    CallScheduler* scheduler_;  // 环境提供调度器时注册到的调度器
+    std::atomic<bool> audio_ready_; // 音频设备已打开，音频周期与音频包的处理可以开始
+    double last_report_;        // 上次发送接收报告的时刻 (环境时钟)
+    
+    // 建立连接: JOIN 的重发状态只在网络线程/反应器线程中使用 (开始前由 Connect 设置)
+    double connect_start_;      // voice_call_connect 的时刻 (环境时钟)
+    double first_join_;         // 第一次发送 JOIN 的时刻
+    double last_join_;          // 最近一次发送 JOIN 的时刻
+    double next_join_;          // 没有收到 JOIN_OK 时下次重发的时刻
+    int join_retry_ms_;         // 下次重发之后的等待间隔
+    uint32_t join_attempts_;
+    // 建立耗时由设备与网络两侧分别填写，setup_mutex_ 保护
+    std::mutex setup_mutex_;
+    voice_call_setup_stats_t setup_stats_;
+    bool setup_joined_;
+    bool setup_reported_;
+    
+    // 音频循环的缓冲区与播放状态 (PrepareAudioLoop 中分配，仅在音频线程/反应器线程中使用)
+    struct AudioLoopState {
+        size_t capture_frames = 0;
+        size_t network_frames = 0;
+        size_t silence_frames = 0;
+        std::vector<int16_t> capture_buffer;
+        std::vector<int16_t> audio_buffer;
+        std::vector<int16_t> stream_buffer;
+        std::vector<int32_t> mix_buffer;
+        std::vector<int16_t> network_buffer;
+        std::vector<int16_t> playback_buffer;
+        std::vector<int16_t> silence_buffer;
+        bool playback_primed = false;
+        double last_tick = 0.0;    // 上个周期的时刻 (环境时钟)
+    };
+    AudioLoopState audio_loop_;
     
-    std::queue<AudioPacket> audio_queue_;
+    // 按发送者区分的接收流，由 audio_queue_mutex_ 保护
+    std::map<uint32_t, std::unique_ptr<RemoteStream>> remote_streams_;
     std::mutex audio_queue_mutex_;
+    // 已释放的远端流的累计统计 (同样由 audio_queue_mutex_ 保护)，汇总值不因流释放而减少
+    struct StreamTotals {
+        uint64_t lost = 0;
+        uint64_t recovered = 0;
+        uint64_t retransmits_recovered = 0;
+        uint64_t reordered = 0;
+        uint64_t late = 0;
+        uint64_t queue_drops = 0;
+        uint64_t concealed_frames = 0;
+        uint64_t accelerated_frames = 0;
+        uint64_t decelerated_frames = 0;
+        uint64_t nack_requests = 0;
+        
+        void Add(const RemoteStream& stream) {
+            lost += stream.GetPacketsLost();
+            recovered += stream.GetPacketsRecovered();
+            retransmits_recovered += stream.GetRetransmitsRecovered();
+            reordered += stream.GetPacketsReordered();
+            late += stream.GetPacketsLate();
+            queue_drops += stream.GetQueueDrops();
+            concealed_frames += stream.GetConcealedFrames();
+            accelerated_frames += stream.GetAcceleratedFrames();
+            decelerated_frames += stream.GetDeceleratedFrames();
+            nack_requests += stream.GetNackRequests();
+        }
+    };
+    StreamTotals retired_stream_totals_;
+    // 通话统计 (音频线程与网络线程无锁写入，voice_call_get_stats 读取快照)
+    CallStats stats_;
     
     std::atomic<uint32_t> sequence_;
+    
+    // 前向纠错: 编码器仅在音频线程中使用，控制器由网络线程的接收报告更新
+    FecEncoder fec_encoder_;
+    FecController fec_controller_;
+    // 码率控制: 控制器由网络线程的接收报告更新，编码方式只在音频线程中使用
+    RateController rate_controller_;
+    std::mutex feedback_mutex_;
+    EncodingMode encoding_;
+    std::vector<int16_t> packet_pcm_;   // 当前包已累积的采集帧
+    size_t packet_capture_frames_;      // 当前包已累积的音频周期数
+    uint32_t packet_timestamp_;         // 当前包第一帧的媒体时间戳
+    bool packet_traced_;                // 当前包被选中追踪 (frame_trace.h)
+    uint32_t trace_counter_;            // 追踪采样的帧计数
+    std::vector<uint8_t> frame_payload_; // 需要分片的整帧负载
+    
+    // 最近发送的包 (音频线程写入，网络线程按NACK重传)
+    struct SentPacket {
+        AudioPacket packet;
+        size_t size = 0;
+        double last_retransmit = -1.0;
+    };
+    std::vector<SentPacket> send_history_;
+    std::mutex send_history_mutex_;
+    std::atomic<uint32_t> local_id_;       // 服务器分配的会话ID (主机字节序)，网络线程收到 JOIN_OK 时写入
+    uint32_t media_timestamp_;  // 发送端媒体时间戳 (网络采样率下的采样帧)
 };
 
-// C API实现
-extern "C" {
-
-voice_call_handle_t voice_call_init(const voice_call_config_t* config, 
-                                   const voice_call_callbacks_t* callbacks) {
-    if (!config || !callbacks) {
+voice_call_handle_t CreateVoiceCall(const voice_call_config_t* config, const voice_call_callbacks_t* callbacks,
+                                    CallEnvironment* environment) {
+    if (!config || !callbacks || !environment) {
         return nullptr;
     }
     
     try {
-        return new UDPVoiceCallImpl(config, callbacks);
+        return new UDPVoiceCallImpl(config, callbacks, environment);
     } catch (const std::exception& e) {
         std::cerr << "Failed to create UDPVoiceCallImpl: " << e.what() << std::endl;
         return nullptr;
     }
 }
 
+// C API实现
+extern "C" {
+
+voice_call_handle_t voice_call_init(const voice_call_config_t* config, 
+                                   const voice_call_callbacks_t* callbacks) {
+    return CreateVoiceCall(config, callbacks, &DefaultCallEnvironment());
+}
+
 voice_call_error_t voice_call_connect(voice_call_handle_t handle) {
     if (!handle) {
         return VOICE_CALL_ERROR_INVALID_PARAM;
@@ -720,6 +1860,15 @@ voice_call_error_t voice_call_disconnect(voice_call_handle_t handle) {
     return impl->Disconnect();
 }
 
+voice_call_error_t voice_call_switch_room(voice_call_handle_t handle, const char* room_id) {
+    if (!handle || !room_id) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    
+    UDPVoiceCallImpl* impl = static_cast<UDPVoiceCallImpl*>(handle);
+    return impl->SwitchRoom(room_id);
+}
+
 voice_call_state_t voice_call_get_state(voice_call_handle_t handle) {
     if (!handle) {
         return VOICE_CALL_STATE_ERROR;
@@ -777,6 +1926,15 @@ bool voice_call_is_muted(voice_call_handle_t handle) {
     return impl->IsMuted();
 }
 
+voice_call_error_t voice_call_get_stats(voice_call_handle_t handle, voice_call_stats_t* stats) {
+    if (!handle || !stats) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    
+    UDPVoiceCallImpl* impl = static_cast<UDPVoiceCallImpl*>(handle);
+    return impl->GetStats(stats);
+}
+
 void voice_call_destroy(voice_call_handle_t handle) {
     if (handle) {
         UDPVoiceCallImpl* impl = static_cast<UDPVoiceCallImpl*>(handle);
@@ -784,6 +1942,21 @@ void voice_call_destroy(voice_call_handle_t handle) {
     }
 }
 
+voice_call_error_t voice_call_trace_start(uint32_t sample_interval) {
+    if (sample_interval == 0) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    FrameTracer::Instance().Start(sample_interval);
+    return VOICE_CALL_SUCCESS;
+}
+
+voice_call_error_t voice_call_trace_stop(const char* path) {
+    if (!path) {
+        return VOICE_CALL_ERROR_INVALID_PARAM;
+    }
+    return FrameTracer::Instance().Stop(path) ? VOICE_CALL_SUCCESS : VOICE_CALL_ERROR_INVALID_PARAM;
+}
+
 const char* voice_call_get_version(void) {
     return "1.0.0 (UDP Audio)";
 }
@@ -0,0 +1,125 @@
+#include "voice_activity_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "audio_kernels.h"
+
+namespace {
+
+// 帧电平高出噪声电平该值 (dB) 时判为语音
+const float kSpeechThresholdDb = 9.0f;
+// 高出噪声电平该值 (dB) 时不再检查频谱
+const float kStrongSpeechDb = 20.0f;
+// 频谱平坦度低于该值时认为有语音的谐波/共振峰结构 (白噪声约0.56)
+const float kFlatnessThreshold = 0.45f;
+// 平坦度统计的频段 (Hz)
+const float kFlatnessLowHz = 100.0f;
+const float kFlatnessHighHz = 4000.0f;
+// 低于该电平 (dBFS) 的帧一律视为静音
+const float kAbsoluteFloorDb = -55.0f;
+// 噪声电平上升速度 (dB/秒)
+const float kNoiseRiseDbPerSecond = 2.0f;
+// 语音拖尾时长 (毫秒)
+const int kHangoverMs = 200;
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector()
+    : low_bin_(0)
+    , high_bin_(0)
+    , noise_rise_db_(0.0f)
+    , hangover_frames_(0)
+    , hangover_left_(0)
+    , initialized_(false)
+    , speech_(false)
+    , level_db_(-100.0f)
+    , noise_db_(-100.0f)
+    , flatness_(1.0f) {
+}
+
+void VoiceActivityDetector::Configure(int sample_rate, size_t frame_frames) {
+    double frame_seconds = sample_rate > 0 ? static_cast<double>(frame_frames) / sample_rate : 0.02;
+    noise_rise_db_ = static_cast<float>(kNoiseRiseDbPerSecond * frame_seconds);
+    hangover_frames_ = std::max(1, static_cast<int>(kHangoverMs / 1000.0 / frame_seconds + 0.5));
+
+    // 频谱分析取不超过帧长的最大2的幂，使用帧末尾的样点
+    size_t n = 1;
+    while (n * 2 <= frame_frames) {
+        n *= 2;
+    }
+    fft_.reset();
+    if (n >= 64 && sample_rate > 0) {
+        fft_.reset(new RealFft(n));
+        window_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            window_[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / n);
+        }
+        time_buf_.assign(n, 0.0f);
+        re_.assign(fft_->Bins(), 0.0f);
+        im_.assign(fft_->Bins(), 0.0f);
+        low_bin_ = std::max<size_t>(1, static_cast<size_t>(kFlatnessLowHz * n / sample_rate));
+        high_bin_ = std::min(fft_->Bins() - 1, static_cast<size_t>(kFlatnessHighHz * n / sample_rate));
+    }
+    Reset();
+}
+
+void VoiceActivityDetector::Reset() {
+    hangover_left_ = 0;
+    initialized_ = false;
+    speech_ = false;
+    level_db_ = -100.0f;
+    noise_db_ = -100.0f;
+    flatness_ = 1.0f;
+}
+
+bool VoiceActivityDetector::Process(const float* samples, size_t frames) {
+    if (frames == 0) return speech_;
+    float energy = audio_kernels::DotProduct(samples, samples, frames) / static_cast<float>(frames);
+    level_db_ = 10.0f * std::log10(energy + 1e-10f);
+
+    if (!initialized_) {
+        noise_db_ = level_db_;
+        initialized_ = true;
+    } else if (level_db_ < noise_db_) {
+        noise_db_ = level_db_;
+    } else {
+        noise_db_ = std::min(level_db_, noise_db_ + noise_rise_db_);
+    }
+
+    bool active = level_db_ > kAbsoluteFloorDb && level_db_ > noise_db_ + kSpeechThresholdDb;
+    if (active && level_db_ < noise_db_ + kStrongSpeechDb) {
+        flatness_ = SpectralFlatness(samples, frames);
+        active = flatness_ < kFlatnessThreshold;
+    }
+    if (active) {
+        hangover_left_ = hangover_frames_;
+    } else if (hangover_left_ > 0) {
+        --hangover_left_;
+    }
+    speech_ = active || hangover_left_ > 0;
+    return speech_;
+}
+
+float VoiceActivityDetector::SpectralFlatness(const float* samples, size_t frames) {
+    if (!fft_ || frames < time_buf_.size() || high_bin_ <= low_bin_) {
+        return 0.0f;
+    }
+    const size_t n = time_buf_.size();
+    const float* tail = samples + frames - n;
+    for (size_t i = 0; i < n; ++i) {
+        time_buf_[i] = tail[i] * window_[i];
+    }
+    fft_->Forward(time_buf_.data(), re_.data(), im_.data());
+
+    // 几何平均 / 算术平均
+    double log_sum = 0.0;
+    double sum = 0.0;
+    for (size_t k = low_bin_; k <= high_bin_; ++k) {
+        double power = re_[k] * re_[k] + im_[k] * im_[k] + 1e-12;
+        log_sum += std::log(power);
+        sum += power;
+    }
+    double count = static_cast<double>(high_bin_ - low_bin_ + 1);
+    return static_cast<float>(std::exp(log_sum / count) / (sum / count));
+}
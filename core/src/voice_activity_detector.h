@@ -0,0 +1,51 @@
+#ifndef VOICE_ACTIVITY_DETECTOR_H
+#define VOICE_ACTIVITY_DETECTOR_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+
+// 基于能量与频谱平坦度的语音活动检测
+// 跟踪背景噪声电平 (快降慢升)，帧电平高出噪声电平一定门限且高于绝对下限、
+// 并且频谱有明显结构 (平坦度低，区别于类白噪声的突发) 时判为语音；远高于噪声的帧直接判为语音。
+// 语音结束后保持一段拖尾时间，避免字尾被截断
+class VoiceActivityDetector {
+public:
+    VoiceActivityDetector();
+
+    void Configure(int sample_rate, size_t frame_frames);
+    void Reset();
+
+    // 处理一帧单声道信号，返回该帧 (含拖尾) 是否为语音
+    bool Process(const float* samples, size_t frames);
+
+    bool IsSpeech() const { return speech_; }
+    // 最近一帧的电平与噪声电平估计 (dBFS)
+    float GetLevelDb() const { return level_db_; }
+    float GetNoiseLevelDb() const { return noise_db_; }
+    // 最近一次计算的语音频段 (约100Hz~4kHz) 频谱平坦度 (0~1)，仅在能量判决不确定时计算
+    float GetSpectralFlatness() const { return flatness_; }
+
+private:
+    float SpectralFlatness(const float* samples, size_t frames);
+
+    std::unique_ptr<RealFft> fft_;
+    std::vector<float> window_;
+    std::vector<float> time_buf_;
+    std::vector<float> re_, im_;
+    size_t low_bin_;
+    size_t high_bin_;
+
+    float noise_rise_db_;      // 每帧噪声电平的最大上升量
+    int hangover_frames_;
+    int hangover_left_;
+    bool initialized_;
+    bool speech_;
+    float level_db_;
+    float noise_db_;
+    float flatness_;
+};
+
+#endif // VOICE_ACTIVITY_DETECTOR_H
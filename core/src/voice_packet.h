@@ -0,0 +1,98 @@
+#ifndef VOICE_PACKET_H
+#define VOICE_PACKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 负载类型
+const uint8_t kPayloadTypePcm16 = 0;          // 交错的16位PCM
+const uint8_t kPayloadTypeComfortNoise = 1;   // 舒适噪声描述符 (见 comfort_noise.h)
+const uint8_t kPayloadTypePcm16Redundant = 2; // PCM16 + 前几帧的低码率冗余副本 (见 audio_fec.h)
+const uint8_t kPayloadTypeReceiverReport = 3; // 接收报告，data 为 ReceiverReportBlock 数组
+const uint8_t kPayloadTypeNack = 4;           // 重传请求，data 为 NackBlock 数组
+const uint8_t kPayloadTypeAdpcm = 5;          // IMA ADPCM (见 ima_adpcm.h)，码率受限时使用
+const uint8_t kPayloadTypeAdpcmRedundant = 6; // ADPCM + 前几帧的冗余副本，格式同类型2
+
+// 标志位
+const uint8_t kPacketFlagRetransmit = 0x01;   // 响应NACK的重传包，序列号、时间戳与负载与原包相同
+const uint8_t kPacketFlagFragment = 0x02;     // 分片，data 以 FragmentHeader 开头 (见下)
+const uint8_t kPacketFlagTraced = 0x04;       // 发送端选中追踪的帧 (分片的帧只标在第一个分片)，见 frame_trace.h
+const uint8_t kPacketFlagEncrypted = 0x08;    // 负载已加密，data 末尾为密钥纪元与认证标签，见 payload_crypto.h
+
+// 音频包结构 (所有字段为网络字节序)
+// timestamp 为媒体时间戳，单位为网络采样率下的采样帧，每个包递增该包包含的帧数，
+// 32位回绕，接收端需要展开后使用。静音期间 (DTX) 不发送PCM，只周期性发送舒适噪声描述符，
+// 时间戳照常前进。
+// 负载上限加上包头与IPv4/IPv6、UDP头不超过以太网MTU (1500字节)，16kHz单声道40ms的PCM可以放进一个包。
+// session_id 为服务器在 JOIN_OK 中分配的会话ID (服务器会话表的下标)，服务器按它直接索引发送者并核对源地址
+struct AudioPacket {
+    uint32_t sequence;
+    uint32_t timestamp;
+    uint32_t session_id;
+    uint16_t data_size;
+    uint8_t payload_type;
+    uint8_t flags;            // kPacketFlag* 标志位 (同时使负载按2字节对齐)
+    uint8_t data[1400];
+} __attribute__((packed));
+
+// 接收报告块: 报告者对某个发送者的接收统计 (网络字节序)
+// 接收报告不占用发送者的音频序列号空间，由服务器像音频包一样转发给房间内其他成员，
+// 被报告的发送者按 source_id 取出属于自己的块，用于选择冗余深度和码率
+struct ReceiverReportBlock {
+    uint32_t source_id;       // 被报告的发送者的会话ID
+    uint8_t fraction_lost;    // 上个报告周期内的丢包率 (x/256，FEC恢复之前)
+    uint32_t highest_sequence; // 收到的最高序列号
+    uint32_t jitter;          // 到达间隔抖动 (RFC 3550，采样帧)
+    uint32_t transit;         // 本周期平均相对传输时延 (到达时间 - 包内最后一帧的媒体时间，微秒，32位回绕)，
+                              // 绝对值含两端时钟偏差没有意义，发送端只使用其变化量
+} __attribute__((packed));
+
+// 重传请求块 (与 RFC 4585 的通用NACK类似，网络字节序)
+// 请求 source_id 发送者的 sequence 包，以及 bitmask 第i位为1时的 sequence+i+1 包。
+// 服务器先从自己缓存的最近包中应答，缓存未命中的部分转发给发送者本人
+struct NackBlock {
+    uint32_t source_id;
+    uint32_t sequence;
+    uint16_t bitmask;
+} __attribute__((packed));
+
+// 加密负载的尾部: 密钥纪元 (4字节) + 认证标签 (16字节)。
+// 编码与分片的负载上限为 kMaxPayloadSize，无论是否加密都留出尾部，编码方式与分片不随加密改变
+const size_t kPayloadCryptoTrailerSize = 20;
+const size_t kMaxPayloadSize = sizeof(AudioPacket::data) - kPayloadCryptoTrailerSize;
+
+// 收到 JOIN_OK 之前没有会话ID，此时不发送音频与控制包
+const uint32_t kUnassignedSessionId = 0xFFFFFFFF;
+
+// 包头大小
+const size_t kAudioPacketHeaderSize = sizeof(AudioPacket) - sizeof(AudioPacket::data);
+
+// 分片头 (网络字节序)
+// 负载超过一个包 (kMaxPayloadSize) 的帧 (例如48kHz、立体声或60ms的PCM) 拆成若干分片，
+// 每个分片占一个序列号，连续发送；时间戳与负载类型与整帧相同。
+// 丢包统计、NACK重传和服务器缓存都按分片进行，接收端收齐后拼接解码。
+// 分片的负载不附加冗余副本 (冗余块按序列号恢复整帧，只用于单包的帧)
+struct FragmentHeader {
+    uint8_t index;            // 分片序号，从0开始
+    uint8_t count;            // 整帧的分片数
+    uint16_t frames;          // 整帧的音频帧数
+} __attribute__((packed));
+
+// 一帧最多的分片数与整帧负载上限
+const size_t kMaxFrameFragments = 16;
+const size_t kFragmentPayloadSize = kMaxPayloadSize - sizeof(FragmentHeader);
+const size_t kMaxFramePayload = kMaxFrameFragments * kFragmentPayloadSize;
+
+// 单独的包头，与 AudioPacket 的前几个字段布局相同
+struct AudioPacketHeader {
+    uint32_t sequence;
+    uint32_t timestamp;
+    uint32_t session_id;
+    uint16_t data_size;
+    uint8_t payload_type;
+    uint8_t flags;
+} __attribute__((packed));
+
+static_assert(sizeof(AudioPacketHeader) == kAudioPacketHeaderSize, "AudioPacketHeader must match AudioPacket");
+
+#endif // VOICE_PACKET_H
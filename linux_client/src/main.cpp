@@ -27,6 +27,14 @@ std::string g_server_ip = "127.0.0.1";
 int g_server_port = 8080;
 std::string g_room_id = "test_room";
 std::string g_user_id = generate_random_user_id();
+std::string g_audio_backend;  // 为空时由库读取环境变量 VOICE_CALL_AUDIO_BACKEND，默认 ALSA
+int g_frame_size = 20;        // 包长 (毫秒)
+int g_realtime_priority = 0;  // 音频线程的 SCHED_FIFO 优先级，0 表示默认调度
+bool g_lock_memory = false;
+std::string g_trace_file;     // 非空时开启帧级追踪，退出时导出到该文件
+int g_trace_sample = 10;      // 追踪采样间隔 (帧)
+std::string g_media_key;      // 房间密钥 (十六进制)，为空时不加密
+bool g_async_connect = true;  // 设备打开与 JOIN 握手并行，收到 JOIN_OK 后才显示已连接
 
 // 显示使用帮助
 void show_usage(const char* program_name) {
@@ -37,10 +45,22 @@ void show_usage(const char* program_name) {
     std::cout << "  -p, --port <PORT>       设置服务器端口 (默认: 8080)" << std::endl;
     std::cout << "  -r, --room <ROOM_ID>    设置房间ID (默认: test_room)" << std::endl;
     std::cout << "  -u, --user <USER_ID>    设置用户ID (默认: linux_user)" << std::endl;
+    std::cout << "  -a, --audio <BACKEND>   设置音频后端: alsa, alsa:rw, null, loopback, file:<输入>[,<输出>] (默认: alsa)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>   设置包长: 10, 20, 40, 60 (默认: 20)" << std::endl;
+    std::cout << "      --realtime <PRIO>   音频与网络线程使用 SCHED_FIFO 实时调度，优先级 1-99 (需要 CAP_SYS_NICE)" << std::endl;
+    std::cout << "      --lock-memory       锁定进程内存，避免通话中缺页 (需要 CAP_IPC_LOCK)" << std::endl;
+    std::cout << "      --trace <FILE>      帧级追踪，退出时导出 Chrome trace JSON" << std::endl;
+    std::cout << "      --trace-sample <N>  每 N 帧追踪一帧 (默认: 10)" << std::endl;
+    std::cout << "  -k, --media-key <HEX>   房间密钥 (32或64个十六进制字符)，加密音频负载，房间内所有成员需使用同一密钥" << std::endl;
+    std::cout << "      --sync-connect      打开音频设备后再发送 JOIN，不等待服务器应答即显示已连接" << std::endl;
     std::cout << std::endl;
     std::cout << "示例:" << std::endl;
     std::cout << "  " << program_name << " -s 192.168.1.100 -p 8080" << std::endl;
     std::cout << "  " << program_name << " --server 10.0.0.5 --port 9000 --room my_room --user alice" << std::endl;
+    std::cout << "  " << program_name << " --audio file:speech.wav,received.wav" << std::endl;
+    std::cout << "  " << program_name << " --realtime 50 --lock-memory" << std::endl;
+    std::cout << "  " << program_name << " --trace client.json --trace-sample 1" << std::endl;
+    std::cout << "  " << program_name << " --media-key $(openssl rand -hex 16)" << std::endl;
 }
 
 // 解析命令行参数
@@ -88,6 +108,80 @@ bool parse_arguments(int argc, char* argv[]) {
                 return false;
             }
         }
+        else if (arg == "-a" || arg == "--audio") {
+            if (i + 1 < argc) {
+                g_audio_backend = argv[++i];
+                if (g_audio_backend.size() >= sizeof(voice_call_config_t::audio_backend)) {
+                    std::cerr << "错误: 音频后端描述过长" << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "错误: --audio 需要指定音频后端" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-f" || arg == "--frame-size") {
+            if (i + 1 < argc) {
+                g_frame_size = std::atoi(argv[++i]);
+                if (g_frame_size != 10 && g_frame_size != 20 && g_frame_size != 40 && g_frame_size != 60) {
+                    std::cerr << "错误: 包长必须为 10, 20, 40 或 60 毫秒" << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "错误: --frame-size 需要指定包长" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--realtime") {
+            if (i + 1 < argc) {
+                g_realtime_priority = std::atoi(argv[++i]);
+                if (g_realtime_priority < 1 || g_realtime_priority > 99) {
+                    std::cerr << "错误: 实时优先级必须在 1-99 之间" << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "错误: --realtime 需要指定优先级" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--lock-memory") {
+            g_lock_memory = true;
+        }
+        else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                g_trace_file = argv[++i];
+            } else {
+                std::cerr << "错误: --trace 需要指定输出文件" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--trace-sample") {
+            if (i + 1 < argc) {
+                g_trace_sample = std::atoi(argv[++i]);
+                if (g_trace_sample < 1) {
+                    std::cerr << "错误: 追踪采样间隔必须大于0" << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "错误: --trace-sample 需要指定采样间隔" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-k" || arg == "--media-key") {
+            if (i + 1 < argc) {
+                g_media_key = argv[++i];
+                if (g_media_key.size() != 32 && g_media_key.size() != 64) {
+                    std::cerr << "错误: 房间密钥必须为32或64个十六进制字符" << std::endl;
+                    return false;
+                }
+            } else {
+                std::cerr << "错误: --media-key 需要指定密钥" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--sync-connect") {
+            g_async_connect = false;
+        }
         else {
             std::cerr << "错误: 未知参数 " << arg << std::endl;
             show_usage(argv[0]);
@@ -129,6 +223,13 @@ void on_state_changed(voice_call_state_t state, const char* reason) {
     std::cout << std::endl;
 }
 
+// 通话建立耗时回调
+void on_setup_complete(const voice_call_setup_stats_t* stats) {
+    std::cout << "通话建立耗时: " << stats->total_ms << "ms (音频设备 " << stats->audio_open_ms << "ms, 服务器应答 "
+              << stats->join_ms << "ms, JOIN 发送 " << stats->join_attempts << " 次"
+              << (stats->overlapped ? "，两者并行" : "") << ")" << std::endl;
+}
+
 // 用户加入回调
 void on_peer_joined(const char* peer_id) {
     std::cout << "用户加入: " << peer_id << std::endl;
@@ -170,6 +271,9 @@ void on_error(voice_call_error_t error, const char* message) {
         case VOICE_CALL_ERROR_ALREADY_IN_CALL:
             std::cout << "已在通话中";
             break;
+        case VOICE_CALL_ERROR_NOT_SUPPORTED:
+            std::cout << "不支持的操作";
+            break;
         default:
             std::cout << "未知错误";
             break;
@@ -188,6 +292,7 @@ void show_help() {
     std::cout << "  disconnect  - 断开连接" << std::endl;
     std::cout << "  mute        - 静音/取消静音" << std::endl;
     std::cout << "  volume      - 设置音量" << std::endl;
+    std::cout << "  room        - 切换房间 (保留音频设备)" << std::endl;
     std::cout << "  status      - 显示状态" << std::endl;
     std::cout << "  help        - 显示帮助" << std::endl;
     std::cout << "  quit        - 退出程序" << std::endl;
@@ -216,6 +321,22 @@ void handle_volume_command() {
     std::cout << "扬声器音量已设置为: " << volume << std::endl;
 }
 
+// 处理切换房间命令
+void handle_room_command() {
+    std::cout << "新房间ID: ";
+    std::string room_id;
+    if (!std::getline(std::cin, room_id) || room_id.empty()) {
+        std::cout << "无效的房间ID" << std::endl;
+        return;
+    }
+    
+    if (voice_call_switch_room(g_voice_call, room_id.c_str()) == VOICE_CALL_SUCCESS) {
+        std::cout << "已切换到房间: " << room_id << std::endl;
+    } else {
+        std::cout << "切换房间失败" << std::endl;
+    }
+}
+
 // 显示状态信息
 void show_status() {
     if (!g_voice_call) {
@@ -247,6 +368,23 @@ void show_status() {
     }
     std::cout << std::endl;
     std::cout << "  静音状态: " << (muted ? "已静音" : "未静音") << std::endl;
+    
+    voice_call_stats_t stats;
+    if (voice_call_get_stats(g_voice_call, &stats) == VOICE_CALL_SUCCESS) {
+        std::cout << "  发送: " << stats.packets_sent << " 包 / " << stats.bytes_sent << " 字节"
+                  << ", 码率 " << stats.send_bitrate << " bps (目标 " << stats.target_bitrate << ")"
+                  << ", 冗余深度 " << stats.fec_depth << ", 重传 " << stats.retransmits_sent << std::endl;
+        std::cout << "  接收: " << stats.packets_received << " 包 / " << stats.bytes_received << " 字节"
+                  << ", 丢失 " << stats.packets_lost << ", 恢复 " << stats.packets_recovered
+                  << " (重传 " << stats.retransmits_recovered << ")"
+                  << ", 乱序 " << stats.packets_reordered << ", 迟到 " << stats.packets_late
+                  << ", 认证失败 " << stats.decrypt_failures << std::endl;
+        std::cout << "  抖动: " << stats.jitter_ms << "ms, 往返时延: " << stats.rtt_ms
+                  << "ms, 抖动缓冲: " << stats.jitter_buffer_ms << "ms, 远端流: " << stats.remote_streams << std::endl;
+        std::cout << "  欠载/溢出: 采集 " << stats.capture_xruns << ", 播放 " << stats.playback_xruns
+                  << ", 丢帧补偿 " << stats.concealed_frames << " 帧"
+                  << ", 快放/慢放 " << stats.accelerated_frames << "/" << stats.decelerated_frames << " 帧" << std::endl;
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -272,15 +410,25 @@ int main(int argc, char* argv[]) {
     strcpy(config.server_url, server_url.c_str());
     strcpy(config.room_id, g_room_id.c_str());
     strcpy(config.user_id, g_user_id.c_str());
+    strcpy(config.audio_backend, g_audio_backend.c_str());
     
     config.audio_config.sample_rate = 16000;  // 16kHz 对语音通话更合适
     config.audio_config.channels = 1;
     config.audio_config.bits_per_sample = 16;
-    config.audio_config.frame_size = 20;
+    config.audio_config.frame_size = g_frame_size;
     
     config.enable_echo_cancellation = true;
     config.enable_noise_suppression = true;
     config.enable_automatic_gain_control = true;
+    config.enable_dtx = true;
+    
+    if (g_realtime_priority > 0) {
+        config.sched_policy = VOICE_CALL_SCHED_FIFO;
+        config.sched_priority = g_realtime_priority;
+    }
+    config.lock_memory = g_lock_memory;
+    strcpy(config.media_key, g_media_key.c_str());
+    config.async_connect = g_async_connect;
     
     // 设置回调函数
     voice_call_callbacks_t callbacks = {};
@@ -289,6 +437,11 @@ int main(int argc, char* argv[]) {
     callbacks.on_peer_left = on_peer_left;
     callbacks.on_audio_level = on_audio_level;
     callbacks.on_error = on_error;
+    callbacks.on_setup_complete = on_setup_complete;
+    
+    if (!g_trace_file.empty()) {
+        voice_call_trace_start(static_cast<uint32_t>(g_trace_sample));
+    }
     
     // 初始化语音通话
     g_voice_call = voice_call_init(&config, &callbacks);
@@ -358,6 +511,9 @@ int main(int argc, char* argv[]) {
         else if (command == "volume") {
             handle_volume_command();
         }
+        else if (command == "room") {
+            handle_room_command();
+        }
         else if (command == "status") {
             show_status();
         }
@@ -378,6 +534,9 @@ int main(int argc, char* argv[]) {
         voice_call_disconnect(g_voice_call);
         voice_call_destroy(g_voice_call);
     }
+    if (!g_trace_file.empty()) {
+        voice_call_trace_stop(g_trace_file.c_str());
+    }
     
     std::cout << "程序已退出" << std::endl;
     return 0;
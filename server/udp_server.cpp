@@ -1,17 +1,21 @@
 #include <iostream>
+#include <algorithm>
+#include <deque>
 #include <map>
-#include <set>
 #include <string>
 #include <thread>
 #include <atomic>
 #include <memory>
 #include <vector>
+#include <fstream>
 #include <sys/socket.h>
+#include <sys/syscall.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
 #include <cstdlib>
+#include <chrono>
 
 // ============================================================================
 // 配置类 - 管理服务器配置
@@ -20,58 +24,138 @@ class ServerConfig {
 public:
     std::string bind_ip = "0.0.0.0";
     int port = 8080;
+    std::string trace_file;   // 非空时记录帧追踪事件，停止时导出到该文件
     
     static ServerConfig parseCommandLine(int argc, char* argv[]);
     void showUsage(const char* program_name) const;
 };
 
+// ============================================================================
+// 包缓存类 - 保存一个发送者最近转发的音频包，用于应答重传请求 (NACK)
+// ============================================================================
+class PacketCache {
+public:
+    // 缓存的包数，20ms一包约1.3秒
+    static const size_t kCacheSize = 64;
+    
+    // 记录一个转发的音频包 (原始字节)
+    void store(uint32_t sequence, const char* data, int length);
+    
+    // 查找缓存的包，找不到返回nullptr
+    const std::vector<char>* find(uint32_t sequence) const;
+    
+private:
+    struct Entry {
+        uint32_t sequence = 0;
+        std::vector<char> data;
+    };
+    std::vector<Entry> entries_;
+};
+
+// ============================================================================
+// 帧追踪类 - 记录客户端选中追踪的音频包 (flags 带追踪标志) 的收发时间，停止时导出 Chrome trace JSON。
+// 事件格式与客户端库导出的相同 (core/src/frame_trace.cpp)，追踪ID为 (会话ID, 媒体时间戳)，
+// 时间为 CLOCK_REALTIME 微秒，用 trace_merge 与客户端的文件合并到同一时间轴
+// ============================================================================
+class FrameTracer {
+public:
+    // 追踪标志位 (flags字节)
+    static const uint8_t kTracedFlag = 0x04;
+    // 阶段编号与客户端一致
+    enum Stage { kServerRx = 3, kServerTx = 4 };
+    // 最多记录的事件数 (约24MB)，超过后丢弃
+    static const size_t kMaxEvents = 1 << 20;
+    
+    // 记录一个事件 (只在服务器线程中调用)
+    void record(Stage stage, uint32_t session_id, uint32_t timestamp);
+    
+    // 导出到文件 (服务器线程停止后调用)
+    bool save(const std::string& path) const;
+    
+private:
+    struct Event {
+        int64_t time_us;
+        uint32_t session_id;
+        uint32_t timestamp;
+        Stage stage;
+    };
+    std::vector<Event> events_;
+    int tid_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+// ============================================================================
+// 房间 - 成员按会话ID保存，转发时直接索引会话表
+// ============================================================================
+struct Room {
+    std::string room_id;
+    std::vector<uint32_t> members;
+};
+
 // ============================================================================
 // 客户端信息类 - 存储客户端状态
 // ============================================================================
 class ClientInfo {
 public:
+    uint32_t session_id;
     std::string user_id;
     std::string room_id;
     struct sockaddr_in address;
+    std::shared_ptr<Room> room;
+    PacketCache packet_cache;
     
-    ClientInfo(const std::string& uid, const std::string& rid, const struct sockaddr_in& addr)
-        : user_id(uid), room_id(rid), address(addr) {}
+    ClientInfo(uint32_t sid, const std::string& uid, const std::string& rid, const struct sockaddr_in& addr)
+        : session_id(sid), user_id(uid), room_id(rid), address(addr) {}
     
-    std::string getKey() const {
-        return std::string(inet_ntoa(address.sin_addr)) + ":" + std::to_string(ntohs(address.sin_port));
+    bool hasAddress(const struct sockaddr_in& addr) const {
+        return address.sin_addr.s_addr == addr.sin_addr.s_addr && address.sin_port == addr.sin_port;
     }
 };
 
 // ============================================================================
 // 房间管理类 - 管理房间和用户
+// 每个加入的客户端分配一个紧凑的会话ID (会话表的下标)，在 JOIN_OK 中返回，客户端在每个包头中携带。
+// 转发路径按会话ID直接索引并核对源地址，不构造字符串也不查找映射表
 // ============================================================================
 class RoomManager {
 private:
-    std::map<std::string, std::set<std::string>> rooms_;  // room_id -> set of client_keys
-    std::map<std::string, std::shared_ptr<ClientInfo>> clients_;  // client_key -> ClientInfo
+    std::map<std::string, std::shared_ptr<Room>> rooms_;  // room_id -> 房间
+    std::vector<std::shared_ptr<ClientInfo>> sessions_;   // 会话ID -> 客户端，空位为nullptr
+    std::deque<uint32_t> free_sessions_;                  // 释放的会话ID，按释放顺序复用 (尽量推迟复用)
+    std::map<uint64_t, uint32_t> addresses_;              // 源地址 -> 会话ID (只用于 JOIN/LEAVE)
+    
+    static uint64_t addressKey(const struct sockaddr_in& address) {
+        return (static_cast<uint64_t>(address.sin_addr.s_addr) << 16) | address.sin_port;
+    }
     
 public:
-    // 添加用户到房间
-    bool addUserToRoom(const std::string& client_key, const std::string& user_id, 
-                      const std::string& room_id, const struct sockaddr_in& address);
+    // 添加用户到房间，返回新分配的会话
+    ClientInfo* addUserToRoom(const std::string& user_id, const std::string& room_id,
+                              const struct sockaddr_in& address);
     
-    // 从房间移除用户
-    bool removeUserFromRoom(const std::string& client_key, const std::string& room_id);
+    // 从房间移除地址对应的用户，返回被移除的会话 (不存在时返回nullptr)
+    std::shared_ptr<ClientInfo> removeUser(const struct sockaddr_in& address);
     
-    // 获取用户所在房间
-    std::string getUserRoom(const std::string& client_key) const;
+    // 按源地址查找会话 (控制消息使用)
+    ClientInfo* findByAddress(const struct sockaddr_in& address) const;
     
-    // 获取房间内的所有客户端
-    std::vector<std::shared_ptr<ClientInfo>> getRoomClients(const std::string& room_id) const;
+    // 按会话ID查找，源地址不一致时返回nullptr (转发路径)
+    ClientInfo* findSession(uint32_t session_id, const struct sockaddr_in& address) const {
+        if (session_id >= sessions_.size()) return nullptr;
+        ClientInfo* client = sessions_[session_id].get();
+        return client && client->hasAddress(address) ? client : nullptr;
+    }
     
-    // 检查用户是否在房间中
-    bool isUserInRoom(const std::string& client_key, const std::string& room_id) const;
+    // 按会话ID查找，不核对地址
+    ClientInfo* getSession(uint32_t session_id) const {
+        return session_id < sessions_.size() ? sessions_[session_id].get() : nullptr;
+    }
     
     // 获取房间数量
     size_t getRoomCount() const { return rooms_.size(); }
     
     // 获取客户端数量
-    size_t getClientCount() const { return clients_.size(); }
+    size_t getClientCount() const { return addresses_.size(); }
 };
 
 // ============================================================================
@@ -81,9 +165,13 @@ class MessageHandler {
 private:
     RoomManager& room_manager_;
     int server_fd_;
+    FrameTracer* tracer_;     // 未开启追踪时为nullptr
+    uint64_t nack_cache_hits_ = 0;
+    uint64_t nack_forwarded_ = 0;
     
 public:
-    MessageHandler(RoomManager& rm, int fd) : room_manager_(rm), server_fd_(fd) {}
+    MessageHandler(RoomManager& rm, int fd, FrameTracer* tracer)
+        : room_manager_(rm), server_fd_(fd), tracer_(tracer) {}
     
     // 处理接收到的消息
     void handleMessage(const char* message, int length, const struct sockaddr_in& from_addr);
@@ -98,13 +186,14 @@ private:
     // 处理音频包
     void handleAudioPacket(const char* data, int length, const struct sockaddr_in& from_addr);
     
-    // 广播消息到房间
-    void broadcastToRoom(const std::string& room_id, const std::string& message, 
-                        const struct sockaddr_in& exclude_addr);
+    // 处理重传请求: 从缓存应答，未命中的部分转发给发送者
+    void handleNack(const ClientInfo& requester, const char* data, int length);
     
-    // 广播音频包到房间
-    void broadcastAudioPacket(const std::string& room_id, const char* data, int length,
-                             const struct sockaddr_in& exclude_addr);
+    // 广播消息到房间 (不发给 sender 本人)
+    void broadcastToRoom(const Room& room, const std::string& message, uint32_t sender);
+    
+    // 广播音频包到房间 (不发给 sender 本人)
+    void broadcastAudioPacket(const ClientInfo& sender, const char* data, int length);
 };
 
 // ============================================================================
@@ -148,6 +237,7 @@ private:
     std::unique_ptr<NetworkManager> network_manager_;
     std::unique_ptr<RoomManager> room_manager_;
     std::unique_ptr<MessageHandler> message_handler_;
+    std::unique_ptr<FrameTracer> frame_tracer_;
     
 public:
     UDPServer(const ServerConfig& config) : config_(config) {}
@@ -201,6 +291,14 @@ ServerConfig ServerConfig::parseCommandLine(int argc, char* argv[]) {
                 exit(1);
             }
         }
+        else if (arg == "-t" || arg == "--trace") {
+            if (i + 1 < argc) {
+                config.trace_file = argv[++i];
+            } else {
+                std::cerr << "错误: --trace 需要指定输出文件" << std::endl;
+                exit(1);
+            }
+        }
         else {
             std::cerr << "错误: 未知参数 " << arg << std::endl;
             config.showUsage(argv[0]);
@@ -216,6 +314,7 @@ void ServerConfig::showUsage(const char* program_name) const {
     std::cout << "  -h, --help              显示此帮助信息" << std::endl;
     std::cout << "  -i, --ip <IP>           设置监听IP地址 (默认: 0.0.0.0)" << std::endl;
     std::cout << "  -p, --port <PORT>       设置监听端口 (默认: 8080)" << std::endl;
+    std::cout << "  -t, --trace <FILE>      记录客户端选中追踪的帧，停止时导出 Chrome trace JSON" << std::endl;
     std::cout << std::endl;
     std::cout << "示例:" << std::endl;
     std::cout << "  " << program_name << " -i 192.168.1.100 -p 8080" << std::endl;
@@ -223,78 +322,136 @@ void ServerConfig::showUsage(const char* program_name) const {
 }
 
 // RoomManager 实现
-bool RoomManager::addUserToRoom(const std::string& client_key, const std::string& user_id, 
-                               const std::string& room_id, const struct sockaddr_in& address) {
-    // 创建客户端信息
-    auto client_info = std::make_shared<ClientInfo>(user_id, room_id, address);
-    clients_[client_key] = client_info;
+ClientInfo* RoomManager::addUserToRoom(const std::string& user_id, const std::string& room_id,
+                                       const struct sockaddr_in& address) {
+    // 分配会话ID: 优先复用最早释放的ID，会话表保持紧凑
+    uint32_t session_id;
+    if (!free_sessions_.empty()) {
+        session_id = free_sessions_.front();
+        free_sessions_.pop_front();
+    } else {
+        session_id = static_cast<uint32_t>(sessions_.size());
+        sessions_.emplace_back();
+    }
     
-    // 添加到房间
-    rooms_[room_id].insert(client_key);
+    auto client_info = std::make_shared<ClientInfo>(session_id, user_id, room_id, address);
+    auto& room = rooms_[room_id];
+    if (!room) {
+        room = std::make_shared<Room>();
+        room->room_id = room_id;
+    }
+    room->members.push_back(session_id);
+    client_info->room = room;
+    sessions_[session_id] = client_info;
+    addresses_[addressKey(address)] = session_id;
     
-    std::cout << "User " << user_id << " joined room " << room_id << std::endl;
-    return true;
+    std::cout << "User " << user_id << " joined room " << room_id << " (session " << session_id << ")" << std::endl;
+    return client_info.get();
 }
 
-bool RoomManager::removeUserFromRoom(const std::string& client_key, const std::string& room_id) {
+std::shared_ptr<ClientInfo> RoomManager::removeUser(const struct sockaddr_in& address) {
+    auto it = addresses_.find(addressKey(address));
+    if (it == addresses_.end()) {
+        return nullptr;
+    }
+    uint32_t session_id = it->second;
+    addresses_.erase(it);
+    std::shared_ptr<ClientInfo> client_info = sessions_[session_id];
+    sessions_[session_id].reset();
+    free_sessions_.push_back(session_id);
+    
     // 从房间移除
-    if (rooms_.find(room_id) != rooms_.end()) {
-        rooms_[room_id].erase(client_key);
-        if (rooms_[room_id].empty()) {
-            rooms_.erase(room_id);
-        }
+    std::vector<uint32_t>& members = client_info->room->members;
+    members.erase(std::remove(members.begin(), members.end(), session_id), members.end());
+    if (members.empty()) {
+        rooms_.erase(client_info->room_id);
     }
     
-    // 从客户端列表移除
-    if (clients_.find(client_key) != clients_.end()) {
-        std::string user_id = clients_[client_key]->user_id;
-        clients_.erase(client_key);
-        std::cout << "User " << user_id << " left room " << room_id << std::endl;
-        return true;
+    std::cout << "User " << client_info->user_id << " left room " << client_info->room_id
+              << " (session " << session_id << ")" << std::endl;
+    return client_info;
+}
+
+ClientInfo* RoomManager::findByAddress(const struct sockaddr_in& address) const {
+    auto it = addresses_.find(addressKey(address));
+    return it != addresses_.end() ? sessions_[it->second].get() : nullptr;
+}
+
+// PacketCache 实现
+void PacketCache::store(uint32_t sequence, const char* data, int length) {
+    if (entries_.empty()) {
+        entries_.resize(kCacheSize);
     }
-    return false;
+    Entry& entry = entries_[sequence % kCacheSize];
+    entry.sequence = sequence;
+    entry.data.assign(data, data + length);
 }
 
-std::string RoomManager::getUserRoom(const std::string& client_key) const {
-    auto it = clients_.find(client_key);
-    if (it != clients_.end()) {
-        return it->second->room_id;
+const std::vector<char>* PacketCache::find(uint32_t sequence) const {
+    if (entries_.empty()) {
+        return nullptr;
+    }
+    const Entry& entry = entries_[sequence % kCacheSize];
+    if (entry.data.empty() || entry.sequence != sequence) {
+        return nullptr;
     }
-    return "";
+    return &entry.data;
 }
 
-std::vector<std::shared_ptr<ClientInfo>> RoomManager::getRoomClients(const std::string& room_id) const {
-    std::vector<std::shared_ptr<ClientInfo>> result;
-    auto it = rooms_.find(room_id);
-    if (it != rooms_.end()) {
-        for (const auto& client_key : it->second) {
-            auto client_it = clients_.find(client_key);
-            if (client_it != clients_.end()) {
-                result.push_back(client_it->second);
-            }
-        }
+// FrameTracer 实现
+void FrameTracer::record(Stage stage, uint32_t session_id, uint32_t timestamp) {
+    if (events_.size() >= kMaxEvents) {
+        ++dropped_;
+        return;
+    }
+    if (tid_ == 0) {
+        tid_ = static_cast<int>(syscall(SYS_gettid));
     }
-    return result;
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    events_.push_back(Event{now, session_id, timestamp, stage});
 }
 
-bool RoomManager::isUserInRoom(const std::string& client_key, const std::string& room_id) const {
-    auto it = rooms_.find(room_id);
-    if (it != rooms_.end()) {
-        return it->second.find(client_key) != it->second.end();
+bool FrameTracer::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "无法写入追踪文件: " << path << std::endl;
+        return false;
+    }
+    const int pid = static_cast<int>(getpid());
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"udp_server\"}},\n";
+    out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << tid_
+        << ",\"args\":{\"name\":\"server\"}}";
+    for (size_t i = 0; i < events_.size(); ++i) {
+        const Event& event = events_[i];
+        // 收到切片持续到转发完毕 (紧随其后的同一帧的发送事件)
+        int64_t duration = 1;
+        if (event.stage == kServerRx && i + 1 < events_.size() && events_[i + 1].stage == kServerTx &&
+            events_[i + 1].session_id == event.session_id && events_[i + 1].timestamp == event.timestamp) {
+            duration = std::max<int64_t>(events_[i + 1].time_us - event.time_us, 1);
+        }
+        uint64_t id = (static_cast<uint64_t>(event.session_id) << 32) | event.timestamp;
+        out << ",\n{\"ph\":\"X\",\"name\":\"" << (event.stage == kServerRx ? "server_rx" : "server_tx")
+            << "\",\"cat\":\"frame\",\"pid\":" << pid << ",\"tid\":" << tid_ << ",\"ts\":" << event.time_us
+            << ",\"dur\":" << duration << ",\"args\":{\"session\":" << event.session_id
+            << ",\"timestamp\":" << event.timestamp << "}},\n"
+            << "{\"ph\":\"t\",\"name\":\"frame\",\"cat\":\"frame\",\"id\":" << id << ",\"pid\":" << pid
+            << ",\"tid\":" << tid_ << ",\"ts\":" << event.time_us << ",\"bp\":\"e\"}";
     }
-    return false;
+    out << "\n]}\n";
+    std::cout << "追踪已导出: " << path << ", 事件=" << events_.size() << ", 丢弃=" << dropped_ << std::endl;
+    return static_cast<bool>(out);
 }
 
 // MessageHandler 实现
 void MessageHandler::handleMessage(const char* message, int length, const struct sockaddr_in& from_addr) {
     try {
-        // 检查是否是字符串消息
-        std::string msg(message, length);
-        
-        if (msg.find("JOIN:") == 0) {
-            handleJoinMessage(msg, from_addr);
-        } else if (msg.find("LEAVE:") == 0) {
-            handleLeaveMessage(msg, from_addr);
+        // 只有控制消息构造字符串，音频包直接按包头处理
+        if (length >= 5 && memcmp(message, "JOIN:", 5) == 0) {
+            handleJoinMessage(std::string(message, length), from_addr);
+        } else if (length >= 6 && memcmp(message, "LEAVE:", 6) == 0) {
+            handleLeaveMessage(std::string(message, length), from_addr);
         } else {
             // 尝试解析为音频包
             handleAudioPacket(message, length, from_addr);
@@ -310,19 +467,31 @@ void MessageHandler::handleJoinMessage(const std::string& message, const struct
         std::string room_id = message.substr(5, pos1 - 5);
         std::string user_id = message.substr(pos1 + 1);
         
-        std::string client_key = std::string(inet_ntoa(from_addr.sin_addr)) + ":" + 
-                                std::to_string(ntohs(from_addr.sin_port));
-        
-        // 添加用户到房间
-        room_manager_.addUserToRoom(client_key, user_id, room_id, from_addr);
+        // 同一地址重复 JOIN (客户端在收到 JOIN_OK 之前会重发) 时沿用原会话，只重发 JOIN_OK；
+        // 加入另一个房间或换了用户时先按离开处理
+        ClientInfo* client = room_manager_.findByAddress(from_addr);
+        bool is_new = false;
+        if (client && (client->room_id != room_id || client->user_id != user_id)) {
+            std::shared_ptr<ClientInfo> removed = room_manager_.removeUser(from_addr);
+            broadcastToRoom(*removed->room, "LEAVE:" + removed->room_id + ":" + removed->user_id + ":" +
+                            std::to_string(removed->session_id), removed->session_id);
+            client = nullptr;
+        }
+        if (!client) {
+            client = room_manager_.addUserToRoom(user_id, room_id, from_addr);
+            is_new = true;
+        }
+        std::string session = std::to_string(client->session_id);
         
-        // 发送JOIN_OK响应
-        std::string response = "JOIN_OK:" + room_id + ":" + user_id;
+        // 发送JOIN_OK响应，带上分配的会话ID
+        std::string response = "JOIN_OK:" + room_id + ":" + user_id + ":" + session;
         sendto(server_fd_, response.c_str(), response.length(), 0,
                (struct sockaddr*)&from_addr, sizeof(from_addr));
         
         // 广播给房间内其他用户
-        broadcastToRoom(room_id, "JOIN:" + room_id + ":" + user_id, from_addr);
+        if (is_new) {
+            broadcastToRoom(*client->room, "JOIN:" + room_id + ":" + user_id + ":" + session, client->session_id);
+        }
     }
 }
 
@@ -330,90 +499,172 @@ void MessageHandler::handleLeaveMessage(const std::string& message, const struct
     size_t pos1 = message.find(':', 6);
     if (pos1 != std::string::npos) {
         std::string room_id = message.substr(6, pos1 - 6);
-        std::string user_id = message.substr(pos1 + 1);
-        
-        std::string client_key = std::string(inet_ntoa(from_addr.sin_addr)) + ":" + 
-                                std::to_string(ntohs(from_addr.sin_port));
-        
-        // 从房间移除用户
-        if (room_manager_.removeUserFromRoom(client_key, room_id)) {
-            // 广播给房间内其他用户
-            broadcastToRoom(room_id, "LEAVE:" + room_id + ":" + user_id, from_addr);
+        ClientInfo* client = room_manager_.findByAddress(from_addr);
+        if (!client || client->room_id != room_id) {
+            return;
         }
+        
+        // 从房间移除用户 (发送者的包缓存随会话一起释放)，广播给房间内其他用户
+        std::shared_ptr<ClientInfo> removed = room_manager_.removeUser(from_addr);
+        broadcastToRoom(*removed->room, "LEAVE:" + removed->room_id + ":" + removed->user_id + ":" +
+                        std::to_string(removed->session_id), removed->session_id);
     }
 }
 
 void MessageHandler::handleAudioPacket(const char* data, int length, const struct sockaddr_in& from_addr) {
-    // 检查最小长度
-    if (length < 14) return;
+    // 包头: sequence(4) timestamp(4) session_id(4) data_size(2) payload_type(1) flags(1)
+    const int header_size = 16;
+    // 单个包的负载上限 (与客户端一致，更长的帧由客户端分片)
+    const int max_data_size = 1400;
+    if (length < header_size) return;
     
     // 解析音频包头部
     uint32_t sequence = ntohl(*reinterpret_cast<const uint32_t*>(data));
     uint32_t timestamp = ntohl(*reinterpret_cast<const uint32_t*>(data + 4));
-    uint32_t user_id = ntohl(*reinterpret_cast<const uint32_t*>(data + 8));
-    uint16_t raw_data_size = ntohs(*reinterpret_cast<const uint16_t*>(data + 12));
+    uint32_t session_id = ntohl(*reinterpret_cast<const uint32_t*>(data + 8));
+    uint16_t raw_data_size = *reinterpret_cast<const uint16_t*>(data + 12);
     uint16_t data_size = ntohs(raw_data_size);
+    uint8_t payload_type = static_cast<uint8_t>(data[14]);
     
     // 记录调试信息
     static auto last_audio_print = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
     if (now - last_audio_print > std::chrono::seconds(5)) {
         std::cerr << "[SERVER_LOG] 尝试解析音频包: length=" << length << ", sequence=" << sequence 
-                  << ", timestamp=" << timestamp << ", user_id=" << user_id 
+                  << ", timestamp=" << timestamp << ", session_id=" << session_id 
                   << ", raw_data_size=0x" << std::hex << raw_data_size << std::dec
-                  << ", data_size=" << data_size << ", 验证=" << (data_size <= 1024 && length >= (14 + data_size)) << std::endl;
+                  << ", data_size=" << data_size << ", payload_type=" << static_cast<int>(payload_type)
+                  << ", 验证=" << (data_size <= max_data_size && length >= (header_size + data_size)) << std::endl;
         last_audio_print = now;
     }
     
     // 验证音频包
-    if (data_size <= 1024 && length >= (14 + data_size)) {
-        std::string client_key = std::string(inet_ntoa(from_addr.sin_addr)) + ":" + 
-                                std::to_string(ntohs(from_addr.sin_port));
-        
-        // 检查客户端是否在列表中
-        if (room_manager_.getUserRoom(client_key).empty()) {
-            std::cerr << "[SERVER_LOG] 警告: 客户端 " << client_key << " 不在客户端列表中，忽略音频包" << std::endl;
+    if (data_size <= max_data_size && length >= (header_size + data_size)) {
+        // 按会话ID直接索引发送者，源地址必须与加入时一致
+        ClientInfo* sender = room_manager_.findSession(session_id, from_addr);
+        if (!sender) {
+            static auto last_unknown_print = std::chrono::steady_clock::now();
+            if (now - last_unknown_print > std::chrono::seconds(5)) {
+                std::cerr << "[SERVER_LOG] 警告: 会话 " << session_id << " 不存在或源地址不匹配 ("
+                          << inet_ntoa(from_addr.sin_addr) << ":" << ntohs(from_addr.sin_port) << ")，忽略音频包" << std::endl;
+                last_unknown_print = now;
+            }
             return;
         }
         
-        std::string user_room_id = room_manager_.getUserRoom(client_key);
-        
-        // 检查房间是否存在
-        if (user_room_id.empty()) {
-            std::cerr << "[SERVER_LOG] 警告: 房间不存在，忽略音频包" << std::endl;
+        // 负载类型: 3=接收报告 4=重传请求，其余为音频
+        if (payload_type == 4) {
+            handleNack(*sender, data, length);
             return;
         }
+        if (payload_type != 3) {
+            sender->packet_cache.store(sequence, data, length);
+        }
         
-        // 检查用户是否在房间中
-        if (!room_manager_.isUserInRoom(client_key, user_room_id)) {
-            return;
+        // flags: 0x01=重传 0x04=追踪
+        const bool traced = tracer_ && (data[15] & (FrameTracer::kTracedFlag | 0x01)) == FrameTracer::kTracedFlag;
+        if (traced) {
+            tracer_->record(FrameTracer::kServerRx, session_id, timestamp);
         }
         
         // 广播音频包
-        broadcastAudioPacket(user_room_id, data, length, from_addr);
+        broadcastAudioPacket(*sender, data, length);
+        if (traced) {
+            tracer_->record(FrameTracer::kServerTx, session_id, timestamp);
+        }
+    }
+}
+
+void MessageHandler::handleNack(const ClientInfo& requester, const char* data, int length) {
+    // NACK块: source_id(4) sequence(4) bitmask(2)，source_id 为被请求发送者的会话ID
+    const int header_size = 16;
+    const int block_size = 10;
+    // 重传包标志位 (flags字节)
+    const char retransmit_flag = 0x01;
+    
+    std::vector<char> header(data, data + header_size);
+    for (int offset = header_size; offset + block_size <= length; offset += block_size) {
+        uint32_t source_id;
+        uint32_t first_sequence;
+        uint16_t bitmask;
+        memcpy(&source_id, data + offset, 4);
+        memcpy(&first_sequence, data + offset + 4, 4);
+        memcpy(&bitmask, data + offset + 8, 2);
+        source_id = ntohl(source_id);
+        first_sequence = ntohl(first_sequence);
+        bitmask = ntohs(bitmask);
+        
+        // 只应答同一房间内的发送者
+        const ClientInfo* source = room_manager_.getSession(source_id);
+        if (!source || source->room != requester.room) continue;
+        
+        // 缓存命中的包直接重传给请求者，未命中的重新组成NACK块
+        uint32_t missed_first = 0;
+        uint16_t missed_mask = 0;
+        bool has_missed = false;
+        for (int bit = -1; bit < 16; ++bit) {
+            if (bit >= 0 && !(bitmask & (1u << bit))) continue;
+            uint32_t sequence = first_sequence + bit + 1;
+            const std::vector<char>* cached = source->packet_cache.find(sequence);
+            if (cached) {
+                std::vector<char> packet(*cached);
+                packet[15] |= retransmit_flag;
+                sendto(server_fd_, packet.data(), packet.size(), 0,
+                       (const struct sockaddr*)&requester.address, sizeof(requester.address));
+                ++nack_cache_hits_;
+            } else if (!has_missed) {
+                has_missed = true;
+                missed_first = sequence;
+            } else {
+                missed_mask |= 1u << (sequence - missed_first - 1);
+            }
+        }
+        
+        // 服务器也没有收到的包 (上行丢失) 转发给发送者重传，重传包会正常广播给整个房间
+        if (has_missed) {
+            uint32_t net_source = htonl(source_id);
+            uint32_t net_sequence = htonl(missed_first);
+            uint16_t net_mask = htons(missed_mask);
+            std::vector<char> block(block_size);
+            memcpy(block.data(), &net_source, 4);
+            memcpy(block.data() + 4, &net_sequence, 4);
+            memcpy(block.data() + 8, &net_mask, 2);
+            // 每个发送者单独发送一个NACK包
+            std::vector<char> packet(header);
+            packet.insert(packet.end(), block.begin(), block.end());
+            uint16_t net_size = htons(block_size);
+            memcpy(packet.data() + 12, &net_size, 2);
+            sendto(server_fd_, packet.data(), packet.size(), 0,
+                   (const struct sockaddr*)&source->address, sizeof(source->address));
+            ++nack_forwarded_;
+        }
+    }
+    
+    static auto last_nack_print = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_nack_print > std::chrono::seconds(5)) {
+        std::cerr << "[SERVER_LOG] NACK统计: 缓存应答=" << nack_cache_hits_
+                  << ", 转发给发送者=" << nack_forwarded_ << std::endl;
+        last_nack_print = now;
     }
 }
 
-void MessageHandler::broadcastToRoom(const std::string& room_id, const std::string& message, 
-                                   const struct sockaddr_in& exclude_addr) {
-    auto clients = room_manager_.getRoomClients(room_id);
-    for (const auto& client : clients) {
-        if (client->address.sin_addr.s_addr != exclude_addr.sin_addr.s_addr ||
-            client->address.sin_port != exclude_addr.sin_port) {
+void MessageHandler::broadcastToRoom(const Room& room, const std::string& message, uint32_t sender) {
+    for (uint32_t session_id : room.members) {
+        const ClientInfo* client = room_manager_.getSession(session_id);
+        if (session_id != sender && client) {
             sendto(server_fd_, message.c_str(), message.length(), 0,
-                   (struct sockaddr*)&client->address, sizeof(client->address));
+                   (const struct sockaddr*)&client->address, sizeof(client->address));
         }
     }
 }
 
-void MessageHandler::broadcastAudioPacket(const std::string& room_id, const char* data, int length,
-                                        const struct sockaddr_in& exclude_addr) {
-    auto clients = room_manager_.getRoomClients(room_id);
-    for (const auto& client : clients) {
-        if (client->address.sin_addr.s_addr != exclude_addr.sin_addr.s_addr ||
-            client->address.sin_port != exclude_addr.sin_port) {
+void MessageHandler::broadcastAudioPacket(const ClientInfo& sender, const char* data, int length) {
+    for (uint32_t session_id : sender.room->members) {
+        if (session_id != sender.session_id) {
+            const ClientInfo* client = room_manager_.getSession(session_id);
             sendto(server_fd_, data, length, 0,
-                   (struct sockaddr*)&client->address, sizeof(client->address));
+                   (const struct sockaddr*)&client->address, sizeof(client->address));
         }
     }
 }
@@ -475,6 +726,8 @@ void NetworkManager::stop() {
     if (!running_) return;
     
     running_ = false;
+    // 唤醒阻塞在 recvfrom 中的服务器线程
+    shutdown(server_fd_, SHUT_RDWR);
     if (server_thread_.joinable()) {
         server_thread_.join();
     }
@@ -511,8 +764,14 @@ bool UDPServer::initializeComponents() {
     // 创建房间管理器
     room_manager_ = std::make_unique<RoomManager>();
     
+    // 创建帧追踪器 (--trace)
+    if (!config_.trace_file.empty()) {
+        frame_tracer_ = std::make_unique<FrameTracer>();
+    }
+    
     // 创建消息处理器
-    message_handler_ = std::make_unique<MessageHandler>(*room_manager_, network_manager_->getServerFd());
+    message_handler_ = std::make_unique<MessageHandler>(*room_manager_, network_manager_->getServerFd(),
+                                                        frame_tracer_.get());
     
     return true;
 }
@@ -530,6 +789,10 @@ void UDPServer::stop() {
     if (network_manager_) {
         network_manager_->stop();
     }
+    if (frame_tracer_) {
+        frame_tracer_->save(config_.trace_file);
+        frame_tracer_.reset();
+    }
 }
 
 bool UDPServer::isRunning() const {
@@ -0,0 +1,54 @@
+# 工具共用的构建配置
+# 各工具的 CMakeLists.txt 在 project() 之后引入本文件，再调用:
+#   add_voice_call_tool(<名称> [RELEASE] <源文件>...)
+# 生成 bin/<名称> 并链接核心库 (第一次调用时把 core 加入构建)。工具使用核心库内部的模块
+# (音频后端接口、包格式与各处理模块)，因此同时包含 core/include 与 core/src；
+# 核心库复制到可执行文件旁边，直接运行即可。
+# RELEASE: 未指定构建类型时按 Release 构建 (包括核心库)，基准测试与模拟器使用
+
+include_guard(GLOBAL)
+
+set(VOICE_CALL_ROOT_DIR ${CMAKE_CURRENT_LIST_DIR}/..)
+
+# 设置C++标准
+set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+
+# 设置输出目录
+set(CMAKE_RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/bin)
+
+function(add_voice_call_tool name)
+    cmake_parse_arguments(TOOL "RELEASE" "" "" ${ARGN})
+    if(TOOL_RELEASE AND NOT CMAKE_BUILD_TYPE)
+        set(CMAKE_BUILD_TYPE Release)
+        set(CMAKE_BUILD_TYPE Release PARENT_SCOPE)
+    endif()
+
+    # 创建可执行文件
+    add_executable(${name} ${TOOL_UNPARSED_ARGUMENTS})
+
+    # 添加核心库子目录 (一次构建多个工具时只添加一次)
+    if(NOT TARGET voice_call)
+        add_subdirectory(${VOICE_CALL_ROOT_DIR}/core ${CMAKE_BINARY_DIR}/core)
+    endif()
+
+    # 链接核心库
+    target_link_libraries(${name}
+        voice_call
+    )
+
+    # 设置包含目录
+    target_include_directories(${name} PRIVATE
+        ${VOICE_CALL_ROOT_DIR}/core/include
+        ${VOICE_CALL_ROOT_DIR}/core/src
+    )
+
+    # 复制依赖库到输出目录
+    if(UNIX AND NOT APPLE)
+        add_custom_command(TARGET ${name} POST_BUILD
+            COMMAND ${CMAKE_COMMAND} -E copy_if_different
+            $<TARGET_FILE:voice_call>
+            $<TARGET_FILE_DIR:${name}>
+        )
+    endif()
+endfunction()
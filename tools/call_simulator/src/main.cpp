@@ -0,0 +1,377 @@
+// 通话引擎的虚拟时间模拟器
+// 多个通话 (完整的 UDPVoiceCallImpl: 处理链、编码、FEC、NACK、码率控制、接收流与变速) 与转发服务器模型
+// 在一个线程中按虚拟时间运行，不创建线程也不使用socket与声卡。每个客户端的上行与下行链路有独立的
+// 时延、抖动、突发丢包与瓶颈队列，随机数只来自一个种子，同一组参数的结果完全一致 (输出结果指纹)。
+// 用于在几秒内跑完一小时的通话，比较抖动缓冲、冗余与拥塞控制改动前后的统计
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "call_environment.h"
+#include "simulation.h"
+#include "voice_call.h"
+
+namespace {
+
+int g_calls_per_room = 2;
+int g_rooms = 1;
+double g_duration = 3600.0;     // 模拟时长 (秒)
+uint64_t g_seed = 1;
+double g_loss_percent = 0.0;
+double g_burst = 1.0;
+double g_delay_ms = 20.0;
+double g_jitter_ms = 0.0;
+int g_bandwidth_kbps = 0;
+double g_queue_ms = 200.0;
+double g_clock_ppm = 0.0;
+int g_sample_rate = 16000;
+int g_frame_ms = 20;
+bool g_dtx = false;
+std::string g_media_key;        // 房间密钥，为空时不加密
+double g_interval = 600.0;      // 进度输出间隔 (模拟秒)
+bool g_verbose = false;         // 显示通话库的日志
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -n, --calls <N>          每个房间的通话数 (默认: 2)" << std::endl;
+    std::cout << "  -m, --rooms <N>          房间数 (默认: 1)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     模拟时长 (秒，默认: 3600)" << std::endl;
+    std::cout << "  -s, --seed <N>           随机种子 (默认: 1)" << std::endl;
+    std::cout << "  -l, --loss <PCT>         每个方向的平均丢包率 (%，默认: 0)" << std::endl;
+    std::cout << "  -B, --burst <N>          平均连续丢包数 (默认: 1)" << std::endl;
+    std::cout << "  -D, --delay <MS>         单程时延 (毫秒，默认: 20)" << std::endl;
+    std::cout << "  -j, --jitter <MS>        附加时延的范围 (毫秒，均匀分布，默认: 0)" << std::endl;
+    std::cout << "  -b, --bandwidth <KBPS>   每个客户端上行与下行的瓶颈带宽 (默认: 不限)" << std::endl;
+    std::cout << "  -q, --queue <MS>         瓶颈队列长度 (毫秒，默认: 200)" << std::endl;
+    std::cout << "  -p, --clock-ppm <PPM>    设备时钟偏差范围 (±PPM，默认: 0)" << std::endl;
+    std::cout << "  -r, --rate <HZ>          采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    包长 10/20/40/60 毫秒 (默认: 20)" << std::endl;
+    std::cout << "      --dtx                开启不连续发送 (模拟讲话的停顿段只发送舒适噪声描述符)" << std::endl;
+    std::cout << "  -k, --media-key <HEX>    房间密钥 (32或64个十六进制字符)，所有通话加密音频负载" << std::endl;
+    std::cout << "  -i, --interval <SEC>     进度输出间隔 (模拟秒，默认: 600)" << std::endl;
+    std::cout << "  -v, --verbose            显示通话库的日志" << std::endl;
+    std::cout << std::endl;
+    std::cout << "示例:" << std::endl;
+    std::cout << "  " << program_name << " -l 3 -B 2 -j 30            # 3%突发丢包与30ms抖动下的一小时通话" << std::endl;
+    std::cout << "  " << program_name << " -m 10 -n 4 -b 256 -d 600   # 10个四人房间，256kbps瓶颈" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-n" || arg == "--calls") && i + 1 < argc) {
+            g_calls_per_room = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-m" || arg == "--rooms") && i + 1 < argc) {
+            g_rooms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration = std::atof(argv[++i]);
+        }
+        else if ((arg == "-s" || arg == "--seed") && i + 1 < argc) {
+            g_seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((arg == "-l" || arg == "--loss") && i + 1 < argc) {
+            g_loss_percent = std::atof(argv[++i]);
+        }
+        else if ((arg == "-B" || arg == "--burst") && i + 1 < argc) {
+            g_burst = std::atof(argv[++i]);
+        }
+        else if ((arg == "-D" || arg == "--delay") && i + 1 < argc) {
+            g_delay_ms = std::atof(argv[++i]);
+        }
+        else if ((arg == "-j" || arg == "--jitter") && i + 1 < argc) {
+            g_jitter_ms = std::atof(argv[++i]);
+        }
+        else if ((arg == "-b" || arg == "--bandwidth") && i + 1 < argc) {
+            g_bandwidth_kbps = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-q" || arg == "--queue") && i + 1 < argc) {
+            g_queue_ms = std::atof(argv[++i]);
+        }
+        else if ((arg == "-p" || arg == "--clock-ppm") && i + 1 < argc) {
+            g_clock_ppm = std::atof(argv[++i]);
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            g_sample_rate = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if (arg == "--dtx") {
+            g_dtx = true;
+        }
+        else if ((arg == "-k" || arg == "--media-key") && i + 1 < argc) {
+            g_media_key = argv[++i];
+        }
+        else if ((arg == "-i" || arg == "--interval") && i + 1 < argc) {
+            g_interval = std::atof(argv[++i]);
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            g_verbose = true;
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_calls_per_room < 1 || g_rooms < 1 || g_duration <= 0.0 || g_interval <= 0.0) {
+        std::cerr << "错误: 通话数、房间数、模拟时长与输出间隔必须为正" << std::endl;
+        return false;
+    }
+    if (g_loss_percent < 0.0 || g_loss_percent >= 100.0 || g_burst < 1.0 || g_delay_ms < 0.0 || g_jitter_ms < 0.0 ||
+        g_bandwidth_kbps < 0 || g_queue_ms < 0.0 || g_clock_ppm < 0.0) {
+        std::cerr << "错误: 网络参数超出范围 (丢包率0~100%，连续丢包数至少为1，其余不能为负)" << std::endl;
+        return false;
+    }
+    if (g_sample_rate != 8000 && g_sample_rate != 16000 && g_sample_rate != 32000 && g_sample_rate != 48000) {
+        std::cerr << "错误: 采样率必须为 8000/16000/32000/48000" << std::endl;
+        return false;
+    }
+    if (g_frame_ms != 10 && g_frame_ms != 20 && g_frame_ms != 40 && g_frame_ms != 60) {
+        std::cerr << "错误: 包长必须为 10/20/40/60 毫秒" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 丢弃写入的内容 (未指定 -v 时替换 std::cout，屏蔽通话库的日志)
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct SimulatedCall {
+    std::string user_id;
+    voice_call_handle_t handle;
+};
+
+// 所有通话的合计
+struct Totals {
+    uint64_t packets_sent = 0;
+    uint64_t packets_received = 0;
+    uint64_t packets_lost = 0;
+    uint64_t packets_recovered = 0;
+    uint64_t retransmits_recovered = 0;
+    uint64_t packets_late = 0;
+    uint64_t concealed_frames = 0;
+    uint64_t accelerated_frames = 0;
+    uint64_t decelerated_frames = 0;
+    double jitter_buffer_ms = 0.0;
+    double target_kbps = 0.0;
+};
+
+Totals sum_stats(const std::vector<SimulatedCall>& calls) {
+    Totals totals;
+    for (const SimulatedCall& call : calls) {
+        voice_call_stats_t stats;
+        voice_call_get_stats(call.handle, &stats);
+        totals.packets_sent += stats.packets_sent;
+        totals.packets_received += stats.packets_received;
+        totals.packets_lost += stats.packets_lost;
+        totals.packets_recovered += stats.packets_recovered;
+        totals.retransmits_recovered += stats.retransmits_recovered;
+        totals.packets_late += stats.packets_late;
+        totals.concealed_frames += stats.concealed_frames;
+        totals.accelerated_frames += stats.accelerated_frames;
+        totals.decelerated_frames += stats.decelerated_frames;
+        totals.jitter_buffer_ms += stats.jitter_buffer_ms / calls.size();
+        totals.target_kbps += stats.target_bitrate / 1000.0 / calls.size();
+    }
+    return totals;
+}
+
+// FNV-1a，只包含由虚拟时间决定的计数 (不含处理耗时)
+class Fingerprint {
+public:
+    Fingerprint() : hash_(1469598103934665603ull) {}
+    void Add(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash_ ^= (value >> (8 * i)) & 0xff;
+            hash_ *= 1099511628211ull;
+        }
+    }
+    uint64_t Get() const { return hash_; }
+
+private:
+    uint64_t hash_;
+};
+
+void print_progress(std::ostream& out, double elapsed, double wall_seconds, const Totals& totals) {
+    const double to_ms = 1000.0 / g_sample_rate;
+    out << std::fixed << std::setprecision(1);
+    out << "[" << std::setw(7) << elapsed << "s] 实际 " << wall_seconds << "s (" << std::setprecision(0)
+        << elapsed / std::max(wall_seconds, 1e-3) << "x), 接收 " << totals.packets_received << ", 丢包 "
+        << totals.packets_lost << ", FEC/重传恢复 " << totals.packets_recovered << "/"
+        << totals.retransmits_recovered << ", 迟到 " << totals.packets_late << ", 补静音 "
+        << totals.concealed_frames * to_ms << "ms, 快放/慢放 " << totals.accelerated_frames * to_ms << "/"
+        << totals.decelerated_frames * to_ms << "ms" << std::setprecision(1) << ", 接收队列 "
+        << totals.jitter_buffer_ms << "ms, 目标码率 " << totals.target_kbps << "kbps" << std::endl;
+}
+
+void print_calls(std::ostream& out, const std::vector<SimulatedCall>& calls, Fingerprint* fingerprint) {
+    const double to_ms = 1000.0 / g_sample_rate;
+    out << std::left << std::setw(10) << "user" << std::right << std::setw(9) << "sent" << std::setw(9) << "recv"
+        << std::setw(8) << "lost" << std::setw(7) << "fec" << std::setw(7) << "rtx" << std::setw(7) << "late"
+        << std::setw(11) << "conceal_ms" << std::setw(10) << "accel_ms" << std::setw(10) << "decel_ms"
+        << std::setw(9) << "jbuf_ms" << std::setw(8) << "rtt_ms" << std::setw(8) << "kbps" << std::setw(7)
+        << "xruns" << std::endl;
+    out << std::fixed << std::setprecision(1);
+    uint64_t decrypt_failures = 0;
+    for (const SimulatedCall& call : calls) {
+        voice_call_stats_t stats;
+        voice_call_get_stats(call.handle, &stats);
+        decrypt_failures += stats.decrypt_failures;
+        out << std::left << std::setw(10) << call.user_id << std::right << std::setw(9) << stats.packets_sent
+            << std::setw(9) << stats.packets_received << std::setw(8) << stats.packets_lost << std::setw(7)
+            << stats.packets_recovered << std::setw(7) << stats.retransmits_recovered << std::setw(7)
+            << stats.packets_late << std::setw(11) << stats.concealed_frames * to_ms << std::setw(10)
+            << stats.accelerated_frames * to_ms << std::setw(10) << stats.decelerated_frames * to_ms
+            << std::setw(9) << stats.jitter_buffer_ms << std::setw(8) << stats.rtt_ms << std::setw(8)
+            << stats.target_bitrate / 1000.0 << std::setw(7) << stats.capture_xruns + stats.playback_xruns
+            << std::endl;
+
+        const uint64_t values[] = {
+            stats.packets_sent, stats.bytes_sent, stats.retransmits_sent, stats.dtx_suppressed_frames,
+            static_cast<uint64_t>(stats.target_bitrate), static_cast<uint64_t>(stats.send_bitrate),
+            static_cast<uint64_t>(stats.fec_depth), stats.packets_received, stats.bytes_received,
+            stats.packets_lost, stats.packets_recovered, stats.retransmits_recovered, stats.packets_reordered,
+            stats.packets_late, stats.queue_drops, stats.concealed_frames, stats.accelerated_frames,
+            stats.decelerated_frames, stats.nack_requests, stats.capture_xruns, stats.playback_xruns,
+        };
+        for (uint64_t value : values) {
+            fingerprint->Add(value);
+        }
+    }
+    if (!g_media_key.empty()) {
+        out << "认证失败而丢弃的包: " << decrypt_failures << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
+    std::ostream out(std::cout.rdbuf());
+    NullBuffer null_buffer;
+    if (!g_verbose) {
+        std::cout.rdbuf(&null_buffer);
+    }
+
+    LinkConfig link;
+    link.delay_ms = g_delay_ms;
+    link.jitter_ms = g_jitter_ms;
+    link.loss = g_loss_percent / 100.0;
+    link.burst = g_burst;
+    link.bandwidth_kbps = g_bandwidth_kbps;
+    link.queue_ms = g_queue_ms;
+    Simulation simulation(link, link, g_seed, g_clock_ppm);
+
+    out << "模拟 " << g_rooms << " 个房间 x " << g_calls_per_room << " 个通话, " << g_duration << " 秒, 种子 "
+        << g_seed << std::endl;
+    out << "链路 (每个方向): 时延 " << g_delay_ms << "ms + 抖动 0~" << g_jitter_ms << "ms, 丢包 " << g_loss_percent
+        << "% (平均连续 " << g_burst << "), 瓶颈 ";
+    if (g_bandwidth_kbps > 0) {
+        out << g_bandwidth_kbps << "kbps / 队列 " << g_queue_ms << "ms";
+    } else {
+        out << "不限";
+    }
+    out << ", 设备时钟偏差 ±" << g_clock_ppm << "ppm; " << g_sample_rate << " Hz, 包长 " << g_frame_ms << " ms, DTX "
+        << (g_dtx ? "开" : "关") << ", 加密 " << (g_media_key.empty() ? "关" : "开") << std::endl;
+
+    voice_call_callbacks_t callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    std::vector<SimulatedCall> calls;
+    for (int room = 0; room < g_rooms; ++room) {
+        for (int index = 0; index < g_calls_per_room; ++index) {
+            voice_call_config_t config;
+            memset(&config, 0, sizeof(config));
+            strcpy(config.server_url, "udp://127.0.0.1:8080");
+            snprintf(config.room_id, sizeof(config.room_id), "room%d", room);
+            snprintf(config.user_id, sizeof(config.user_id), "r%d-u%d", room, index);
+            config.audio_config.sample_rate = g_sample_rate;
+            config.audio_config.channels = 1;
+            config.audio_config.bits_per_sample = 16;
+            config.audio_config.frame_size = g_frame_ms;
+            config.enable_dtx = g_dtx;
+            snprintf(config.media_key, sizeof(config.media_key), "%s", g_media_key.c_str());
+            strcpy(config.audio_backend, "simulated");
+
+            SimulatedCall call;
+            call.user_id = config.user_id;
+            call.handle = CreateVoiceCall(&config, &callbacks, &simulation);
+            if (!call.handle || voice_call_connect(call.handle) != VOICE_CALL_SUCCESS) {
+                std::cerr << "错误: 通话 " << call.user_id << " 连接失败" << std::endl;
+                voice_call_destroy(call.handle);
+                for (SimulatedCall& created : calls) {
+                    voice_call_destroy(created.handle);
+                }
+                std::cout.rdbuf(out.rdbuf());
+                return 1;
+            }
+            calls.push_back(call);
+        }
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < g_duration) {
+        const double step = std::min(g_interval, g_duration - elapsed);
+        simulation.Advance(step);
+        elapsed += step;
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        print_progress(out, elapsed, wall, sum_stats(calls));
+    }
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    out << std::endl;
+    Fingerprint fingerprint;
+    print_calls(out, calls, &fingerprint);
+    for (SimulatedCall& call : calls) {
+        voice_call_disconnect(call.handle);
+        voice_call_destroy(call.handle);
+    }
+
+    const LinkStats uplink = simulation.GetUplinkStats();
+    const LinkStats downlink = simulation.GetDownlinkStats();
+    const ServerModel& server = simulation.GetServer();
+    const uint64_t link_values[] = {
+        uplink.packets, uplink.lost, uplink.queue_drops, downlink.packets, downlink.lost, downlink.queue_drops,
+        server.GetPacketsForwarded(), server.GetNackCacheHits(), server.GetNackForwarded(),
+    };
+    for (uint64_t value : link_values) {
+        fingerprint.Add(value);
+    }
+    out << std::endl;
+    out << "上行: 包 " << uplink.packets << ", 随机丢包 " << uplink.lost << ", 队列溢出 " << uplink.queue_drops
+        << "; 下行: 包 " << downlink.packets << ", 随机丢包 " << downlink.lost << ", 队列溢出 "
+        << downlink.queue_drops << std::endl;
+    out << "服务器: 转发 " << server.GetPacketsForwarded() << ", NACK 缓存应答 " << server.GetNackCacheHits()
+        << ", 转发给发送者 " << server.GetNackForwarded() << std::endl;
+    out << std::setprecision(2) << "模拟 " << g_duration << " 秒用时 " << wall_seconds << " 秒 ("
+        << std::setprecision(0) << g_duration / std::max(wall_seconds, 1e-3) << " 倍实时)，事件 "
+        << simulation.GetEventCount() << std::endl;
+    out << "结果指纹: " << std::hex << std::setw(16) << std::setfill('0') << fingerprint.Get() << std::dec
+        << std::setfill(' ') << std::endl;
+
+    std::cout.rdbuf(out.rdbuf());
+    return 0;
+}
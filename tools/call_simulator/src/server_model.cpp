@@ -0,0 +1,201 @@
+#include "server_model.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "voice_packet.h"
+
+ServerModel::ServerModel(SendFunction send)
+    : send_(send)
+    , packets_forwarded_(0)
+    , nack_cache_hits_(0)
+    , nack_forwarded_(0) {
+}
+
+void ServerModel::HandleDatagram(int address, const char* data, size_t size) {
+    if (size >= 5 && memcmp(data, "JOIN:", 5) == 0) {
+        HandleJoin(address, std::string(data, size));
+    } else if (size >= 6 && memcmp(data, "LEAVE:", 6) == 0) {
+        HandleLeave(address, std::string(data, size));
+    } else {
+        HandleAudio(address, data, size);
+    }
+}
+
+void ServerModel::HandleJoin(int address, const std::string& message) {
+    size_t pos = message.find(':', 5);
+    if (pos == std::string::npos) {
+        return;
+    }
+    std::string room_id = message.substr(5, pos - 5);
+    std::string user_id = message.substr(pos + 1);
+
+    // 同一地址重复 JOIN 时沿用原会话，只重发 JOIN_OK；加入另一个房间或换了用户时先按离开处理
+    Session* session = FindByAddress(address);
+    bool is_new = false;
+    if (session && (session->room_id != room_id || session->user_id != user_id)) {
+        RemoveSession(address);
+        session = nullptr;
+    }
+    if (!session) {
+        session = AddSession(address, user_id, room_id);
+        is_new = true;
+    }
+    std::string id = std::to_string(session->session_id);
+    std::string response = "JOIN_OK:" + room_id + ":" + user_id + ":" + id;
+    send_(address, response.data(), response.size());
+    if (is_new) {
+        BroadcastToRoom(room_id, "JOIN:" + room_id + ":" + user_id + ":" + id, session->session_id);
+    }
+}
+
+void ServerModel::HandleLeave(int address, const std::string& message) {
+    size_t pos = message.find(':', 6);
+    if (pos == std::string::npos) {
+        return;
+    }
+    Session* session = FindByAddress(address);
+    if (session && session->room_id == message.substr(6, pos - 6)) {
+        RemoveSession(address);
+    }
+}
+
+void ServerModel::HandleAudio(int address, const char* data, size_t size) {
+    if (size < kAudioPacketHeaderSize) {
+        return;
+    }
+    AudioPacketHeader header;
+    memcpy(&header, data, sizeof(header));
+    const size_t data_size = ntohs(header.data_size);
+    const uint32_t session_id = ntohl(header.session_id);
+    if (data_size > sizeof(AudioPacket::data) || size < kAudioPacketHeaderSize + data_size ||
+        session_id >= sessions_.size() || !sessions_[session_id] || sessions_[session_id]->address != address) {
+        return;
+    }
+    Session& sender = *sessions_[session_id];
+    if (header.payload_type == kPayloadTypeNack) {
+        HandleNack(sender, data, size);
+        return;
+    }
+    if (header.payload_type != kPayloadTypeReceiverReport) {
+        if (sender.cache.empty()) {
+            sender.cache.resize(kCacheSize);
+        }
+        CachedPacket& entry = sender.cache[ntohl(header.sequence) % kCacheSize];
+        entry.sequence = ntohl(header.sequence);
+        entry.data.assign(data, data + size);
+    }
+    for (uint32_t member : rooms_[sender.room_id]) {
+        if (member != session_id) {
+            send_(sessions_[member]->address, data, size);
+            ++packets_forwarded_;
+        }
+    }
+}
+
+void ServerModel::HandleNack(const Session& requester, const char* data, size_t size) {
+    const size_t header_size = kAudioPacketHeaderSize;
+    for (size_t offset = header_size; offset + sizeof(NackBlock) <= size; offset += sizeof(NackBlock)) {
+        NackBlock block;
+        memcpy(&block, data + offset, sizeof(block));
+        const uint32_t source_id = ntohl(block.source_id);
+        const uint32_t first_sequence = ntohl(block.sequence);
+        const uint16_t bitmask = ntohs(block.bitmask);
+        if (source_id >= sessions_.size() || !sessions_[source_id] ||
+            sessions_[source_id]->room_id != requester.room_id) {
+            continue;
+        }
+        const Session& source = *sessions_[source_id];
+
+        // 缓存命中的包直接重传给请求者，未命中的重新组成NACK块
+        uint32_t missed_first = 0;
+        uint16_t missed_mask = 0;
+        bool has_missed = false;
+        for (int bit = -1; bit < 16; ++bit) {
+            if (bit >= 0 && !(bitmask & (1u << bit))) continue;
+            const uint32_t sequence = first_sequence + bit + 1;
+            const CachedPacket* cached = source.cache.empty() ? nullptr : &source.cache[sequence % kCacheSize];
+            if (cached && !cached->data.empty() && cached->sequence == sequence) {
+                std::vector<char> packet(cached->data);
+                packet[offsetof(AudioPacketHeader, flags)] |= kPacketFlagRetransmit;
+                send_(requester.address, packet.data(), packet.size());
+                ++nack_cache_hits_;
+            } else if (!has_missed) {
+                has_missed = true;
+                missed_first = sequence;
+            } else {
+                missed_mask |= 1u << (sequence - missed_first - 1);
+            }
+        }
+
+        // 服务器也没有收到的包转发给发送者重传
+        if (has_missed) {
+            std::vector<char> packet(data, data + header_size);
+            NackBlock missed;
+            missed.source_id = htonl(source_id);
+            missed.sequence = htonl(missed_first);
+            missed.bitmask = htons(missed_mask);
+            packet.insert(packet.end(), reinterpret_cast<const char*>(&missed),
+                          reinterpret_cast<const char*>(&missed) + sizeof(missed));
+            const uint16_t net_size = htons(sizeof(NackBlock));
+            memcpy(packet.data() + offsetof(AudioPacketHeader, data_size), &net_size, sizeof(net_size));
+            send_(source.address, packet.data(), packet.size());
+            ++nack_forwarded_;
+        }
+    }
+}
+
+ServerModel::Session* ServerModel::AddSession(int address, const std::string& user_id, const std::string& room_id) {
+    uint32_t session_id;
+    if (!free_sessions_.empty()) {
+        session_id = free_sessions_.front();
+        free_sessions_.pop_front();
+    } else {
+        session_id = static_cast<uint32_t>(sessions_.size());
+        sessions_.emplace_back();
+    }
+    sessions_[session_id].reset(new Session{session_id, address, user_id, room_id, {}});
+    rooms_[room_id].push_back(session_id);
+    addresses_[address] = session_id;
+    return sessions_[session_id].get();
+}
+
+void ServerModel::RemoveSession(int address) {
+    auto found = addresses_.find(address);
+    if (found == addresses_.end()) {
+        return;
+    }
+    const uint32_t session_id = found->second;
+    addresses_.erase(found);
+    std::unique_ptr<Session> session = std::move(sessions_[session_id]);
+    free_sessions_.push_back(session_id);
+    std::vector<uint32_t>& members = rooms_[session->room_id];
+    members.erase(std::remove(members.begin(), members.end(), session_id), members.end());
+    if (members.empty()) {
+        rooms_.erase(session->room_id);
+    } else {
+        BroadcastToRoom(session->room_id,
+                        "LEAVE:" + session->room_id + ":" + session->user_id + ":" + std::to_string(session_id),
+                        session_id);
+    }
+}
+
+ServerModel::Session* ServerModel::FindByAddress(int address) {
+    auto found = addresses_.find(address);
+    return found != addresses_.end() ? sessions_[found->second].get() : nullptr;
+}
+
+void ServerModel::BroadcastToRoom(const std::string& room_id, const std::string& message, uint32_t sender) {
+    auto room = rooms_.find(room_id);
+    if (room == rooms_.end()) {
+        return;
+    }
+    for (uint32_t member : room->second) {
+        if (member != sender) {
+            send_(sessions_[member]->address, message.data(), message.size());
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SERVER_MODEL_H
+#define SERVER_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 转发服务器的模型，行为与 server/udp_server.cpp 一致: JOIN 分配会话ID并回复 JOIN_OK，
+// 同一地址重复 JOIN 只重发 JOIN_OK；音频包与接收报告按会话ID核对源地址后转发给房间内其他成员；
+// 每个发送者缓存最近64个音频包，NACK 命中缓存时直接重传给请求者，未命中的转发给发送者。
+// 客户端地址为模拟网络中的整数地址
+class ServerModel {
+public:
+    typedef std::function<void(int address, const char* data, size_t size)> SendFunction;
+
+    explicit ServerModel(SendFunction send);
+
+    void HandleDatagram(int address, const char* data, size_t size);
+
+    size_t GetSessionCount() const { return addresses_.size(); }
+    uint64_t GetPacketsForwarded() const { return packets_forwarded_; }
+    uint64_t GetNackCacheHits() const { return nack_cache_hits_; }
+    uint64_t GetNackForwarded() const { return nack_forwarded_; }
+
+private:
+    // 缓存的包数，与服务器相同
+    static const size_t kCacheSize = 64;
+
+    struct CachedPacket {
+        uint32_t sequence = 0;
+        std::vector<char> data;
+    };
+    struct Session {
+        uint32_t session_id;
+        int address;
+        std::string user_id;
+        std::string room_id;
+        std::vector<CachedPacket> cache;
+    };
+
+    void HandleJoin(int address, const std::string& message);
+    void HandleLeave(int address, const std::string& message);
+    void HandleAudio(int address, const char* data, size_t size);
+    void HandleNack(const Session& requester, const char* data, size_t size);
+
+    Session* AddSession(int address, const std::string& user_id, const std::string& room_id);
+    void RemoveSession(int address);
+    Session* FindByAddress(int address);
+    void BroadcastToRoom(const std::string& room_id, const std::string& message, uint32_t sender);
+
+    SendFunction send_;
+    std::vector<std::unique_ptr<Session>> sessions_;   // 会话ID -> 会话，空位为空
+    std::deque<uint32_t> free_sessions_;               // 释放的会话ID，按释放顺序复用
+    std::map<int, uint32_t> addresses_;                // 地址 -> 会话ID
+    std::map<std::string, std::vector<uint32_t>> rooms_;
+    uint64_t packets_forwarded_;
+    uint64_t nack_cache_hits_;
+    uint64_t nack_forwarded_;
+};
+
+#endif // SERVER_MODEL_H
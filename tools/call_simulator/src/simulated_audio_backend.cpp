@@ -0,0 +1,137 @@
+#include "simulated_audio_backend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+
+namespace {
+
+// 设备缓冲区长度 (毫秒)，与 null 后端相同
+const unsigned int kDeviceBufferMs = 80;
+// 讲话段 1~3 秒，停顿段 0.5~1.5 秒
+const double kTalkMinSeconds = 1.0;
+const double kTalkMaxSeconds = 3.0;
+const double kPauseMinSeconds = 0.5;
+const double kPauseMaxSeconds = 1.5;
+const double kPi = 3.14159265358979323846;
+// 一个基音周期的波形表长度
+const size_t kWaveSize = 4096;
+
+} // namespace
+
+SimulatedAudioBackend::SimulatedAudioBackend(CallEnvironment* environment, double clock_ppm, uint64_t seed,
+                                             double pitch_hz)
+    : environment_(environment)
+    , clock_scale_(1.0 + clock_ppm * 1e-6)
+    , random_(seed | 1)
+    , pitch_hz_(pitch_hz)
+    , rate_(0)
+    , channels_(1)
+    , buffer_frames_(0)
+    , capture_running_(false)
+    , capture_start_(0.0)
+    , capture_position_(0)
+    , playback_running_(false)
+    , playback_start_(0.0)
+    , playback_position_(0)
+    , phase_(0.0)
+    , segment_left_(0)
+    , talking_(false) {
+}
+
+bool SimulatedAudioBackend::Open(unsigned int sample_rate, int channels) {
+    rate_ = sample_rate;
+    channels_ = channels;
+    buffer_frames_ = static_cast<uint64_t>(sample_rate) * kDeviceBufferMs / 1000;
+    // 一个周期的谐波 (12次以内且低于奈奎斯特频率)，逐样点查表
+    wave_.assign(kWaveSize, 0);
+    for (size_t i = 0; i < kWaveSize; ++i) {
+        const double phase = 2.0 * kPi * i / kWaveSize;
+        double value = 0.0;
+        for (int k = 1; k <= 12 && k * pitch_hz_ < sample_rate / 2; ++k) {
+            value += std::sin(k * phase) / k;
+        }
+        wave_[i] = static_cast<int16_t>(std::lrint(5000.0 * value));
+    }
+    capture_running_ = false;
+    playback_running_ = false;
+    return true;
+}
+
+void SimulatedAudioBackend::Start() {
+    if (!capture_running_) {
+        capture_running_ = true;
+        capture_start_ = environment_->Now();
+        capture_position_ = 0;
+    }
+}
+
+uint64_t SimulatedAudioBackend::Elapsed(double start) const {
+    // 加上很小的余量，节拍恰好落在周期边界时不因浮点误差少算一帧
+    const double frames = (environment_->Now() - start) * rate_ * clock_scale_ + 1e-6;
+    return frames > 0.0 ? static_cast<uint64_t>(frames) : 0;
+}
+
+long SimulatedAudioBackend::Read(int16_t* pcm, size_t frames) {
+    Start();
+    // 读取落后超过一个缓冲区时溢出，丢弃积压的数据；虚拟时间中不能等待，数据不足时也立即返回
+    const uint64_t elapsed = Elapsed(capture_start_);
+    if (elapsed > capture_position_ + buffer_frames_) {
+        capture_position_ = elapsed;
+        return -EPIPE;
+    }
+    capture_position_ += frames;
+    Generate(pcm, frames);
+    return static_cast<long>(frames);
+}
+
+long SimulatedAudioBackend::Write(const int16_t*, size_t frames) {
+    if (!playback_running_) {
+        playback_running_ = true;
+        playback_start_ = environment_->Now();
+        playback_position_ = 0;
+    }
+    // 已写入的数据播放完毕时欠载，下次写入重新开始
+    if (playback_position_ < Elapsed(playback_start_)) {
+        playback_running_ = false;
+        return -EPIPE;
+    }
+    playback_position_ += frames;
+    return static_cast<long>(frames);
+}
+
+long SimulatedAudioBackend::GetCaptureDelay() {
+    if (!capture_running_) return 0;
+    const uint64_t elapsed = Elapsed(capture_start_);
+    return elapsed > capture_position_ ? static_cast<long>(elapsed - capture_position_) : 0;
+}
+
+long SimulatedAudioBackend::GetPlaybackDelay() {
+    if (!playback_running_) return 0;
+    const uint64_t elapsed = Elapsed(playback_start_);
+    return playback_position_ > elapsed ? static_cast<long>(playback_position_ - elapsed) : 0;
+}
+
+void SimulatedAudioBackend::Generate(int16_t* pcm, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        if (segment_left_ == 0) {
+            // xorshift64，讲话与停顿交替，时长均匀分布
+            random_ ^= random_ << 13;
+            random_ ^= random_ >> 7;
+            random_ ^= random_ << 17;
+            const double uniform = (random_ >> 11) * (1.0 / 9007199254740992.0);
+            talking_ = !talking_;
+            const double seconds = talking_ ? kTalkMinSeconds + uniform * (kTalkMaxSeconds - kTalkMinSeconds)
+                                            : kPauseMinSeconds + uniform * (kPauseMaxSeconds - kPauseMinSeconds);
+            segment_left_ = static_cast<uint64_t>(seconds * rate_);
+        }
+        --segment_left_;
+
+        const int16_t sample = talking_ ? wave_[static_cast<size_t>(phase_ * kWaveSize)] : 0;
+        phase_ += pitch_hz_ / rate_;
+        phase_ -= std::floor(phase_);
+        for (int ch = 0; ch < channels_; ++ch) {
+            pcm[i * channels_ + ch] = sample;
+        }
+    }
+}
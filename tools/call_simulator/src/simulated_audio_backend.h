@@ -0,0 +1,61 @@
+#ifndef SIMULATED_AUDIO_BACKEND_H
+#define SIMULATED_AUDIO_BACKEND_H
+
+#include <cstdint>
+#include <vector>
+
+#include "audio_backend.h"
+#include "call_environment.h"
+
+// 虚拟时间的音频设备: 采集与播放按环境时钟 (可带 ppm 级偏差) 计算设备位置，Read/Write 从不阻塞。
+// 行为与 null 后端的设备时钟相同 (80ms缓冲区，读取落后一个缓冲区时溢出，已写入的数据播完时欠载)，
+// 调度器只在采集有一个周期的数据时运行音频周期。
+// 采集信号为固定基音的谐波 (类似浊音，基音随通话不同)，按随机的讲话/停顿交替，停顿期间为静音
+class SimulatedAudioBackend : public AudioBackend {
+public:
+    // clock_ppm: 设备时钟相对标称采样率的偏差；seed 决定讲话/停顿的时长序列
+    SimulatedAudioBackend(CallEnvironment* environment, double clock_ppm, uint64_t seed, double pitch_hz);
+
+    bool Open(unsigned int sample_rate, int channels) override;
+    void Close() override {}
+    void Start() override;
+
+    unsigned int GetCaptureRate() const override { return rate_; }
+    unsigned int GetPlaybackRate() const override { return rate_; }
+
+    long Read(int16_t* pcm, size_t frames) override;
+    long Write(const int16_t* pcm, size_t frames) override;
+
+    long GetCaptureDelay() override;
+    long GetPlaybackDelay() override;
+
+    const char* GetName() const override { return "simulated"; }
+
+private:
+    // 从 start 开始经过的设备帧数
+    uint64_t Elapsed(double start) const;
+    void Generate(int16_t* pcm, size_t frames);
+
+    CallEnvironment* environment_;
+    double clock_scale_;        // 1 + ppm * 1e-6
+    uint64_t random_;           // xorshift 状态
+    double pitch_hz_;
+    unsigned int rate_;
+    int channels_;
+    uint64_t buffer_frames_;
+
+    bool capture_running_;
+    double capture_start_;
+    uint64_t capture_position_;     // 已读取的帧数
+    bool playback_running_;
+    double playback_start_;
+    uint64_t playback_position_;    // 已写入的帧数
+
+    // 信号发生器
+    std::vector<int16_t> wave_;     // 一个基音周期的波形
+    double phase_;                  // 基音周期内的位置 [0, 1)
+    uint64_t segment_left_;     // 当前讲话/停顿段剩余的帧数
+    bool talking_;
+};
+
+#endif // SIMULATED_AUDIO_BACKEND_H
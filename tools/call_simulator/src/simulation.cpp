@@ -0,0 +1,296 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+
+#include "simulated_audio_backend.h"
+
+namespace {
+
+// 节拍间隔 (秒)，与共享反应器相同
+const double kTickSeconds = 0.01;
+// 虚拟时钟的起点: 与单调时钟一样为正值 (各模块以0表示尚未更新)
+const double kStartSeconds = 1.0;
+// 各通话模拟讲话的基音 (Hz)，依次循环
+const double kPitches[] = {110.0, 150.0, 190.0, 230.0, 130.0, 170.0, 210.0};
+
+} // namespace
+
+// 模拟网络上的一个客户端端点，收到的数据报在到达时刻放入接收队列后回调所属通话
+class SimTransport : public PacketTransport {
+public:
+    explicit SimTransport(Simulation* simulation) : simulation_(simulation), address_(-1) {}
+    ~SimTransport() override { Close(); }
+
+    bool Connect(const std::string&, int) override {
+        if (address_ < 0) {
+            address_ = simulation_->AttachTransport(this);
+        }
+        return true;
+    }
+
+    void Close() override {
+        if (address_ >= 0) {
+            simulation_->DetachTransport(address_);
+            address_ = -1;
+        }
+        inbox_.clear();
+    }
+
+    long Send(const void* header, size_t header_size, const void* payload, size_t payload_size) override {
+        if (address_ < 0) {
+            errno = ENOTCONN;
+            return -1;
+        }
+        simulation_->SendToServer(address_, header, header_size, payload, payload_size);
+        return static_cast<long>(header_size + payload_size);
+    }
+
+    long Receive(void* buffer, size_t size) override {
+        if (inbox_.empty()) {
+            return -1;
+        }
+        std::vector<char> datagram = std::move(inbox_.front());
+        inbox_.pop_front();
+        const size_t length = std::min(size, datagram.size());
+        memcpy(buffer, datagram.data(), length);
+        return static_cast<long>(length);
+    }
+
+    // 虚拟时间中只由调度器回调 OnReadable，不使用网络线程
+    bool WaitReadable(int) override { return !inbox_.empty(); }
+    int GetFd() const override { return -1; }
+
+    void Enqueue(std::vector<char>&& datagram) { inbox_.push_back(std::move(datagram)); }
+
+private:
+    Simulation* simulation_;
+    int address_;
+    std::deque<std::vector<char>> inbox_;
+};
+
+SimLink::SimLink(const LinkConfig& config)
+    : config_(config)
+    , bad_(false)
+    , free_at_(0.0) {
+    // 稳态丢包率 p = enter / (enter + leave)，平均连续丢包数 = 1 / leave
+    const double loss = std::min(std::max(config.loss, 0.0), 0.99);
+    const double burst = std::max(config.burst, 1.0);
+    leave_bad_ = 1.0 / burst;
+    enter_bad_ = std::min(1.0, loss * leave_bad_ / (1.0 - loss));
+}
+
+bool SimLink::Transmit(double now, size_t bytes, SimRandom* random, double* arrival) {
+    ++stats_.packets;
+    // 瓶颈: 排队时延超过队列长度时尾丢弃，否则排在队列中最后一个包之后发送
+    double departure = now;
+    if (config_.bandwidth_kbps > 0) {
+        const double start = std::max(now, free_at_);
+        if (start - now > config_.queue_ms / 1000.0) {
+            ++stats_.queue_drops;
+            return false;
+        }
+        free_at_ = start + bytes * 8.0 / (config_.bandwidth_kbps * 1000.0);
+        departure = free_at_;
+    }
+    // Gilbert-Elliott: 每个包先转移状态，处于丢包状态时丢弃
+    if (config_.loss > 0.0) {
+        const double draw = random->Uniform();
+        bad_ = bad_ ? draw >= leave_bad_ : draw < enter_bad_;
+        if (bad_) {
+            ++stats_.lost;
+            return false;
+        }
+    }
+    *arrival = departure + config_.delay_ms / 1000.0;
+    if (config_.jitter_ms > 0.0) {
+        *arrival += random->Uniform() * config_.jitter_ms / 1000.0;
+    }
+    return true;
+}
+
+Simulation::Simulation(const LinkConfig& uplink, const LinkConfig& downlink, uint64_t seed, double clock_ppm)
+    : uplink_config_(uplink)
+    , downlink_config_(downlink)
+    , clock_ppm_(clock_ppm)
+    , random_(seed)
+    , start_(kStartSeconds)
+    , now_(kStartSeconds)
+    , next_tick_(kStartSeconds + kTickSeconds)
+    , next_order_(0)
+    , event_count_(0)
+    , next_address_(0)
+    , next_audio_index_(0)
+    , server_([this](int address, const char* data, size_t size) { SendToClient(address, data, size); }) {
+}
+
+Simulation::~Simulation() {
+}
+
+std::unique_ptr<PacketTransport> Simulation::CreateTransport() {
+    return std::unique_ptr<PacketTransport>(new SimTransport(this));
+}
+
+std::unique_ptr<AudioBackend> Simulation::CreateAudioBackend(const std::string&) {
+    // 通话按连接顺序取得各自的时钟偏差、讲话序列与基音
+    const size_t index = next_audio_index_++;
+    const double ppm = clock_ppm_ * (2.0 * random_.Uniform() - 1.0);
+    const double pitch = kPitches[index % (sizeof(kPitches) / sizeof(kPitches[0]))];
+    return std::unique_ptr<AudioBackend>(new SimulatedAudioBackend(this, ppm, random_.Next(), pitch));
+}
+
+bool Simulation::Add(PacketTransport* transport, ReactorHandler* handler) {
+    for (auto& entry : clients_) {
+        if (entry.second.transport == transport) {
+            if (!entry.second.handler) {
+                tick_order_.push_back(entry.first);
+            }
+            entry.second.handler = handler;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Simulation::Remove(PacketTransport* transport) {
+    for (auto& entry : clients_) {
+        if (entry.second.transport == transport) {
+            entry.second.handler = nullptr;
+            tick_order_.erase(std::remove(tick_order_.begin(), tick_order_.end(), entry.first), tick_order_.end());
+            return;
+        }
+    }
+}
+
+int Simulation::AttachTransport(SimTransport* transport) {
+    const int address = next_address_++;
+    Client& client = clients_[address];
+    client.transport = transport;
+    client.uplink.reset(new SimLink(uplink_config_));
+    client.downlink.reset(new SimLink(downlink_config_));
+    return address;
+}
+
+void Simulation::DetachTransport(int address) {
+    auto found = clients_.find(address);
+    if (found == clients_.end()) {
+        return;
+    }
+    // 已发出的包照常到达服务器 (LEAVE)，发往该地址的包在到达时丢弃
+    const LinkStats& uplink = found->second.uplink->GetStats();
+    const LinkStats& downlink = found->second.downlink->GetStats();
+    closed_uplink_.packets += uplink.packets;
+    closed_uplink_.lost += uplink.lost;
+    closed_uplink_.queue_drops += uplink.queue_drops;
+    closed_downlink_.packets += downlink.packets;
+    closed_downlink_.lost += downlink.lost;
+    closed_downlink_.queue_drops += downlink.queue_drops;
+    tick_order_.erase(std::remove(tick_order_.begin(), tick_order_.end(), address), tick_order_.end());
+    clients_.erase(found);
+}
+
+void Simulation::SendToServer(int address, const void* header, size_t header_size, const void* payload,
+                              size_t payload_size) {
+    auto found = clients_.find(address);
+    double arrival = 0.0;
+    if (found == clients_.end() ||
+        !found->second.uplink->Transmit(now_, header_size + payload_size, &random_, &arrival)) {
+        return;
+    }
+    Event event;
+    event.time = arrival;
+    event.order = next_order_++;
+    event.address = address;
+    event.to_server = true;
+    event.data.resize(header_size + payload_size);
+    memcpy(event.data.data(), header, header_size);
+    if (payload_size > 0) {
+        memcpy(event.data.data() + header_size, payload, payload_size);
+    }
+    events_.push(std::move(event));
+}
+
+void Simulation::SendToClient(int address, const char* data, size_t size) {
+    auto found = clients_.find(address);
+    double arrival = 0.0;
+    if (found == clients_.end() || !found->second.downlink->Transmit(now_, size, &random_, &arrival)) {
+        return;
+    }
+    Event event;
+    event.time = arrival;
+    event.order = next_order_++;
+    event.address = address;
+    event.to_server = false;
+    event.data.assign(data, data + size);
+    events_.push(std::move(event));
+}
+
+void Simulation::Deliver(Event& event) {
+    ++event_count_;
+    if (event.to_server) {
+        server_.HandleDatagram(event.address, event.data.data(), event.data.size());
+        return;
+    }
+    auto found = clients_.find(event.address);
+    if (found == clients_.end()) {
+        return;
+    }
+    found->second.transport->Enqueue(std::move(event.data));
+    if (found->second.handler) {
+        found->second.handler->OnReadable();
+    }
+}
+
+void Simulation::Tick() {
+    // 回调中不会注册或注销通话 (连接与断开只在 Advance 之外进行)
+    for (int address : tick_order_) {
+        clients_[address].handler->OnTick();
+    }
+}
+
+void Simulation::Advance(double seconds) {
+    const double end = now_ + seconds;
+    while (true) {
+        const bool has_event = !events_.empty();
+        const double next_event = has_event ? events_.top().time : 0.0;
+        // 同一时刻先投递数据报再运行节拍，与反应器中可读事件先于定时器处理一致
+        if (has_event && next_event <= next_tick_) {
+            if (next_event > end) break;
+            // 比较只用时刻与顺序，移出数据后再弹出不影响堆
+            Event event = std::move(const_cast<Event&>(events_.top()));
+            events_.pop();
+            now_ = std::max(now_, event.time);
+            Deliver(event);
+        } else {
+            if (next_tick_ > end) break;
+            now_ = next_tick_;
+            next_tick_ += kTickSeconds;
+            Tick();
+        }
+    }
+    now_ = std::max(now_, end);
+}
+
+LinkStats Simulation::GetUplinkStats() const {
+    LinkStats total = closed_uplink_;
+    for (const auto& entry : clients_) {
+        const LinkStats& stats = entry.second.uplink->GetStats();
+        total.packets += stats.packets;
+        total.lost += stats.lost;
+        total.queue_drops += stats.queue_drops;
+    }
+    return total;
+}
+
+LinkStats Simulation::GetDownlinkStats() const {
+    LinkStats total = closed_downlink_;
+    for (const auto& entry : clients_) {
+        const LinkStats& stats = entry.second.downlink->GetStats();
+        total.packets += stats.packets;
+        total.lost += stats.lost;
+        total.queue_drops += stats.queue_drops;
+    }
+    return total;
+}
@@ -0,0 +1,145 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "call_environment.h"
+#include "server_model.h"
+
+// 可复现的随机数: mt19937_64 的输出序列由标准规定，浮点换算自行完成，不依赖标准库分布的实现
+class SimRandom {
+public:
+    explicit SimRandom(uint64_t seed) : engine_(seed) {}
+
+    uint64_t Next() { return engine_(); }
+    // [0, 1) 均匀分布
+    double Uniform() { return (engine_() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+// 单向链路的参数 (每个客户端的上行与下行各一条)
+struct LinkConfig {
+    double delay_ms = 20.0;     // 固定单程时延
+    double jitter_ms = 0.0;     // 附加时延，在 [0, jitter_ms) 内均匀分布 (会引起乱序)
+    double loss = 0.0;          // 平均丢包率 (0~1)
+    double burst = 1.0;         // 平均连续丢包数 (Gilbert-Elliott 两状态模型)
+    int bandwidth_kbps = 0;     // 瓶颈带宽，0 为不限
+    double queue_ms = 200.0;    // 瓶颈队列的排队时延超过该值时尾丢弃
+};
+
+struct LinkStats {
+    uint64_t packets = 0;
+    uint64_t lost = 0;          // 随机丢包
+    uint64_t queue_drops = 0;   // 瓶颈队列溢出
+};
+
+// 一条链路的状态: 先经过瓶颈队列，再按 Gilbert-Elliott 模型随机丢包，最后加上时延与抖动
+class SimLink {
+public:
+    explicit SimLink(const LinkConfig& config);
+
+    // 在 now 时刻发送 bytes 字节，返回 false 表示丢失，否则 arrival 为到达时刻
+    bool Transmit(double now, size_t bytes, SimRandom* random, double* arrival);
+
+    const LinkStats& GetStats() const { return stats_; }
+
+private:
+    LinkConfig config_;
+    double enter_bad_;      // 好状态转入丢包状态的概率
+    double leave_bad_;      // 丢包状态回到好状态的概率
+    bool bad_;
+    double free_at_;        // 瓶颈发送完队列中最后一个包的时刻
+    LinkStats stats_;
+};
+
+class SimTransport;
+
+// 虚拟时间的运行环境: 所有通话、链路与服务器模型在调用线程中按事件顺序执行。
+// 事件按 (时刻, 产生顺序) 排序，节拍每10ms依次回调所有注册的通话 (与共享反应器相同)，
+// 同一种子与参数的结果完全一致
+class Simulation : public CallEnvironment, public CallScheduler {
+public:
+    // clock_ppm: 每个通话的模拟设备时钟在 ±clock_ppm 内随机偏离标称采样率
+    Simulation(const LinkConfig& uplink, const LinkConfig& downlink, uint64_t seed, double clock_ppm);
+    ~Simulation() override;
+
+    // CallEnvironment
+    double Now() override { return now_; }
+    std::unique_ptr<PacketTransport> CreateTransport() override;
+    // 所有通话使用模拟音频设备 (simulated_audio_backend.h)，忽略 spec
+    std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& spec) override;
+    CallScheduler* GetScheduler() override { return this; }
+
+    // CallScheduler
+    bool Add(PacketTransport* transport, ReactorHandler* handler) override;
+    void Remove(PacketTransport* transport) override;
+
+    // 虚拟时间前进 seconds 秒，执行其间的全部事件与节拍。通话的连接与断开在两次调用之间进行
+    void Advance(double seconds);
+    // 从模拟开始经过的虚拟时间 (秒)
+    double GetElapsed() const { return now_ - start_; }
+
+    // 链路统计 (所有客户端合计)
+    LinkStats GetUplinkStats() const;
+    LinkStats GetDownlinkStats() const;
+    const ServerModel& GetServer() const { return server_; }
+    uint64_t GetEventCount() const { return event_count_; }
+
+    // 供模拟传输调用
+    int AttachTransport(SimTransport* transport);
+    void DetachTransport(int address);
+    void SendToServer(int address, const void* header, size_t header_size, const void* payload,
+                      size_t payload_size);
+
+private:
+    struct Event {
+        double time;
+        uint64_t order;
+        int address;        // 客户端地址
+        bool to_server;     // true: 客户端 -> 服务器，false: 服务器 -> 客户端
+        std::vector<char> data;
+    };
+    struct EventLater {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.time > b.time || (a.time == b.time && a.order > b.order);
+        }
+    };
+    struct Client {
+        SimTransport* transport = nullptr;
+        ReactorHandler* handler = nullptr;
+        std::unique_ptr<SimLink> uplink;
+        std::unique_ptr<SimLink> downlink;
+    };
+
+    void SendToClient(int address, const char* data, size_t size);
+    void Deliver(Event& event);
+    void Tick();
+
+    LinkConfig uplink_config_;
+    LinkConfig downlink_config_;
+    double clock_ppm_;
+    SimRandom random_;
+    double start_;
+    double now_;
+    double next_tick_;
+    uint64_t next_order_;
+    uint64_t event_count_;
+    int next_address_;
+    size_t next_audio_index_;
+    std::priority_queue<Event, std::vector<Event>, EventLater> events_;
+    std::map<int, Client> clients_;
+    std::vector<int> tick_order_;   // 注册的客户端地址，按注册顺序回调节拍
+    LinkStats closed_uplink_;       // 已关闭的传输的链路统计
+    LinkStats closed_downlink_;
+    ServerModel server_;
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,480 @@
+// 回声消除 (PBFDAF) 基准
+// 远端信号经过回声路径 (合成的房间冲激响应或 --path 指定的录制冲激响应) 得到回声，加上近端底噪后送入
+// 回声消除器；第 --double-talk 秒起近端讲话 3 秒 (双讲)。因为回声与近端信号分别已知，按 残差回声 = 输出 - 近端
+// 计算真实的回声损耗增强 (ERLE)，逐秒输出真实值与回声消除器自己的估计，并汇总收敛时间、单讲稳态、
+// 双讲期间与双讲之后的 ERLE 以及每帧处理耗时；最后单独测量 8/16/48kHz 下每帧的处理耗时
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "echo_canceller.h"
+
+namespace {
+
+int g_sample_rate = 16000;
+int g_frame_ms = 20;
+int g_tail_ms = 128;          // 回声消除器覆盖的回声路径长度
+double g_duration = 16.0;     // 模拟时长 (秒)
+double g_double_talk = 10.0;  // 双讲开始时刻 (秒)
+int g_room_ms = 100;          // 合成冲激响应的长度
+double g_echo_db = -6.0;      // 回声路径增益 (冲激响应能量，dB)
+std::string g_path_file;      // 录制的冲激响应 (WAV)
+std::string g_far_file;       // 录制的远端语音 (WAV)，不指定时使用合成信号
+bool g_voiced_far = true;     // 合成远端信号使用浊音 (谐波)，否则为噪声
+
+const double kDoubleTalkSeconds = 3.0;
+const double kNoiseDbfs = -60.0;   // 近端底噪
+const double kEchoActive = 1e-5;   // 回声平均功率低于该值 (-50dBFS) 的帧不计入 ERLE
+const double kPi = 3.14159265358979323846;
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -r, --rate <HZ>          采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    帧长 10/20/40/60 毫秒 (默认: 20)" << std::endl;
+    std::cout << "  -t, --tail <MS>          回声消除器覆盖的回声路径长度 (毫秒，默认: 128)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     模拟时长 (秒，默认: 16)" << std::endl;
+    std::cout << "  -D, --double-talk <SEC>  双讲开始时刻 (秒，默认: 10，持续3秒；负数表示没有双讲)" << std::endl;
+    std::cout << "  -m, --room <MS>          合成冲激响应的长度 (毫秒，默认: 100)" << std::endl;
+    std::cout << "  -g, --echo-gain <DB>     合成冲激响应的能量 (dB，默认: -6)" << std::endl;
+    std::cout << "  -p, --path <WAV>         使用录制的冲激响应 (单声道或取第一个声道，采样率须与 -r 相同)" << std::endl;
+    std::cout << "  -s, --signal <TYPE>      合成远端信号: voiced 或 noise (默认: voiced)" << std::endl;
+    std::cout << "  -x, --far <WAV>          使用录制的远端语音 (循环播放，采样率须与 -r 相同)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            g_sample_rate = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-t" || arg == "--tail") && i + 1 < argc) {
+            g_tail_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration = std::atof(argv[++i]);
+        }
+        else if ((arg == "-D" || arg == "--double-talk") && i + 1 < argc) {
+            g_double_talk = std::atof(argv[++i]);
+        }
+        else if ((arg == "-m" || arg == "--room") && i + 1 < argc) {
+            g_room_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-g" || arg == "--echo-gain") && i + 1 < argc) {
+            g_echo_db = std::atof(argv[++i]);
+        }
+        else if ((arg == "-p" || arg == "--path") && i + 1 < argc) {
+            g_path_file = argv[++i];
+        }
+        else if ((arg == "-s" || arg == "--signal") && i + 1 < argc) {
+            std::string type = argv[++i];
+            if (type != "noise" && type != "voiced") {
+                std::cerr << "错误: 远端信号必须为 noise 或 voiced" << std::endl;
+                return false;
+            }
+            g_voiced_far = type == "voiced";
+        }
+        else if ((arg == "-x" || arg == "--far") && i + 1 < argc) {
+            g_far_file = argv[++i];
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_sample_rate < 8000 || g_sample_rate > 48000 || g_tail_ms <= 0 || g_room_ms <= 0 || g_duration < 2.0) {
+        std::cerr << "错误: 参数超出范围 (采样率8000~48000，模拟时长至少2秒)" << std::endl;
+        return false;
+    }
+    if (g_frame_ms != 10 && g_frame_ms != 20 && g_frame_ms != 40 && g_frame_ms != 60) {
+        std::cerr << "错误: 帧长必须为 10/20/40/60 毫秒" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 可复现的伪随机数 (xorshift64)，返回 [-1, 1)
+class Noise {
+public:
+    explicit Noise(uint64_t seed) : state_(seed) {}
+    double Next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<double>(state_ >> 11) / static_cast<double>(1ULL << 52) - 1.0;
+    }
+
+private:
+    uint64_t state_;
+};
+
+// 读取 WAV 的第一个声道 (16位PCM或32位float)，归一化到 [-1, 1)
+bool LoadWav(const std::string& path, std::vector<float>* samples) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "错误: 无法打开 " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+
+    auto u16 = [&](size_t at) { return static_cast<uint32_t>(data[at] | (data[at + 1] << 8)); };
+    auto u32 = [&](size_t at) { return u16(at) | (u16(at + 2) << 16); };
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << "错误: " << path << " 不是 WAV 文件" << std::endl;
+        return false;
+    }
+    uint32_t format = 0, channels = 0, rate = 0, bits = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        const uint32_t size = u32(pos + 4);
+        const size_t body = pos + 8;
+        if (memcmp(data.data() + pos, "fmt ", 4) == 0 && body + 16 <= data.size()) {
+            format = u16(body);
+            channels = u16(body + 2);
+            rate = u32(body + 4);
+            bits = u16(body + 14);
+        } else if (memcmp(data.data() + pos, "data", 4) == 0 && format != 0) {
+            if (rate != static_cast<uint32_t>(g_sample_rate)) {
+                std::cerr << "错误: " << path << " 的采样率为 " << rate << " Hz，请先重采样到 " << g_sample_rate
+                          << " Hz" << std::endl;
+                return false;
+            }
+            const bool pcm16 = format == 1 && bits == 16;
+            const bool float32 = format == 3 && bits == 32;
+            if (!pcm16 && !float32) {
+                std::cerr << "错误: " << path << " 只支持16位PCM或32位float" << std::endl;
+                return false;
+            }
+            const size_t stride = channels * bits / 8;
+            const size_t end = std::min(data.size(), body + size);
+            for (size_t at = body; at + stride <= end; at += stride) {
+                if (pcm16) {
+                    samples->push_back(static_cast<int16_t>(u16(at)) / 32768.0f);
+                } else {
+                    uint32_t bits_value = u32(at);
+                    float value;
+                    memcpy(&value, &bits_value, sizeof(value));
+                    samples->push_back(value);
+                }
+            }
+            return !samples->empty();
+        }
+        pos = body + size + (size & 1);
+    }
+    std::cerr << "错误: " << path << " 没有音频数据" << std::endl;
+    return false;
+}
+
+// 合成的房间冲激响应: 5ms 的直达声，之后是按 RT60=300ms 指数衰减的白噪声 (混响)，能量归一化到 g_echo_db
+std::vector<float> MakeRoomResponse() {
+    const size_t length = static_cast<size_t>(g_sample_rate) * g_room_ms / 1000;
+    const size_t direct = static_cast<size_t>(g_sample_rate) * 5 / 1000;
+    const double decay = std::log(1000.0) / (0.3 * g_sample_rate);
+    std::vector<float> response(length, 0.0f);
+    Noise noise(0x5eed);
+    for (size_t i = direct + 1; i < length; ++i) {
+        response[i] = static_cast<float>(0.3 * noise.Next() * std::exp(-decay * (i - direct)));
+    }
+    if (direct < length) {
+        response[direct] = 1.0f;
+    }
+    double energy = 0.0;
+    for (float tap : response) {
+        energy += tap * tap;
+    }
+    const double scale = std::pow(10.0, g_echo_db / 20.0) / std::sqrt(energy);
+    for (float& tap : response) {
+        tap = static_cast<float>(tap * scale);
+    }
+    return response;
+}
+
+// 按随机的讲话 (0.5~2秒)/停顿 (0.2~0.8秒) 交替、带 4Hz 包络的合成信号。voiced 为基音缓慢变化的谐波加少量噪声，
+// 否则为白噪声；浊音的频谱只集中在谐波上，回声消除器收敛明显更慢
+class TalkSignal {
+public:
+    TalkSignal(int sample_rate, bool voiced, double pitch, double level_db, uint64_t seed)
+        : sample_rate_(sample_rate), voiced_(voiced), pitch_(pitch), level_(std::pow(10.0, level_db / 20.0)),
+          noise_(seed), phase_(0.0), time_(0.0), segment_left_(0.0), talking_(false) {}
+
+    float Next() {
+        if (segment_left_ <= 0.0) {
+            talking_ = !talking_;
+            const double u = 0.5 * (noise_.Next() + 1.0);
+            segment_left_ = talking_ ? 0.5 + 1.5 * u : 0.2 + 0.6 * u;
+        }
+        segment_left_ -= 1.0 / sample_rate_;
+        time_ += 1.0 / sample_rate_;
+        const double f0 = pitch_ * (1.0 + 0.15 * std::sin(2.0 * kPi * 0.7 * time_));
+        phase_ += 2.0 * kPi * f0 / sample_rate_;
+        if (phase_ > 2.0 * kPi) {
+            phase_ -= 2.0 * kPi;
+        }
+        const double excitation = noise_.Next();
+        if (!talking_) {
+            return 0.0f;
+        }
+        double value = voiced_ ? 0.1 * excitation : excitation;
+        for (int k = 1; voiced_ && k * f0 < 3400.0 && k * f0 < sample_rate_ / 2; ++k) {
+            value += std::sin(k * phase_) / k;
+        }
+        const double envelope = 0.55 + 0.45 * std::sin(2.0 * kPi * 4.0 * time_);
+        return static_cast<float>(level_ * 0.5 * envelope * value);
+    }
+
+private:
+    int sample_rate_;
+    bool voiced_;
+    double pitch_;
+    double level_;
+    Noise noise_;
+    double phase_;
+    double time_;
+    double segment_left_;
+    bool talking_;
+};
+
+double ToDb(double ratio) {
+    return 10.0 * std::log10(std::max(ratio, 1e-12));
+}
+
+// 每帧处理耗时 (微秒)
+struct Timing {
+    double total_us = 0.0;
+    double max_us = 0.0;
+    size_t frames = 0;
+};
+
+bool RunScenario() {
+    const size_t frame = static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000;
+    EchoCanceller canceller;
+    if (!canceller.Configure(g_sample_rate, frame, g_tail_ms)) {
+        std::cerr << "错误: 回声消除器不支持该采样率与帧长" << std::endl;
+        return false;
+    }
+
+    std::vector<float> response;
+    if (!g_path_file.empty()) {
+        if (!LoadWav(g_path_file, &response)) {
+            return false;
+        }
+    } else {
+        response = MakeRoomResponse();
+    }
+    std::vector<float> recorded_far;
+    if (!g_far_file.empty() && !LoadWav(g_far_file, &recorded_far)) {
+        return false;
+    }
+    double path_energy = 0.0;
+    size_t peak = 0;
+    for (size_t i = 0; i < response.size(); ++i) {
+        path_energy += response[i] * response[i];
+        if (std::fabs(response[i]) > std::fabs(response[peak])) peak = i;
+    }
+    std::cout << "回声路径: " << (g_path_file.empty() ? "合成" : g_path_file) << ", " << response.size() * 1000 / g_sample_rate
+              << "ms, 能量 " << std::fixed << std::setprecision(1) << ToDb(path_energy) << "dB, 峰值位于 "
+              << peak * 1000.0 / g_sample_rate << "ms" << std::endl;
+    std::cout << "回声消除器: " << g_sample_rate << " Hz, 帧长 " << frame << ", 分块 " << canceller.GetBlockSize()
+              << " x " << canceller.GetPartitions() << " (覆盖 "
+              << canceller.GetBlockSize() * canceller.GetPartitions() * 1000 / g_sample_rate << "ms)" << std::endl;
+    if (response.size() > canceller.GetBlockSize() * canceller.GetPartitions()) {
+        std::cout << "注意: 回声路径长于回声消除器覆盖的长度，超出部分无法消除" << std::endl;
+    }
+
+    TalkSignal far_talker(g_sample_rate, g_voiced_far, 120.0, -12.0, 1);
+    TalkSignal near_talker(g_sample_rate, true, 210.0, -12.0, 2);
+    Noise near_noise(3);
+    const double noise_level = std::pow(10.0, kNoiseDbfs / 20.0);
+    const size_t total_frames = static_cast<size_t>(g_duration * g_sample_rate / frame);
+    const size_t frames_per_second = static_cast<size_t>(g_sample_rate) / frame;
+
+    std::vector<float> far_history(response.size() + frame, 0.0f);   // 卷积用的远端历史
+    std::vector<float> far(frame), near(frame), mic(frame), echo(frame);
+    size_t far_position = 0;
+    Timing timing;
+
+    // 每秒与各阶段的能量: 回声、残差回声
+    double second_echo = 0.0, second_residual = 0.0;
+    double single_echo = 0.0, single_residual = 0.0;    // 双讲开始前的最后2秒
+    double dt_echo = 0.0, dt_residual = 0.0;
+    double after_echo = 0.0, after_residual = 0.0;      // 双讲结束1秒之后
+    double converge20 = -1.0, converge30 = -1.0;
+    double window_echo = 0.0, window_residual = 0.0;    // 100ms 窗口，用于收敛时间
+    size_t window_active = 0;
+    const size_t window_frames = std::max<size_t>(1, frames_per_second / 10);
+
+    std::cout << std::endl << "  时间  状态      真实ERLE  估计ERLE" << std::endl;
+    for (size_t n = 0; n < total_frames; ++n) {
+        const double time = static_cast<double>(n * frame) / g_sample_rate;
+        const bool double_talk = g_double_talk >= 0.0 && time >= g_double_talk &&
+                                 time < g_double_talk + kDoubleTalkSeconds;
+        // 远端信号移入历史 (最新的样点在末尾)，回声为历史与冲激响应的卷积
+        std::memmove(far_history.data(), far_history.data() + frame, (far_history.size() - frame) * sizeof(float));
+        for (size_t i = 0; i < frame; ++i) {
+            if (!recorded_far.empty()) {
+                far[i] = recorded_far[far_position++ % recorded_far.size()];
+            } else {
+                far[i] = far_talker.Next();
+            }
+            far_history[far_history.size() - frame + i] = far[i];
+            const float talk = near_talker.Next();
+            near[i] = static_cast<float>(noise_level * near_noise.Next()) + (double_talk ? talk : 0.0f);
+        }
+        for (size_t i = 0; i < frame; ++i) {
+            const size_t newest = far_history.size() - frame + i;
+            double sum = 0.0;
+            for (size_t k = 0; k < response.size(); ++k) {
+                sum += response[k] * far_history[newest - k];
+            }
+            echo[i] = static_cast<float>(sum);
+            mic[i] = echo[i] + near[i];
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        canceller.Process(mic.data(), far.data(), frame);
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        timing.total_us += us;
+        timing.max_us = std::max(timing.max_us, us);
+        ++timing.frames;
+
+        double echo_energy = 0.0, residual_energy = 0.0;
+        for (size_t i = 0; i < frame; ++i) {
+            const double residual = mic[i] - near[i];
+            echo_energy += echo[i] * echo[i];
+            residual_energy += residual * residual;
+        }
+        // 远端停顿时回声只剩混响尾部，这些帧的比值没有意义
+        const bool echo_active = echo_energy > kEchoActive * frame;
+        if (!echo_active) {
+            echo_energy = residual_energy = 0.0;
+        } else {
+            ++window_active;
+        }
+        second_echo += echo_energy;
+        second_residual += residual_energy;
+        window_echo += echo_energy;
+        window_residual += residual_energy;
+        if (double_talk) {
+            dt_echo += echo_energy;
+            dt_residual += residual_energy;
+        } else if (g_double_talk < 0.0 || time < g_double_talk) {
+            if (time >= std::max(0.0, (g_double_talk < 0.0 ? g_duration : g_double_talk) - 2.0)) {
+                single_echo += echo_energy;
+                single_residual += residual_energy;
+            }
+        } else if (time >= g_double_talk + kDoubleTalkSeconds + 1.0) {
+            after_echo += echo_energy;
+            after_residual += residual_energy;
+        }
+
+        if ((n + 1) % window_frames == 0) {
+            // 至少一半的帧有回声的窗口才计入收敛判断
+            if (window_active * 2 >= window_frames) {
+                const double erle = ToDb(window_echo / std::max(window_residual, 1e-20));
+                const double end = static_cast<double>((n + 1) * frame) / g_sample_rate;
+                if (converge20 < 0.0 && erle >= 20.0) converge20 = end;
+                if (converge30 < 0.0 && erle >= 30.0) converge30 = end;
+            }
+            window_echo = window_residual = 0.0;
+            window_active = 0;
+        }
+        if ((n + 1) % frames_per_second == 0) {
+            std::cout << std::setw(5) << (n + 1) / frames_per_second << "s  " << (double_talk ? "双讲" : "单讲");
+            if (second_echo > 0.0) {
+                std::cout << std::setw(14) << ToDb(second_echo / std::max(second_residual, 1e-20)) << "dB";
+            } else {
+                std::cout << std::setw(16) << "-";
+            }
+            std::cout << std::setw(8) << canceller.GetErleDb() << "dB" << std::endl;
+            second_echo = second_residual = 0.0;
+        }
+    }
+
+    auto print_erle = [](const char* label, double echo, double residual) {
+        std::cout << label;
+        if (echo > 0.0) {
+            std::cout << ToDb(echo / std::max(residual, 1e-20)) << "dB" << std::endl;
+        } else {
+            std::cout << "-" << std::endl;
+        }
+    };
+    std::cout << std::endl;
+    std::cout << "收敛到 20dB/30dB: ";
+    std::cout << (converge20 < 0.0 ? std::string("未达到") : std::to_string(converge20).substr(0, 4) + "s") << " / "
+              << (converge30 < 0.0 ? std::string("未达到") : std::to_string(converge30).substr(0, 4) + "s") << std::endl;
+    print_erle("单讲稳态 ERLE (双讲前2秒): ", single_echo, single_residual);
+    print_erle("双讲期间 ERLE: ", dt_echo, dt_residual);
+    print_erle("双讲之后 ERLE (结束1秒后): ", after_echo, after_residual);
+    const double mean_us = timing.total_us / timing.frames;
+    std::cout << "每帧耗时: 平均 " << std::setprecision(1) << mean_us << "us, 最大 " << timing.max_us << "us ("
+              << std::setprecision(2) << 100.0 * mean_us / (g_frame_ms * 1000.0) << "% 单核)" << std::endl;
+    return true;
+}
+
+// 单独测量每帧的处理耗时: 远端与近端为独立的噪声，回声消除器一直处于自适应状态
+void RunCpuBenchmark() {
+    std::cout << std::endl << "CPU 基准 (帧长 " << g_frame_ms << "ms, 覆盖 " << g_tail_ms << "ms):" << std::endl;
+    const int rates[] = {8000, 16000, 48000};
+    for (int rate : rates) {
+        const size_t frame = static_cast<size_t>(rate) * g_frame_ms / 1000;
+        EchoCanceller canceller;
+        if (!canceller.Configure(rate, frame, g_tail_ms)) {
+            std::cout << "  " << rate << " Hz: 不支持该帧长" << std::endl;
+            continue;
+        }
+        Noise noise(rate);
+        std::vector<float> far(frame), near(frame);
+        const size_t frames = static_cast<size_t>(5000 / g_frame_ms);   // 5秒的音频
+        double total_us = 0.0;
+        for (size_t n = 0; n < frames; ++n) {
+            for (size_t i = 0; i < frame; ++i) {
+                far[i] = static_cast<float>(0.1 * noise.Next());
+                near[i] = static_cast<float>(0.05 * noise.Next() + 0.5 * far[i]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            canceller.Process(near.data(), far.data(), frame);
+            total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        const double mean_us = total_us / frames;
+        std::cout << "  " << std::setw(5) << rate << " Hz: 分块 " << canceller.GetBlockSize() << " x "
+                  << canceller.GetPartitions() << ", 每帧 " << std::setprecision(1) << mean_us << "us ("
+                  << std::setprecision(2) << 100.0 * mean_us / (g_frame_ms * 1000.0) << "% 单核)" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+    if (!RunScenario()) {
+        return 1;
+    }
+    RunCpuBenchmark();
+    return 0;
+}
@@ -0,0 +1,311 @@
+// 冗余音频 (FEC) 丢包模拟基准
+// 在虚拟时间上模拟一路发送者: 每个包由 FecEncoder 组装 (PCM16 主负载 + 前几帧的 ADPCM 副本)，
+// 经过 Gilbert-Elliott 两状态丢包信道 (固定单程时延) 送入接收流 RemoteStream，按包长拉取播放。
+// 对每个丢包率分别以冗余深度 0/1/2 与自适应深度 (接收报告驱动 FecController，与通话相同) 运行，
+// 各次运行的丢包序列相同。输出被冗余副本恢复的丢包比例、剩余丢包率、每包字节数 (含包头与 IP/UDP 头)、
+// 相对深度0的带宽开销，以及每包的组装与接收 (Push + Pull) 耗时
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "audio_fec.h"
+#include "remote_stream.h"
+
+namespace {
+
+int g_sample_rate = 16000;
+int g_channels = 1;
+int g_frame_ms = 20;             // 包长
+double g_burst = 2.0;            // 平均连续丢包数
+int g_packets = 20000;           // 每次运行的包数
+std::vector<double> g_losses;    // 平均丢包率 (%)，为空时使用默认的扫描列表
+uint64_t g_seed = 1;
+
+const double kOneWayDelay = 0.040;      // 单程时延
+const double kReportInterval = 1.0;     // 接收报告间隔 (与通话相同)
+const size_t kUdpIpOverhead = 28;       // IPv4 + UDP 头
+const double kDefaultLosses[] = {0.5, 1.0, 2.0, 3.0, 5.0, 8.0, 10.0, 15.0};
+const int kAdaptiveDepth = -1;
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -r, --rate <HZ>          采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -c, --channels <N>       声道数 (默认: 1)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    包长 10/20/40/60 毫秒 (默认: 20)" << std::endl;
+    std::cout << "  -l, --loss <PCT>         平均丢包率 (%)，可重复指定 (默认: 0.5 1 2 3 5 8 10 15)" << std::endl;
+    std::cout << "  -B, --burst <N>          平均连续丢包数，1 表示不会连续丢包 (默认: 2)" << std::endl;
+    std::cout << "  -n, --packets <N>        每次运行的包数 (默认: 20000)" << std::endl;
+    std::cout << "  -s, --seed <N>           丢包序列的随机种子 (默认: 1)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            g_sample_rate = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-c" || arg == "--channels") && i + 1 < argc) {
+            g_channels = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-l" || arg == "--loss") && i + 1 < argc) {
+            g_losses.push_back(std::atof(argv[++i]));
+        }
+        else if ((arg == "-B" || arg == "--burst") && i + 1 < argc) {
+            g_burst = std::atof(argv[++i]);
+        }
+        else if ((arg == "-n" || arg == "--packets") && i + 1 < argc) {
+            g_packets = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-s" || arg == "--seed") && i + 1 < argc) {
+            g_seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_losses.empty()) {
+        g_losses.assign(std::begin(kDefaultLosses), std::end(kDefaultLosses));
+    }
+    for (double loss : g_losses) {
+        if (loss < 0.0 || loss > 50.0) {
+            std::cerr << "错误: 丢包率必须在 0~50% 之间" << std::endl;
+            return false;
+        }
+    }
+    if (g_sample_rate < 8000 || g_channels < 1 || g_channels > 2 || g_burst < 1.0 || g_packets < 100) {
+        std::cerr << "错误: 参数超出范围 (声道数1~2，平均连续丢包数至少1，至少100个包)" << std::endl;
+        return false;
+    }
+    if (g_frame_ms != 10 && g_frame_ms != 20 && g_frame_ms != 40 && g_frame_ms != 60) {
+        std::cerr << "错误: 包长必须为 10/20/40/60 毫秒" << std::endl;
+        return false;
+    }
+    if (static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000 * g_channels * sizeof(int16_t) > kMaxPayloadSize) {
+        std::cerr << "错误: 一个包放不下，请降低采样率、声道数或包长" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 类似浊音的测试信号: 基音在120~200Hz之间缓慢变化的谐波，按约4Hz的音节起伏
+class VoicedSignal {
+public:
+    explicit VoicedSignal(int sample_rate) : sample_rate_(sample_rate), phase_(0.0), time_(0.0) {}
+
+    void Generate(int16_t* out, size_t frames, int channels) {
+        const double pi = 3.14159265358979323846;
+        for (size_t i = 0; i < frames; ++i) {
+            const double f0 = 160.0 + 40.0 * std::sin(2.0 * pi * 0.7 * time_);
+            const double envelope = 0.55 + 0.45 * std::sin(2.0 * pi * 4.0 * time_);
+            double value = 0.0;
+            for (int k = 1; k <= 12; ++k) {
+                if (k * f0 < sample_rate_ / 2) {
+                    value += std::sin(k * phase_) / k;
+                }
+            }
+            const int16_t sample = static_cast<int16_t>(std::lrint(5000.0 * envelope * value));
+            for (int ch = 0; ch < channels; ++ch) {
+                out[i * channels + ch] = sample;
+            }
+            phase_ = std::fmod(phase_ + 2.0 * pi * f0 / sample_rate_, 2.0 * pi);
+            time_ += 1.0 / sample_rate_;
+        }
+    }
+
+private:
+    int sample_rate_;
+    double phase_;
+    double time_;
+};
+
+// Gilbert-Elliott 两状态丢包信道 (与 call_simulator 的链路模型相同):
+// 稳态丢包率 p = enter / (enter + leave)，平均连续丢包数 = 1 / leave
+class LossChannel {
+public:
+    LossChannel(double loss, double burst, uint64_t seed) : engine_(seed), bad_(false), loss_(loss) {
+        leave_bad_ = 1.0 / burst;
+        enter_bad_ = std::min(1.0, loss * leave_bad_ / (1.0 - loss));
+    }
+
+    // 返回 true 表示这个包丢失
+    bool Drop() {
+        if (loss_ <= 0.0) {
+            return false;
+        }
+        const double draw = (engine_() >> 11) * (1.0 / 9007199254740992.0);
+        bad_ = bad_ ? draw >= leave_bad_ : draw < enter_bad_;
+        return bad_;
+    }
+
+private:
+    std::mt19937_64 engine_;
+    bool bad_;
+    double loss_;
+    double enter_bad_;
+    double leave_bad_;
+};
+
+struct Arrival {
+    double time;
+    AudioPacket packet;
+};
+
+struct RunResult {
+    uint64_t lost = 0;              // 信道丢弃的包
+    uint64_t recovered = 0;         // 由后续包的冗余副本补上的包
+    uint64_t concealed_frames = 0;  // 播放时补静音的帧 (不含第一个包到达之前)
+    uint64_t bytes = 0;             // 发出的字节 (含包头与 IP/UDP 头)
+    double average_depth = 0.0;     // 每包实际携带的冗余块数 (放不下的块被丢弃)
+    double encode_us = 0.0;         // 每包组装耗时
+    double receive_us = 0.0;        // 每包 Push + Pull 耗时
+};
+
+// depth 为 kAdaptiveDepth 时由接收报告驱动 FecController 选择深度
+RunResult run(const std::vector<int16_t>& signal, double loss_percent, int depth, size_t packet_frames) {
+    using Clock = std::chrono::steady_clock;
+    const double packet_seconds = static_cast<double>(packet_frames) / g_sample_rate;
+    LossChannel channel(loss_percent / 100.0, g_burst, g_seed);
+    FecEncoder encoder;
+    encoder.Configure(g_channels);
+    encoder.SetDepth(depth == kAdaptiveDepth ? 0 : depth);
+    FecController controller;
+    RemoteStream stream(1, g_sample_rate, g_channels, packet_frames, packet_frames);
+    std::vector<int16_t> out(packet_frames * g_channels);
+    std::deque<Arrival> in_flight;
+
+    RunResult result;
+    double encode_total_us = 0.0;
+    double receive_total_us = 0.0;
+    uint64_t depth_sum = 0;
+    double next_report = kReportInterval;
+    bool started = false;
+    uint64_t startup_concealed = 0;   // 第一个包到达之前补的静音
+    for (int n = 0; n < g_packets; ++n) {
+        // 包在最后一帧采集完成后发出，播放时钟与发送时钟错开一个不整的相位
+        const double now = (n + 1) * packet_seconds;
+
+        Arrival arrival;
+        memset(&arrival.packet, 0, sizeof(arrival.packet));
+        arrival.packet.sequence = htonl(static_cast<uint32_t>(n));
+        arrival.packet.timestamp = htonl(static_cast<uint32_t>(n * packet_frames));
+        arrival.packet.session_id = htonl(1);
+        const int16_t* pcm = &signal[n * packet_frames * g_channels];
+        uint8_t payload_type = kPayloadTypePcm16;
+        auto start = Clock::now();
+        size_t size = encoder.BuildPayload(pcm, packet_frames, static_cast<uint32_t>(n),
+                                           static_cast<uint32_t>(n * packet_frames), kPayloadTypePcm16,
+                                           arrival.packet.data, kMaxPayloadSize, &payload_type);
+        encode_total_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        arrival.packet.payload_type = payload_type;
+        arrival.packet.data_size = htons(static_cast<uint16_t>(size));
+        result.bytes += kUdpIpOverhead + kAudioPacketHeaderSize + size;
+        if (payload_type == kPayloadTypePcm16Redundant && size > 0) {
+            depth_sum += arrival.packet.data[0];
+        }
+        if (channel.Drop()) {
+            ++result.lost;
+        } else {
+            arrival.time = now + kOneWayDelay;
+            in_flight.push_back(arrival);
+        }
+
+        const double play_time = now + 0.0037;
+        start = Clock::now();
+        for (; !in_flight.empty() && in_flight.front().time <= play_time; in_flight.pop_front()) {
+            stream.Push(in_flight.front().packet, in_flight.front().time);
+            started = true;
+        }
+        stream.Pull(out.data(), packet_frames, play_time);
+        receive_total_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        if (!started) {
+            startup_concealed = stream.GetConcealedFrames();
+        }
+
+        // 接收报告经一个单程时延回到发送端，发送端在下一个包之前更新深度
+        if (depth == kAdaptiveDepth && play_time >= next_report) {
+            next_report += kReportInterval;
+            ReceiverReportBlock block;
+            if (stream.TakeReport(&block)) {
+                controller.OnLossReport(block.fraction_lost / 256.0f, play_time + kOneWayDelay);
+            }
+            encoder.SetDepth(controller.Update(play_time + kOneWayDelay));
+        }
+    }
+    result.recovered = stream.GetPacketsRecovered();
+    result.concealed_frames = stream.GetConcealedFrames() - startup_concealed;
+    result.average_depth = static_cast<double>(depth_sum) / g_packets;
+    result.encode_us = encode_total_us / g_packets;
+    result.receive_us = receive_total_us / g_packets;
+    return result;
+}
+
+void print_row(const char* label, const RunResult& result, uint64_t baseline_bytes, size_t packet_frames) {
+    const double lost = 100.0 * result.lost / g_packets;
+    const double recovered = result.lost > 0 ? 100.0 * result.recovered / result.lost : 0.0;
+    const double residual = 100.0 * (result.lost - result.recovered) / g_packets;
+    const double concealed = 100.0 * result.concealed_frames / (static_cast<double>(g_packets) * packet_frames);
+    const double overhead = 100.0 * (static_cast<double>(result.bytes) / baseline_bytes - 1.0);
+    const double kbps = result.bytes * 8.0 / (g_packets * g_frame_ms);
+    std::cout << std::fixed << std::setw(8) << label << std::setprecision(1) << std::setw(7) << result.average_depth
+              << std::setprecision(2) << std::setw(9) << lost << std::setprecision(1) << std::setw(9) << recovered
+              << std::setprecision(2) << std::setw(10) << residual << std::setw(10) << concealed
+              << std::setprecision(0) << std::setw(8) << static_cast<double>(result.bytes) / g_packets
+              << std::setw(7) << kbps << std::setprecision(1) << std::setw(9) << overhead << std::setprecision(2)
+              << std::setw(9) << result.encode_us << std::setw(9) << result.receive_us << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
+    const size_t packet_frames = static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000;
+    // 各次运行发送同一段信号
+    std::vector<int16_t> signal(static_cast<size_t>(g_packets) * packet_frames * g_channels);
+    VoicedSignal(g_sample_rate).Generate(signal.data(), signal.size() / g_channels, g_channels);
+    std::cout << "=== " << g_sample_rate << " Hz, " << g_channels << " 声道, " << g_frame_ms << "ms 包长, 平均连续丢包 "
+              << g_burst << ", 每次 " << g_packets << " 个包, 单程时延 " << kOneWayDelay * 1000 << "ms ===" << std::endl;
+    std::cout << "丢包: 信道丢包率; 恢复: 被冗余副本补上的丢包比例; 剩余: 恢复后仍缺失的包; 补静音: 播放时补静音的帧;"
+              << std::endl << "字节/包含16字节包头与28字节 IP/UDP 头; 开销: 相对深度0的带宽增加; 耗时为每包 (us)"
+              << std::endl;
+    for (double loss : g_losses) {
+        std::cout << std::defaultfloat << std::endl << "平均丢包率 " << loss << "%" << std::endl;
+        std::cout << "    深度   平均    丢包%    恢复%     剩余%   补静音%  字节/包  kbps    开销%     组装     接收"
+                  << std::endl;
+        uint64_t baseline_bytes = 0;
+        for (int depth = 0; depth <= kMaxFecDepth; ++depth) {
+            RunResult result = run(signal, loss, depth, packet_frames);
+            if (depth == 0) {
+                baseline_bytes = result.bytes;
+            }
+            print_row(std::to_string(depth).c_str(), result, baseline_bytes, packet_frames);
+        }
+        print_row("  自适应", run(signal, loss, kAdaptiveDepth, packet_frames), baseline_bytes, packet_frames);
+    }
+    return 0;
+}
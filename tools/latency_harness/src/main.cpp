@@ -0,0 +1,628 @@
+// 端到端 (嘴到耳) 延迟测量工具
+// 在本机启动 udp_server 与两个通话实例 (alice 发送、bob 接收)，两个实例之间各经过一条UDP中继。
+// alice 使用 "probe:source" 音频后端，每隔一个周期在采集数据中注入调频脉冲；
+// bob 使用 "probe:sink" 音频后端，记录写入播放设备的数据，通话结束后用匹配滤波找出脉冲，
+// 按各环节记录的时刻拆分延迟:
+//   采集缓冲    设备采集 -> Read 返回
+//   打包编码    Read 返回 -> 包到达中继 (凑满一个包、处理、编码与发送)
+//   网络与服务器 包到达中继 -> 服务器转发的包回到中继
+//   抖动缓冲    转发包回到中继 -> 写入播放设备 (接收、排队、混音与重采样)
+//   设备队列    写入播放设备 -> 播放
+// --cpu-load 时另外启动若干以默认优先级空转的进程，对比实时调度设置下两端的设备溢出/欠载次数
+// --trace 时每帧都追踪，客户端与服务器的事件合并导出为 Chrome trace JSON，可以逐帧查看各环节的时刻
+// --encrypt 时两端使用同一个随机房间密钥加密音频负载，加解密的耗时计入打包编码与抖动缓冲阶段
+// 结束时另外输出两端建立通话的耗时分解 (--async-connect 时设备打开与 JOIN 握手并行)
+
+#include "voice_call.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_backend.h"
+#include "frame_trace.h"
+#include "probe_audio_backend.h"
+#include "udp_relay.h"
+
+namespace {
+
+// 默认配置
+std::string g_server_bin = "udp_server";
+int g_server_port = 18080;        // 中继使用其后的两个端口
+int g_duration_seconds = 30;
+int g_period_ms = 1000;
+int g_sample_rate = 16000;
+int g_frame_size_ms = 20;
+bool g_dtx = false;
+bool g_reactor = false;
+int g_cpu_load_processes = 0;
+int g_realtime_priority = 0;      // 0 表示默认调度
+bool g_lock_memory = false;
+bool g_encrypt = false;
+bool g_async_connect = false;
+std::string g_trace_file;         // 非空时导出帧追踪
+bool g_verbose = false;
+
+const unsigned int kFirstBurstMs = 2000;   // 等待两端加入房间、处理链收敛后再开始注入
+const char* kSender = "latency_alice";
+const char* kReceiver = "latency_bob";
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -b, --server-bin <PATH>  udp_server 可执行文件 (默认: 在 PATH 中查找 udp_server)" << std::endl;
+    std::cout << "  -p, --port <PORT>        服务器端口，中继使用其后两个端口 (默认: 18080)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     测量时长 (默认: 30)" << std::endl;
+    std::cout << "  -i, --interval <MS>      脉冲间隔 (默认: 1000)" << std::endl;
+    std::cout << "  -r, --rate <HZ>          网络采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    包长: 10, 20, 40, 60 (默认: 20)" << std::endl;
+    std::cout << "      --dtx                开启DTX (默认关闭，语音检测的起始延迟会计入打包编码阶段)" << std::endl;
+    std::cout << "      --reactor            两个通话使用共享反应器 (use_shared_reactor)" << std::endl;
+    std::cout << "      --cpu-load <N>       测量期间运行 N 个空转进程作为合成CPU负载 (默认: 0)" << std::endl;
+    std::cout << "      --realtime <PRIO>    通话线程使用 SCHED_FIFO 优先级 PRIO (1-99)" << std::endl;
+    std::cout << "      --lock-memory        通话锁定内存 (lock_memory)" << std::endl;
+    std::cout << "      --encrypt            使用随机房间密钥加密音频负载 (media_key，AES-128-GCM)" << std::endl;
+    std::cout << "      --async-connect      异步连接 (async_connect)，设备打开与 JOIN 握手并行" << std::endl;
+    std::cout << "      --trace <FILE>       追踪每一帧，把客户端与服务器的事件合并导出为 Chrome trace JSON" << std::endl;
+    std::cout << "  -v, --verbose            显示服务器输出" << std::endl;
+    std::cout << std::endl;
+    std::cout << "示例:" << std::endl;
+    std::cout << "  " << program_name << " --server-bin ../../server/udp_server --duration 60" << std::endl;
+    std::cout << "  " << program_name << " --server-bin ../../server/udp_server --cpu-load 8 --realtime 50 --lock-memory" << std::endl;
+}
+
+bool parse_int(const char* text, int min_value, int max_value, int* value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || parsed < min_value || parsed > max_value) {
+        return false;
+    }
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if (arg == "-b" || arg == "--server-bin") {
+            if (!has_value) {
+                std::cerr << "错误: --server-bin 需要指定路径" << std::endl;
+                return false;
+            }
+            g_server_bin = argv[++i];
+        }
+        else if (arg == "-p" || arg == "--port") {
+            if (!has_value || !parse_int(argv[++i], 1, 65533, &g_server_port)) {
+                std::cerr << "错误: 端口号必须在 1-65533 之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-d" || arg == "--duration") {
+            if (!has_value || !parse_int(argv[++i], 5, 3600, &g_duration_seconds)) {
+                std::cerr << "错误: 测量时长必须在 5-3600 秒之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-i" || arg == "--interval") {
+            if (!has_value || !parse_int(argv[++i], 200, 10000, &g_period_ms)) {
+                std::cerr << "错误: 脉冲间隔必须在 200-10000 毫秒之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-r" || arg == "--rate") {
+            if (!has_value || !parse_int(argv[++i], 8000, 48000, &g_sample_rate)) {
+                std::cerr << "错误: 采样率必须在 8000-48000 之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "-f" || arg == "--frame-size") {
+            if (!has_value || !parse_int(argv[++i], 10, 60, &g_frame_size_ms) ||
+                (g_frame_size_ms != 10 && g_frame_size_ms != 20 && g_frame_size_ms != 40 && g_frame_size_ms != 60)) {
+                std::cerr << "错误: 包长必须为 10, 20, 40 或 60 毫秒" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--dtx") {
+            g_dtx = true;
+        }
+        else if (arg == "--reactor") {
+            g_reactor = true;
+        }
+        else if (arg == "--cpu-load") {
+            if (!has_value || !parse_int(argv[++i], 0, 256, &g_cpu_load_processes)) {
+                std::cerr << "错误: 负载进程数必须在 0-256 之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--realtime") {
+            if (!has_value || !parse_int(argv[++i], 1, 99, &g_realtime_priority)) {
+                std::cerr << "错误: 实时优先级必须在 1-99 之间" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--lock-memory") {
+            g_lock_memory = true;
+        }
+        else if (arg == "--encrypt") {
+            g_encrypt = true;
+        }
+        else if (arg == "--async-connect") {
+            g_async_connect = true;
+        }
+        else if (arg == "--trace") {
+            if (!has_value) {
+                std::cerr << "错误: --trace 需要指定输出文件" << std::endl;
+                return false;
+            }
+            g_trace_file = argv[++i];
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            g_verbose = true;
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 服务器子进程: 标准输入接管道，服务器读到 EOF 时退出
+struct ServerProcess {
+    pid_t pid = -1;
+    int stdin_fd = -1;
+};
+
+bool start_server(ServerProcess* server) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) < 0) {
+        std::cerr << "创建管道失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "fork 失败: " << strerror(errno) << std::endl;
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(pipe_fds[0], STDIN_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        if (!g_verbose) {
+            FILE* null_output = std::fopen("/dev/null", "w");
+            if (null_output) {
+                dup2(fileno(null_output), STDOUT_FILENO);
+                dup2(fileno(null_output), STDERR_FILENO);
+            }
+        }
+        std::string port = std::to_string(g_server_port);
+        std::string trace_file = g_trace_file + ".server.json";
+        if (g_trace_file.empty()) {
+            execlp(g_server_bin.c_str(), g_server_bin.c_str(), "-i", "127.0.0.1", "-p", port.c_str(),
+                   static_cast<char*>(nullptr));
+        } else {
+            execlp(g_server_bin.c_str(), g_server_bin.c_str(), "-i", "127.0.0.1", "-p", port.c_str(),
+                   "--trace", trace_file.c_str(), static_cast<char*>(nullptr));
+        }
+        std::_Exit(127);
+    }
+    close(pipe_fds[0]);
+    server->pid = pid;
+    server->stdin_fd = pipe_fds[1];
+
+    // 等待服务器绑定端口
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    int status = 0;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+        std::cerr << "服务器启动失败: " << g_server_bin << " (退出码 "
+                  << (WIFEXITED(status) ? WEXITSTATUS(status) : -1) << ")" << std::endl;
+        close(server->stdin_fd);
+        server->pid = -1;
+        return false;
+    }
+    return true;
+}
+
+// 客户端事件先导出到临时文件，与服务器退出时导出的文件合并后删除
+void merge_traces() {
+    const std::string client_file = g_trace_file + ".client.json";
+    const std::string server_file = g_trace_file + ".server.json";
+    voice_call_trace_stop(client_file.c_str());
+    if (MergeTraceFiles({client_file, server_file}, g_trace_file)) {
+        std::cout << "帧追踪 (客户端与服务器): " << g_trace_file << std::endl;
+        std::remove(client_file.c_str());
+        std::remove(server_file.c_str());
+    }
+}
+
+void stop_server(ServerProcess* server) {
+    if (server->pid < 0) return;
+    close(server->stdin_fd);
+    const int signals[] = {0, SIGTERM, SIGKILL};
+    for (int sig : signals) {
+        if (sig) kill(server->pid, sig);
+        for (int i = 0; i < 20; ++i) {
+            if (waitpid(server->pid, nullptr, WNOHANG) == server->pid) {
+                server->pid = -1;
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+// 两个通话共用的随机房间密钥 (十六进制)
+const std::string& media_key() {
+    static const std::string key = [] {
+        std::random_device device;
+        char hex[33];
+        for (int i = 0; i < 16; ++i) {
+            snprintf(hex + 2 * i, 3, "%02x", static_cast<unsigned>(device() & 0xff));
+        }
+        return std::string(hex);
+    }();
+    return key;
+}
+
+// 两端的建立耗时 (on_setup_complete 在通话的网络或音频线程中回调)
+std::mutex g_setup_mutex;
+voice_call_setup_stats_t g_sender_setup = {};
+voice_call_setup_stats_t g_receiver_setup = {};
+
+void on_sender_setup(const voice_call_setup_stats_t* stats) {
+    std::lock_guard<std::mutex> lock(g_setup_mutex);
+    g_sender_setup = *stats;
+}
+
+void on_receiver_setup(const voice_call_setup_stats_t* stats) {
+    std::lock_guard<std::mutex> lock(g_setup_mutex);
+    g_receiver_setup = *stats;
+}
+
+void print_setup(const char* name, const voice_call_setup_stats_t& stats) {
+    std::printf("%s 总计=%.2fms (设备=%.2fms, JOIN=%.2fms, 往返=%.2fms, 发送 %u 次)", name, stats.total_ms,
+                stats.audio_open_ms, stats.join_ms, stats.join_rtt_ms, stats.join_attempts);
+}
+
+voice_call_handle_t create_call(const char* user_id, int port, const char* backend,
+                                void (*on_setup_complete)(const voice_call_setup_stats_t*)) {
+    voice_call_config_t config = {};
+    std::string server_url = "udp://127.0.0.1:" + std::to_string(port);
+    strcpy(config.server_url, server_url.c_str());
+    strcpy(config.room_id, "latency_room");
+    strcpy(config.user_id, user_id);
+    strcpy(config.audio_backend, backend);
+
+    config.audio_config.sample_rate = g_sample_rate;
+    config.audio_config.channels = 1;
+    config.audio_config.bits_per_sample = 16;
+    config.audio_config.frame_size = g_frame_size_ms;
+
+    config.enable_echo_cancellation = true;
+    config.enable_noise_suppression = true;
+    config.enable_automatic_gain_control = true;
+    config.enable_dtx = g_dtx;
+    config.use_shared_reactor = g_reactor;
+    config.sched_policy = g_realtime_priority > 0 ? VOICE_CALL_SCHED_FIFO : VOICE_CALL_SCHED_DEFAULT;
+    config.sched_priority = g_realtime_priority;
+    config.lock_memory = g_lock_memory;
+    if (g_encrypt) {
+        strcpy(config.media_key, media_key().c_str());
+    }
+    config.async_connect = g_async_connect;
+
+    voice_call_callbacks_t callbacks = {};
+    callbacks.on_setup_complete = on_setup_complete;
+    return voice_call_init(&config, &callbacks);
+}
+
+// 设置主线程的调度策略，之后创建的线程与子进程继承该策略
+void set_main_thread_priority(int priority) {
+    sched_param param = {};
+    param.sched_priority = priority;
+    int result = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (result != 0) {
+        std::cerr << "警告: 无法设置服务器与中继的实时优先级: " << strerror(result) << std::endl;
+    }
+}
+
+// 合成CPU负载: 每个子进程以默认优先级空转，并反复改写一块超过末级缓存的内存，模拟同机的编译任务。
+// 使用独立进程而不是线程，负载的内存分配不会与通话争用同一个地址空间的锁
+class CpuLoad {
+public:
+    void Start(int processes) {
+        for (int i = 0; i < processes; ++i) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                std::cerr << "fork 失败: " << strerror(errno) << std::endl;
+                break;
+            }
+            if (pid == 0) {
+                const size_t kBytes = 16 * 1024 * 1024;
+                std::vector<uint8_t> memory(kBytes);
+                uint32_t state = 1;
+                for (;;) {
+                    for (size_t offset = 0; offset < kBytes; offset += 64) {
+                        state = state * 1664525u + 1013904223u;
+                        memory[offset] = static_cast<uint8_t>(state);
+                    }
+                }
+            }
+            pids_.push_back(pid);
+        }
+    }
+
+    void Stop() {
+        for (pid_t pid : pids_) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        pids_.clear();
+    }
+
+private:
+    std::vector<pid_t> pids_;
+};
+
+// 匹配滤波: 返回播放流中脉冲起点的位置 (归一化相关系数超过阈值的局部最大值)
+std::vector<size_t> detect_chirps(const std::vector<float>& signal, const std::vector<float>& chirp,
+                                  size_t min_spacing) {
+    const float threshold = 0.5f;
+    const size_t length = chirp.size();
+    std::vector<size_t> onsets;
+    if (signal.size() < length) return onsets;
+
+    double chirp_energy = 0.0;
+    for (float s : chirp) chirp_energy += s * s;
+    std::vector<double> energy_prefix(signal.size() + 1, 0.0);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        energy_prefix[i + 1] = energy_prefix[i] + signal[i] * signal[i];
+    }
+    auto score = [&](size_t n) {
+        double energy = energy_prefix[n + length] - energy_prefix[n];
+        if (energy < 1e-6) return 0.0;
+        double sum = 0.0;
+        for (size_t k = 0; k < length; ++k) sum += signal[n + k] * chirp[k];
+        return sum / std::sqrt(energy * chirp_energy);
+    };
+
+    size_t n = 0;
+    while (n + length <= signal.size()) {
+        if (score(n) < threshold) {
+            ++n;
+            continue;
+        }
+        // 在一个脉冲长度内取相关最大的位置
+        size_t best = n;
+        double best_score = score(n);
+        for (size_t m = n + 1; m < n + length && m + length <= signal.size(); ++m) {
+            double s = score(m);
+            if (s > best_score) {
+                best_score = s;
+                best = m;
+            }
+        }
+        onsets.push_back(best);
+        n = best + min_spacing;
+    }
+    return onsets;
+}
+
+// 各阶段的延迟样本 (毫秒)
+struct Stage {
+    const char* name;
+    std::vector<double> samples;
+};
+
+// 按显示宽度左对齐 (中文字符占两列)
+std::string pad(const char* text, size_t width) {
+    size_t columns = 0;
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if ((c & 0xC0) != 0x80) columns += c >= 0xE0 ? 2 : 1;
+    }
+    return std::string(text) + std::string(columns < width ? width - columns : 0, ' ');
+}
+
+void print_stage(const Stage& stage) {
+    std::string name = pad(stage.name, 14);
+    if (stage.samples.empty()) {
+        std::printf("  %s %6d\n", name.c_str(), 0);
+        return;
+    }
+    std::vector<double> sorted = stage.samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(std::ceil(p * sorted.size())) - 1;
+        return sorted[std::min(index, sorted.size() - 1)];
+    };
+    std::printf("  %s %6zu %8.2f %8.2f %8.2f %8.2f\n", name.c_str(), sorted.size(),
+                sorted.front(), percentile(0.5), percentile(0.95), sorted.back());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    auto recorder = std::make_shared<ProbeRecorder>(g_period_ms, kFirstBurstMs);
+    RegisterAudioBackend("probe", [recorder](const std::string& args) -> std::unique_ptr<AudioBackend> {
+        if (args != "source" && args != "sink") return nullptr;
+        return std::unique_ptr<AudioBackend>(new ProbeAudioBackend(args == "source", recorder));
+    });
+
+    // 实时调度时服务器与中继也以同一优先级运行，负载只作用于被测的通话 (实际部署中服务器在另一台机器上)
+    if (g_realtime_priority > 0) {
+        set_main_thread_priority(g_realtime_priority);
+    }
+
+    ServerProcess server;
+    if (!start_server(&server)) {
+        return 1;
+    }
+
+    // 两条中继都记录发送者的包: alice 一侧记录上行，bob 一侧记录服务器转发的下行
+    UdpRelay sender_relay;
+    UdpRelay receiver_relay;
+    sender_relay.TrackSource(kSender);
+    receiver_relay.TrackSource(kSender);
+    if (!sender_relay.Start(g_server_port + 1, g_server_port) ||
+        !receiver_relay.Start(g_server_port + 2, g_server_port)) {
+        stop_server(&server);
+        return 1;
+    }
+    if (g_realtime_priority > 0) {
+        set_main_thread_priority(0);
+    }
+
+    if (!g_trace_file.empty()) {
+        voice_call_trace_start(1);
+    }
+    voice_call_handle_t receiver = create_call(kReceiver, g_server_port + 2, "probe:sink", on_receiver_setup);
+    voice_call_handle_t sender = create_call(kSender, g_server_port + 1, "probe:source", on_sender_setup);
+    if (!receiver || !sender ||
+        voice_call_connect(receiver) != VOICE_CALL_SUCCESS ||
+        voice_call_connect(sender) != VOICE_CALL_SUCCESS) {
+        std::cerr << "通话初始化或连接失败" << std::endl;
+        if (sender) voice_call_destroy(sender);
+        if (receiver) voice_call_destroy(receiver);
+        sender_relay.Stop();
+        receiver_relay.Stop();
+        stop_server(&server);
+        return 1;
+    }
+
+    CpuLoad load;
+    load.Start(g_cpu_load_processes);
+    std::this_thread::sleep_for(std::chrono::seconds(g_duration_seconds));
+    load.Stop();
+
+    voice_call_stats_t sender_stats = {};
+    voice_call_stats_t receiver_stats = {};
+    voice_call_get_stats(sender, &sender_stats);
+    voice_call_get_stats(receiver, &receiver_stats);
+    voice_call_disconnect(sender);
+    voice_call_disconnect(receiver);
+    voice_call_destroy(sender);
+    voice_call_destroy(receiver);
+    sender_relay.Stop();
+    receiver_relay.Stop();
+    stop_server(&server);
+    if (!g_trace_file.empty()) {
+        merge_traces();
+    }
+
+    // 分析
+    std::vector<ProbeBurst> bursts = recorder->GetBursts();
+    std::vector<ProbeChunk> chunks = recorder->GetChunks();
+    std::vector<float> playback = recorder->GetPlayback();
+    std::vector<float> chirp = MakeChirp(g_sample_rate);
+    const double period = g_period_ms / 1000.0;
+    std::vector<size_t> onsets = detect_chirps(playback, chirp, static_cast<size_t>(g_sample_rate * period / 2));
+
+    Stage stages[] = {
+        {"采集缓冲", {}},
+        {"打包编码", {}},
+        {"网络与服务器", {}},
+        {"抖动缓冲", {}},
+        {"设备队列", {}},
+        {"总延迟", {}},
+    };
+    size_t matched = 0;
+    for (size_t onset : onsets) {
+        // 脉冲起点所在的写入段
+        auto chunk = std::upper_bound(chunks.begin(), chunks.end(), onset,
+                                      [](size_t value, const ProbeChunk& c) { return value < c.start; });
+        if (chunk == chunks.begin()) continue;
+        --chunk;
+        double play_time = chunk->end_play_time -
+                           static_cast<double>(chunk->start + chunk->frames - 1 - onset) / g_sample_rate;
+
+        // 一个周期内最近注入的脉冲
+        const ProbeBurst* burst = nullptr;
+        for (const ProbeBurst& b : bursts) {
+            if (b.capture_time < play_time && play_time - b.capture_time < period) burst = &b;
+        }
+        if (!burst) continue;
+        ++matched;
+
+        stages[0].samples.push_back((burst->read_time - burst->capture_time) * 1000.0);
+        stages[4].samples.push_back((play_time - chunk->write_time) * 1000.0);
+        stages[5].samples.push_back((play_time - burst->capture_time) * 1000.0);
+
+        uint32_t sequence = 0;
+        double upstream_time = 0.0;
+        double downstream_time = 0.0;
+        if (!sender_relay.FindUpstream(static_cast<uint32_t>(burst->frame), &sequence, &upstream_time)) continue;
+        stages[1].samples.push_back((upstream_time - burst->read_time) * 1000.0);
+        if (!receiver_relay.FindDownstream(sequence, &downstream_time)) continue;
+        stages[2].samples.push_back((downstream_time - upstream_time) * 1000.0);
+        stages[3].samples.push_back((chunk->write_time - downstream_time) * 1000.0);
+    }
+
+    std::cout << std::endl;
+    std::cout << "=== 端到端延迟 (" << g_duration_seconds << " 秒，" << g_sample_rate << " Hz，" << g_frame_size_ms
+              << " ms 包长，DTX " << (g_dtx ? "开" : "关") << (g_reactor ? "，共享反应器" : "")
+              << (g_encrypt ? "，加密" : "") << ") ===" << std::endl;
+    if (g_cpu_load_processes > 0 || g_realtime_priority > 0 || g_lock_memory) {
+        std::cout << "负载进程: " << g_cpu_load_processes << "，调度: "
+                  << (g_realtime_priority > 0 ? "SCHED_FIFO " + std::to_string(g_realtime_priority) : std::string("默认"))
+                  << "，锁定内存: " << (g_lock_memory ? "是" : "否") << std::endl;
+    }
+    std::cout << "注入脉冲: " << bursts.size() << "，检测到: " << onsets.size()
+              << "，匹配: " << matched << std::endl;
+    std::cout << "  " << pad("阶段", 14) << "   样本     最小   中位数      P95     最大  (毫秒)" << std::endl;
+    for (const Stage& stage : stages) {
+        print_stage(stage);
+    }
+    std::cout << "接收端: 丢包=" << receiver_stats.packets_lost
+              << ", 晚到=" << receiver_stats.packets_late
+              << ", 接收队列=" << receiver_stats.jitter_buffer_ms << "ms"
+              << ", 抖动=" << receiver_stats.jitter_ms << "ms"
+              << ", 播放欠载=" << receiver_stats.playback_xruns
+              << ", 认证失败=" << receiver_stats.decrypt_failures << std::endl;
+    std::cout << "设备溢出/欠载: 发送端 采集=" << sender_stats.capture_xruns << " 播放=" << sender_stats.playback_xruns
+              << "，接收端 采集=" << receiver_stats.capture_xruns << " 播放=" << receiver_stats.playback_xruns
+              << "，补静音=" << receiver_stats.concealed_frames << " 帧"
+              << "，快放/慢放=" << receiver_stats.accelerated_frames << "/" << receiver_stats.decelerated_frames << " 帧"
+              << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(g_setup_mutex);
+        std::cout << "通话建立 (" << (g_async_connect ? "异步" : "同步") << "): ";
+        print_setup("发送端", g_sender_setup);
+        std::cout << "，";
+        print_setup("接收端", g_receiver_setup);
+        std::cout << std::endl;
+    }
+    return matched > 0 ? 0 : 1;
+}
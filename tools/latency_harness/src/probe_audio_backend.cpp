@@ -0,0 +1,119 @@
+#include "probe_audio_backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<float> MakeChirp(unsigned int sample_rate) {
+    const double duration = 0.05;
+    const double f0 = 1000.0;
+    const double f1 = 3000.0;
+    const double fade = 0.005;
+    size_t length = static_cast<size_t>(sample_rate * duration);
+    std::vector<float> chirp(length);
+    for (size_t i = 0; i < length; ++i) {
+        double t = static_cast<double>(i) / sample_rate;
+        double phase = 2.0 * M_PI * (f0 * t + (f1 - f0) / (2.0 * duration) * t * t);
+        double envelope = std::min(1.0, std::min(t, duration - t) / fade);
+        chirp[i] = static_cast<float>(0.5 * envelope * std::sin(phase));
+    }
+    return chirp;
+}
+
+ProbeRecorder::ProbeRecorder(unsigned int period_ms, unsigned int first_burst_ms)
+    : period_ms_(period_ms), first_burst_ms_(first_burst_ms) {
+}
+
+void ProbeRecorder::AddBurst(const ProbeBurst& burst) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bursts_.push_back(burst);
+}
+
+void ProbeRecorder::AddPlayback(const int16_t* pcm, size_t frames, int channels,
+                                double write_time, double end_play_time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunks_.push_back({playback_.size(), frames, write_time, end_play_time});
+    for (size_t i = 0; i < frames; ++i) {
+        playback_.push_back(pcm[i * channels] / 32768.0f);
+    }
+}
+
+std::vector<ProbeBurst> ProbeRecorder::GetBursts() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bursts_;
+}
+
+std::vector<ProbeChunk> ProbeRecorder::GetChunks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_;
+}
+
+std::vector<float> ProbeRecorder::GetPlayback() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return playback_;
+}
+
+ProbeAudioBackend::ProbeAudioBackend(bool source, std::shared_ptr<ProbeRecorder> recorder)
+    : source_(source), recorder_(recorder), inner_(CreateAudioBackend("null")),
+      channels_(0), captured_frames_(0) {
+}
+
+bool ProbeAudioBackend::Open(unsigned int sample_rate, int channels) {
+    channels_ = channels;
+    captured_frames_ = 0;
+    chirp_ = MakeChirp(sample_rate);
+    return inner_->Open(sample_rate, channels);
+}
+
+void ProbeAudioBackend::Close() {
+    inner_->Close();
+}
+
+long ProbeAudioBackend::Read(int16_t* pcm, size_t frames) {
+    long result = inner_->Read(pcm, frames);
+    if (result <= 0 || !source_) {
+        return result;
+    }
+
+    double now = NowSeconds();
+    const unsigned int rate = inner_->GetCaptureRate();
+    // 本次返回的最后一帧在 now 之前 delay 帧被采集
+    long delay = inner_->GetCaptureDelay();
+    const uint64_t period = static_cast<uint64_t>(rate) * recorder_->GetPeriodMs() / 1000;
+    const uint64_t first = static_cast<uint64_t>(rate) * recorder_->GetFirstBurstMs() / 1000;
+    for (long i = 0; i < result; ++i) {
+        uint64_t frame = captured_frames_ + i;
+        if (frame < first) continue;
+        uint64_t offset = (frame - first) % period;
+        if (offset >= chirp_.size()) continue;
+        if (offset == 0) {
+            double capture_time = now - static_cast<double>(delay + result - 1 - i) / rate;
+            recorder_->AddBurst({frame, capture_time, now});
+        }
+        int16_t sample = static_cast<int16_t>(std::lrint(chirp_[offset] * 32767.0f));
+        for (int ch = 0; ch < channels_; ++ch) {
+            pcm[i * channels_ + ch] = sample;
+        }
+    }
+    captured_frames_ += result;
+    return result;
+}
+
+long ProbeAudioBackend::Write(const int16_t* pcm, size_t frames) {
+    double write_time = NowSeconds();
+    long result = inner_->Write(pcm, frames);
+    if (result <= 0 || source_) {
+        return result;
+    }
+
+    // 写入后设备中未播放的帧数包含本次写入的数据，最后一帧在这些帧播放完时播出
+    double now = NowSeconds();
+    long delay = inner_->GetPlaybackDelay();
+    double end_play_time = now + static_cast<double>(delay) / inner_->GetPlaybackRate();
+    recorder_->AddPlayback(pcm, static_cast<size_t>(result), channels_, write_time, end_play_time);
+    return result;
+}
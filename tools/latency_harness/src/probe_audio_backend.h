@@ -0,0 +1,85 @@
+#ifndef PROBE_AUDIO_BACKEND_H
+#define PROBE_AUDIO_BACKEND_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audio_backend.h"
+
+// 探测信号: 线性调频脉冲 (1kHz -> 3kHz，50ms，两端各5ms淡入淡出)
+std::vector<float> MakeChirp(unsigned int sample_rate);
+
+// 注入的一个脉冲 (发送端)
+struct ProbeBurst {
+    uint64_t frame;        // 脉冲第一个样点的采集帧序号 (与发送端媒体时间戳相同)
+    double capture_time;   // 第一个样点被设备采集的时刻
+    double read_time;      // 含该样点的数据被 Read 返回的时刻
+};
+
+// 播放端写入设备的一段数据
+struct ProbeChunk {
+    uint64_t start;        // 第一帧在播放流中的序号
+    size_t frames;
+    double write_time;     // 调用 Write 的时刻
+    double end_play_time;  // 最后一帧从设备播放出去的时刻
+};
+
+// 两个探测后端共享的记录，Read/Write 在音频线程中追加，分析在通话结束后进行
+class ProbeRecorder {
+public:
+    ProbeRecorder(unsigned int period_ms, unsigned int first_burst_ms);
+
+    unsigned int GetPeriodMs() const { return period_ms_; }
+    unsigned int GetFirstBurstMs() const { return first_burst_ms_; }
+
+    void AddBurst(const ProbeBurst& burst);
+    void AddPlayback(const int16_t* pcm, size_t frames, int channels, double write_time, double end_play_time);
+
+    std::vector<ProbeBurst> GetBursts();
+    std::vector<ProbeChunk> GetChunks();
+    std::vector<float> GetPlayback();
+
+private:
+    unsigned int period_ms_;
+    unsigned int first_burst_ms_;
+    std::mutex mutex_;
+    std::vector<ProbeBurst> bursts_;
+    std::vector<ProbeChunk> chunks_;
+    std::vector<float> playback_;   // 播放流第一声道 (归一化到 [-1, 1])
+};
+
+// 探测后端: 内部使用 null 后端的设备时钟，
+// "source" 角色在采集数据中周期性注入调频脉冲，"sink" 角色记录写入播放设备的全部数据与时刻
+class ProbeAudioBackend : public AudioBackend {
+public:
+    ProbeAudioBackend(bool source, std::shared_ptr<ProbeRecorder> recorder);
+
+    bool Open(unsigned int sample_rate, int channels) override;
+    void Close() override;
+    void Start() override { inner_->Start(); }
+
+    unsigned int GetCaptureRate() const override { return inner_->GetCaptureRate(); }
+    unsigned int GetPlaybackRate() const override { return inner_->GetPlaybackRate(); }
+
+    long Read(int16_t* pcm, size_t frames) override;
+    long Write(const int16_t* pcm, size_t frames) override;
+
+    long GetCaptureDelay() override { return inner_->GetCaptureDelay(); }
+    long GetPlaybackDelay() override { return inner_->GetPlaybackDelay(); }
+
+    const char* GetName() const override { return source_ ? "probe:source" : "probe:sink"; }
+
+private:
+    bool source_;
+    std::shared_ptr<ProbeRecorder> recorder_;
+    std::unique_ptr<AudioBackend> inner_;
+    int channels_;
+    std::vector<float> chirp_;
+    uint64_t captured_frames_;
+};
+
+// 当前时刻 (steady_clock，秒)
+double NowSeconds();
+
+#endif // PROBE_AUDIO_BACKEND_H
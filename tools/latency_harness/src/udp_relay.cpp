@@ -0,0 +1,171 @@
+#include "udp_relay.h"
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "probe_audio_backend.h"
+#include "voice_packet.h"
+
+UdpRelay::UdpRelay()
+    : client_fd_(-1), server_fd_(-1), client_known_(false), running_(false), source_id_(kUnassignedSessionId) {
+    std::memset(&server_addr_, 0, sizeof(server_addr_));
+    std::memset(&client_addr_, 0, sizeof(client_addr_));
+}
+
+UdpRelay::~UdpRelay() {
+    Stop();
+}
+
+bool UdpRelay::Start(int listen_port, int server_port) {
+    client_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    server_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (client_fd_ < 0 || server_fd_ < 0) {
+        std::cerr << "Failed to create relay socket" << std::endl;
+        Stop();
+        return false;
+    }
+
+    sockaddr_in listen_addr;
+    std::memset(&listen_addr, 0, sizeof(listen_addr));
+    listen_addr.sin_family = AF_INET;
+    listen_addr.sin_port = htons(listen_port);
+    listen_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(client_fd_, reinterpret_cast<sockaddr*>(&listen_addr), sizeof(listen_addr)) < 0) {
+        std::cerr << "Failed to bind relay port " << listen_port << ": " << strerror(errno) << std::endl;
+        Stop();
+        return false;
+    }
+
+    server_addr_.sin_family = AF_INET;
+    server_addr_.sin_port = htons(server_port);
+    server_addr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    running_ = true;
+    thread_ = std::thread(&UdpRelay::Loop, this);
+    return true;
+}
+
+void UdpRelay::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (client_fd_ >= 0) {
+        close(client_fd_);
+        client_fd_ = -1;
+    }
+    if (server_fd_ >= 0) {
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+}
+
+bool UdpRelay::FindUpstream(uint32_t timestamp, uint32_t* sequence, double* time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 含该媒体时间戳的包: 起始时间戳不大于它的最后一个包
+    auto found = upstream_.upper_bound(timestamp);
+    if (found == upstream_.begin()) {
+        return false;
+    }
+    --found;
+    *sequence = found->second.sequence;
+    *time = found->second.time;
+    return true;
+}
+
+bool UdpRelay::FindDownstream(uint32_t sequence, double* time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = downstream_.find(sequence);
+    if (found == downstream_.end()) {
+        return false;
+    }
+    *time = found->second;
+    return true;
+}
+
+void UdpRelay::Record(const uint8_t* data, ssize_t size, bool upstream) {
+    if (size < static_cast<ssize_t>(kAudioPacketHeaderSize)) {
+        return;
+    }
+    AudioPacketHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (ntohl(header.session_id) != source_id_ || (header.flags & kPacketFlagRetransmit)) {
+        return;
+    }
+    switch (header.payload_type) {
+        case kPayloadTypePcm16:
+        case kPayloadTypePcm16Redundant:
+        case kPayloadTypeAdpcm:
+        case kPayloadTypeAdpcmRedundant:
+            break;
+        default:
+            return;
+    }
+
+    double now = NowSeconds();
+    uint32_t sequence = ntohl(header.sequence);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (upstream) {
+        upstream_.insert({ntohl(header.timestamp), {sequence, now}});
+    } else {
+        downstream_.insert({sequence, now});
+    }
+}
+
+void UdpRelay::LearnSession(const uint8_t* data, ssize_t size) {
+    // "JOIN_OK:房间:用户:会话ID" 或 "JOIN:房间:用户:会话ID"
+    std::string message(reinterpret_cast<const char*>(data), size);
+    if (message.compare(0, 8, "JOIN_OK:") != 0 && message.compare(0, 5, "JOIN:") != 0) {
+        return;
+    }
+    size_t user_end = message.rfind(':');
+    size_t user_start = message.rfind(':', user_end - 1);
+    if (user_start == std::string::npos || user_start == 0 ||
+        message.compare(user_start + 1, user_end - user_start - 1, source_user_) != 0) {
+        return;
+    }
+    source_id_ = static_cast<uint32_t>(std::strtoul(message.c_str() + user_end + 1, nullptr, 10));
+}
+
+void UdpRelay::Loop() {
+    uint8_t buffer[2048];
+    pollfd fds[2] = {{client_fd_, POLLIN, 0}, {server_fd_, POLLIN, 0}};
+    while (running_) {
+        if (poll(fds, 2, 100) <= 0) {
+            continue;
+        }
+
+        // 客户端 -> 服务器
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            ssize_t received = recvfrom(client_fd_, buffer, sizeof(buffer), 0,
+                                        reinterpret_cast<sockaddr*>(&from), &from_len);
+            if (received > 0) {
+                client_addr_ = from;
+                client_known_ = true;
+                Record(buffer, received, true);
+                sendto(server_fd_, buffer, received, 0,
+                       reinterpret_cast<sockaddr*>(&server_addr_), sizeof(server_addr_));
+            }
+        }
+
+        // 服务器 -> 客户端
+        if (fds[1].revents & POLLIN) {
+            ssize_t received = recv(server_fd_, buffer, sizeof(buffer), 0);
+            if (received > 0 && client_known_) {
+                LearnSession(buffer, received);
+                Record(buffer, received, false);
+                sendto(client_fd_, buffer, received, 0,
+                       reinterpret_cast<sockaddr*>(&client_addr_), sizeof(client_addr_));
+            }
+        }
+    }
+}
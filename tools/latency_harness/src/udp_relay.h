@@ -0,0 +1,57 @@
+#ifndef UDP_RELAY_H
+#define UDP_RELAY_H
+
+#include <netinet/in.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 客户端与服务器之间的UDP中继 (每个客户端一条)，记录指定发送者音频包经过中继的时刻:
+//   上行: 该发送者的客户端发出的原始音频包到达中继 (不含重传)
+//   下行: 服务器转发给另一个客户端的同一个包到达中继
+// 中继本身在本机回环上只增加几十微秒，计入"网络与服务器"阶段
+class UdpRelay {
+public:
+    UdpRelay();
+    ~UdpRelay();
+
+    // 在 127.0.0.1:listen_port 上等待客户端，转发到 127.0.0.1:server_port
+    bool Start(int listen_port, int server_port);
+    void Stop();
+
+    // 记录 user_id 用户的包 (按序列号)。会话ID由服务器分配，从经过中继的 JOIN_OK/JOIN 消息中得到
+    void TrackSource(const std::string& user_id) { source_user_ = user_id; }
+
+    // 查询某个包的到达时刻 (NowSeconds)，没有记录时返回 false
+    bool FindUpstream(uint32_t timestamp, uint32_t* sequence, double* time);
+    bool FindDownstream(uint32_t sequence, double* time);
+
+private:
+    void Loop();
+    void Record(const uint8_t* data, ssize_t size, bool upstream);
+    void LearnSession(const uint8_t* data, ssize_t size);
+
+    int client_fd_;     // 面向客户端
+    int server_fd_;     // 面向服务器
+    sockaddr_in server_addr_;
+    sockaddr_in client_addr_;
+    bool client_known_;
+    std::atomic<bool> running_;
+    std::string source_user_;
+    std::atomic<uint32_t> source_id_;
+    std::thread thread_;
+
+    struct UpstreamPacket {
+        uint32_t sequence;
+        double time;
+    };
+    std::mutex mutex_;
+    std::map<uint32_t, UpstreamPacket> upstream_;   // 媒体时间戳 -> 包
+    std::map<uint32_t, double> downstream_;         // 序列号 -> 到达时刻
+};
+
+#endif // UDP_RELAY_H
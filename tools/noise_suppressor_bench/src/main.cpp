@@ -0,0 +1,522 @@
+// 噪声抑制基准
+// 干净语音 (合成的讲话/停顿交替的浊音，或 --speech 指定的录音) 按给定信噪比与一组噪声混合后送入
+// 噪声抑制器。噪声集包括白噪声、粉红噪声、褐色噪声 (低频隆隆声)、电源嗡声、多人嘈杂声与幅度起伏的
+// 非平稳噪声，--noise 可以再加入一段录制的噪声。因为干净语音已知，输出按抑制器的一个跳步对齐后计算:
+//   输出信噪比   讲话帧上 干净语音 与 (输出 - 干净语音) 的功率比，语音失真也计入噪声
+//   分段信噪比   讲话帧逐帧信噪比 (限制在 -10~35dB) 的平均
+//   停顿噪声衰减 停顿帧上输入噪声与输出的功率比
+// 开头2秒 (噪声底跟踪的建立时间) 不计入。最后单独测量 8/16/48kHz 下每帧的处理耗时
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "noise_suppressor.h"
+
+namespace {
+
+int g_sample_rate = 16000;
+int g_frame_ms = 20;
+double g_duration = 20.0;      // 每种噪声的时长 (秒)
+std::vector<double> g_snrs;    // 输入信噪比 (dB)，为空时使用默认列表
+std::string g_speech_file;     // 录制的干净语音 (WAV)，不指定时使用合成信号
+std::string g_noise_file;      // 加入噪声集的录制噪声 (WAV)
+
+const double kDefaultSnrs[] = {0.0, 5.0, 10.0, 20.0};
+const double kSettleSeconds = 2.0;     // 不计入统计的开头
+const double kActiveThreshold = 1e-4;  // 帧功率高于最大帧功率 -40dB 的帧视为讲话帧
+const double kPi = 3.14159265358979323846;
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -r, --rate <HZ>          采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    帧长 10/20 毫秒 (默认: 20)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     每种噪声的时长 (秒，默认: 20)" << std::endl;
+    std::cout << "  -S, --snr <DB>           输入信噪比，可重复指定 (默认: 0 5 10 20)" << std::endl;
+    std::cout << "  -s, --speech <FILE>      干净语音 (WAV，16位PCM或32位float，采样率须与 -r 相同)" << std::endl;
+    std::cout << "  -n, --noise <FILE>       加入噪声集的录制噪声 (WAV，长度不足时循环)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            g_sample_rate = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration = std::atof(argv[++i]);
+        }
+        else if ((arg == "-S" || arg == "--snr") && i + 1 < argc) {
+            g_snrs.push_back(std::atof(argv[++i]));
+        }
+        else if ((arg == "-s" || arg == "--speech") && i + 1 < argc) {
+            g_speech_file = argv[++i];
+        }
+        else if ((arg == "-n" || arg == "--noise") && i + 1 < argc) {
+            g_noise_file = argv[++i];
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_snrs.empty()) {
+        g_snrs.assign(std::begin(kDefaultSnrs), std::end(kDefaultSnrs));
+    }
+    if (g_sample_rate < 8000 || g_sample_rate > 48000 || g_duration < kSettleSeconds + 3.0) {
+        std::cerr << "错误: 参数超出范围 (采样率 8000~48000，时长至少5秒)" << std::endl;
+        return false;
+    }
+    // 音频循环的周期不超过20ms，噪声抑制器按周期长度配置
+    if (g_frame_ms != 10 && g_frame_ms != 20) {
+        std::cerr << "错误: 帧长必须为 10/20 毫秒" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 可复现的伪随机数 (xorshift64)，返回 [-1, 1)
+class Noise {
+public:
+    explicit Noise(uint64_t seed) : state_(seed) {}
+    double Next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<double>(state_ >> 11) / static_cast<double>(1ULL << 52) - 1.0;
+    }
+
+private:
+    uint64_t state_;
+};
+
+// 读取 WAV 的第一个声道 (16位PCM或32位float)，归一化到 [-1, 1)
+bool LoadWav(const std::string& path, std::vector<float>* samples) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "错误: 无法打开 " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+
+    auto u16 = [&](size_t at) { return static_cast<uint32_t>(data[at] | (data[at + 1] << 8)); };
+    auto u32 = [&](size_t at) { return u16(at) | (u16(at + 2) << 16); };
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << "错误: " << path << " 不是 WAV 文件" << std::endl;
+        return false;
+    }
+    uint32_t format = 0, channels = 0, rate = 0, bits = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        const uint32_t size = u32(pos + 4);
+        const size_t body = pos + 8;
+        if (memcmp(data.data() + pos, "fmt ", 4) == 0 && body + 16 <= data.size()) {
+            format = u16(body);
+            channels = u16(body + 2);
+            rate = u32(body + 4);
+            bits = u16(body + 14);
+        } else if (memcmp(data.data() + pos, "data", 4) == 0 && format != 0) {
+            if (rate != static_cast<uint32_t>(g_sample_rate)) {
+                std::cerr << "错误: " << path << " 的采样率为 " << rate << " Hz，请先重采样到 " << g_sample_rate
+                          << " Hz" << std::endl;
+                return false;
+            }
+            const bool pcm16 = format == 1 && bits == 16;
+            const bool float32 = format == 3 && bits == 32;
+            if (!pcm16 && !float32) {
+                std::cerr << "错误: " << path << " 只支持16位PCM或32位float" << std::endl;
+                return false;
+            }
+            const size_t stride = channels * bits / 8;
+            const size_t end = std::min(data.size(), body + size);
+            for (size_t at = body; at + stride <= end; at += stride) {
+                if (pcm16) {
+                    samples->push_back(static_cast<int16_t>(u16(at)) / 32768.0f);
+                } else {
+                    uint32_t bits_value = u32(at);
+                    float value;
+                    memcpy(&value, &bits_value, sizeof(value));
+                    samples->push_back(value);
+                }
+            }
+            return !samples->empty();
+        }
+        pos = body + size + (size & 1);
+    }
+    std::cerr << "错误: " << path << " 没有音频数据" << std::endl;
+    return false;
+}
+
+// 按随机的讲话 (0.5~2秒)/停顿 (0.2~0.8秒) 交替、带 4Hz 包络的合成浊音: 基音缓慢变化的谐波加少量噪声
+class TalkSignal {
+public:
+    TalkSignal(int sample_rate, double pitch, uint64_t seed)
+        : sample_rate_(sample_rate), pitch_(pitch), noise_(seed), phase_(0.0), time_(0.0), segment_left_(0.0),
+          talking_(false) {}
+
+    float Next() {
+        if (segment_left_ <= 0.0) {
+            talking_ = !talking_;
+            const double u = 0.5 * (noise_.Next() + 1.0);
+            segment_left_ = talking_ ? 0.5 + 1.5 * u : 0.2 + 0.6 * u;
+        }
+        segment_left_ -= 1.0 / sample_rate_;
+        time_ += 1.0 / sample_rate_;
+        const double f0 = pitch_ * (1.0 + 0.15 * std::sin(2.0 * kPi * 0.7 * time_));
+        phase_ += 2.0 * kPi * f0 / sample_rate_;
+        if (phase_ > 2.0 * kPi) {
+            phase_ -= 2.0 * kPi;
+        }
+        const double excitation = noise_.Next();
+        if (!talking_) {
+            return 0.0f;
+        }
+        double value = 0.1 * excitation;
+        for (int k = 1; k * f0 < 3400.0 && k * f0 < sample_rate_ / 2; ++k) {
+            value += std::sin(k * phase_) / k;
+        }
+        const double envelope = 0.55 + 0.45 * std::sin(2.0 * kPi * 4.0 * time_);
+        return static_cast<float>(0.5 * envelope * value);
+    }
+
+private:
+    int sample_rate_;
+    double pitch_;
+    Noise noise_;
+    double phase_;
+    double time_;
+    double segment_left_;
+    bool talking_;
+};
+
+double ToDb(double ratio) {
+    return 10.0 * std::log10(std::max(ratio, 1e-12));
+}
+
+// 粉红噪声 (Paul Kellet 的经济型滤波器，-3dB/倍频程)
+class PinkNoise {
+public:
+    explicit PinkNoise(uint64_t seed) : white_(seed), b0_(0.0), b1_(0.0), b2_(0.0) {}
+    double Next() {
+        const double white = white_.Next();
+        b0_ = 0.99765 * b0_ + white * 0.0990460;
+        b1_ = 0.96300 * b1_ + white * 0.2965164;
+        b2_ = 0.57000 * b2_ + white * 1.0526913;
+        return b0_ + b1_ + b2_ + white * 0.1848;
+    }
+
+private:
+    Noise white_;
+    double b0_, b1_, b2_;
+};
+
+struct NoiseType {
+    const char* name;
+    std::vector<float> samples;
+};
+
+// 生成噪声集，每种噪声长度为 frames
+std::vector<NoiseType> MakeNoiseCorpus(size_t frames, const std::vector<float>& recorded) {
+    std::vector<NoiseType> corpus;
+    const double rate = g_sample_rate;
+
+    NoiseType white{"白噪声", std::vector<float>(frames)};
+    Noise noise(0x1001);
+    for (float& sample : white.samples) {
+        sample = static_cast<float>(noise.Next());
+    }
+    corpus.push_back(white);
+
+    NoiseType pink{"粉红噪声", std::vector<float>(frames)};
+    PinkNoise pink_noise(0x1002);
+    for (float& sample : pink.samples) {
+        sample = static_cast<float>(pink_noise.Next());
+    }
+    corpus.push_back(pink);
+
+    // 积分的白噪声 (-6dB/倍频程)，泄漏避免直流漂移，类似车内或风扇的低频隆隆声
+    NoiseType brown{"褐色噪声", std::vector<float>(frames)};
+    Noise brown_noise(0x1003);
+    double level = 0.0;
+    for (float& sample : brown.samples) {
+        level = 0.995 * level + 0.1 * brown_noise.Next();
+        sample = static_cast<float>(level);
+    }
+    corpus.push_back(brown);
+
+    // 50Hz 及其谐波 (到1kHz，逐级减弱) 加 -30dB 的白噪声
+    NoiseType hum{"电源嗡声", std::vector<float>(frames)};
+    Noise hum_noise(0x1004);
+    for (size_t i = 0; i < frames; ++i) {
+        double value = 0.03 * hum_noise.Next();
+        for (int k = 1; k * 50.0 <= 1000.0; ++k) {
+            value += std::sin(2.0 * kPi * 50.0 * k * i / rate) / k;
+        }
+        hum.samples[i] = static_cast<float>(value);
+    }
+    corpus.push_back(hum);
+
+    // 6个基音不同的讲话者叠加，讲话/停顿相互错开，频谱与语音重叠且不平稳
+    NoiseType babble{"多人嘈杂", std::vector<float>(frames, 0.0f)};
+    for (int talker = 0; talker < 6; ++talker) {
+        TalkSignal voice(g_sample_rate, 100.0 + 25.0 * talker, 0x2001 + talker);
+        for (float& sample : babble.samples) {
+            sample += voice.Next();
+        }
+    }
+    corpus.push_back(babble);
+
+    // 粉红噪声按 0.3Hz 起伏 ±10dB，检验噪声底跟踪的速度
+    NoiseType modulated{"起伏噪声", std::vector<float>(frames)};
+    PinkNoise modulated_noise(0x1005);
+    for (size_t i = 0; i < frames; ++i) {
+        const double gain = std::pow(10.0, 0.5 * std::sin(2.0 * kPi * 0.3 * i / rate));
+        modulated.samples[i] = static_cast<float>(gain * modulated_noise.Next());
+    }
+    corpus.push_back(modulated);
+
+    if (!recorded.empty()) {
+        NoiseType file{"录制噪声", std::vector<float>(frames)};
+        for (size_t i = 0; i < frames; ++i) {
+            file.samples[i] = recorded[i % recorded.size()];
+        }
+        corpus.push_back(file);
+    }
+
+    // 与采集链路一样去掉直流与次声 (一阶高通，约40Hz)，否则粉红/褐色噪声的大部分功率在听不到的频段，
+    // 输入信噪比失去意义
+    const double pole = std::exp(-2.0 * kPi * 40.0 / rate);
+    for (NoiseType& noise : corpus) {
+        double previous_in = 0.0, previous_out = 0.0;
+        for (float& sample : noise.samples) {
+            const double out = pole * (previous_out + sample - previous_in);
+            previous_in = sample;
+            previous_out = out;
+            sample = static_cast<float>(out);
+        }
+    }
+    return corpus;
+}
+
+struct Result {
+    double output_snr_db = 0.0;
+    double input_segmental_db = 0.0;
+    double output_segmental_db = 0.0;
+    double pause_reduction_db = 0.0;
+    double frame_us = 0.0;
+};
+
+// 讲话帧上的功率
+double ActivePower(const std::vector<float>& signal, const std::vector<bool>& active, size_t frame) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t n = 0; n < active.size(); ++n) {
+        if (!active[n]) continue;
+        for (size_t i = n * frame; i < (n + 1) * frame; ++i) {
+            sum += static_cast<double>(signal[i]) * signal[i];
+        }
+        count += frame;
+    }
+    return count > 0 ? sum / count : 0.0;
+}
+
+Result RunMixture(const std::vector<float>& speech, const std::vector<float>& noise, const std::vector<bool>& active,
+                  double snr_db) {
+    const size_t frame = static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000;
+    const size_t frames = active.size();
+    NoiseSuppressor suppressor;
+    suppressor.Configure(g_sample_rate, frame);
+    const size_t delay = suppressor.GetHopSize();
+
+    // 按讲话帧上的语音功率缩放噪声
+    double noise_power = 0.0;
+    for (float sample : noise) {
+        noise_power += static_cast<double>(sample) * sample;
+    }
+    noise_power /= noise.size();
+    const double scale = std::sqrt(ActivePower(speech, active, frame) / noise_power / std::pow(10.0, snr_db / 10.0));
+    std::vector<float> scaled_noise(noise.size());
+    std::vector<float> output(speech.size());
+    for (size_t i = 0; i < speech.size(); ++i) {
+        scaled_noise[i] = static_cast<float>(scale * noise[i]);
+        output[i] = speech[i] + scaled_noise[i];
+    }
+
+    double total_us = 0.0;
+    for (size_t n = 0; n < frames; ++n) {
+        auto start = std::chrono::steady_clock::now();
+        suppressor.Process(&output[n * frame], frame);
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 输出比输入晚 delay 个样点
+    const size_t first = static_cast<size_t>(kSettleSeconds * g_sample_rate / frame);
+    double speech_sum = 0.0, error_sum = 0.0, pause_in = 0.0, pause_out = 0.0;
+    double segmental_in = 0.0, segmental_out = 0.0;
+    size_t segments = 0;
+    for (size_t n = first; n < frames; ++n) {
+        double frame_speech = 0.0, frame_error = 0.0, frame_noise = 0.0, frame_output = 0.0;
+        for (size_t i = n * frame; i < (n + 1) * frame && i + delay < output.size(); ++i) {
+            const double error = output[i + delay] - speech[i];
+            frame_speech += static_cast<double>(speech[i]) * speech[i];
+            frame_error += error * error;
+            frame_noise += static_cast<double>(scaled_noise[i]) * scaled_noise[i];
+            frame_output += static_cast<double>(output[i + delay]) * output[i + delay];
+        }
+        if (active[n]) {
+            speech_sum += frame_speech;
+            error_sum += frame_error;
+            segmental_in += std::min(35.0, std::max(-10.0, ToDb(frame_speech / std::max(frame_noise, 1e-20))));
+            segmental_out += std::min(35.0, std::max(-10.0, ToDb(frame_speech / std::max(frame_error, 1e-20))));
+            ++segments;
+        } else {
+            pause_in += frame_noise;
+            pause_out += frame_output;
+        }
+    }
+
+    Result result;
+    result.output_snr_db = ToDb(speech_sum / std::max(error_sum, 1e-20));
+    result.input_segmental_db = segments > 0 ? segmental_in / segments : 0.0;
+    result.output_segmental_db = segments > 0 ? segmental_out / segments : 0.0;
+    result.pause_reduction_db = ToDb(pause_in / std::max(pause_out, 1e-20));
+    result.frame_us = total_us / frames;
+    return result;
+}
+
+bool RunCorpus() {
+    const size_t frame = static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000;
+    NoiseSuppressor probe;
+    if (!probe.Configure(g_sample_rate, frame)) {
+        std::cerr << "错误: 噪声抑制器不支持 " << g_sample_rate << " Hz 与 " << g_frame_ms << "ms 帧长" << std::endl;
+        return false;
+    }
+
+    std::vector<float> speech;
+    if (!g_speech_file.empty()) {
+        if (!LoadWav(g_speech_file, &speech)) {
+            return false;
+        }
+    } else {
+        TalkSignal talk(g_sample_rate, 140.0, 0x3001);
+        speech.resize(static_cast<size_t>(g_duration * g_sample_rate));
+        for (float& sample : speech) {
+            sample = 0.5f * talk.Next();
+        }
+    }
+    const size_t frames = speech.size() / frame;
+    if (frames * frame < (kSettleSeconds + 3.0) * g_sample_rate) {
+        std::cerr << "错误: 语音太短 (至少5秒)" << std::endl;
+        return false;
+    }
+    speech.resize(frames * frame);
+
+    std::vector<float> recorded;
+    if (!g_noise_file.empty() && !LoadWav(g_noise_file, &recorded)) {
+        return false;
+    }
+    std::vector<NoiseType> corpus = MakeNoiseCorpus(speech.size(), recorded);
+
+    // 讲话帧: 帧功率高于最大帧功率 -40dB
+    std::vector<double> powers(frames, 0.0);
+    for (size_t n = 0; n < frames; ++n) {
+        for (size_t i = n * frame; i < (n + 1) * frame; ++i) {
+            powers[n] += static_cast<double>(speech[i]) * speech[i];
+        }
+    }
+    const double peak = *std::max_element(powers.begin(), powers.end());
+    std::vector<bool> active(frames);
+    size_t active_count = 0;
+    for (size_t n = 0; n < frames; ++n) {
+        active[n] = powers[n] > peak * kActiveThreshold;
+        active_count += active[n] ? 1 : 0;
+    }
+
+    std::cout << "=== " << g_sample_rate << " Hz, " << g_frame_ms << "ms 帧, 跳步 " << probe.GetHopSize() << ", "
+              << (g_speech_file.empty() ? std::string("合成浊音") : g_speech_file) << " " << frames * frame / g_sample_rate
+              << " 秒 (讲话帧 " << 100 * active_count / frames << "%) ===" << std::endl;
+    std::cout << "信噪比按讲话帧计算; 输出信噪比把语音失真也计入噪声; 分段为逐帧信噪比 (-10~35dB) 的平均" << std::endl;
+    std::cout << "  噪声        输入dB  输出dB    提升  分段输入  分段输出  停顿衰减  每帧us" << std::endl;
+    std::cout << std::fixed;
+    for (const NoiseType& noise : corpus) {
+        for (double snr : g_snrs) {
+            Result result = RunMixture(speech, noise.samples, active, snr);
+            // 中文名称占两列宽，手动补齐到12列
+            std::string label = std::string("  ") + noise.name;
+            label.append(12 - 2 - 2 * (std::strlen(noise.name) / 3), ' ');
+            std::cout << label << std::setprecision(1) << std::setw(6) << snr << std::setw(8) << result.output_snr_db
+                      << std::setw(8) << result.output_snr_db - snr << std::setw(10) << result.input_segmental_db
+                      << std::setw(10) << result.output_segmental_db << std::setw(10) << result.pause_reduction_db
+                      << std::setw(8) << result.frame_us << std::endl;
+        }
+    }
+    return true;
+}
+
+// 单独测量每帧的处理耗时: 输入为白噪声加合成语音
+void RunCpuBenchmark() {
+    std::cout << std::endl << "CPU 基准 (帧长 " << g_frame_ms << "ms):" << std::endl;
+    const int rates[] = {8000, 16000, 48000};
+    for (int rate : rates) {
+        const size_t frame = static_cast<size_t>(rate) * g_frame_ms / 1000;
+        NoiseSuppressor suppressor;
+        if (!suppressor.Configure(rate, frame)) {
+            std::cout << "  " << rate << " Hz: 不支持该帧长" << std::endl;
+            continue;
+        }
+        Noise noise(rate);
+        TalkSignal talk(rate, 140.0, rate);
+        std::vector<float> samples(frame);
+        const size_t frames = static_cast<size_t>(5000 / g_frame_ms);   // 5秒的音频
+        double total_us = 0.0;
+        for (size_t n = 0; n < frames; ++n) {
+            for (size_t i = 0; i < frame; ++i) {
+                samples[i] = static_cast<float>(0.05 * noise.Next() + 0.5 * talk.Next());
+            }
+            auto start = std::chrono::steady_clock::now();
+            suppressor.Process(samples.data(), frame);
+            total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        const double mean_us = total_us / frames;
+        std::cout << "  " << std::setw(5) << rate << " Hz: 跳步 " << suppressor.GetHopSize() << ", 每帧 "
+                  << std::setprecision(1) << mean_us << "us (" << std::setprecision(2)
+                  << 100.0 * mean_us / (g_frame_ms * 1000.0) << "% 单核)" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+    if (!RunCorpus()) {
+        return 1;
+    }
+    RunCpuBenchmark();
+    return 0;
+}
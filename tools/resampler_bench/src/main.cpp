@@ -0,0 +1,262 @@
+// 重采样基准
+// 对常用采样率 (8/16/32/44.1/48 kHz) 之间的每一对比例，用多相重采样器按包长分块处理正弦信号，
+// 对输出做给定频率的正弦最小二乘拟合 (幅度与相位任意，因此不需要知道滤波器时延):
+//   信噪比   拟合残差 (谐波、镜像、噪声与int16量化) 相对拟合正弦的功率比
+//   通带增益 0.8倍较低奈奎斯特频率处的正弦经过后的幅度变化
+//   混叠抑制 降采样时输入奈奎斯特与输出奈奎斯特之间的正弦在输出中残留的功率 (相对输入，
+//            残留低于int16的半个最低位时只能给出下限)
+// 以及单声道/立体声每处理一个包长的输入所需的时间。最后测量时钟漂移补偿用的分数比例重采样器
+// 在几个比例下的信噪比与耗时
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "audio_resampler.h"
+
+namespace {
+
+int g_frame_ms = 20;          // 每次处理的输入长度
+double g_duration = 2.0;      // 测试信号时长 (秒)
+double g_tone = 1000.0;       // 信噪比测试的正弦频率
+
+const int kRates[] = {8000, 16000, 32000, 44100, 48000};
+const double kAmplitude = 16384.0;   // 正弦幅度 (满量程的一半)
+const double kSettleSeconds = 0.1;   // 跳过开头的滤波器建立时间
+const int kTimingIterations = 10;
+const double kPi = 3.14159265358979323846;
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    每次处理的输入长度 10/20/40/60 毫秒 (默认: 20)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     测试信号时长 (秒，默认: 2)" << std::endl;
+    std::cout << "  -t, --tone <HZ>          信噪比测试的正弦频率 (默认: 1000，须低于3600)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration = std::atof(argv[++i]);
+        }
+        else if ((arg == "-t" || arg == "--tone") && i + 1 < argc) {
+            g_tone = std::atof(argv[++i]);
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_frame_ms != 10 && g_frame_ms != 20 && g_frame_ms != 40 && g_frame_ms != 60) {
+        std::cerr << "错误: 包长必须为 10/20/40/60 毫秒" << std::endl;
+        return false;
+    }
+    // 8kHz 的截止频率约为 3.7kHz
+    if (g_duration < 0.5 || g_tone <= 0.0 || g_tone >= 3600.0) {
+        std::cerr << "错误: 参数超出范围 (时长至少0.5秒，正弦频率 0~3600Hz)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<int16_t> make_sine(int rate, double frequency, int channels) {
+    const size_t frames = static_cast<size_t>(g_duration * rate);
+    std::vector<int16_t> signal(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        const int16_t sample = static_cast<int16_t>(std::lrint(kAmplitude * std::sin(2.0 * kPi * frequency * i / rate)));
+        for (int ch = 0; ch < channels; ++ch) {
+            signal[i * channels + ch] = sample;
+        }
+    }
+    return signal;
+}
+
+// 按包长分块送入重采样器，返回全部输出 (交错)
+template <typename Resampler>
+std::vector<int16_t> process_blocks(Resampler* resampler, const std::vector<int16_t>& in, int channels,
+                                    size_t block_frames) {
+    const size_t in_frames = in.size() / channels;
+    std::vector<int16_t> out;
+    out.reserve((resampler->MaxOutputFrames(block_frames) + 1) * (in_frames / block_frames + 1) * channels);
+    std::vector<int16_t> block(resampler->MaxOutputFrames(block_frames) * channels);
+    for (size_t offset = 0; offset + block_frames <= in_frames; offset += block_frames) {
+        size_t produced = resampler->Process(&in[offset * channels], block_frames, block.data(),
+                                             block.size() / channels);
+        out.insert(out.end(), block.begin(), block.begin() + produced * channels);
+    }
+    return out;
+}
+
+struct SineFit {
+    double amplitude = 0.0;
+    double snr_db = 0.0;
+};
+
+// 对单声道信号 start 之后的部分做 a*cos(wn) + b*sin(wn) 的最小二乘拟合
+SineFit fit_sine(const std::vector<int16_t>& y, size_t start, double w) {
+    double cc = 0.0, cs = 0.0, ss = 0.0, yc = 0.0, ys = 0.0;
+    for (size_t n = start; n < y.size(); ++n) {
+        const double c = std::cos(w * n);
+        const double s = std::sin(w * n);
+        cc += c * c;
+        cs += c * s;
+        ss += s * s;
+        yc += y[n] * c;
+        ys += y[n] * s;
+    }
+    const double det = cc * ss - cs * cs;
+    const double a = (yc * ss - ys * cs) / det;
+    const double b = (ys * cc - yc * cs) / det;
+    double signal = 0.0;
+    double residual = 0.0;
+    for (size_t n = start; n < y.size(); ++n) {
+        const double fitted = a * std::cos(w * n) + b * std::sin(w * n);
+        signal += fitted * fitted;
+        residual += (y[n] - fitted) * (y[n] - fitted);
+    }
+    SineFit fit;
+    fit.amplitude = std::sqrt(a * a + b * b);
+    fit.snr_db = 10.0 * std::log10(signal / std::max(residual, 1e-9));
+    return fit;
+}
+
+// start 之后的均方根
+double rms(const std::vector<int16_t>& y, size_t start) {
+    double sum = 0.0;
+    for (size_t n = start; n < y.size(); ++n) {
+        sum += static_cast<double>(y[n]) * y[n];
+    }
+    return std::sqrt(sum / std::max<size_t>(1, y.size() - start));
+}
+
+// 单声道输出的正弦拟合
+SineFit measure_polyphase(int in_rate, int out_rate, double frequency, size_t block_frames) {
+    PolyphaseResampler resampler;
+    resampler.Configure(in_rate, out_rate, 1, block_frames);
+    std::vector<int16_t> out = process_blocks(&resampler, make_sine(in_rate, frequency, 1), 1, block_frames);
+    return fit_sine(out, static_cast<size_t>(kSettleSeconds * out_rate), 2.0 * kPi * frequency / out_rate);
+}
+
+// 每处理 block_frames 帧输入的平均耗时 (微秒)
+template <typename Resampler>
+double time_blocks(Resampler* resampler, const std::vector<int16_t>& in, int channels, size_t block_frames) {
+    using Clock = std::chrono::steady_clock;
+    const size_t blocks = in.size() / channels / block_frames;
+    std::vector<int16_t> out(resampler->MaxOutputFrames(block_frames) * channels);
+    auto start = Clock::now();
+    for (int iteration = 0; iteration < kTimingIterations; ++iteration) {
+        for (size_t i = 0; i < blocks; ++i) {
+            resampler->Process(&in[i * block_frames * channels], block_frames, out.data(), out.size() / channels);
+        }
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / (kTimingIterations * blocks);
+}
+
+double time_polyphase(int in_rate, int out_rate, int channels, size_t block_frames) {
+    PolyphaseResampler resampler;
+    resampler.Configure(in_rate, out_rate, channels, block_frames);
+    return time_blocks(&resampler, make_sine(in_rate, g_tone, channels), channels, block_frames);
+}
+
+void bench_polyphase_pair(int in_rate, int out_rate) {
+    const size_t block_frames = static_cast<size_t>(in_rate) * g_frame_ms / 1000;
+    const double nyquist = std::min(in_rate, out_rate) / 2.0;
+
+    SineFit tone = measure_polyphase(in_rate, out_rate, g_tone, block_frames);
+    SineFit edge = measure_polyphase(in_rate, out_rate, 0.8 * nyquist, block_frames);
+    const double edge_gain = 20.0 * std::log10(edge.amplitude / kAmplitude);
+
+    std::cout << std::fixed << std::setw(7) << in_rate << std::setw(8) << out_rate << std::setw(6)
+              << GetResamplerFilterBank(in_rate, out_rate)->taps << std::setprecision(1) << std::setw(9)
+              << tone.snr_db << std::setprecision(2) << std::setw(10) << edge_gain;
+
+    // 降采样时取两个奈奎斯特频率的中点，该频率被输出采样后折叠到 out_rate - f
+    if (in_rate > out_rate * 1.05) {
+        const double alias = (in_rate + out_rate) / 4.0;
+        PolyphaseResampler resampler;
+        resampler.Configure(in_rate, out_rate, 1, block_frames);
+        std::vector<int16_t> out = process_blocks(&resampler, make_sine(in_rate, alias, 1), 1, block_frames);
+        // 残留低于半个最低位时输出全为0，只能给出量化决定的下限
+        const double residual = rms(out, static_cast<size_t>(kSettleSeconds * out_rate));
+        const double rejection = 20.0 * std::log10(kAmplitude / std::sqrt(2.0) / std::max(residual, 0.5));
+        std::ostringstream text;
+        text << (residual < 0.5 ? ">" : "") << std::fixed << std::setprecision(1) << rejection;
+        std::cout << std::setw(10) << text.str();
+    } else {
+        std::cout << std::setw(10) << "-";
+    }
+
+    std::cout << std::setprecision(2) << std::setw(10) << time_polyphase(in_rate, out_rate, 1, block_frames)
+              << std::setw(10) << time_polyphase(in_rate, out_rate, 2, block_frames) << std::endl;
+}
+
+// ratio 为每个输出帧消耗的输入帧数，输出中的正弦频率为 tone * ratio
+void bench_fractional(int rate, double ratio) {
+    const size_t block_frames = static_cast<size_t>(rate) * g_frame_ms / 1000;
+    FractionalResampler resampler;
+    resampler.Configure(1, block_frames);
+    resampler.SetRatio(ratio);
+    std::vector<int16_t> out = process_blocks(&resampler, make_sine(rate, g_tone, 1), 1, block_frames);
+    SineFit fit = fit_sine(out, static_cast<size_t>(kSettleSeconds * rate), 2.0 * kPi * g_tone * ratio / rate);
+
+    FractionalResampler timed;
+    timed.Configure(1, block_frames);
+    timed.SetRatio(ratio);
+    const double mono_us = time_blocks(&timed, make_sine(rate, g_tone, 1), 1, block_frames);
+    FractionalResampler stereo;
+    stereo.Configure(2, block_frames);
+    stereo.SetRatio(ratio);
+    const double stereo_us = time_blocks(&stereo, make_sine(rate, g_tone, 2), 2, block_frames);
+
+    std::cout << std::fixed << std::setw(7) << rate << std::setw(9) << std::lrint((ratio - 1.0) * 1e6)
+              << std::setprecision(1) << std::setw(9) << fit.snr_db << std::setprecision(2) << std::setw(10)
+              << mono_us << std::setw(10) << stereo_us << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
+    std::cout << "=== 多相重采样器: " << g_frame_ms << "ms 输入块, " << g_tone << "Hz 正弦 (幅度 " << kAmplitude
+              << "), " << g_duration << " 秒 ===" << std::endl;
+    std::cout << "通带增益在 0.8 倍较低奈奎斯特频率处; 混叠抑制只对降采样测量; 耗时为每个输入块 (us)" << std::endl;
+    std::cout << "  输入Hz  输出Hz 抽头  信噪比dB  通带增益  混叠抑制    单声道    立体声" << std::endl;
+    for (int in_rate : kRates) {
+        for (int out_rate : kRates) {
+            if (in_rate != out_rate) {
+                bench_polyphase_pair(in_rate, out_rate);
+            }
+        }
+    }
+
+    std::cout << std::endl << "=== 分数比例重采样器 (时钟漂移补偿，最多 ±2000ppm) ===" << std::endl;
+    std::cout << "  采样率   比例ppm  信噪比dB    单声道    立体声" << std::endl;
+    const int drift_rates[] = {16000, 48000};
+    const double ratios[] = {1.0, 1.0001, 0.9999, 1.002, 0.998};
+    for (int rate : drift_rates) {
+        for (double ratio : ratios) {
+            bench_fractional(rate, ratio);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,323 @@
+// 样点格式转换基准
+// 对每种 (设备格式, 声道数) 组合测量四个方向的转换吞吐量 (百万样点/秒):
+//   设备格式 -> 交错S16、交错S16 -> 设备格式 (设备读写)，设备格式 -> 平面float、平面float -> 设备格式 (处理链)。
+// 同时给出按样点分支判断格式的通用实现作为对照，并校验 S16 经过每种格式的往返结果不变。
+// 最后比较 ALSA 两种访问方式下每个周期在设备缓冲区与重采样之间搬运数据的开销 (采样率相同、重采样直通时):
+//   RW: readi/writei 在设备缓冲区与用户缓冲区之间复制，格式不是S16时再经过字节缓冲区转换，重采样再复制一次；
+//   mmap: S16 时重采样直接读写设备缓冲区 (BeginCapture/BeginPlayback)，其他格式在设备缓冲区中直接转换
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sample_format.h"
+
+namespace {
+
+int g_frames = 960;          // 每次调用的帧数 (48kHz 下20ms)
+int g_duration_ms = 200;     // 每项测量的时长
+volatile uint32_t g_sink = 0; // 防止编译器消除结果未被使用的转换
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -f, --frames <N>         每次转换的帧数 (默认: 960)" << std::endl;
+    std::cout << "  -d, --duration <MS>      每项测量的时长 (毫秒，默认: 200)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-f" || arg == "--frames") && i + 1 < argc) {
+            g_frames = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration_ms = std::atoi(argv[++i]);
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_frames <= 0 || g_duration_ms <= 0) {
+        std::cerr << "错误: 帧数与时长必须大于0" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 对照组: 每个样点按运行时格式分支 (特化之前的写法)
+int16_t GenericToS16(const uint8_t* p, SampleFormat format) {
+    switch (format) {
+    case kSampleS24: return static_cast<int16_t>(p[1] | (p[2] << 8));
+    case kSampleS32: {
+        int32_t value;
+        memcpy(&value, p, sizeof(value));
+        return static_cast<int16_t>(value >> 16);
+    }
+    case kSampleF32: {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        float scaled = value * 32768.0f;
+        if (scaled >= 32767.0f) return 32767;
+        if (scaled <= -32768.0f) return -32768;
+        return static_cast<int16_t>(std::lrintf(scaled));
+    }
+    default: {
+        int16_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    }
+}
+
+void GenericConvertToS16(const void* in, int16_t* out, size_t frames, int channels, SampleFormat format) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(in);
+    const size_t stride = SampleFormatBytes(format);
+    for (size_t i = 0; i < frames * channels; ++i) {
+        out[i] = GenericToS16(bytes + i * stride, format);
+    }
+}
+
+// 重复调用 fn 直到达到测量时长，返回百万样点/秒
+template <typename Fn>
+double Measure(size_t samples_per_call, Fn fn) {
+    using Clock = std::chrono::steady_clock;
+    // 预热，并确定每批的调用次数
+    fn();
+    size_t batch = 1;
+    size_t calls = 0;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::milliseconds(g_duration_ms);
+    auto now = start;
+    while (now < deadline) {
+        for (size_t i = 0; i < batch; ++i) {
+            fn();
+        }
+        calls += batch;
+        batch = batch < 1024 ? batch * 2 : batch;
+        now = Clock::now();
+    }
+    double seconds = std::chrono::duration<double>(now - start).count();
+    return static_cast<double>(calls * samples_per_call) / seconds / 1e6;
+}
+
+struct Buffers {
+    std::vector<int16_t> s16;
+    std::vector<uint8_t> device;
+    std::vector<std::vector<float>> planes;
+    std::vector<float*> plane_ptrs;
+};
+
+void FillSignal(Buffers* buffers, int channels) {
+    // 满幅正弦加上边界值，覆盖饱和与符号扩展
+    buffers->s16.resize(static_cast<size_t>(g_frames) * channels);
+    for (size_t i = 0; i < buffers->s16.size(); ++i) {
+        buffers->s16[i] = static_cast<int16_t>(32767.0 * std::sin(0.01 * static_cast<double>(i)));
+    }
+    buffers->s16[0] = -32768;
+    buffers->s16[buffers->s16.size() - 1] = 32767;
+}
+
+bool CheckRoundTrip(const SampleConversion& conversion, Buffers* buffers, int channels) {
+    std::vector<int16_t> back(buffers->s16.size());
+    conversion.from_s16(buffers->s16.data(), buffers->device.data(), g_frames, channels);
+    conversion.to_s16(buffers->device.data(), back.data(), g_frames, channels);
+    if (back != buffers->s16) return false;
+    conversion.to_planar_float(buffers->device.data(), buffers->plane_ptrs.data(), g_frames, channels);
+    conversion.from_planar_float(buffers->plane_ptrs.data(), buffers->device.data(), g_frames, channels);
+    conversion.to_s16(buffers->device.data(), back.data(), g_frames, channels);
+    return back == buffers->s16;
+}
+
+bool RunCase(SampleFormat format, int channels) {
+    const SampleConversion& conversion = GetSampleConversion(format, channels);
+    Buffers buffers;
+    FillSignal(&buffers, channels);
+    buffers.device.resize(buffers.s16.size() * SampleFormatBytes(format));
+    buffers.planes.assign(channels, std::vector<float>(g_frames));
+    for (int ch = 0; ch < channels; ++ch) {
+        buffers.plane_ptrs.push_back(buffers.planes[ch].data());
+    }
+    bool ok = CheckRoundTrip(conversion, &buffers, channels);
+
+    const size_t frames = static_cast<size_t>(g_frames);
+    const size_t samples = buffers.s16.size();
+    std::vector<int16_t> s16_out(samples);
+    double to_s16 = Measure(samples, [&]() {
+        conversion.to_s16(buffers.device.data(), s16_out.data(), frames, channels);
+        g_sink += static_cast<uint16_t>(s16_out[0]);
+    });
+    double from_s16 = Measure(samples, [&]() {
+        conversion.from_s16(buffers.s16.data(), buffers.device.data(), frames, channels);
+        g_sink += buffers.device[0];
+    });
+    double to_planar = Measure(samples, [&]() {
+        conversion.to_planar_float(buffers.device.data(), buffers.plane_ptrs.data(), frames, channels);
+        g_sink += static_cast<uint32_t>(buffers.planes[0][0]);
+    });
+    double from_planar = Measure(samples, [&]() {
+        conversion.from_planar_float(buffers.plane_ptrs.data(), buffers.device.data(), frames, channels);
+        g_sink += buffers.device[0];
+    });
+    double generic = Measure(samples, [&]() {
+        GenericConvertToS16(buffers.device.data(), s16_out.data(), frames, channels, format);
+        g_sink += static_cast<uint16_t>(s16_out[0]);
+    });
+
+    std::string kernel = conversion.channels > 0 ? std::to_string(conversion.channels) + "ch" : "any";
+    std::cout << std::left << std::setw(10) << SampleFormatName(format) << std::right << std::setw(4) << channels
+              << std::setw(6) << kernel << std::fixed << std::setprecision(1)
+              << std::setw(12) << to_s16 << std::setw(12) << from_s16
+              << std::setw(12) << to_planar << std::setw(12) << from_planar
+              << std::setw(12) << generic << (ok ? "" : "   往返校验失败") << std::endl;
+    return ok;
+}
+
+// 设备缓冲区为4个周期 (80ms)，每次使用下一个周期的位置
+struct TransferBuffers {
+    std::vector<uint8_t> ring;
+    size_t period_bytes;
+    size_t next;
+    std::vector<uint8_t> staging;       // RW 访问时 readi/writei 的用户缓冲区 (非S16)
+    std::vector<int16_t> device_s16;    // capture_buffer / playback_buffer
+    std::vector<int16_t> network;       // audio_buffer / network_buffer
+
+    uint8_t* NextPeriod() {
+        uint8_t* period = ring.data() + next * period_bytes;
+        next = (next + 1) % 4;
+        return period;
+    }
+};
+
+void ApplyVolume(int16_t* pcm, size_t samples) {
+    const float volume = 0.8f;
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(pcm[i] * volume);
+    }
+}
+
+// 返回每周期纳秒数
+double MeasurePeriodNs(size_t samples, const std::function<void()>& fn) {
+    return 1e3 * static_cast<double>(samples) / Measure(samples, fn);
+}
+
+void RunTransferCase(SampleFormat format, int channels) {
+    const SampleConversion& conversion = GetSampleConversion(format, channels);
+    const size_t frames = static_cast<size_t>(g_frames);
+    const size_t samples = frames * channels;
+    const size_t s16_bytes = samples * sizeof(int16_t);
+    TransferBuffers buffers;
+    buffers.period_bytes = samples * SampleFormatBytes(format);
+    buffers.ring.assign(buffers.period_bytes * 4, 0);
+    buffers.next = 0;
+    buffers.staging.assign(buffers.period_bytes, 0);
+    buffers.device_s16.assign(samples, 0);
+    buffers.network.assign(samples, 1000);
+    const bool s16 = format == kSampleS16;
+
+    // 采集: 设备缓冲区 -> 网络采样率的 audio_buffer
+    double capture_rw = MeasurePeriodNs(samples, [&]() {
+        const uint8_t* period = buffers.NextPeriod();
+        if (s16) {
+            memcpy(buffers.device_s16.data(), period, s16_bytes);
+        } else {
+            memcpy(buffers.staging.data(), period, buffers.period_bytes);
+            conversion.to_s16(buffers.staging.data(), buffers.device_s16.data(), frames, channels);
+        }
+        memcpy(buffers.network.data(), buffers.device_s16.data(), s16_bytes);
+        g_sink += static_cast<uint16_t>(buffers.network[0]);
+    });
+    double capture_mmap = MeasurePeriodNs(samples, [&]() {
+        const uint8_t* period = buffers.NextPeriod();
+        if (s16) {
+            memcpy(buffers.network.data(), period, s16_bytes);
+        } else {
+            conversion.to_s16(period, buffers.device_s16.data(), frames, channels);
+            memcpy(buffers.network.data(), buffers.device_s16.data(), s16_bytes);
+        }
+        g_sink += static_cast<uint16_t>(buffers.network[0]);
+    });
+
+    // 播放: 混音后的 network_buffer -> 设备缓冲区，包括音量
+    double playback_rw = MeasurePeriodNs(samples, [&]() {
+        uint8_t* period = buffers.NextPeriod();
+        memcpy(buffers.device_s16.data(), buffers.network.data(), s16_bytes);
+        ApplyVolume(buffers.device_s16.data(), samples);
+        if (s16) {
+            memcpy(period, buffers.device_s16.data(), s16_bytes);
+        } else {
+            conversion.from_s16(buffers.device_s16.data(), buffers.staging.data(), frames, channels);
+            memcpy(period, buffers.staging.data(), buffers.period_bytes);
+        }
+        g_sink += period[0];
+    });
+    double playback_mmap = MeasurePeriodNs(samples, [&]() {
+        uint8_t* period = buffers.NextPeriod();
+        if (s16) {
+            int16_t* out = reinterpret_cast<int16_t*>(period);
+            memcpy(out, buffers.network.data(), s16_bytes);
+            ApplyVolume(out, samples);
+        } else {
+            memcpy(buffers.device_s16.data(), buffers.network.data(), s16_bytes);
+            ApplyVolume(buffers.device_s16.data(), samples);
+            conversion.from_s16(buffers.device_s16.data(), period, frames, channels);
+        }
+        g_sink += period[0];
+    });
+
+    // 每小时的周期数按48kHz计 (默认960帧即20ms一个周期)
+    const double periods_per_hour = 3600.0 * 48000.0 / static_cast<double>(frames);
+    const double saved_ms = (capture_rw - capture_mmap + playback_rw - playback_mmap) * periods_per_hour / 1e6;
+    std::cout << std::left << std::setw(10) << SampleFormatName(format) << std::right << std::setw(4) << channels
+              << std::fixed << std::setprecision(0)
+              << std::setw(10) << capture_rw << std::setw(10) << capture_mmap
+              << std::setw(10) << playback_rw << std::setw(10) << playback_mmap
+              << std::setprecision(1) << std::setw(14) << saved_ms
+              << "    复制 " << (s16 ? "2->1" : "3->2") << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
+    std::cout << "每次转换 " << g_frames << " 帧，单位: 百万样点/秒" << std::endl;
+    std::cout << "(分支对照: 按样点判断格式的 设备->S16 实现)" << std::endl;
+    // 表头含中文 (每字显示宽度为2)，按显示宽度手工对齐
+    std::cout << "格式      声道  内核   设备->S16   S16->设备  设备->平面  平面->设备    分支对照" << std::endl;
+
+    bool ok = true;
+    const SampleFormat formats[] = {kSampleS16, kSampleS24, kSampleS32, kSampleF32};
+    const int channel_counts[] = {1, 2, 6};
+    for (SampleFormat format : formats) {
+        for (int channels : channel_counts) {
+            ok = RunCase(format, channels) && ok;
+        }
+    }
+
+    std::cout << std::endl;
+    std::cout << "设备缓冲区搬运 (每周期 " << g_frames << " 帧，单位: 纳秒；每小时节省按48kHz、采集与播放合计)" << std::endl;
+    std::cout << "格式      声道   采集RW  采集mmap    播放RW  播放mmap  每小时节省ms    每方向的整段复制" << std::endl;
+    for (SampleFormat format : formats) {
+        for (int channels : channel_counts) {
+            RunTransferCase(format, channels);
+        }
+    }
+    return ok ? 0 : 1;
+}
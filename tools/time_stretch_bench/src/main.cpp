@@ -0,0 +1,329 @@
+// 变速 (WSOLA) 基准
+// 在虚拟时间上模拟一路发送者: 包按包长均匀发出，网络时延为5ms加0~2ms的抖动，
+// 第2秒起网络停顿 spike 毫秒，期间的包在停顿结束时一起到达。同一组到达序列分别送入
+// 关闭与开启变速的两个接收流，每次拉取前记录队列深度，输出停顿之后队列降回目标深度所用的时间、
+// 丢弃的包、补的静音与每次拉取的耗时；最后单独测量一次快放/慢放 (查找周期与交叉淡化) 的耗时
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "remote_stream.h"
+#include "time_stretcher.h"
+
+namespace {
+
+int g_sample_rate = 16000;
+int g_channels = 1;
+int g_frame_ms = 20;          // 包长
+int g_spike_ms = 300;         // 网络停顿时长
+double g_duration = 8.0;      // 模拟时长 (秒)
+bool g_verbose = false;       // 每100ms输出一次队列深度
+
+const double kSpikeStart = 2.0;
+const double kBaseDelay = 0.005;
+const double kMaxJitter = 0.002;
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -r, --rate <HZ>          采样率 (默认: 16000)" << std::endl;
+    std::cout << "  -c, --channels <N>       声道数 (默认: 1)" << std::endl;
+    std::cout << "  -f, --frame-size <MS>    包长 10/20/40/60 毫秒 (默认: 20)" << std::endl;
+    std::cout << "  -s, --spike <MS>         网络停顿时长 (毫秒，默认: 300)" << std::endl;
+    std::cout << "  -d, --duration <SEC>     模拟时长 (秒，默认: 8)" << std::endl;
+    std::cout << "  -v, --verbose            每100ms输出一次两个接收流的队列深度" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            g_sample_rate = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-c" || arg == "--channels") && i + 1 < argc) {
+            g_channels = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--frame-size") && i + 1 < argc) {
+            g_frame_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-s" || arg == "--spike") && i + 1 < argc) {
+            g_spike_ms = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            g_duration = std::atof(argv[++i]);
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            g_verbose = true;
+        }
+        else {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+    }
+    if (g_sample_rate < 8000 || g_channels < 1 || g_channels > 2 || g_spike_ms < 0 ||
+        g_duration < kSpikeStart + 1.0) {
+        std::cerr << "错误: 参数超出范围 (声道数1~2，模拟时长至少3秒)" << std::endl;
+        return false;
+    }
+    if (g_frame_ms != 10 && g_frame_ms != 20 && g_frame_ms != 40 && g_frame_ms != 60) {
+        std::cerr << "错误: 包长必须为 10/20/40/60 毫秒" << std::endl;
+        return false;
+    }
+    if (static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000 * g_channels * sizeof(int16_t) > kMaxPayloadSize) {
+        std::cerr << "错误: 一个包放不下，请降低采样率、声道数或包长" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 类似浊音的测试信号: 基音在120~200Hz之间缓慢变化的谐波，按约4Hz的音节起伏
+class VoicedSignal {
+public:
+    explicit VoicedSignal(int sample_rate) : sample_rate_(sample_rate), phase_(0.0), time_(0.0) {}
+
+    void Generate(int16_t* out, size_t frames, int channels) {
+        const double pi = 3.14159265358979323846;
+        for (size_t i = 0; i < frames; ++i) {
+            const double f0 = 160.0 + 40.0 * std::sin(2.0 * pi * 0.7 * time_);
+            const double envelope = 0.55 + 0.45 * std::sin(2.0 * pi * 4.0 * time_);
+            double value = 0.0;
+            for (int k = 1; k <= 12; ++k) {
+                if (k * f0 < sample_rate_ / 2) {
+                    value += std::sin(k * phase_) / k;
+                }
+            }
+            const int16_t sample = static_cast<int16_t>(std::lrint(5000.0 * envelope * value));
+            for (int ch = 0; ch < channels; ++ch) {
+                out[i * channels + ch] = sample;
+            }
+            phase_ = std::fmod(phase_ + 2.0 * pi * f0 / sample_rate_, 2.0 * pi);
+            time_ += 1.0 / sample_rate_;
+        }
+    }
+
+private:
+    int sample_rate_;
+    double phase_;
+    double time_;
+};
+
+struct Arrival {
+    double time;
+    AudioPacket packet;
+};
+
+// 生成全部包及其到达时刻 (按到达时刻排序，停顿期间的包保持发送顺序)
+std::vector<Arrival> build_arrivals(size_t packet_frames) {
+    std::vector<Arrival> arrivals;
+    VoicedSignal signal(g_sample_rate);
+    std::vector<int16_t> pcm(packet_frames * g_channels);
+    uint32_t random = 12345;
+    const double packet_seconds = g_frame_ms / 1000.0;
+    const double spike_end = kSpikeStart + g_spike_ms / 1000.0;
+    for (uint32_t n = 0; n * packet_seconds < g_duration; ++n) {
+        signal.Generate(pcm.data(), packet_frames, g_channels);
+        Arrival arrival;
+        memset(&arrival.packet, 0, sizeof(arrival.packet));
+        arrival.packet.sequence = htonl(n);
+        arrival.packet.timestamp = htonl(static_cast<uint32_t>(n * packet_frames));
+        arrival.packet.session_id = htonl(1);
+        arrival.packet.payload_type = kPayloadTypePcm16;
+        arrival.packet.data_size = htons(static_cast<uint16_t>(pcm.size() * sizeof(int16_t)));
+        memcpy(arrival.packet.data, pcm.data(), pcm.size() * sizeof(int16_t));
+
+        random = random * 1103515245u + 12345u;
+        const double jitter = kMaxJitter * ((random >> 8) & 0xffff) / 65536.0;
+        // 包在最后一帧采集完成后发出
+        arrival.time = (n + 1) * packet_seconds + kBaseDelay + jitter;
+        if (arrival.time >= kSpikeStart && arrival.time < spike_end) {
+            arrival.time = spike_end + n * 1e-6;
+        }
+        arrivals.push_back(arrival);
+    }
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const Arrival& a, const Arrival& b) { return a.time < b.time; });
+    return arrivals;
+}
+
+struct RunResult {
+    std::vector<double> levels_ms;  // 每次拉取前的队列深度
+    double baseline_ms = 0.0;       // 停顿之前1秒的平均深度
+    double peak_ms = 0.0;           // 停顿之后的最大深度
+    double recovery_ms = -1.0;      // 停顿结束到深度回到 max(基线, 目标) + 一次拉取 的时间，-1 表示未恢复
+    double final_ms = 0.0;          // 最后1秒的平均深度
+    uint64_t queue_drops = 0;
+    uint64_t concealed_frames = 0;
+    uint64_t accelerated_frames = 0;
+    uint64_t decelerated_frames = 0;
+    double pull_avg_us = 0.0;
+    double pull_max_us = 0.0;
+};
+
+RunResult run(const std::vector<Arrival>& arrivals, size_t packet_frames, size_t pull_frames, bool stretch) {
+    using Clock = std::chrono::steady_clock;
+    RemoteStream stream(1, g_sample_rate, g_channels, packet_frames, pull_frames);
+    stream.SetTimeStretchEnabled(stretch);
+    const double pull_seconds = static_cast<double>(pull_frames) / g_sample_rate;
+    const double spike_end = kSpikeStart + g_spike_ms / 1000.0;
+    const double to_ms = 1000.0 / g_sample_rate;
+    std::vector<int16_t> out(pull_frames * g_channels);
+
+    RunResult result;
+    double baseline_sum = 0.0;
+    size_t baseline_count = 0;
+    double final_sum = 0.0;
+    size_t final_count = 0;
+    double pull_total_us = 0.0;
+    size_t next = 0;
+    // 播放时钟与发送时钟错开一个不整的相位
+    for (double now = 0.0123; now < g_duration; now += pull_seconds) {
+        for (; next < arrivals.size() && arrivals[next].time <= now; ++next) {
+            stream.Push(arrivals[next].packet, arrivals[next].time);
+        }
+        const double level = stream.QueuedFrames() * to_ms;
+        result.levels_ms.push_back(level);
+        if (now >= kSpikeStart - 1.0 && now < kSpikeStart) {
+            baseline_sum += level;
+            ++baseline_count;
+        }
+        if (now >= g_duration - 1.0) {
+            final_sum += level;
+            ++final_count;
+        }
+        if (now >= spike_end) {
+            result.peak_ms = std::max(result.peak_ms, level);
+        }
+
+        auto start = Clock::now();
+        stream.Pull(out.data(), pull_frames, now);
+        double elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        pull_total_us += elapsed;
+        result.pull_max_us = std::max(result.pull_max_us, elapsed);
+    }
+    result.baseline_ms = baseline_count > 0 ? baseline_sum / baseline_count : 0.0;
+    result.final_ms = final_count > 0 ? final_sum / final_count : 0.0;
+    result.pull_avg_us = pull_total_us / result.levels_ms.size();
+
+    // 停顿结束后深度先升到峰值，再找第一次回到阈值以内的时刻
+    const double threshold = std::max(result.baseline_ms, stream.TargetFrames() * to_ms) + pull_seconds * 1000.0;
+    bool peaked = false;
+    for (size_t i = 0; i < result.levels_ms.size(); ++i) {
+        const double now = 0.0123 + i * pull_seconds;
+        if (now < spike_end) continue;
+        if (!peaked) {
+            peaked = result.levels_ms[i] > threshold;
+            if (!peaked && result.peak_ms <= threshold) {
+                result.recovery_ms = 0.0;
+                break;
+            }
+            continue;
+        }
+        if (result.levels_ms[i] <= threshold) {
+            result.recovery_ms = (now - spike_end) * 1000.0;
+            break;
+        }
+    }
+    result.queue_drops = stream.GetQueueDrops();
+    result.concealed_frames = stream.GetConcealedFrames();
+    result.accelerated_frames = stream.GetAcceleratedFrames();
+    result.decelerated_frames = stream.GetDeceleratedFrames();
+    return result;
+}
+
+void print_result(const char* label, const RunResult& result) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << label << ": 基线 " << result.baseline_ms << "ms, 峰值 " << result.peak_ms << "ms, 恢复用时 ";
+    if (result.recovery_ms >= 0.0) {
+        std::cout << result.recovery_ms << "ms";
+    } else {
+        std::cout << "未恢复";
+    }
+    std::cout << ", 最后1秒 " << result.final_ms << "ms" << std::endl;
+    std::cout << "    队列满丢包 " << result.queue_drops << ", 补静音 " << result.concealed_frames
+              << " 帧, 快放/慢放 " << result.accelerated_frames << "/" << result.decelerated_frames << " 帧"
+              << std::setprecision(2) << ", 每次拉取 平均 " << result.pull_avg_us << "us 最大 "
+              << result.pull_max_us << "us" << std::endl;
+}
+
+// 单独测量一次变速的耗时 (最长输入，浊音与静音)
+void bench_stretcher(int sample_rate) {
+    using Clock = std::chrono::steady_clock;
+    TimeStretcher stretcher;
+    stretcher.Configure(sample_rate, g_channels);
+    const size_t frames = stretcher.MaxInputFrames();
+    std::vector<int16_t> voiced(frames * g_channels);
+    VoicedSignal signal(sample_rate);
+    signal.Generate(voiced.data(), frames, g_channels);
+    std::vector<int16_t> out((frames + frames / 2) * g_channels);
+
+    const int iterations = 2000;
+    size_t removed = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        removed += frames - stretcher.Accelerate(voiced.data(), frames, out.data());
+    }
+    double accelerate_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    size_t inserted = 0;
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        inserted += stretcher.Decelerate(voiced.data(), frames, out.data()) - frames;
+    }
+    double decelerate_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    std::cout << std::setprecision(2) << "  " << std::setw(5) << sample_rate << " Hz  输入 " << std::setw(4)
+              << frames << " 帧  快放 " << std::setw(6) << accelerate_us << "us (去掉 " << removed / iterations
+              << " 帧)  慢放 " << std::setw(6) << decelerate_us << "us (插入 " << inserted / iterations << " 帧)"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
+    const size_t packet_frames = static_cast<size_t>(g_sample_rate) * g_frame_ms / 1000;
+    // 与通话相同: 音频循环的周期为包长但不超过20ms
+    const size_t pull_frames = static_cast<size_t>(g_sample_rate) * std::min(g_frame_ms, 20) / 1000;
+    std::vector<Arrival> arrivals = build_arrivals(packet_frames);
+
+    std::cout << "=== " << g_sample_rate << " Hz, " << g_channels << " 声道, " << g_frame_ms << "ms 包长, 第"
+              << kSpikeStart << "秒起网络停顿 " << g_spike_ms << "ms ===" << std::endl;
+    RunResult plain = run(arrivals, packet_frames, pull_frames, false);
+    RunResult stretched = run(arrivals, packet_frames, pull_frames, true);
+    print_result("关闭变速", plain);
+    print_result("开启变速", stretched);
+
+    if (g_verbose) {
+        std::cout << std::endl << "  时刻(s)  关闭(ms)  开启(ms)" << std::endl;
+        const size_t step = std::max<size_t>(1, static_cast<size_t>(0.1 * g_sample_rate / pull_frames));
+        for (size_t i = 0; i < plain.levels_ms.size(); i += step) {
+            std::cout << std::setprecision(2) << std::setw(9) << 0.0123 + i * static_cast<double>(pull_frames) / g_sample_rate
+                      << std::setprecision(1) << std::setw(10) << plain.levels_ms[i] << std::setw(10)
+                      << stretched.levels_ms[i] << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "单次变速耗时 (" << g_channels << " 声道):" << std::endl;
+    const int rates[] = {8000, 16000, 48000};
+    for (int rate : rates) {
+        bench_stretcher(rate);
+    }
+    return 0;
+}
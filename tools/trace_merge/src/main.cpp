@@ -0,0 +1,68 @@
+// 帧追踪合并工具
+// 把客户端 (voice_call_trace_stop / voice_call_client --trace) 与服务器 (udp_server --trace)
+// 各自导出的 Chrome trace JSON 合并成一个文件，在 chrome://tracing 或 Perfetto UI 中按同一时间轴查看。
+// 各文件的时间为 CLOCK_REALTIME 微秒，不在同一台机器上时两端需要NTP对时
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "frame_trace.h"
+
+namespace {
+
+void show_usage(const char* program_name) {
+    std::cout << "用法: " << program_name << " -o <输出文件> <追踪文件>..." << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h, --help               显示此帮助信息" << std::endl;
+    std::cout << "  -o, --output <FILE>      合并后的输出文件" << std::endl;
+    std::cout << std::endl;
+    std::cout << "示例:" << std::endl;
+    std::cout << "  " << program_name << " -o call.json alice.json bob.json server.json" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[], std::string* output, std::vector<std::string>* inputs) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            show_usage(argv[0]);
+            return false;
+        }
+        else if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= argc) {
+                std::cerr << "错误: --output 需要指定输出文件" << std::endl;
+                return false;
+            }
+            *output = argv[++i];
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "错误: 未知参数 " << arg << std::endl;
+            show_usage(argv[0]);
+            return false;
+        }
+        else {
+            inputs->push_back(arg);
+        }
+    }
+    if (output->empty() || inputs->empty()) {
+        show_usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output;
+    std::vector<std::string> inputs;
+    if (!parse_arguments(argc, argv, &output, &inputs)) {
+        return 1;
+    }
+    if (!MergeTraceFiles(inputs, output)) {
+        return 1;
+    }
+    std::cout << "已合并 " << inputs.size() << " 个追踪文件: " << output << std::endl;
+    return 0;
+}